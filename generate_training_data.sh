@@ -9,12 +9,12 @@ set -e
 SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
 TRAINING_PATH="$SCRIPT_DIR/build/training"
 TRAINING_DIR="$SCRIPT_DIR/training_data"
-OUTPUT_FILE="$TRAINING_DIR/training_combined.txt"
 TEMP_PREFIX="$TRAINING_DIR/training_temp"
 
 # Parameter (können überschrieben werden)
 NUM_GAMES=${NUM_GAMES:-10000000}          # Gesamtanzahl Spiele
 CONCURRENCY=${CONCURRENCY:-32}          # Anzahl paralleler Instanzen
+THREADS=${THREADS:-1}                   # Worker-Threads pro Instanz (teilen sich Netz und Hash)
 DEPTH=${DEPTH:-6}                       # Suchtiefe
 NODES=${NODES:-5000}                       # Knotenlimit (0=benutze Tiefe)
 RANDOM_MOVES=${RANDOM_MOVES:-12}         # Zufallszüge am Anfang
@@ -27,6 +27,18 @@ FILTER_TACTICS=${FILTER_TACTICS:-1}   # Taktische Positionen filtern (0=aus)
 VERBOSE=${VERBOSE:-1}  # Verbosity Level
 SYZYGY_PATH=${SYZYGY_PATH:-}          # Pfad zu Syzygy-Tablebases (leer=aus)
 SYZYGY_PROBE_LIMIT=${SYZYGY_PROBE_LIMIT:-7}  # Max. Steinezahl für TB-Adjudication
+FORMAT=${FORMAT:-text}                # text (fen | eval | wdl) oder bullet (gepackte 32-Byte-Records)
+ZSTD_LEVEL=${ZSTD_LEVEL:-0}           # zstd-Kompression der Ausgabe (braucht Build mit ZSTD=1, 0=aus)
+
+# Ausgabedatei passend zum Format
+if [ "$FORMAT" = "bullet" ]; then
+    OUTPUT_FILE="$TRAINING_DIR/training_combined.data"
+else
+    OUTPUT_FILE="$TRAINING_DIR/training_combined.txt"
+fi
+if [ "$ZSTD_LEVEL" -gt 0 ]; then
+    OUTPUT_FILE="$OUTPUT_FILE.zst"
+fi
 
 # Farben für Output
 RED='\033[0;31m'
@@ -58,7 +70,7 @@ REMAINING_GAMES=$((NUM_GAMES % CONCURRENCY))
 echo -e "${YELLOW}Konfiguration:${NC}"
 echo "  Training-Programm: $TRAINING_PATH"
 echo "  Gesamtspiele:      $NUM_GAMES"
-echo "  Parallelität:      $CONCURRENCY Instanzen"
+echo "  Parallelität:      $CONCURRENCY Instanzen x $THREADS Threads"
 echo "  Spiele/Instanz:    $GAMES_PER_INSTANCE (+$REMAINING_GAMES Rest)"
 if [ "$NODES" -gt 0 ]; then
 echo "  Suchknoten:        $NODES"
@@ -76,6 +88,7 @@ echo "  Syzygy-TB:         $SYZYGY_PATH (bis $SYZYGY_PROBE_LIMIT Steine)"
 else
 echo "  Syzygy-TB:         aus"
 fi
+echo "  Format:            $FORMAT (zstd: $ZSTD_LEVEL)"
 echo "  Output:            $OUTPUT_FILE"
 echo ""
 
@@ -88,13 +101,37 @@ fi
 # Array für PIDs der Hintergrundprozesse
 declare -a PIDS
 
+# Temporäre Datendateien (ohne Logs)
+temp_data_files() {
+    ls -1 "${TEMP_PREFIX}"_*.* 2>/dev/null | grep -v '.log$' || true
+}
+
+# Zählt die Positionen in den temporären Dateien (Zeilen bzw. 32-Byte-Records)
+count_positions() {
+    local files
+    files=$(temp_data_files)
+    if [ -z "$files" ]; then
+        echo 0
+        return
+    fi
+    local reader="cat"
+    if [ "$ZSTD_LEVEL" -gt 0 ]; then
+        reader="zstd -dcq"  # Frames laufender Instanzen sind offen: Fehler ignorieren
+    fi
+    if [ "$FORMAT" = "bullet" ]; then
+        echo $(($($reader $files 2>/dev/null | wc -c) / 32))
+    else
+        $reader $files 2>/dev/null | wc -l
+    fi
+}
+
 # Funktion zum Kombinieren der Daten
 combine_data() {
     echo ""
     echo -e "${YELLOW}Kombiniere Trainingsdaten...${NC}"
     
     # Zähle temporäre Dateien
-    TEMP_COUNT=$(ls -1 "${TEMP_PREFIX}"_*.* 2>/dev/null | grep -v '.log$' | wc -l || echo "0")
+    TEMP_COUNT=$(temp_data_files | wc -l)
     
     if [ "$TEMP_COUNT" -eq 0 ]; then
         echo -e "${RED}Keine Trainingsdaten zum Kombinieren gefunden.${NC}"
@@ -103,12 +140,19 @@ combine_data() {
     
     echo "Gefundene Trainingsdateien: $TEMP_COUNT"
     
-    # Kombiniere alle Trainingsdaten
-    cat "${TEMP_PREFIX}"_*.* 2>/dev/null | grep -v '^$' | grep '|' >> "$OUTPUT_FILE"
-    
-    # Zähle Zeilen
-    NEW_LINES=$(cat "${TEMP_PREFIX}"_*.* 2>/dev/null | grep -v '^$' | grep '|' | wc -l)
-    TOTAL_LINES=$(wc -l < "$OUTPUT_FILE" 2>/dev/null || echo "0")
+    # Kombiniere alle Trainingsdaten. Binäre Records und zstd-Frames lassen
+    # sich direkt aneinanderhängen, Text wird dabei von Leerzeilen befreit.
+    NEW_LINES=$(count_positions)
+    if [ "$ZSTD_LEVEL" -gt 0 ]; then
+        temp_data_files | xargs cat >> "$OUTPUT_FILE"
+        TOTAL_LINES="-"
+    elif [ "$FORMAT" = "bullet" ]; then
+        temp_data_files | xargs cat >> "$OUTPUT_FILE"
+        TOTAL_LINES=$(($(wc -c < "$OUTPUT_FILE") / 32))
+    else
+        cat "${TEMP_PREFIX}"_*.* 2>/dev/null | grep -v '^$' | grep '|' >> "$OUTPUT_FILE"
+        TOTAL_LINES=$(wc -l < "$OUTPUT_FILE" 2>/dev/null || echo "0")
+    fi
     
     echo ""
     echo -e "${GREEN}=== Ergebnis ===${NC}"
@@ -178,6 +222,9 @@ for i in $(seq 1 $CONCURRENCY); do
             --max-moves "$MAX_MOVES" \
             --draw-threshold "$DRAW_THRESHOLD" \
             -v "$VERBOSE" \
+            --threads "$THREADS" \
+            -F "$FORMAT" \
+            -z "$ZSTD_LEVEL" \
             "${SYZYGY_ARGS[@]}" \
             > "${OUTPUT_TEMP}.log" 2>&1 &
     else
@@ -193,6 +240,9 @@ for i in $(seq 1 $CONCURRENCY); do
             --max-moves "$MAX_MOVES" \
             --draw-threshold "$DRAW_THRESHOLD" \
             -v "$VERBOSE" \
+            --threads "$THREADS" \
+            -F "$FORMAT" \
+            -z "$ZSTD_LEVEL" \
             "${SYZYGY_ARGS[@]}" \
             > "${OUTPUT_TEMP}.log" 2>&1 &
     fi
@@ -221,7 +271,7 @@ while true; do
     
     # Zeige Status
     ELAPSED=$(($(date +%s) - START_TIME))
-    TOTAL_POS=$(cat "${TEMP_PREFIX}"_*.* 2>/dev/null | wc -l || echo "0")
+    TOTAL_POS=$(count_positions)
     if [ $ELAPSED -gt 0 ]; then
         POS_PER_SEC=$((TOTAL_POS / ELAPSED))
     else
@@ -6,6 +6,9 @@
 
 ENGINE="./build/sleepmind"
 THRESHOLD=1000000000  # 1 Milliarde
+# Wurzelzüge auf Threads verteilen, optionaler Perft-Hash in MB (0 = aus)
+PERFT_THREADS=${PERFT_THREADS:-$(nproc 2>/dev/null || echo 1)}
+PERFT_HASH=${PERFT_HASH:-0}
 
 # Farben für Output
 RED='\033[0;31m'
@@ -34,6 +37,7 @@ while [[ $# -gt 0 ]]; do
             echo "Usage: $0 [--slow] [--fast]"
             echo "  --slow  Führt auch Tests >= 1 Mrd. Nodes aus"
             echo "  --fast  Überspringt Tests >= 1 Mrd. Nodes (Standard)"
+            echo "  Umgebung: PERFT_THREADS=<n> (Standard: nproc), PERFT_HASH=<MB> (Standard: 0)"
             exit 0
             ;;
         *)
@@ -71,7 +75,7 @@ run_perft() {
     
     # Führe Perft aus
     local start_time=$(date +%s%3N)
-    local result=$(echo -e "position fen $fen\nperft $depth\nquit" | $ENGINE 2>/dev/null | grep "^perft" | awk '{print $3}')
+    local result=$(echo -e "position fen $fen\nperft $depth threads $PERFT_THREADS hash $PERFT_HASH\nquit" | $ENGINE 2>/dev/null | grep "^perft" | awk '{print $3}')
     local end_time=$(date +%s%3N)
     
     # Berechne Zeit in Millisekunden
@@ -11,7 +11,8 @@ usage() {
     echo ""
     echo "Options:"
     echo "  -b  Path to bullet-utils executable"
-    echo "  -i  Input folder containing .txt training data files"
+    echo "  -i  Input folder containing .txt training data files (or packed"
+    echo "      .data / .data.zst files from the generator's -F bullet mode)"
     echo "  -o  Output file path for the final shuffled .dat file"
     echo "  -m  Memory to use for shuffling in MB (default: 1024)"
     echo "  -r  Drop entries recorded during the random-opening phase:"
@@ -123,8 +124,31 @@ if [ "$RANDOM_MOVES" -gt 0 ]; then
     echo "Dropped $TOTAL_DROPPED random-phase entries in total (ply < $RANDOM_MOVES)"
 fi
 
+# Packed files (training -F bullet) are already in bullet's format and need
+# no conversion; compressed ones are only unpacked. The generator never
+# records random-phase entries, so -r does not apply to them.
+for packed_file in "$INPUT_FOLDER"/**/*.data "$INPUT_FOLDER"/**/*.data.zst; do
+    if [ -f "$packed_file" ]; then
+        if [[ "$packed_file" == *.zst ]]; then
+            if ! command -v zstd > /dev/null; then
+                echo "Error: zstd is needed to unpack $packed_file"
+                exit 1
+            fi
+            rel_path="${packed_file#$INPUT_FOLDER/}"
+            safe_name=$(echo "$rel_path" | sed 's/[\/\\]/_/g' | sed 's/\.data\.zst$//')
+            dat_file="$TEMP_DIR/${safe_name}.packed.dat"
+            echo "Unpacking:  $packed_file -> $dat_file"
+            zstd -dcq "$packed_file" > "$dat_file"
+        else
+            dat_file="$packed_file"
+            echo "Packed:     $packed_file (no conversion)"
+        fi
+        DAT_FILES+=("$dat_file")
+    fi
+done
+
 if [ ${#DAT_FILES[@]} -eq 0 ]; then
-    echo "Error: No .txt files found in $INPUT_FOLDER (including subdirectories)"
+    echo "Error: No .txt, .data or .data.zst files found in $INPUT_FOLDER (including subdirectories)"
     exit 1
 fi
 
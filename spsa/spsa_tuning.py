@@ -18,6 +18,7 @@ import os
 import sys
 import logging
 import threading
+import subprocess
 from typing import Dict, List
 from concurrent.futures import ThreadPoolExecutor, as_completed
 import chess
@@ -29,6 +30,10 @@ import chess.pgn
 # =============================================================================
 
 ENGINE_PATH = "../build/sleepmind"
+# Native match runner (make match): plays the pairs in-process on its own
+# threads instead of two UCI engines per game; SPSA_NATIVE=0 forces UCI
+MATCH_PATH = "../build/match"
+USE_NATIVE = os.environ.get("SPSA_NATIVE", "1") == "1" and os.path.exists(MATCH_PATH)
 OPENING_BOOK_PATH = "/home/paschty/Downloads/2moves_v2.pgn"
 
 TIME_PER_MOVE_MS = int(os.environ.get("SPSA_MOVETIME_MS", "1000"))
@@ -219,6 +224,71 @@ class OpeningBook:
         return [self.get_opening() for _ in range(count)]
 
 
+# =============================================================================
+# Native Match Runner
+# =============================================================================
+
+class NativeMatch:
+    """One long-running "match --serve" process: each request line
+    "<id> <θ+ params> <θ- params>" is answered by a "pair <id> score <s> ..."
+    line once its two games are done, in completion order."""
+
+    def __init__(self):
+        cmd = [MATCH_PATH, "--serve", "-T", str(MAX_PARALLEL_GAMES),
+               "-t", str(TIME_PER_MOVE_MS), "-p", "8", "-v", "0"]
+        if os.path.exists(OPENING_BOOK_PATH):
+            cmd += ["-b", OPENING_BOOK_PATH]
+        self.proc = subprocess.Popen(cmd, stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                                     text=True, bufsize=1)
+        self.next_id = 0
+        self.pending = {}  # id -> [event, score or error]
+        self.lock = threading.Lock()
+        self.reader = threading.Thread(target=self._read_results, daemon=True)
+        self.reader.start()
+
+    def _read_results(self):
+        for line in self.proc.stdout:
+            parts = line.split()
+            if len(parts) < 3 or parts[0] != "pair":
+                continue
+            with self.lock:
+                slot = self.pending.get(int(parts[1]))
+            if slot is None:
+                continue
+            slot[1] = float(parts[3]) if parts[2] == "score" else " ".join(parts[3:])
+            slot[0].set()
+        with self.lock:  # process gone: wake everybody up
+            for slot in self.pending.values():
+                if slot[1] is None:
+                    slot[1] = "match process exited"
+                slot[0].set()
+
+    def play_pair(self, theta_plus: Dict[str, int], theta_minus: Dict[str, int]) -> float:
+        """Score of θ+ in [0, 1] over one colour-swapped opening pair."""
+        spec_plus = ",".join(f"{name}={val}" for name, val in theta_plus.items()) or "-"
+        spec_minus = ",".join(f"{name}={val}" for name, val in theta_minus.items()) or "-"
+        slot = [threading.Event(), None]
+        with self.lock:
+            pair_id = self.next_id
+            self.next_id += 1
+            self.pending[pair_id] = slot
+            self.proc.stdin.write(f"{pair_id} {spec_plus} {spec_minus}\n")
+            self.proc.stdin.flush()
+        slot[0].wait()
+        with self.lock:
+            del self.pending[pair_id]
+        if isinstance(slot[1], str):
+            raise RuntimeError(f"pair {pair_id}: {slot[1]}")
+        return slot[1]
+
+    def close(self):
+        try:
+            self.proc.stdin.close()
+        except OSError:
+            pass
+        self.proc.wait()
+
+
 # =============================================================================
 # SPSA Tuner (Fishtest Style)
 # =============================================================================
@@ -230,7 +300,9 @@ class SPSATuner:
         self.best_params = self.get_int_params()
         self.iteration = 0
         self.history = []
-        self.opening_book = OpeningBook(OPENING_BOOK_PATH)
+        # The native runner reads the book itself
+        self.native = NativeMatch() if USE_NATIVE else None
+        self.opening_book = None if USE_NATIVE else OpeningBook(OPENING_BOOK_PATH)
         # Which parameters to actually tune (None = all)
         self.tune_only = tune_only
 
@@ -381,9 +453,11 @@ class SPSATuner:
                 return
             direction = self.get_perturbation()
             theta_plus, theta_minus = self.create_theta_plus_minus(direction)
-        opening = self.opening_book.get_opening()
-
-        score = self.play_pair(theta_plus, theta_minus, opening)
+        if self.native is not None:
+            score = self.native.play_pair(theta_plus, theta_minus)
+        else:
+            opening = self.opening_book.get_opening()
+            score = self.play_pair(theta_plus, theta_minus, opening)
 
         with self.lock:
             self.apply_update(direction, score)
@@ -431,6 +505,9 @@ class SPSATuner:
             print("\nInterrupted - cancelling pending pairs, waiting for running games...")
             executor.shutdown(wait=True, cancel_futures=True)
             raise
+        finally:
+            if self.native is not None:
+                self.native.close()
         executor.shutdown()
 
 
@@ -460,6 +537,7 @@ def main():
     print(f"Max pairs: {MAX_ITERATIONS} ({MAX_ITERATIONS * 2} games)")
     print(f"Time per move: {TIME_PER_MOVE_MS}ms")
     print(f"Parallel pair slots: {MAX_PARALLEL_GAMES}")
+    print(f"Games: {'native match runner' if USE_NATIVE else 'UCI engines via python-chess'}")
     print()
 
     if not os.path.exists(ENGINE_PATH):
@@ -64,6 +64,27 @@ enum Squares {
     SQ_NONE // Represents no square or an invalid square
 };
 
+// =============================================================================
+// StateInfo - per-ply state saved by applyMove
+//
+// Lives in storage owned by the caller (the search stack frame of the move,
+// a game history array in uci/training) instead of inside Board, so copying
+// a Board stays cheap. Each entry links to the one before it; the repetition
+// check walks this chain back as far as the halfmove clock allows.
+// =============================================================================
+typedef struct StateInfo {
+    int capturedPieceType; // PieceTypeToken of captured piece (or NO_PIECE_TYPE)
+    int oldEnPassantSquare;
+    uint8_t oldCastlingRights;
+    int oldHalfMoveClock;
+    uint64_t oldZobristKey;       // key of the position before the move
+    int oldPliesFromNull;
+    Bitboard oldCheckers;         // check info of the position before the move
+    Bitboard oldBlockersForKing[2];
+    Bitboard oldPinners[2];
+    struct StateInfo* previous;   // state of the move before, NULL at the game start
+} StateInfo;
+
 // =============================================================================
 // Board structure - Stockfish-style with indexed bitboards
 // =============================================================================
@@ -81,8 +102,14 @@ typedef struct {
     int fullMoveNumber;
     int enPassantSquare;
     uint64_t zobristKey; 
-    uint64_t history[1000]; 
-    int historyIndex; 
+    int pliesFromNull;         // plies since the last null move / start of the state chain
+    StateInfo* st;             // state of the last applied move, NULL if none
+
+    // Check info, recomputed by updateCheckInfo() (move_generator.c) after
+    // every applyMove and whenever a position is set up
+    Bitboard checkers;           // enemy pieces giving check to the side to move
+    Bitboard blockersForKing[2]; // [color]: pieces (either color) that alone block a slider from that king
+    Bitboard pinners[2];         // [color]: sliders of that color pinning a piece to the enemy king
 } Board;
 
 // For compatibility with old code
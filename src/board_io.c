@@ -1,14 +1,15 @@
 #include "board_io.h"
 #include "board.h"
 #include "zobrist.h"
+#include "move_generator.h" // updateCheckInfo
 
 Board parseFEN(const char* fen) {
     Board board = {};
     
     // Initialize all bitboards and piece array to empty
     clear_piece_array(&board);
-    board.historyIndex = 0;
-    memset(board.history, 0, sizeof(board.history));
+    board.st = NULL;  // no moves played yet
+    board.pliesFromNull = 0;
 
     // implement FEN parsing
     int rank = 7, file = 0;
@@ -138,12 +139,13 @@ Board parseFEN(const char* fen) {
 
     // 7. Zobrist key
     board.zobristKey = calculate_zobrist_key(&board);
+    updateCheckInfo(&board);
 
     return board;
 }
 
 const char* outputFEN(const Board* board) {
-    static char fen[128]; // Buffer for FEN string
+    static _Thread_local char fen[128]; // Buffer for FEN string (per thread: self-play workers)
     int index = 0;
 
     // 1. Piece placement
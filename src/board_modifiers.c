@@ -1,6 +1,7 @@
 
 #include "board_modifiers.h"
 #include "zobrist.h"
+#include "move_generator.h" // updateCheckInfo
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -84,13 +85,21 @@ void clearCaptureSquareOnAllBitboards(Board* board, Square sq) {
 
 // =============================================================================
 // OPTIMIZED applyMove - Stockfish-style branchless hotpath
+//
+// Make and unmake take the moving side as a constant and are forced inline
+// into one instance per colour (see the dispatchers below), so the colour
+// tests - en passant offsets, castling squares, fullmove update - fold at
+// compile time.
 // =============================================================================
 
-void applyMove(Board* board, Move move, MoveUndoInfo* undoInfo, NNUEAccumulator* nnue_acc, const NNUENetwork* nnue_net) {
+#define COLOR_SPECIALIZED static inline __attribute__((always_inline))
+
+COLOR_SPECIALIZED void applyMoveFor(Board* board, Move move, MoveUndoInfo* undoInfo,
+                                    NNUEAccumulator* nnue_acc, const NNUENetwork* nnue_net,
+                                    const int us) {
     Square from = MOVE_FROM(move);
     Square to = MOVE_TO(move);
-    int us = board->whiteToMove ? WHITE : BLACK;
-    int them = 1 - us;
+    const int them = 1 - us;
     
     // O(1) piece lookup - THE key optimization
     uint8_t movingPiece = board->piece[from];
@@ -109,6 +118,13 @@ void applyMove(Board* board, Move move, MoveUndoInfo* undoInfo, NNUEAccumulator*
     undoInfo->oldHalfMoveClock = board->halfMoveClock;
     undoInfo->oldZobristKey = board->zobristKey;
     undoInfo->capturedPieceType = NO_PIECE_TYPE;
+    undoInfo->oldPliesFromNull = board->pliesFromNull;
+    undoInfo->oldCheckers = board->checkers;
+    undoInfo->oldBlockersForKing[WHITE] = board->blockersForKing[WHITE];
+    undoInfo->oldBlockersForKing[BLACK] = board->blockersForKing[BLACK];
+    undoInfo->oldPinners[WHITE] = board->pinners[WHITE];
+    undoInfo->oldPinners[BLACK] = board->pinners[BLACK];
+    undoInfo->previous = board->st;
     
     // Determine captured piece (O(1) lookup)
     uint8_t capturedPiece = NO_PIECE;
@@ -137,7 +153,7 @@ void applyMove(Board* board, Move move, MoveUndoInfo* undoInfo, NNUEAccumulator*
         if (nnue_lazy) {
             nnue_mark_accumulator_dirty(nnue_acc, board, from, to, movingType,
                                         capturedType, us == WHITE, MOVE_IS_EN_PASSANT(move),
-                                        MOVE_IS_CASTLING(move) || promoFlag || kingNeedsRefresh);
+                                        MOVE_IS_CASTLING(move) || promoFlag);
         } else if (MOVE_IS_CASTLING(move) || promoFlag || kingNeedsRefresh) {
             // Refresh after board update
         } else {
@@ -277,21 +293,66 @@ void applyMove(Board* board, Move move, MoveUndoInfo* undoInfo, NNUEAccumulator*
 
     // Single write of zobrist key
     board->zobristKey = zobrist;
-    board->history[board->historyIndex++] = zobrist;
+    board->pliesFromNull++;
+    board->st = undoInfo;
+    updateCheckInfo(board);
+}
+
+void applyMove(Board* board, Move move, MoveUndoInfo* undoInfo, NNUEAccumulator* nnue_acc, const NNUENetwork* nnue_net) {
+    if (board->whiteToMove) applyMoveFor(board, move, undoInfo, nnue_acc, nnue_net, WHITE);
+    else applyMoveFor(board, move, undoInfo, nnue_acc, nnue_net, BLACK);
+}
+
+// =============================================================================
+// Null move
+// =============================================================================
+
+void applyNullMove(Board* board, StateInfo* st) {
+    st->capturedPieceType = NO_PIECE_TYPE;
+    st->oldEnPassantSquare = board->enPassantSquare;
+    st->oldCastlingRights = board->castlingRights;
+    st->oldHalfMoveClock = board->halfMoveClock;
+    st->oldZobristKey = board->zobristKey;
+    st->oldPliesFromNull = board->pliesFromNull;
+    st->oldCheckers = board->checkers;
+    st->previous = board->st;
+
+    board->whiteToMove = !board->whiteToMove;
+    board->zobristKey ^= zobrist_side_to_move_key;
+    if (board->enPassantSquare != SQ_NONE) {
+        board->zobristKey ^= zobrist_enpassant_keys[board->enPassantSquare];
+    }
+    board->enPassantSquare = SQ_NONE;
+    board->pliesFromNull = 0;
+    board->st = st;
+    // Never played in check, so the opponent is not in check either;
+    // blockers and pinners do not depend on the side to move
+    board->checkers = 0;
+}
+
+void undoNullMove(Board* board, const StateInfo* st) {
+    board->whiteToMove = !board->whiteToMove;
+    board->enPassantSquare = st->oldEnPassantSquare;
+    board->zobristKey = st->oldZobristKey;
+    board->pliesFromNull = st->oldPliesFromNull;
+    board->checkers = st->oldCheckers;
+    board->st = st->previous;
 }
 
 // =============================================================================
 // OPTIMIZED undoMove
 // =============================================================================
 
-void undoMove(Board* board, Move move, const MoveUndoInfo* undoInfo, NNUEAccumulator* nnue_acc, const NNUENetwork* nnue_net) {
+// `us` is the side that made the move
+COLOR_SPECIALIZED void undoMoveFor(Board* board, Move move, const MoveUndoInfo* undoInfo,
+                                   NNUEAccumulator* nnue_acc, const NNUENetwork* nnue_net,
+                                   const int us) {
     Square from = MOVE_FROM(move);
     Square to = MOVE_TO(move);
     
     // Revert side to move first
-    board->whiteToMove = !board->whiteToMove;
-    int us = board->whiteToMove ? WHITE : BLACK;
-    int them = 1 - us;
+    board->whiteToMove = (us == WHITE);
+    const int them = 1 - us;
 
     // Revert fullmove number
     if (us == BLACK) {
@@ -302,7 +363,13 @@ void undoMove(Board* board, Move move, const MoveUndoInfo* undoInfo, NNUEAccumul
     board->halfMoveClock = undoInfo->oldHalfMoveClock;
     board->enPassantSquare = undoInfo->oldEnPassantSquare;
     board->castlingRights = undoInfo->oldCastlingRights;
-    board->historyIndex--;
+    board->pliesFromNull = undoInfo->oldPliesFromNull;
+    board->checkers = undoInfo->oldCheckers;
+    board->blockersForKing[WHITE] = undoInfo->oldBlockersForKing[WHITE];
+    board->blockersForKing[BLACK] = undoInfo->oldBlockersForKing[BLACK];
+    board->pinners[WHITE] = undoInfo->oldPinners[WHITE];
+    board->pinners[BLACK] = undoInfo->oldPinners[BLACK];
+    board->st = undoInfo->previous;
 
     // Get moved piece info
     int promoFlag = MOVE_PROMOTION(move);
@@ -396,6 +463,12 @@ void undoMove(Board* board, Move move, const MoveUndoInfo* undoInfo, NNUEAccumul
     board->zobristKey = undoInfo->oldZobristKey;
 }
 
+void undoMove(Board* board, Move move, const MoveUndoInfo* undoInfo, NNUEAccumulator* nnue_acc, const NNUENetwork* nnue_net) {
+    // The side to move is the opponent of the side that made the move
+    if (board->whiteToMove) undoMoveFor(board, move, undoInfo, nnue_acc, nnue_net, BLACK);
+    else undoMoveFor(board, move, undoInfo, nnue_acc, nnue_net, WHITE);
+}
+
 // =============================================================================
 // Board mirroring for symmetry testing
 // =============================================================================
@@ -471,7 +544,9 @@ void mirrorBoard(Board* board) {
     }
     
     // Clear history (mirrored position has new history)
-    board->historyIndex = 0;
+    board->st = NULL;
+    board->pliesFromNull = 0;
+    updateCheckInfo(board);
     
     #undef FLIP_SQUARE
 }
@@ -6,14 +6,13 @@
 #include "move.h" // For Move, PieceTypeToken, Square, promotion flags
 #include "nnue.h" // For NNUEAccumulator
 
-// Structure to hold information needed to undo a move
-typedef struct {
-    int capturedPieceType; // PieceTypeToken of captured piece (or NO_PIECE_TYPE)
-    int oldEnPassantSquare;
-    uint8_t oldCastlingRights;
-    int oldHalfMoveClock;
-    uint64_t oldZobristKey;
-} MoveUndoInfo;
+// Information needed to undo a move (see StateInfo in board.h)
+typedef StateInfo MoveUndoInfo;
+
+// Game-level history of StateInfo entries (uci position moves, training
+// games), used as a ring: the repetition check never looks back further than
+// the halfmove clock (< 100 plies), so older entries may be overwritten
+#define MAX_GAME_STATES 1024
 
 // --- Function Prototypes ---
 
@@ -41,6 +40,24 @@ void applyMove(Board* board, Move move, MoveUndoInfo* undoInfo, NNUEAccumulator*
  */
 void undoMove(Board* board, Move move, const MoveUndoInfo* undoInfo, NNUEAccumulator* nnue_acc, const NNUENetwork* nnue_net);
 
+/**
+ * @brief Passes the move to the opponent (null move) and pushes a StateInfo
+ *        so the repetition chain keeps its ply parity. The halfmove clock is
+ *        left unchanged.
+ *
+ * @param board Pointer to the Board to be modified.
+ * @param st Storage for the state, must stay valid until undoNullMove.
+ */
+void applyNullMove(Board* board, StateInfo* st);
+
+/**
+ * @brief Reverts applyNullMove.
+ *
+ * @param board Pointer to the Board to be modified.
+ * @param st The state passed to applyNullMove.
+ */
+void undoNullMove(Board* board, const StateInfo* st);
+
 PieceTypeToken getPieceTypeAtSquare(const Board* board, Square sq, bool* pieceIsWhite);
 void addPieceToBoard(Board* board, Square sq, PieceTypeToken pieceType, bool isWhite);
 void removePieceFromBoard(Board* board, Square sq, PieceTypeToken pieceType, bool isWhite);
@@ -0,0 +1,505 @@
+// posix_memalign needs POSIX visibility under -std=c11
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include "epd.h"
+#include "bitboard_utils.h"
+#include "board_io.h"
+#include "board_modifiers.h"
+#include "evaluation.h"
+#include "move.h"
+#include "move_generator.h"
+#include "san.h"
+#include "search.h"
+#include "tt.h"
+#include <ctype.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EPD_LINE_MAX  1024
+#define EPD_OP_MOVES  8     // moves per bm/am op
+#define EPD_TEXT_MAX  64
+
+typedef struct {
+    char fen[128];
+    char id[EPD_TEXT_MAX];
+    char expect[EPD_TEXT_MAX];  // "bm Qd5" / "am Bxh7" as in the file, for the report
+    Move bm[EPD_OP_MOVES];
+    int bm_count;
+    Move am[EPD_OP_MOVES];
+    int am_count;
+    bool valid;
+
+    // Result
+    char best[8];           // SAN
+    int score;              // side to move relative
+    int depth;              // last completed iteration
+    uint64_t nodes;
+    long time_ms;
+    bool solved;
+    long solved_ms;         // start of the final run of correct iterations, -1 = never
+    uint64_t solved_nodes;
+} EpdPosition;
+
+typedef struct {
+    const EpdConfig* config;
+    const NNUENetwork* net;
+    EpdPosition* positions;
+    int count;
+    atomic_int next;        // next unclaimed position
+} EpdJob;
+
+typedef struct {
+    SearchInfo search_info;
+    NNUEAccumulator acc;
+    EpdPosition* current;   // position being searched, for the iteration hook
+    int id;
+    EpdJob* job;
+    pthread_t thread;
+} EpdWorker;
+
+// =============================================================================
+// EPD parsing
+// =============================================================================
+
+// "bm Qd5 Nf3" -> moves; false if one of them is not a legal move
+static bool parse_move_op(const Board* board, const MoveList* legal, char* operands,
+                          Move* moves, int* count) {
+    char* save = NULL;
+    for (char* tok = strtok_r(operands, " \t", &save); tok != NULL; tok = strtok_r(NULL, " \t", &save)) {
+        Move m = parse_san_move(board, legal, tok);
+        if (m == 0) return false;
+        if (*count < EPD_OP_MOVES) moves[(*count)++] = m;
+    }
+    return true;
+}
+
+static char* trim(char* s) {
+    while (isspace((unsigned char)*s)) s++;
+    char* end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) *--end = '\0';
+    return s;
+}
+
+// Four FEN fields, optionally the two move counters, then "opcode operands;"
+// operations. False for lines that are not a playable position.
+static bool parse_epd_line(char* line, EpdPosition* pos) {
+    memset(pos, 0, sizeof(*pos));
+    pos->solved_ms = -1;
+
+    char* fields[6];
+    char* rest = line;
+    int n = 0;
+    while (n < 6) {
+        while (isspace((unsigned char)*rest)) rest++;
+        if (*rest == '\0') break;
+        char* start = rest;
+        while (*rest && !isspace((unsigned char)*rest)) rest++;
+        // The counters are optional: stop at the first op
+        if (n >= 4 && !isdigit((unsigned char)*start)) {
+            rest = start;
+            break;
+        }
+        if (*rest) *rest++ = '\0';
+        fields[n++] = start;
+    }
+    if (n < 4) return false;
+    snprintf(pos->fen, sizeof(pos->fen), "%s %s %s %s %s %s", fields[0], fields[1], fields[2],
+             fields[3], n > 4 ? fields[4] : "0", n > 5 ? fields[5] : "1");
+
+    Board board = parseFEN(pos->fen);
+    if (POPCOUNT(board.byTypeBB[WHITE][KING]) != 1 || POPCOUNT(board.byTypeBB[BLACK][KING]) != 1) {
+        return false;
+    }
+    MoveList legal;
+    generateLegalMoves(&board, &legal);
+
+    while (*rest) {
+        char* op = rest;
+        char* end = strchr(rest, ';');
+        if (end != NULL) {
+            *end = '\0';
+            rest = end + 1;
+        } else {
+            rest += strlen(rest);
+        }
+        op = trim(op);
+        char* operands = op;
+        while (*operands && !isspace((unsigned char)*operands)) operands++;
+        if (*operands) *operands++ = '\0';
+        operands = trim(operands);
+
+        if (strcmp(op, "id") == 0) {
+            size_t len = strlen(operands);
+            if (len >= 2 && operands[0] == '"' && operands[len - 1] == '"') {
+                operands[len - 1] = '\0';
+                operands++;
+            }
+            snprintf(pos->id, sizeof(pos->id), "%s", operands);
+        } else if (strcmp(op, "bm") == 0 || strcmp(op, "am") == 0) {
+            bool bm = op[0] == 'b';
+            size_t used = strlen(pos->expect);
+            snprintf(pos->expect + used, sizeof(pos->expect) - used, "%s%s %s",
+                     used ? ", " : "", op, operands);
+            if (!parse_move_op(&board, &legal, operands, bm ? pos->bm : pos->am,
+                               bm ? &pos->bm_count : &pos->am_count)) {
+                fprintf(stderr, "Error: Illegal %s move in EPD position %s\n", op, pos->fen);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Reads every position; entries that fail to parse stay in the list as
+// invalid so the report numbering matches the file
+static EpdPosition* load_epd(const char* path, int* count) {
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "Error: Cannot open EPD file %s\n", path);
+        return NULL;
+    }
+    int capacity = 256;
+    EpdPosition* positions = (EpdPosition*)malloc((size_t)capacity * sizeof(EpdPosition));
+    char line[EPD_LINE_MAX];
+    *count = 0;
+    while (positions != NULL && fgets(line, sizeof(line), f)) {
+        char* text = trim(line);
+        if (*text == '\0' || *text == '#') continue;
+        if (*count == capacity) {
+            capacity *= 2;
+            EpdPosition* grown = (EpdPosition*)realloc(positions, (size_t)capacity * sizeof(EpdPosition));
+            if (grown == NULL) {
+                free(positions);
+                positions = NULL;
+                break;
+            }
+            positions = grown;
+        }
+        EpdPosition* pos = &positions[(*count)++];
+        pos->valid = parse_epd_line(text, pos);
+    }
+    fclose(f);
+    if (positions == NULL) fprintf(stderr, "Error: Out of memory reading %s\n", path);
+    return positions;
+}
+
+// =============================================================================
+// Solving
+// =============================================================================
+
+static bool move_in(Move m, const Move* moves, int count) {
+    for (int i = 0; i < count; i++) {
+        if (moves[i] == m) return true;
+    }
+    return false;
+}
+
+static bool is_correct(const EpdPosition* pos, Move m) {
+    if (m == 0) return false;
+    if (pos->bm_count > 0 && !move_in(m, pos->bm, pos->bm_count)) return false;
+    return !move_in(m, pos->am, pos->am_count);
+}
+
+// Time-to-solution is when the best move turned correct and then stayed so
+// for every later iteration
+static void on_iteration(const SearchInfo* info, int depth, Move best, int score) {
+    EpdWorker* w = (EpdWorker*)info->onIterationCtx;
+    EpdPosition* pos = w->current;
+    pos->depth = depth;
+    pos->score = score;
+    if (!is_correct(pos, best)) {
+        pos->solved_ms = -1;
+    } else if (pos->solved_ms < 0) {
+        pos->solved_ms = search_current_time_ms() - info->startTimeMs;
+        pos->solved_nodes = info->nodesSearched;
+    }
+}
+
+static void solve_position(EpdWorker* w, EpdPosition* pos) {
+    const EpdConfig* config = w->job->config;
+    SearchInfo* search = &w->search_info;
+    Board board = parseFEN(pos->fen);
+
+    nnue_refresh_accumulator(&board, &w->acc, w->job->net);
+    // A private slice starts empty for every position, like bench; a shared
+    // table keeps what the other positions stored
+    if (!config->shared_tt) clear_tt();
+    clear_search_history(search);
+
+    w->current = pos;
+    // No tablebase probing: the verdict should come from the search under test
+    search_info_prepare(search, NULL);
+    search->hardTimeLimit = config->movetime_ms;
+    search->depthLimit = config->depth;
+    search->nodeLimit = config->nodes;
+    search->nnue_acc = &w->acc;
+    search->nnue_net = w->job->net;
+    search->onIteration = on_iteration;
+    search->onIterationCtx = w;
+
+    Move best = iterative_deepening_search(&board, search);
+
+    pos->time_ms = search_current_time_ms() - search->startTimeMs;
+    pos->nodes = search->nodesSearched;
+    pos->solved = is_correct(pos, best) && (pos->bm_count > 0 || pos->am_count > 0);
+    if (!pos->solved) pos->solved_ms = -1;
+    if (best != 0) {
+        MoveList legal;
+        generateLegalMoves(&board, &legal);
+        move_to_san(&board, &legal, best, pos->best);
+    } else {
+        strcpy(pos->best, "(none)");
+    }
+}
+
+static void* epd_worker(void* arg) {
+    EpdWorker* w = (EpdWorker*)arg;
+    EpdJob* job = w->job;
+    if (!job->config->shared_tt) tt_use_slice(w->id, job->config->threads);
+
+    int i;
+    while ((i = atomic_fetch_add(&job->next, 1)) < job->count) {
+        if (job->positions[i].valid) solve_position(w, &job->positions[i]);
+    }
+    return NULL;
+}
+
+static void format_score(int score, char* out, size_t size) {
+    if (score > TB_WIN_SCORE) snprintf(out, size, "mate %d", (MATE_SCORE - score + 1) / 2);
+    else if (score < -TB_WIN_SCORE) snprintf(out, size, "mate %d", -((MATE_SCORE + score + 1) / 2));
+    else snprintf(out, size, "cp %d", score);
+}
+
+static void print_result(const EpdPosition* pos, int index, int count) {
+    const char* name = pos->id[0] ? pos->id : pos->fen;
+    if (!pos->valid) {
+        printf("info string EPD %d/%d %s: invalid, skipped\n", index + 1, count, name);
+        return;
+    }
+    bool has_ops = pos->bm_count > 0 || pos->am_count > 0;
+    char score[32];
+    format_score(pos->score, score, sizeof(score));
+    printf("info string EPD %d/%d %s: %s%s%s, found %s (score %s, depth %d, %llu nodes, %ld ms",
+           index + 1, count, name, !has_ops ? "searched" : pos->solved ? "solved" : "FAILED",
+           has_ops ? ", " : "", pos->expect, pos->best, score, pos->depth,
+           (unsigned long long)pos->nodes, pos->time_ms);
+    if (pos->solved) {
+        printf(", solved at %ld ms / %llu nodes", pos->solved_ms, (unsigned long long)pos->solved_nodes);
+    }
+    printf(")\n");
+}
+
+bool epd_solve(const EpdConfig* config, const NNUENetwork* net) {
+    int count = 0;
+    EpdPosition* positions = load_epd(config->path, &count);
+    if (positions == NULL) return false;
+
+    // A stop or ponder left over from an earlier UCI search would cut every
+    // position short or lift its time limit
+    search_clear_stop();
+    search_set_pondering(false);
+
+    int threads = config->threads < 1 ? 1 : config->threads;
+    EpdConfig run = *config;
+    run.threads = threads;
+    EpdJob job = {.config = &run, .net = net, .positions = positions, .count = count};
+    atomic_init(&job.next, 0);
+
+    // One search thread per position: the pool itself is the parallelism
+    bool was_silent = search_silent_mode;
+    int old_search_threads = search_get_threads();
+    set_search_silent(true);
+    search_set_threads(1);
+    clear_tt();
+
+    // Workers, 64-byte aligned for the NNUE accumulators
+    EpdWorker* workers[threads];
+    int worker_count = 0;
+    for (int i = 0; i < threads; i++) {
+        void* mem = NULL;
+        if (posix_memalign(&mem, 64, sizeof(EpdWorker)) != 0) break;
+        memset(mem, 0, sizeof(EpdWorker));
+        EpdWorker* w = (EpdWorker*)mem;
+        w->id = i;
+        w->job = &job;
+        w->acc.cache = &w->search_info.nnue_cache;
+        search_params_init(&w->search_info.params);  // builds the shared LMR table before any thread runs
+        workers[worker_count++] = w;
+    }
+
+    long start_ms = search_current_time_ms();
+    int started = 0;
+    if (worker_count == threads) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setstacksize(&attr, SEARCH_THREAD_STACK_SIZE);
+        for (int i = 0; i < worker_count; i++) {
+            if (pthread_create(&workers[i]->thread, &attr, epd_worker, workers[i]) != 0) break;
+            started++;
+        }
+        pthread_attr_destroy(&attr);
+    }
+    // Threads that did start work through the whole list anyway
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i]->thread, NULL);
+    }
+    long elapsed = search_current_time_ms() - start_ms;
+    if (elapsed < 1) elapsed = 1;
+    for (int i = 0; i < worker_count; i++) {
+        free(workers[i]);
+    }
+
+    set_search_silent(was_silent);
+    search_set_threads(old_search_threads);
+    clear_tt();
+
+    bool ok = started > 0;
+    if (!ok) {
+        fprintf(stderr, "Error: Failed to set up %d EPD threads\n", threads);
+        free(positions);
+        return false;
+    }
+
+    int tested = 0, solved = 0, invalid = 0;
+    long solve_time = 0;
+    uint64_t total_nodes = 0;
+    for (int i = 0; i < count; i++) {
+        const EpdPosition* pos = &positions[i];
+        print_result(pos, i, count);
+        if (!pos->valid) {
+            invalid++;
+            continue;
+        }
+        total_nodes += pos->nodes;
+        if (pos->bm_count == 0 && pos->am_count == 0) continue;
+        tested++;
+        if (pos->solved) {
+            solved++;
+            solve_time += pos->solved_ms;
+        }
+    }
+
+    printf("info string EPD: %d positions (%d invalid), threads %d, %s TT, limits:", count, invalid,
+           started, run.shared_tt ? "shared" : "private");
+    if (run.nodes) printf(" nodes %llu", (unsigned long long)run.nodes);
+    if (run.movetime_ms) printf(" movetime %ld", run.movetime_ms);
+    if (run.depth) printf(" depth %d", run.depth);
+    if (!run.nodes && !run.movetime_ms && !run.depth) printf(" none");
+    printf("\n");
+    printf("Solved          : %d/%d\n", solved, tested);
+    printf("Avg solve (ms)  : %ld\n", solved > 0 ? solve_time / solved : 0);
+    printf("Total time (ms) : %ld\n", elapsed);
+    printf("Nodes searched  : %llu\n", (unsigned long long)total_nodes);
+    printf("Nodes/second    : %llu\n", (unsigned long long)(total_nodes * 1000 / (uint64_t)elapsed));
+    fflush(stdout);
+
+    free(positions);
+    return true;
+}
+
+// =============================================================================
+// Eval symmetry
+//
+// The built-in version of symmetry_test.sh's eval check: evaluate() is white
+// relative, so a colour-flipped position must score the negated value.
+// =============================================================================
+
+bool epd_symmetry(const char* path, int tolerance_cp, const NNUENetwork* net) {
+    int count = 0;
+    EpdPosition* positions = load_epd(path, &count);
+    if (positions == NULL) return false;
+
+    void* mem = NULL;
+    if (posix_memalign(&mem, 64, sizeof(NNUEAccumulator)) != 0) {
+        fprintf(stderr, "Error: Out of memory for the symmetry check\n");
+        free(positions);
+        return false;
+    }
+    NNUEAccumulator* acc = (NNUEAccumulator*)mem;
+    memset(acc, 0, sizeof(*acc));  // no refresh cache: every eval is a full refresh
+
+    int tested = 0, failed = 0, worst = 0;
+    long start_ms = search_current_time_ms();
+    for (int i = 0; i < count; i++) {
+        const EpdPosition* pos = &positions[i];
+        if (!pos->valid) continue;
+        Board board = parseFEN(pos->fen);
+        nnue_refresh_accumulator(&board, acc, net);
+        int eval = evaluate(&board, acc, net);
+        mirrorBoard(&board);
+        nnue_refresh_accumulator(&board, acc, net);
+        int mirrored = evaluate(&board, acc, net);
+
+        int diff = abs(eval + mirrored);
+        if (diff > worst) worst = diff;
+        tested++;
+        if (diff > tolerance_cp) {
+            failed++;
+            printf("info string Symmetry FAILED %d/%d %s: eval %d, mirrored %d, diff %d\n",
+                   i + 1, count, pos->id[0] ? pos->id : pos->fen, eval, mirrored, eval + mirrored);
+        }
+    }
+    long elapsed = search_current_time_ms() - start_ms;
+    free(acc);
+    free(positions);
+
+    printf("info string Symmetry: %d positions, tolerance %d cp\n", tested, tolerance_cp);
+    printf("Passed          : %d/%d\n", tested - failed, tested);
+    printf("Max difference  : %d cp\n", worst);
+    printf("Total time (ms) : %ld\n", elapsed);
+    fflush(stdout);
+    return true;
+}
+
+bool epd_compare(const char* path, int tolerance_cp, const NNUENetwork* net, const NNUENetwork* reference) {
+    int count = 0;
+    EpdPosition* positions = load_epd(path, &count);
+    if (positions == NULL) return false;
+
+    void* mem = NULL;
+    if (posix_memalign(&mem, 64, sizeof(NNUEAccumulator)) != 0) {
+        fprintf(stderr, "Error: Out of memory for the net comparison\n");
+        free(positions);
+        return false;
+    }
+    NNUEAccumulator* acc = (NNUEAccumulator*)mem;
+    memset(acc, 0, sizeof(*acc));  // no refresh cache: every eval is a full refresh
+
+    int tested = 0, failed = 0, worst = 0;
+    long total = 0;
+    long start_ms = search_current_time_ms();
+    for (int i = 0; i < count; i++) {
+        const EpdPosition* pos = &positions[i];
+        if (!pos->valid) continue;
+        Board board = parseFEN(pos->fen);
+        nnue_refresh_accumulator(&board, acc, net);
+        int eval = evaluate(&board, acc, net);
+        nnue_refresh_accumulator(&board, acc, reference);
+        int expected = evaluate(&board, acc, reference);
+
+        int diff = abs(eval - expected);
+        if (diff > worst) worst = diff;
+        total += diff;
+        tested++;
+        if (diff > tolerance_cp) {
+            failed++;
+            printf("info string Compare FAILED %d/%d %s: eval %d, reference %d, diff %d\n",
+                   i + 1, count, pos->id[0] ? pos->id : pos->fen, eval, expected, eval - expected);
+        }
+    }
+    long elapsed = search_current_time_ms() - start_ms;
+    free(acc);
+    free(positions);
+
+    printf("info string Compare: %d positions, tolerance %d cp\n", tested, tolerance_cp);
+    printf("Passed          : %d/%d\n", tested - failed, tested);
+    printf("Mean difference : %.2f cp\n", tested > 0 ? (double)total / tested : 0.0);
+    printf("Max difference  : %d cp\n", worst);
+    printf("Total time (ms) : %ld\n", elapsed);
+    fflush(stdout);
+    return true;
+}
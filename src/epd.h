@@ -0,0 +1,41 @@
+#ifndef EPD_H
+#define EPD_H
+
+#include "nnue.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// =============================================================================
+// EPD test suites
+//
+// epd_solve() searches every position of an EPD file under a fixed budget on
+// a pool of threads, each with its own SearchInfo, and checks the result
+// against the "bm" (best move) and "am" (avoid move) operations. Moves may be
+// given in SAN or UCI notation. Positions without either op are only
+// searched. epd_symmetry() checks eval(pos) == -eval(mirror) for every
+// position without searching, epd_compare() the eval of one net against a
+// reference net (e.g. an int8 conversion against the int16 original).
+// =============================================================================
+
+typedef struct {
+    const char* path;
+    uint64_t nodes;       // per position, soft limit like "go nodes" (0 = none)
+    long movetime_ms;     // per position (0 = none)
+    int depth;            // per position (0 = none)
+    int threads;          // positions searched in parallel
+    bool shared_tt;       // one table for all threads instead of a cleared slice each
+} EpdConfig;
+
+// Prints one line per position in file order, then the totals. Returns false
+// if the file cannot be read or the threads cannot be set up.
+bool epd_solve(const EpdConfig* config, const NNUENetwork* net);
+
+// Prints the positions whose mirrored eval differs by more than tolerance_cp
+// and the totals. Returns false if the file cannot be read.
+bool epd_symmetry(const char* path, int tolerance_cp, const NNUENetwork* net);
+
+// Prints the positions where net and reference evaluate more than
+// tolerance_cp apart, then the totals. Returns false if the file cannot be read.
+bool epd_compare(const char* path, int tolerance_cp, const NNUENetwork* net, const NNUENetwork* reference);
+
+#endif // EPD_H
@@ -2,6 +2,7 @@
 #include "bitboard_utils.h" // For POPCOUNT
 #include "evaluation.h"     // For function signature
 #include "nnue.h"           // For NNUE evaluation
+#include "nnue_simd.h"      // For the kernel name in DEBUG_NNUE_EVAL
 
 #include <stdbool.h>
 #include <math.h>   // For fabs, fmin, fmax for game phase, abs for integer comparison
@@ -398,11 +399,11 @@ int evaluate(const Board* board, NNUEAccumulator* nnue_acc, const NNUENetwork* n
         #ifdef DEBUG_NNUE_EVAL
         nnue_materialize_accumulator(board, nnue_acc, nnue_net);
         // Verify accumulator matches refresh
-        NNUEAccumulator temp_acc;
+        NNUEAccumulator temp_acc = {0};  // no cache: compare against a true full refresh
         nnue_refresh_accumulator(board, &temp_acc, nnue_net);
         
         bool mismatch = false;
-        for (int i = 0; i < NNUE_HIDDEN_SIZE; i++) {
+        for (int i = 0; i < nnue_net->hidden_size; i++) {
             if (nnue_acc->white[i] != temp_acc.white[i] || 
                 nnue_acc->black[i] != temp_acc.black[i]) {
                 mismatch = true;
@@ -413,8 +414,21 @@ int evaluate(const Board* board, NNUEAccumulator* nnue_acc, const NNUENetwork* n
             printf("info string EVAL MISMATCH! last_move=%u from=%d to=%d\n", 
                    g_last_move, g_last_from, g_last_to);
             // Use the correct (refreshed) value
+            NNUEFinnyTable* cache = nnue_acc->cache;
             memcpy(nnue_acc, &temp_acc, sizeof(NNUEAccumulator));
+            nnue_acc->cache = cache;
         }
+        // Verify the SIMD output layer against the exact scalar one
+        NNUENetwork exact_net = *nnue_net;
+        exact_net.output_fast = false;
+        int simd_eval = nnue_evaluate(board, nnue_acc, nnue_net);
+        int exact_eval = nnue_evaluate(board, nnue_acc, &exact_net);
+        if (simd_eval != exact_eval) {
+            printf("info string OUTPUT MISMATCH! kernel %s: %d, exact: %d\n",
+                   nnue_kernels.name, simd_eval, exact_eval);
+            return exact_eval;
+        }
+        return simd_eval;
         #endif
         return nnue_evaluate(board, nnue_acc, nnue_net);
     }
@@ -0,0 +1,134 @@
+#include "game.h"
+#include "bitboard_utils.h"
+#include "move_generator.h"
+#include "syzygy.h"
+#include <pthread.h>
+
+void reset_position_history(PositionHistory* history) {
+    history->count = 0;
+}
+
+void record_position(PositionHistory* history, uint64_t hash) {
+    if (history->count < MAX_POSITION_HISTORY) {
+        history->keys[history->count++] = hash;
+    }
+}
+
+static int count_position_repetitions(const PositionHistory* history, uint64_t hash) {
+    int count = 0;
+    for (int i = 0; i < history->count; i++) {
+        if (history->keys[i] == hash) count++;
+    }
+    return count;
+}
+
+bool is_insufficient_material(const Board* board) {
+    // Count pieces
+    int white_pawns = __builtin_popcountll(board->whitePawns);
+    int black_pawns = __builtin_popcountll(board->blackPawns);
+    int white_rooks = __builtin_popcountll(board->whiteRooks);
+    int black_rooks = __builtin_popcountll(board->blackRooks);
+    int white_queens = __builtin_popcountll(board->whiteQueens);
+    int black_queens = __builtin_popcountll(board->blackQueens);
+    int white_knights = __builtin_popcountll(board->whiteKnights);
+    int black_knights = __builtin_popcountll(board->blackKnights);
+    int white_bishops = __builtin_popcountll(board->whiteBishops);
+    int black_bishops = __builtin_popcountll(board->blackBishops);
+    
+    // If there are pawns, rooks, or queens, sufficient material
+    if (white_pawns || black_pawns || white_rooks || black_rooks || 
+        white_queens || black_queens) {
+        return false;
+    }
+    
+    int white_minor = white_knights + white_bishops;
+    int black_minor = black_knights + black_bishops;
+    
+    // King vs King
+    if (white_minor == 0 && black_minor == 0) return true;
+    
+    // King + minor vs King
+    if ((white_minor == 1 && black_minor == 0) ||
+        (white_minor == 0 && black_minor == 1)) return true;
+    
+    // King + Bishop vs King + Bishop (same color bishops)
+    if (white_knights == 0 && black_knights == 0 &&
+        white_bishops == 1 && black_bishops == 1) {
+        // Check if bishops are on same color
+        int white_bishop_sq = __builtin_ctzll(board->whiteBishops);
+        int black_bishop_sq = __builtin_ctzll(board->blackBishops);
+        int white_color = (white_bishop_sq / 8 + white_bishop_sq % 8) % 2;
+        int black_color = (black_bishop_sq / 8 + black_bishop_sq % 8) % 2;
+        if (white_color == black_color) return true;
+    }
+    
+    return false;
+}
+
+GameResult check_game_result(const Board* board, int half_move_clock, int draw_threshold,
+                             MoveList* moves, const PositionHistory* history) {
+    generateLegalMoves(board, moves);
+    
+    // Check for checkmate or stalemate
+    if (moves->count == 0) {
+        if (board->checkers) {
+            // Checkmate
+            return board->whiteToMove ? GAME_BLACK_WINS : GAME_WHITE_WINS;
+        } else {
+            // Stalemate
+            return GAME_DRAW;
+        }
+    }
+    
+    // 50-move rule
+    if (half_move_clock >= draw_threshold * 2) {
+        return GAME_DRAW;
+    }
+    
+    // Insufficient material
+    if (is_insufficient_material(board)) {
+        return GAME_DRAW;
+    }
+    
+    // Threefold repetition. The position just reached is recorded at the top
+    // of the NEXT game-loop iteration, so it is not in the history yet
+    // and counts as one occurrence itself. Without the +1 this adjudicated
+    // only on the 4th occurrence - one full repetition cycle too late (a
+    // hung search on the 3rd occurrence is what stalled instances for hours).
+    if (count_position_repetitions(history, board->zobristKey) + 1 >= 3) {
+        return GAME_DRAW;
+    }
+    
+    return GAME_ONGOING;
+}
+
+// syzygy_probe_play() uses Fathom's root probe, which is not thread-safe
+static pthread_mutex_t tb_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+bool game_tb_adjudicate(const Board* board, int probe_limit, GameResult* result,
+                        int* wdl, int* dtz) {
+    if (syzygy_max_pieces() == 0 || board->castlingRights != NO_CASTLING ||
+        isKingAttacked(board, !board->whiteToMove)) {
+        return false;
+    }
+    Bitboard occ =
+        board->byTypeBB[WHITE][PAWN]   | board->byTypeBB[BLACK][PAWN]   |
+        board->byTypeBB[WHITE][KNIGHT] | board->byTypeBB[BLACK][KNIGHT] |
+        board->byTypeBB[WHITE][BISHOP] | board->byTypeBB[BLACK][BISHOP] |
+        board->byTypeBB[WHITE][ROOK]   | board->byTypeBB[BLACK][ROOK]   |
+        board->byTypeBB[WHITE][QUEEN]  | board->byTypeBB[BLACK][QUEEN]  |
+        board->byTypeBB[WHITE][KING]   | board->byTypeBB[BLACK][KING];
+    int pieces = POPCOUNT(occ);
+    if (pieces > probe_limit || !syzygy_available(pieces)) return false;
+
+    Move move = 0;
+    pthread_mutex_lock(&tb_mutex);
+    int res = syzygy_probe_play(board, &move, wdl, dtz);
+    pthread_mutex_unlock(&tb_mutex);
+    if (res != 1) return false;
+
+    int white_wdl = board->whiteToMove ? *wdl : -*wdl;
+    *result = white_wdl > 0 ? GAME_WHITE_WINS
+            : white_wdl < 0 ? GAME_BLACK_WINS : GAME_DRAW;
+    return true;
+}
@@ -0,0 +1,48 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include "board.h"
+#include "move.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// =============================================================================
+// Game rules for the self-play drivers (training generator, match runner)
+//
+// Game-over detection over a plain position history, plus tablebase
+// adjudication that serialises Fathom's root probe for worker threads.
+// =============================================================================
+
+typedef enum {
+    GAME_ONGOING,
+    GAME_WHITE_WINS,
+    GAME_BLACK_WINS,
+    GAME_DRAW
+} GameResult;
+
+// Zobrist keys of every position of the game so far (repetition check)
+#define MAX_POSITION_HISTORY 1024
+typedef struct {
+    uint64_t keys[MAX_POSITION_HISTORY];
+    int count;
+} PositionHistory;
+
+void reset_position_history(PositionHistory* history);
+void record_position(PositionHistory* history, uint64_t hash);
+
+// Neither side can mate: K vs K, K+minor vs K, K+B vs K+B on one colour
+bool is_insufficient_material(const Board* board);
+
+// Fills moves with the legal moves of board (the position just reached, not
+// yet recorded) and checks mate, stalemate, draw_threshold moves without
+// pawn move or capture, insufficient material and threefold repetition.
+GameResult check_game_result(const Board* board, int half_move_clock, int draw_threshold,
+                             MoveList* moves, const PositionHistory* history);
+
+// Exact result of a position within the loaded tablebases and at most
+// probe_limit pieces (no castling rights, legal side to move); false
+// otherwise. Safe to call from several threads.
+bool game_tb_adjudicate(const Board* board, int probe_limit, GameResult* result,
+                        int* wdl, int* dtz);
+
+#endif // GAME_H
@@ -10,13 +10,19 @@
 
 int main(int argc, char const *argv[])
 {
-   (void)argc;
-   (void)argv;
+   // Command line arguments form one command that is run instead of the
+   // UCI loop, e.g. "sleepmind bench 12 16 1"
+   char command[512] = "";
+   for (int i = 1; i < argc; i++) {
+      if (i > 1) strncat(command, " ", sizeof(command) - strlen(command) - 1);
+      strncat(command, argv[i], sizeof(command) - strlen(command) - 1);
+   }
+
    init_zobrist_keys(); // Initialize Zobrist hashing keys
-   init_tt(256);        // Initialize transposition table with 256MB size
+   init_tt(TT_DEFAULT_MB); // Initialize transposition table (resized by the Hash option)
    // initMoveGenerator() is called in uci_loop() - don't call it twice
    
-   uci_loop(); // Start the UCI loop - handles NNUE initialization and move generator init
+   uci_loop(argc > 1 ? command : NULL); // Start the UCI loop - handles NNUE initialization and move generator init
 
     return 0;
 }
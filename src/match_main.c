@@ -0,0 +1,1137 @@
+// posix_memalign needs POSIX visibility under -std=c11
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <getopt.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "board.h"
+#include "board_io.h"
+#include "move.h"
+#include "move_generator.h"
+#include "board_modifiers.h"
+#include "search.h"
+#include "bitboard_utils.h"
+#include "nnue.h"
+#include "evaluation.h"
+#include "zobrist.h"
+#include "tt.h"
+#include "syzygy.h"
+#include "game.h"
+#include "san.h"
+
+// =============================================================================
+// Engine-vs-engine match runner
+//
+// Game threads play colour-swapped pairs of games in-process: engine A and
+// engine B are two SearchParams sets on the same NNUE network, each with its
+// own SearchInfo and transposition table slice. Openings come from a PGN or
+// EPD book (or random plies). Every finished pair is printed as one line
+//
+//     pair <id> score <A's score 0..1> <result A white> <result A black>
+//
+// either for a fixed number of pairs (optionally stopped by an SPRT), or, with
+// --serve, for requests read from stdin so a tuner can stream θ+/θ- pairs.
+// =============================================================================
+
+#define MAX_MATCH_THREADS 256
+#define MAX_BOOK_PLIES    32
+#define MATCH_MAX_PLIES   (MAX_POSITION_HISTORY - 1)
+#define REQUEST_LINE_MAX  8192
+
+static const char* const START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+typedef struct {
+    int pairs;                  // pairs to play (batch mode)
+    int threads;                // game threads, one pair each
+    int search_depth;           // per move (used when no other limit is set)
+    long search_time_ms;        // per move, 0 = off
+    uint64_t search_nodes;      // per move, 0 = off
+    long tc_base_ms;            // clock per game, 0 = no clock
+    long tc_inc_ms;
+    char book_file[1024];       // .pgn or EPD/FEN lines, empty = random openings
+    int book_plies;             // PGN moves used per opening
+    int random_plies;           // random opening plies without a book
+    int adjudicate_threshold;   // pawns both engines must agree on, 0 = off
+    int max_game_plies;         // draw after these plies
+    char syzygy_path[1024];     // tablebases for adjudication, empty = off
+    int syzygy_probe_limit;
+    int hash_mb;                // per engine and thread
+    char pgn_file[1024];        // games appended here, empty = off
+    bool sprt;
+    double elo0, elo1, alpha, beta;
+    bool serve;                 // pair requests from stdin
+    uint64_t seed;
+    int verbose;
+} MatchConfig;
+
+static MatchConfig config = {
+    .pairs = 100,
+    .threads = 1,
+    .search_depth = 8,
+    .search_time_ms = 0,
+    .search_nodes = 0,
+    .tc_base_ms = 0,
+    .tc_inc_ms = 0,
+    .book_file = "",
+    .book_plies = 8,
+    .random_plies = 8,
+    .adjudicate_threshold = 10,
+    .max_game_plies = 500,
+    .syzygy_path = "",
+    .syzygy_probe_limit = 7,
+    .hash_mb = 16,
+    .pgn_file = "",
+    .sprt = false,
+    .elo0 = 0.0, .elo1 = 5.0, .alpha = 0.05, .beta = 0.05,
+    .serve = false,
+    .seed = 0,
+    .verbose = 1
+};
+
+static SearchParams params_a, params_b;  // batch mode
+
+static atomic_bool should_stop = false;
+
+void signal_handler(int sig) {
+    (void)sig;
+    atomic_store(&should_stop, true);
+}
+
+static uint64_t rng_next(uint64_t* state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+// "Name=value,Name=value", "@file" with one "Name=value" per line ('#' =
+// comment, the uci_options.txt format of the variant scripts) or "-" for the
+// defaults, applied on top of *params. False with a message in err.
+static bool parse_param_assignment(SearchParams* params, char* item, char* err, size_t err_size) {
+    while (isspace((unsigned char)*item)) item++;
+    size_t len = strlen(item);
+    while (len > 0 && isspace((unsigned char)item[len - 1])) item[--len] = '\0';
+    if (len == 0 || item[0] == '#') return true;
+    char* eq = strchr(item, '=');
+    if (eq == NULL) {
+        snprintf(err, err_size, "expected Name=value, got '%s'", item);
+        return false;
+    }
+    *eq = '\0';
+    if (!search_params_set(params, item, eq + 1)) {
+        snprintf(err, err_size, "unknown parameter '%s'", item);
+        return false;
+    }
+    return true;
+}
+
+static bool parse_param_spec(SearchParams* params, const char* spec, char* err, size_t err_size) {
+    if (strcmp(spec, "-") == 0) return true;
+    if (spec[0] == '@') {
+        FILE* f = fopen(spec + 1, "r");
+        if (f == NULL) {
+            snprintf(err, err_size, "cannot open %s", spec + 1);
+            return false;
+        }
+        char line[256];
+        bool ok = true;
+        while (ok && fgets(line, sizeof(line), f)) {
+            ok = parse_param_assignment(params, line, err, err_size);
+        }
+        fclose(f);
+        return ok;
+    }
+    char buffer[REQUEST_LINE_MAX];
+    snprintf(buffer, sizeof(buffer), "%s", spec);
+    char* save = NULL;
+    for (char* item = strtok_r(buffer, ",", &save); item != NULL; item = strtok_r(NULL, ",", &save)) {
+        if (!parse_param_assignment(params, item, err, err_size)) return false;
+    }
+    return true;
+}
+
+// =============================================================================
+// Opening book
+// =============================================================================
+
+typedef struct {
+    char fen[128];              // "" = start position
+    Move moves[MAX_BOOK_PLIES];
+    int count;
+} Opening;
+
+typedef struct {
+    Opening* openings;
+    int count;
+    int capacity;
+    int skipped;                // unreadable games / positions
+} Book;
+
+static Book book = {NULL, 0, 0, 0};
+static atomic_int next_opening = 0;
+
+static bool book_add(const Opening* opening) {
+    if (book.count == book.capacity) {
+        int capacity = book.capacity ? book.capacity * 2 : 1024;
+        Opening* grown = (Opening*)realloc(book.openings, (size_t)capacity * sizeof(Opening));
+        if (grown == NULL) return false;
+        book.openings = grown;
+        book.capacity = capacity;
+    }
+    book.openings[book.count++] = *opening;
+    return true;
+}
+
+// A position both sides can play from: one king each, side not to move
+// not in check
+static bool playable_position(const Board* board) {
+    return POPCOUNT(board->byTypeBB[WHITE][KING]) == 1 &&
+           POPCOUNT(board->byTypeBB[BLACK][KING]) == 1 &&
+           !isKingAttacked(board, !board->whiteToMove);
+}
+
+// Four FEN fields, the move counters if present, anything after is ignored
+static bool parse_book_fen(char* line, Opening* opening) {
+    char* fields[6];
+    int n = 0;
+    char* save = NULL;
+    for (char* tok = strtok_r(line, " \t\r\n", &save); tok != NULL && n < 6; tok = strtok_r(NULL, " \t\r\n", &save)) {
+        fields[n++] = tok;
+    }
+    if (n < 4) return false;
+    bool counters = n == 6 && isdigit((unsigned char)fields[4][0]) && isdigit((unsigned char)fields[5][0]);
+    snprintf(opening->fen, sizeof(opening->fen), "%s %s %s %s %s %s", fields[0], fields[1], fields[2],
+             fields[3], counters ? fields[4] : "0", counters ? fields[5] : "1");
+    opening->count = 0;
+    Board board = parseFEN(opening->fen);
+    return playable_position(&board);
+}
+
+static bool load_epd_book(FILE* f) {
+    char line[1024];
+    while (fgets(line, sizeof(line), f)) {
+        char* text = line;
+        while (isspace((unsigned char)*text)) text++;
+        if (*text == '\0' || *text == '#') continue;
+        Opening opening;
+        if (!parse_book_fen(text, &opening)) {
+            book.skipped++;
+        } else if (!book_add(&opening)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// PGN reader state for one game
+typedef struct {
+    Opening opening;
+    Board board;
+    StateInfo states[MAX_BOOK_PLIES];
+    bool started;               // board set up (first move seen)
+    bool in_game;               // movetext seen
+    bool bad;                   // a move within the first book_plies was not legal
+} PgnGame;
+
+static void pgn_reset(PgnGame* g) {
+    g->opening.fen[0] = '\0';
+    g->opening.count = 0;
+    g->started = false;
+    g->in_game = false;
+    g->bad = false;
+}
+
+static bool pgn_finish(PgnGame* g) {
+    bool ok = true;
+    if (g->in_game) {
+        if (g->bad) book.skipped++;
+        else ok = book_add(&g->opening);
+    }
+    pgn_reset(g);
+    return ok;
+}
+
+static void pgn_move(PgnGame* g, const char* token) {
+    g->in_game = true;
+    if (g->bad || g->opening.count >= config.book_plies) return;
+    if (!g->started) {
+        g->board = parseFEN(g->opening.fen[0] ? g->opening.fen : START_FEN);
+        g->started = true;
+        if (!playable_position(&g->board)) {
+            g->bad = true;
+            return;
+        }
+    }
+    MoveList legal;
+    generateLegalMoves(&g->board, &legal);
+    Move m = parse_san_move(&g->board, &legal, token);
+    if (m == 0) {
+        g->bad = true;
+        return;
+    }
+    applyMove(&g->board, m, &g->states[g->opening.count], NULL, NULL);
+    g->opening.moves[g->opening.count++] = m;
+}
+
+// Headers (only [FEN] is used), movetext with comments, variations, NAGs
+// and move numbers; games end at a result token or the next header
+static bool load_pgn_book(FILE* f) {
+    PgnGame* g = (PgnGame*)malloc(sizeof(PgnGame));
+    if (g == NULL) return false;
+    pgn_reset(g);
+    bool ok = true;
+    int variation_depth = 0;
+    bool in_comment = false;
+    char line[4096];
+    while (ok && fgets(line, sizeof(line), f)) {
+        char* p = line;
+        if (!in_comment && variation_depth == 0 && (*p == '%' || *p == '[')) {
+            if (*p == '[') {
+                if (g->in_game) ok = pgn_finish(g);
+                char tag[32], value[128];
+                if (sscanf(p, "[%31s \"%127[^\"]\"", tag, value) == 2 && strcmp(tag, "FEN") == 0) {
+                    snprintf(g->opening.fen, sizeof(g->opening.fen), "%s", value);
+                }
+            }
+            continue;
+        }
+        while (*p) {
+            if (in_comment) {
+                if (*p++ == '}') in_comment = false;
+                continue;
+            }
+            if (isspace((unsigned char)*p)) { p++; continue; }
+            if (*p == '{') { in_comment = true; p++; continue; }
+            if (*p == ';') break;
+            if (*p == '(') { variation_depth++; p++; continue; }
+            if (*p == ')') { if (variation_depth > 0) variation_depth--; p++; continue; }
+
+            char token[64];
+            size_t n = 0;
+            while (*p && !isspace((unsigned char)*p) && !strchr("{};()", *p)) {
+                if (n + 1 < sizeof(token)) token[n++] = *p;
+                p++;
+            }
+            token[n] = '\0';
+            if (variation_depth > 0 || token[0] == '$') continue;
+            if (strcmp(token, "1-0") == 0 || strcmp(token, "0-1") == 0 ||
+                strcmp(token, "1/2-1/2") == 0 || strcmp(token, "*") == 0) {
+                ok = pgn_finish(g);
+                continue;
+            }
+            // "12." / "12..." / "12.e4"
+            char* move = token;
+            while (isdigit((unsigned char)*move)) move++;
+            if (*move == '.') {
+                while (*move == '.') move++;
+            } else {
+                move = token;
+            }
+            if (*move) pgn_move(g, move);
+        }
+    }
+    if (ok) ok = pgn_finish(g);
+    free(g);
+    return ok;
+}
+
+static bool load_book(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "Error: Cannot open opening book %s\n", path);
+        return false;
+    }
+    size_t len = strlen(path);
+    bool pgn = len >= 4 && strcasecmp(path + len - 4, ".pgn") == 0;
+    bool ok = pgn ? load_pgn_book(f) : load_epd_book(f);
+    fclose(f);
+    if (!ok) {
+        fprintf(stderr, "Error: Out of memory reading %s\n", path);
+        return false;
+    }
+    if (book.count == 0) {
+        fprintf(stderr, "Error: No usable openings in %s\n", path);
+        return false;
+    }
+    // Shuffled once, then played in order: every opening before a repeat
+    uint64_t rng = config.seed | 1;
+    for (int i = book.count - 1; i > 0; i--) {
+        int j = (int)(rng_next(&rng) % (uint64_t)(i + 1));
+        Opening tmp = book.openings[i];
+        book.openings[i] = book.openings[j];
+        book.openings[j] = tmp;
+    }
+    return true;
+}
+
+// Uniformly random legal plies from the start position
+static void random_opening(Opening* opening, uint64_t* rng) {
+    Board board = parseFEN(START_FEN);
+    StateInfo states[MAX_BOOK_PLIES];
+    opening->fen[0] = '\0';
+    opening->count = 0;
+    int plies = config.random_plies < MAX_BOOK_PLIES ? config.random_plies : MAX_BOOK_PLIES;
+    while (opening->count < plies) {
+        MoveList legal;
+        generateLegalMoves(&board, &legal);
+        if (legal.count == 0) break;
+        Move m = legal.moves[rng_next(rng) % (uint64_t)legal.count];
+        applyMove(&board, m, &states[opening->count], NULL, NULL);
+        opening->moves[opening->count++] = m;
+    }
+}
+
+// =============================================================================
+// Jobs: a pair of games between two parameter sets
+// =============================================================================
+
+typedef struct Job {
+    struct Job* next;
+    long long id;
+    SearchParams params[2];     // engine A, engine B
+} Job;
+
+// --serve: requests queued by the main thread
+static pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+static Job* queue_head = NULL;
+static Job* queue_tail = NULL;
+static bool queue_closed = false;
+
+static atomic_int next_pair = 1;  // batch mode
+
+static void queue_job(Job* job) {
+    pthread_mutex_lock(&queue_mutex);
+    job->next = NULL;
+    if (queue_tail) queue_tail->next = job;
+    else queue_head = job;
+    queue_tail = job;
+    pthread_cond_signal(&queue_cond);
+    pthread_mutex_unlock(&queue_mutex);
+}
+
+static void close_queue(void) {
+    pthread_mutex_lock(&queue_mutex);
+    queue_closed = true;
+    pthread_cond_broadcast(&queue_cond);
+    pthread_mutex_unlock(&queue_mutex);
+}
+
+// Next pair for a game thread into *job; false when there is none left
+static bool next_job(Job* job) {
+    if (atomic_load(&should_stop)) return false;
+    if (!config.serve) {
+        int id = atomic_fetch_add(&next_pair, 1);
+        if (id > config.pairs) return false;
+        job->id = id;
+        job->params[0] = params_a;
+        job->params[1] = params_b;
+        return true;
+    }
+    pthread_mutex_lock(&queue_mutex);
+    while (!queue_head && !queue_closed) {
+        pthread_cond_wait(&queue_cond, &queue_mutex);
+    }
+    Job* queued = queue_head;
+    if (queued) {
+        queue_head = queued->next;
+        if (!queue_head) queue_tail = NULL;
+    }
+    pthread_mutex_unlock(&queue_mutex);
+    if (!queued) return false;
+    *job = *queued;
+    free(queued);
+    return true;
+}
+
+// =============================================================================
+// Results
+// =============================================================================
+
+static pthread_mutex_t result_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int pentanomial[5];      // pairs by A's points x2: 0, 0.5, 1, 1.5, 2
+static int wins_a, losses_a, draws;
+static uint64_t total_nodes = 0;
+static bool sprt_done = false;
+static bool sprt_h1 = false;      // verdict when sprt_done
+static FILE* pgn_out = NULL;
+
+static double elo_from_score(double score) {
+    if (score < 1e-4) score = 1e-4;
+    if (score > 1.0 - 1e-4) score = 1.0 - 1e-4;
+    return 400.0 * log10(score / (1.0 - score));
+}
+
+// Mean and variance of the per-pair score (0, 1/4, ..., 1)
+static int pair_stats(double* mean, double* variance) {
+    int n = 0;
+    double sum = 0.0;
+    for (int i = 0; i < 5; i++) {
+        n += pentanomial[i];
+        sum += pentanomial[i] * (i / 4.0);
+    }
+    *mean = n > 0 ? sum / n : 0.5;
+    *variance = 0.0;
+    for (int i = 0; i < 5; i++) {
+        double d = i / 4.0 - *mean;
+        *variance += pentanomial[i] * d * d;
+    }
+    if (n > 0) *variance /= n;
+    return n;
+}
+
+// GSPRT log-likelihood ratio of elo1 against elo0 (logistic Elo) on the
+// pentanomial pair results
+static double sprt_llr(void) {
+    double mean, variance;
+    int n = pair_stats(&mean, &variance);
+    if (n == 0 || variance <= 0.0) return 0.0;
+    double s0 = 1.0 / (1.0 + pow(10.0, -config.elo0 / 400.0));
+    double s1 = 1.0 / (1.0 + pow(10.0, -config.elo1 / 400.0));
+    return n * (s1 - s0) * (2.0 * mean - s0 - s1) / (2.0 * variance);
+}
+
+static void print_score(void) {
+    double mean, variance;
+    int n = pair_stats(&mean, &variance);
+    int games = wins_a + losses_a + draws;
+    double margin = n > 0 ? 1.96 * sqrt(variance / n) : 0.0;
+    double elo = elo_from_score(mean);
+    double error = (elo_from_score(mean + margin) - elo_from_score(mean - margin)) / 2.0;
+    printf("Score of A vs B: %d - %d - %d  [%.3f] %d games, Elo %.1f +/- %.1f, pentanomial %d %d %d %d %d",
+           wins_a, losses_a, draws, games > 0 ? (wins_a + 0.5 * draws) / games : 0.5, games,
+           elo, error, pentanomial[0], pentanomial[1], pentanomial[2], pentanomial[3], pentanomial[4]);
+    if (config.sprt) {
+        printf(", LLR %.2f (%.2f, %.2f) [%.1f, %.1f]", sprt_llr(),
+               log(config.beta / (1.0 - config.alpha)), log((1.0 - config.beta) / config.alpha),
+               config.elo0, config.elo1);
+    }
+    printf("\n");
+}
+
+static const char* result_string(GameResult result) {
+    return result == GAME_WHITE_WINS ? "1-0" : result == GAME_BLACK_WINS ? "0-1" : "1/2-1/2";
+}
+
+// Points of the engine playing white
+static double white_points(GameResult result) {
+    return result == GAME_WHITE_WINS ? 1.0 : result == GAME_BLACK_WINS ? 0.0 : 0.5;
+}
+
+static void report_pair(long long id, GameResult first, GameResult second, uint64_t nodes) {
+    // A is white in the first game and black in the second
+    double points = white_points(first) + (1.0 - white_points(second));
+    pthread_mutex_lock(&result_mutex);
+    pentanomial[(int)(points * 2.0 + 0.5)]++;
+    for (int g = 0; g < 2; g++) {
+        double a = g == 0 ? white_points(first) : 1.0 - white_points(second);
+        if (a > 0.75) wins_a++;
+        else if (a < 0.25) losses_a++;
+        else draws++;
+    }
+    total_nodes += nodes;
+    printf("pair %lld score %.2f %s %s\n", id, points / 2.0, result_string(first), result_string(second));
+    if (!config.serve && config.verbose >= 1) print_score();
+    if (config.sprt && !sprt_done) {
+        double llr = sprt_llr();
+        if (llr <= log(config.beta / (1.0 - config.alpha)) || llr >= log((1.0 - config.beta) / config.alpha)) {
+            sprt_done = true;
+            sprt_h1 = llr > 0.0;
+            atomic_store(&should_stop, true);
+        }
+    }
+    fflush(stdout);
+    pthread_mutex_unlock(&result_mutex);
+}
+
+static void report_error(long long id, const char* message) {
+    pthread_mutex_lock(&result_mutex);
+    printf("pair %lld error %s\n", id, message);
+    fflush(stdout);
+    pthread_mutex_unlock(&result_mutex);
+}
+
+// =============================================================================
+// Game threads
+//
+// Each thread keeps one SearchInfo per engine across the moves of a game
+// (histories are cleared per game, like ucinewgame) and switches between
+// two TT slices, so neither engine sees the other's entries.
+// =============================================================================
+
+typedef struct {
+    SearchInfo search_info;
+    uint8_t tt_generation;      // of this engine's slice, see tt_switch_slice()
+    long clock_ms;
+} MatchEngine;
+
+typedef struct {
+    MatchEngine engine[2];      // A, B
+    NNUEAccumulator acc;        // of the game board, shared by both engines
+    StateInfo game_states[MAX_GAME_STATES];
+    PositionHistory history;
+    char san[MATCH_MAX_PLIES][SAN_MAX];  // moves for the PGN output
+    uint64_t rng;
+    uint64_t nodes;             // searched in the current pair
+    int id;
+    const NNUENetwork* nnue_network;
+    pthread_t thread;
+} GameThread;
+
+static const char* game_end_reason(const Board* board, const MoveList* legal) {
+    if (legal->count == 0) return board->checkers ? "checkmate" : "stalemate";
+    if (board->halfMoveClock >= 100) return "fifty-move rule";
+    if (is_insufficient_material(board)) return "insufficient material";
+    return "threefold repetition";
+}
+
+static void use_engine(GameThread* t, int e) {
+    tt_switch_slice(2 * t->id + e, 2 * config.threads, &t->engine[e].tt_generation);
+}
+
+static Move search_move(GameThread* t, MatchEngine* engine, Board* board) {
+    SearchInfo* search = &engine->search_info;
+    // Tablebases are not probed inside the search (adjudication covers them)
+    search_info_prepare(search, NULL);
+    if (config.search_nodes > 0) {
+        search->nodeLimit = config.search_nodes;
+    } else if (config.search_time_ms > 0) {
+        search->softTimeLimit = config.search_time_ms;
+        search->hardTimeLimit = config.search_time_ms;
+    } else if (config.tc_base_ms > 0) {
+        search_clock_limits(engine->clock_ms, config.tc_inc_ms, 0,
+                            &search->softTimeLimit, &search->hardTimeLimit);
+        search->timeScaling = true;
+    } else {
+        search->depthLimit = config.search_depth;
+    }
+    t->acc.cache = &search->nnue_cache;
+    search->nnue_acc = &t->acc;
+    search->nnue_net = t->nnue_network;
+    clear_volatile_history(search);
+
+    Move best = iterative_deepening_search(board, search);
+    t->nodes += search->nodesSearched;
+    if (config.tc_base_ms > 0) {
+        engine->clock_ms -= search_current_time_ms() - search->startTimeMs;
+        if (engine->clock_ms >= 0) engine->clock_ms += config.tc_inc_ms;
+    }
+    return best;
+}
+
+static void write_pgn(const GameThread* t, const Opening* opening, long long id, int game,
+                      int white, int plies, GameResult result, const char* reason) {
+    Board start = parseFEN(opening->fen[0] ? opening->fen : START_FEN);
+    pthread_mutex_lock(&result_mutex);
+    fprintf(pgn_out, "[Event \"sleepmind match\"]\n[Round \"%lld.%d\"]\n", id, game);
+    fprintf(pgn_out, "[White \"%s\"]\n[Black \"%s\"]\n[Result \"%s\"]\n",
+            white == 0 ? "A" : "B", white == 0 ? "B" : "A", result_string(result));
+    if (opening->fen[0]) fprintf(pgn_out, "[FEN \"%s\"]\n[SetUp \"1\"]\n", opening->fen);
+    fprintf(pgn_out, "\n");
+    int column = 0;
+    bool white_to_move = start.whiteToMove;
+    int move_number = start.fullMoveNumber;
+    for (int i = 0; i < plies; i++) {
+        char text[32];
+        if (white_to_move) snprintf(text, sizeof(text), "%d. %s", move_number, t->san[i]);
+        else if (i == 0) snprintf(text, sizeof(text), "%d... %s", move_number, t->san[i]);
+        else snprintf(text, sizeof(text), "%s", t->san[i]);
+        int len = (int)strlen(text);
+        if (column > 0 && column + 1 + len > 79) {
+            fprintf(pgn_out, "\n");
+            column = 0;
+        }
+        column += fprintf(pgn_out, "%s%s", column > 0 ? " " : "", text);
+        if (!white_to_move) move_number++;
+        white_to_move = !white_to_move;
+    }
+    fprintf(pgn_out, "%s{%s} %s\n\n", column > 0 ? " " : "", reason, result_string(result));
+    fflush(pgn_out);
+    pthread_mutex_unlock(&result_mutex);
+}
+
+// One game from the opening; white = engine index (0 = A, 1 = B) playing white
+static GameResult play_game(GameThread* t, const Job* job, const Opening* opening, int white, int game) {
+    const NNUENetwork* net = t->nnue_network;
+    Board board = parseFEN(opening->fen[0] ? opening->fen : START_FEN);
+    nnue_reset_accumulator(&board, &t->acc, net);
+    reset_position_history(&t->history);
+    for (int e = 0; e < 2; e++) {
+        use_engine(t, e);
+        clear_tt();  // this engine's slice
+        clear_search_history(&t->engine[e].search_info);
+        t->engine[e].search_info.params = job->params[e];
+        t->engine[e].clock_ms = config.tc_base_ms;
+    }
+
+    MoveList moves;
+    int ply = 0;
+    for (int i = 0; i < opening->count; i++) {
+        record_position(&t->history, board.zobristKey);
+        generateLegalMoves(&board, &moves);
+        move_to_san(&board, &moves, opening->moves[i], t->san[ply]);
+        applyMove(&board, opening->moves[i], &t->game_states[ply % MAX_GAME_STATES], &t->acc, net);
+        ply++;
+    }
+
+    GameResult result = check_game_result(&board, board.halfMoveClock, 50, &moves, &t->history);
+    const char* reason = result != GAME_ONGOING ? game_end_reason(&board, &moves) : "";
+    int last_score = 0;           // white relative, of the previous move
+    bool have_last_score = false;
+    while (result == GAME_ONGOING) {
+        if (ply >= config.max_game_plies || ply >= MATCH_MAX_PLIES) {
+            result = GAME_DRAW;
+            reason = "move limit";
+            break;
+        }
+        record_position(&t->history, board.zobristKey);
+
+        int tb_wdl = 0, tb_dtz = 0;
+        if (game_tb_adjudicate(&board, config.syzygy_probe_limit, &result, &tb_wdl, &tb_dtz)) {
+            reason = "tablebase";
+            break;
+        }
+
+        int e = board.whiteToMove ? white : 1 - white;
+        use_engine(t, e);
+        Move best = search_move(t, &t->engine[e], &board);
+        if (config.tc_base_ms > 0 && t->engine[e].clock_ms < 0) {
+            result = board.whiteToMove ? GAME_BLACK_WINS : GAME_WHITE_WINS;
+            reason = "time forfeit";
+            break;
+        }
+        if (best == 0) best = moves.moves[0];  // never hand out a null move
+
+        // Adjudicate once both engines agree the game is decided
+        int score = t->engine[e].search_info.bestScoreThisIteration;
+        int white_score = board.whiteToMove ? score : -score;
+        int threshold = config.adjudicate_threshold * 100;
+        if (threshold > 0 && have_last_score &&
+            ((white_score >= threshold && last_score >= threshold) ||
+             (white_score <= -threshold && last_score <= -threshold))) {
+            result = white_score > 0 ? GAME_WHITE_WINS : GAME_BLACK_WINS;
+            reason = "adjudication";
+            break;
+        }
+        last_score = white_score;
+        have_last_score = true;
+
+        move_to_san(&board, &moves, best, t->san[ply]);
+        applyMove(&board, best, &t->game_states[ply % MAX_GAME_STATES], &t->acc, net);
+        ply++;
+        result = check_game_result(&board, board.halfMoveClock, 50, &moves, &t->history);
+        if (result != GAME_ONGOING) reason = game_end_reason(&board, &moves);
+    }
+
+    if (config.verbose >= 2) {
+        pthread_mutex_lock(&result_mutex);
+        printf("game %lld.%d %s-%s %s {%s} %d plies\n", job->id, game, white == 0 ? "A" : "B",
+               white == 0 ? "B" : "A", result_string(result), reason, ply);
+        fflush(stdout);
+        pthread_mutex_unlock(&result_mutex);
+    }
+    if (pgn_out != NULL) write_pgn(t, opening, job->id, game, white, ply, result, reason);
+    return result;
+}
+
+static atomic_int threads_running = 0;
+
+static void* game_thread_main(void* arg) {
+    GameThread* t = (GameThread*)arg;
+    Job job;
+    while (next_job(&job)) {
+        Opening opening;
+        if (book.count > 0) {
+            int index = atomic_fetch_add(&next_opening, 1);
+            opening = book.openings[index % book.count];
+        } else {
+            random_opening(&opening, &t->rng);
+        }
+        t->nodes = 0;
+        GameResult first = play_game(t, &job, &opening, 0, 1);
+        if (atomic_load(&should_stop)) break;  // unfinished pair
+        GameResult second = play_game(t, &job, &opening, 1, 2);
+        report_pair(job.id, first, second, t->nodes);
+    }
+    atomic_fetch_sub(&threads_running, 1);
+    return NULL;
+}
+
+// --serve: "<id> <params A> <params B>" per line until EOF
+static void serve_requests(void) {
+    char line[REQUEST_LINE_MAX];
+    while (!atomic_load(&should_stop) && fgets(line, sizeof(line), stdin)) {
+        char* save = NULL;
+        char* id_text = strtok_r(line, " \t\r\n", &save);
+        if (id_text == NULL) continue;
+        char* spec_a = strtok_r(NULL, " \t\r\n", &save);
+        char* spec_b = strtok_r(NULL, " \t\r\n", &save);
+        long long id = atoll(id_text);
+        Job* job = (Job*)malloc(sizeof(Job));
+        if (job == NULL) {
+            report_error(id, "out of memory");
+            continue;
+        }
+        char err[256];
+        job->id = id;
+        search_params_init(&job->params[0]);
+        job->params[1] = job->params[0];
+        if (spec_a == NULL || spec_b == NULL) {
+            snprintf(err, sizeof(err), "expected '<id> <params A> <params B>'");
+        } else if (parse_param_spec(&job->params[0], spec_a, err, sizeof(err)) &&
+                   parse_param_spec(&job->params[1], spec_b, err, sizeof(err))) {
+            queue_job(job);
+            continue;
+        }
+        report_error(id, err);
+        free(job);
+    }
+    close_queue();
+}
+
+// =============================================================================
+// Usage and Argument Parsing
+// =============================================================================
+
+static void print_usage(const char* program_name) {
+    printf("Usage: %s [options]\n", program_name);
+    printf("\nEngines (A and B share the NNUE net, each has its own search parameters):\n");
+    printf("  -A, --params-a SPEC     Parameters of A: Name=value,... or @file (Name=value lines), - = defaults\n");
+    printf("  -B, --params-b SPEC     Parameters of B (same format, default: defaults)\n");
+    printf("\nGames:\n");
+    printf("  -n, --pairs N           Colour-swapped game pairs to play (default: 100)\n");
+    printf("  -T, --threads N         Game threads, one pair each (default: 1)\n");
+    printf("  -d, --depth N           Search depth per move (default: 8)\n");
+    printf("  -t, --time MS           Search time per move in milliseconds (overrides depth)\n");
+    printf("  -N, --nodes N           Search node limit per move (overrides depth and time)\n");
+    printf("  -c, --tc BASE+INC       Clock per game in seconds, e.g. 10+0.1 (overrides depth)\n");
+    printf("  -b, --book FILE         Openings: .pgn games or EPD/FEN lines (default: random plies)\n");
+    printf("  -p, --book-plies N      Plies used from each PGN game (default: 8, max %d)\n", MAX_BOOK_PLIES);
+    printf("  -r, --random-plies N    Random opening plies without a book (default: 8)\n");
+    printf("  -a, --adjudicate N      Adjudicate when both engines see more than N pawns (default: 10, 0=off)\n");
+    printf("  -M, --max-moves N       Draw after N plies (default: 500)\n");
+    printf("  -S, --syzygy-path PATH  Syzygy tablebase path for exact endgame adjudication (default: off)\n");
+    printf("  -L, --syzygy-probe-limit N  Max piece count for TB adjudication (default: 7)\n");
+    printf("  -H, --hash MB           Transposition table per engine and thread (default: 16)\n");
+    printf("  -o, --pgn FILE          Append all games to FILE\n");
+    printf("  -s, --sprt E0,E1[,A,B]  Stop once the SPRT of elo1 against elo0 decides (alpha, beta 0.05)\n");
+    printf("  --seed N                Seed for the book order and random openings (default: time)\n");
+    printf("  -v, --verbose LEVEL     0 = pair lines only, 1 = running score, 2 = every game (default: 1)\n");
+    printf("  --serve                 Play the pairs requested on stdin instead of -n/-A/-B\n");
+    printf("  -h, --help              Show this help message\n");
+    printf("\nOutput, one line per finished pair (A's score 0..1, results with A white / A black):\n");
+    printf("  pair <id> score <score> <result> <result>\n");
+    printf("--serve reads \"<id> <params A> <params B>\" lines and answers each with a pair line\n");
+    printf("(or \"pair <id> error <message>\"); EOF ends the run after the running pairs.\n");
+    printf("\nExample:\n");
+    printf("  %s -b 2moves_v2.pgn -n 500 -T 16 -t 100 -B LMP_Base=7 -s 0,5  # SPRT\n", program_name);
+    printf("  %s --serve -b 2moves_v2.pgn -T 24 -N 20000                  # SPSA driver\n", program_name);
+}
+
+static long parse_seconds_ms(const char* text) {
+    return (long)(atof(text) * 1000.0 + 0.5);
+}
+
+static void parse_arguments(int argc, char* argv[]) {
+    static struct option long_options[] = {
+        {"params-a",           required_argument, 0, 'A'},
+        {"params-b",           required_argument, 0, 'B'},
+        {"pairs",              required_argument, 0, 'n'},
+        {"threads",            required_argument, 0, 'T'},
+        {"depth",              required_argument, 0, 'd'},
+        {"time",               required_argument, 0, 't'},
+        {"nodes",              required_argument, 0, 'N'},
+        {"tc",                 required_argument, 0, 'c'},
+        {"book",               required_argument, 0, 'b'},
+        {"book-plies",         required_argument, 0, 'p'},
+        {"random-plies",       required_argument, 0, 'r'},
+        {"adjudicate",         required_argument, 0, 'a'},
+        {"max-moves",          required_argument, 0, 'M'},
+        {"syzygy-path",        required_argument, 0, 'S'},
+        {"syzygy-probe-limit", required_argument, 0, 'L'},
+        {"hash",               required_argument, 0, 'H'},
+        {"pgn",                required_argument, 0, 'o'},
+        {"sprt",               required_argument, 0, 's'},
+        {"seed",               required_argument, 0, 'Z'},
+        {"verbose",            required_argument, 0, 'v'},
+        {"serve",              no_argument,       0, 'X'},
+        {"help",               no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    char err[256];
+    int c;
+    while ((c = getopt_long(argc, argv, "A:B:n:T:d:t:N:c:b:p:r:a:M:S:L:H:o:s:v:h", long_options, NULL)) != -1) {
+        switch (c) {
+            case 'A':
+            case 'B':
+                if (!parse_param_spec(c == 'A' ? &params_a : &params_b, optarg, err, sizeof(err))) {
+                    fprintf(stderr, "Error: --params-%c: %s\n", c == 'A' ? 'a' : 'b', err);
+                    exit(1);
+                }
+                break;
+            case 'n':
+                config.pairs = atoi(optarg);
+                break;
+            case 'T':
+                config.threads = atoi(optarg);
+                if (config.threads < 1) config.threads = 1;
+                if (config.threads > MAX_MATCH_THREADS) config.threads = MAX_MATCH_THREADS;
+                break;
+            case 'd':
+                config.search_depth = atoi(optarg);
+                break;
+            case 't':
+                config.search_time_ms = atol(optarg);
+                break;
+            case 'N':
+                config.search_nodes = strtoull(optarg, NULL, 10);
+                break;
+            case 'c': {
+                const char* plus = strchr(optarg, '+');
+                config.tc_base_ms = parse_seconds_ms(optarg);
+                config.tc_inc_ms = plus ? parse_seconds_ms(plus + 1) : 0;
+                break;
+            }
+            case 'b':
+                strncpy(config.book_file, optarg, sizeof(config.book_file) - 1);
+                config.book_file[sizeof(config.book_file) - 1] = '\0';
+                break;
+            case 'p':
+                config.book_plies = atoi(optarg);
+                if (config.book_plies < 0) config.book_plies = 0;
+                if (config.book_plies > MAX_BOOK_PLIES) config.book_plies = MAX_BOOK_PLIES;
+                break;
+            case 'r':
+                config.random_plies = atoi(optarg);
+                break;
+            case 'a':
+                config.adjudicate_threshold = atoi(optarg);
+                break;
+            case 'M':
+                config.max_game_plies = atoi(optarg);
+                break;
+            case 'S':
+                strncpy(config.syzygy_path, optarg, sizeof(config.syzygy_path) - 1);
+                config.syzygy_path[sizeof(config.syzygy_path) - 1] = '\0';
+                break;
+            case 'L':
+                config.syzygy_probe_limit = atoi(optarg);
+                break;
+            case 'H':
+                config.hash_mb = atoi(optarg);
+                if (config.hash_mb < 1) config.hash_mb = 1;
+                break;
+            case 'o':
+                strncpy(config.pgn_file, optarg, sizeof(config.pgn_file) - 1);
+                config.pgn_file[sizeof(config.pgn_file) - 1] = '\0';
+                break;
+            case 's': {
+                double v[4] = {0.0, 5.0, 0.05, 0.05};
+                int n = sscanf(optarg, "%lf,%lf,%lf,%lf", &v[0], &v[1], &v[2], &v[3]);
+                if (n < 2 || v[1] <= v[0] || v[2] <= 0.0 || v[2] >= 0.5 || v[3] <= 0.0 || v[3] >= 0.5) {
+                    fprintf(stderr, "Error: --sprt needs ELO0,ELO1[,ALPHA,BETA] with ELO1 > ELO0\n");
+                    exit(1);
+                }
+                config.sprt = true;
+                config.elo0 = v[0];
+                config.elo1 = v[1];
+                config.alpha = v[2];
+                config.beta = v[3];
+                break;
+            }
+            case 'Z':
+                config.seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'v':
+                config.verbose = atoi(optarg);
+                break;
+            case 'X':
+                config.serve = true;
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                exit(0);
+            default:
+                print_usage(argv[0]);
+                exit(1);
+        }
+    }
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+static void print_config(void) {
+    printf("=== Match ===\n");
+    printf("Pairs:             %d (%d games)\n", config.pairs, 2 * config.pairs);
+    printf("Threads:           %d\n", config.threads);
+    if (config.search_nodes > 0) {
+        printf("Search nodes:      %llu\n", (unsigned long long)config.search_nodes);
+    } else if (config.search_time_ms > 0) {
+        printf("Search time:       %ld ms\n", config.search_time_ms);
+    } else if (config.tc_base_ms > 0) {
+        printf("Time control:      %.3g+%.3g s\n", config.tc_base_ms / 1000.0, config.tc_inc_ms / 1000.0);
+    } else {
+        printf("Search depth:      %d\n", config.search_depth);
+    }
+    if (book.count > 0) {
+        printf("Opening book:      %s (%d openings, %d skipped)\n", config.book_file, book.count, book.skipped);
+    } else {
+        printf("Opening book:      none (%d random plies)\n", config.random_plies);
+    }
+    SearchParams defaults;
+    search_params_init(&defaults);
+    for (int e = 0; e < 2; e++) {
+        const SearchParams* p = e == 0 ? &params_a : &params_b;
+        printf("Engine %c:          ", e == 0 ? 'A' : 'B');
+        // The parameters that differ from the defaults
+        int differing = 0;
+        const char* name;
+        for (int i = 0; (name = search_params_name(i)) != NULL; i++) {
+            char value[16], base[16];
+            search_params_get(p, name, value, sizeof(value));
+            search_params_get(&defaults, name, base, sizeof(base));
+            if (strcmp(value, base) != 0) printf("%s%s=%s", differing++ ? " " : "", name, value);
+        }
+        printf("%s\n", differing ? "" : "defaults");
+    }
+    if (config.adjudicate_threshold > 0) {
+        printf("Adjudicate at:     +/-%d pawns (both engines)\n", config.adjudicate_threshold);
+    } else {
+        printf("Adjudicate at:     disabled\n");
+    }
+    if (syzygy_max_pieces() > 0) {
+        printf("Syzygy TB:         %s (adjudicate up to %d pieces, %d loaded)\n",
+               config.syzygy_path, config.syzygy_probe_limit, syzygy_max_pieces());
+    } else {
+        printf("Syzygy TB:         disabled\n");
+    }
+    if (config.sprt) {
+        printf("SPRT:              elo0 %.1f, elo1 %.1f, alpha %.3f, beta %.3f\n",
+               config.elo0, config.elo1, config.alpha, config.beta);
+    }
+    printf("=============\n\n");
+    fflush(stdout);
+}
+
+int main(int argc, char* argv[]) {
+    search_params_init(&params_a);  // builds the shared LMR table before any thread runs
+    params_b = params_a;
+    parse_arguments(argc, argv);
+    if (config.seed == 0) config.seed = (uint64_t)time(NULL) * (uint64_t)getpid();
+
+    signal(SIGTERM, signal_handler);
+    signal(SIGINT, signal_handler);
+
+    init_zobrist_keys();
+    init_tt((size_t)config.hash_mb * 2 * (size_t)config.threads);  // one slice per engine and thread
+    initMoveGenerator();
+    set_search_silent(true);
+
+    NNUENetwork* nnue_network = (NNUENetwork*)calloc(1, sizeof(NNUENetwork));
+    if (!nnue_network) {
+        fprintf(stderr, "Error: Failed to allocate memory for NNUE network\n");
+        return 1;
+    }
+    eval_init(NNUE_DEFAULT_NET, nnue_network);
+    if (!nnue_network->loaded) {
+        printf("Warning: NNUE network not loaded, using classical evaluation\n");
+    }
+    syzygy_init(config.syzygy_path);
+
+    if (config.book_file[0] && !load_book(config.book_file)) return 1;
+    if (config.pgn_file[0]) {
+        pgn_out = fopen(config.pgn_file, "a");
+        if (pgn_out == NULL) {
+            fprintf(stderr, "Error: Cannot open PGN file %s\n", config.pgn_file);
+            return 1;
+        }
+    }
+    if (!config.serve) print_config();
+
+    // Game threads, 64-byte aligned for the NNUE accumulators
+    GameThread* threads[MAX_MATCH_THREADS];
+    int thread_count = 0;
+    for (int i = 0; i < config.threads; i++) {
+        void* mem = NULL;
+        if (posix_memalign(&mem, 64, sizeof(GameThread)) != 0) {
+            fprintf(stderr, "Failed to allocate game thread %d\n", i);
+            break;
+        }
+        memset(mem, 0, sizeof(GameThread));
+        GameThread* t = (GameThread*)mem;
+        t->id = i;
+        t->nnue_network = nnue_network;
+        t->rng = (config.seed ^ ((uint64_t)(i + 1) * 0x9E3779B97F4A7C15ULL)) | 1;  // never 0
+        threads[thread_count++] = t;
+    }
+    if (thread_count == 0) return 1;
+    config.threads = thread_count;  // slice count
+
+    long start_ms = search_current_time_ms();
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, SEARCH_THREAD_STACK_SIZE);
+    int started = 0;
+    atomic_store(&threads_running, thread_count);
+    for (int i = 0; i < thread_count; i++) {
+        if (pthread_create(&threads[i]->thread, &attr, game_thread_main, threads[i]) != 0) {
+            fprintf(stderr, "Failed to start game thread %d\n", i);
+            atomic_store(&threads_running, started);
+            break;
+        }
+        started++;
+    }
+    pthread_attr_destroy(&attr);
+
+    if (config.serve) serve_requests();
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i]->thread, NULL);
+    }
+    double elapsed = (search_current_time_ms() - start_ms) / 1000.0;
+
+    if (!config.serve) {
+        if (atomic_load(&should_stop) && !sprt_done) {
+            printf("\nReceived signal, stopped after the running pairs.\n");
+        }
+        printf("\n=== Summary ===\n");
+        print_score();
+        if (config.sprt) {
+            printf("SPRT: %s\n", !sprt_done ? "no decision"
+                                 : sprt_h1 ? "H1 accepted (elo1)" : "H0 accepted (elo0)");
+        }
+        int games = wins_a + losses_a + draws;
+        if (elapsed > 0 && games > 0) {
+            printf("Total time:      %.1f seconds (%.0f games/hour, %.0f knps)\n", elapsed,
+                   games * 3600.0 / elapsed, total_nodes / elapsed / 1000.0);
+        }
+    }
+
+    for (int i = 0; i < thread_count; i++) {
+        free(threads[i]);
+    }
+    if (pgn_out != NULL) fclose(pgn_out);
+    free(book.openings);
+    syzygy_free();
+    nnue_unload(nnue_network);
+    free(nnue_network);
+    return 0;
+}
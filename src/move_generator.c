@@ -6,31 +6,84 @@
 #include "board_io.h"       // For outputFEN, printBoard
 #include <stdio.h>
 #include <string.h> // For memset
-#include <stdlib.h> // For rand, srand, malloc, calloc, free
-#include <time.h>   // For time() to seed rand
+#include <stdlib.h>
 #include <stdbool.h>// For bool type
+#ifdef __BMI2__
+#include <immintrin.h> // _pext_u64
+#endif
 
 
 // --- Magic Bitboard Data ---
-static Bitboard ROOK_MAGICS[64];
-static Bitboard BISHOP_MAGICS[64];
-
-static Bitboard ROOK_MASKS[64];
-static Bitboard BISHOP_MASKS[64];
-
-// Array of pointers to attack tables. Each table is dynamically allocated.
-static Bitboard* ROOK_ATTACKS_TABLE[64];
-static Bitboard* BISHOP_ATTACKS_TABLE[64];
+// Fixed "fancy" magics: index = ((occupancy & mask) * magic) >> (64 - bits),
+// found once offline (deterministic xorshift search over sparse candidates)
+// for exactly the masks below, so start-up needs no search and the table
+// layout is the same on every run.
+static const Bitboard ROOK_MAGICS[64] = {
+    0x1080004008801020ULL, 0x0840092002c03000ULL, 0x1900200010400900ULL, 0x0880100008000480ULL,
+    0x4200100420080200ULL, 0x8100020100080400ULL, 0x0200040110886200ULL, 0x0200008040220411ULL,
+    0x0404800084400220ULL, 0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+    0x000a001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x0442000102105084ULL,
+    0x9080010020804100ULL, 0x0040404000201009ULL, 0x0000808010002009ULL, 0x2200090021d00100ULL,
+    0x0008008008040080ULL, 0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000a0001768104ULL,
+    0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+    0x0442000a00049020ULL, 0x2100040080020080ULL, 0x0800120400900148ULL, 0x0010040a00128541ULL,
+    0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+    0x0400802402800800ULL, 0xc100020080800400ULL, 0x0002000802000401ULL, 0x0182085882000401ULL,
+    0x0220204000808000ULL, 0x2860100040024022ULL, 0x0001002004110040ULL, 0x99101042000a0020ULL,
+    0x0004080004008080ULL, 0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+    0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040a00300ULL, 0x0801100280080480ULL,
+    0x0242009008200600ULL, 0x1002000489500200ULL, 0x0040800200010080ULL, 0x0091800041000080ULL,
+    0x0000209300488001ULL, 0x04c1002414824001ULL, 0x020020000b001041ULL, 0x7000100004200901ULL,
+    0x8002002004100802ULL, 0x30010002084c0007ULL, 0x0888221800813004ULL, 0x4000002840840112ULL
+};
+static const Bitboard BISHOP_MAGICS[64] = {
+    0xa010041108003100ULL, 0x006082020a002900ULL, 0x6810010619200000ULL, 0x08281a0520000408ULL,
+    0x0001104001000400ULL, 0x0018901008048400ULL, 0x00040a0210245280ULL, 0x000200210808a402ULL,
+    0x9140048410821200ULL, 0x0800091010820041ULL, 0x20504804832202c0ULL, 0x0100091401081000ULL,
+    0x8021011140000012ULL, 0x0810020804450400ULL, 0x208b0542109008a2ULL, 0x0080084a08040204ULL,
+    0x0040e2a80811244cULL, 0x2505022008008108ULL, 0x0430220100420040ULL, 0x010a040420220040ULL,
+    0x1105000290400000ULL, 0x0093001200822120ULL, 0x4000a62048043004ULL, 0x280120048a015004ULL,
+    0x006090002a020814ULL, 0x44042000240800d0ULL, 0x01102800040a4400ULL, 0x1004080080220040ULL,
+    0x0001001011004024ULL, 0x0010044000805040ULL, 0x0914041200820100ULL, 0x0004821012821480ULL,
+    0x0024040500c05021ULL, 0x0088611002080200ULL, 0x0116080a00040020ULL, 0x4000020080080080ULL,
+    0x2450450140840040ULL, 0x0000880201484100ULL, 0x0222020404020092ULL, 0x8081110600002e00ULL,
+    0x2842101105000801ULL, 0x1100809008001025ULL, 0x00020202221c0400ULL, 0x0422014022009020ULL,
+    0x0210046102100c00ULL, 0xc004008082029102ULL, 0x00aa461801101200ULL, 0x0404080080201108ULL,
+    0x020542108c205002ULL, 0x0410544804100100ULL, 0x0040910841100000ULL, 0x0400200042021100ULL,
+    0x00004204850400c0ULL, 0x0200100410a42102ULL, 0x1040020801210102ULL, 0x0805040410420000ULL,
+    0x2884804130100200ULL, 0x800c262201242000ULL, 0x1058000194108800ULL, 0x0014221054420204ULL,
+    0x0104000012a02200ULL, 0x0200881003300100ULL, 0x0140400202840100ULL, 0x0402020801010201ULL
+};
 
-// Number of relevant bits in the mask for each square
-static int ROOK_RELEVANT_BITS[64];
-static int BISHOP_RELEVANT_BITS[64];
+typedef struct {
+    Bitboard mask;             // relevant occupancy (board edges excluded)
+    Bitboard magic;
+    const Bitboard* attacks;   // this square's slice of SLIDER_ATTACKS
+    unsigned shift;            // 64 - popcount(mask)
+} SliderMagic;
+
+// All rook and bishop attack sets in one contiguous table (2^bits entries
+// per square, rooks first), instead of 128 separate allocations
+#define ROOK_ATTACK_ENTRIES   102400
+#define BISHOP_ATTACK_ENTRIES 5248
+static Bitboard SLIDER_ATTACKS[ROOK_ATTACK_ENTRIES + BISHOP_ATTACK_ENTRIES] __attribute__((aligned(64)));
+static SliderMagic ROOK_MAGIC[64] __attribute__((aligned(64)));
+static SliderMagic BISHOP_MAGIC[64] __attribute__((aligned(64)));
+
+// BMI2 builds index with PEXT instead of the multiply when the CPU does it
+// fast (picked in initMoveGenerator). The table layout follows the method.
+static bool use_pext = false;
 
 // --- Precomputed Attack Tables (Non-sliding pieces) ---
 static Bitboard PAWN_ATTACKS[2][64];   // [color][square] (0 for white, 1 for black)
 static Bitboard KNIGHT_ATTACKS[64];
 static Bitboard KING_ATTACKS[64];
 
+// Squares strictly between two aligned squares / the whole line through
+// them (both 0 when the squares share no rank, file or diagonal)
+Bitboard BETWEEN_BB[64][64];
+static Bitboard LINE_BB[64][64];
+
 
 // --- Helper Functions based on User's Example ---
 
@@ -82,19 +135,6 @@ static void clearSquareOnAllBitboards(Board* board, Square sq) {
     board->piece[sq] = NO_PIECE;
 }
 
-// Generate a specific occupancy permutation from an index and a mask
-static Bitboard index_to_occupancy(int index, int bits, Bitboard mask) {
-  Bitboard result = 0ULL;
-  Bitboard temp_mask = mask; // Use a copy to pop bits from
-  for (int i = 0; i < bits; i++) {
-    int sq = pop_lsb(&temp_mask); // Get square from mask's LSB
-    if (index & (1 << i)) {      // If this bit is set in the index
-      result |= (1ULL << sq);  // Set this bit in the occupancy
-    }
-  }
-  return result;
-}
-
 // Mask generation (from user's example, using <7 and >0 for excluding borders)
 static Bitboard generate_rook_mask_user(Square sq) {
     Bitboard result = 0ULL;
@@ -145,200 +185,60 @@ static Bitboard generate_bishop_attacks_otf_user(Square sq, Bitboard blockers) {
     return result;
 }
 
-// Random bitboard generation (adapted from user's reference code)
-static Bitboard random_u64() {
-  Bitboard u1, u2, u3, u4;
-    // Use rand() from stdlib; mask pieces to build a 64-bit value
-    u1 = (Bitboard)(rand()) & 0xFFFFULL;
-    u2 = (Bitboard)(rand()) & 0xFFFFULL;
-    u3 = (Bitboard)(rand()) & 0xFFFFULL;
-    u4 = (Bitboard)(rand()) & 0xFFFFULL;
-  return u1 | (u2 << 16) | (u3 << 32) | (u4 << 48);
-}
-
-static Bitboard random_u64_fewbits() {
-    return random_u64() & random_u64() & random_u64();
-}
-
-// Magic transformation
-static inline unsigned int transform_magic(Bitboard occupancy, Bitboard magic, int relevant_bits) {
-// #define USE_32_BIT_MULTIPLICATIONS // Define this if you want to try the 32-bit path
-#ifdef USE_32_BIT_MULTIPLICATIONS
-    return (unsigned int)(((unsigned int)(occupancy * magic)) >> (32 - relevant_bits));
-#else
-    return (unsigned int)((occupancy * magic) >> (64 - relevant_bits));
+static inline unsigned slider_index(const SliderMagic* m, Bitboard occupancy) {
+#ifdef __BMI2__
+    if (use_pext) return (unsigned)_pext_u64(occupancy, m->mask);
 #endif
+    return (unsigned)(((occupancy & m->mask) * m->magic) >> m->shift);
 }
 
-// Main function to find magic for a square
-static bool find_magic_for_square_user(Square sq, bool is_rook, int max_attempts) {
-    Bitboard mask = is_rook ? ROOK_MASKS[sq] : BISHOP_MASKS[sq];
-    int relevant_bits = is_rook ? ROOK_RELEVANT_BITS[sq] : BISHOP_RELEVANT_BITS[sq];
-    
-    if (relevant_bits == 0 && (is_rook ? ROOK_MASKS[sq] : BISHOP_MASKS[sq]) == 0ULL) { // Edge cases like A1 for bishop mask
-        if (is_rook) {
-            ROOK_MAGICS[sq] = 0ULL; // No magic needed for empty mask
-            ROOK_ATTACKS_TABLE[sq] = (Bitboard*)calloc(1, sizeof(Bitboard)); 
-            if (ROOK_ATTACKS_TABLE[sq]) ROOK_ATTACKS_TABLE[sq][0] = generate_rook_attacks_otf_user(sq, 0ULL);
-            else { printf("Error: Mem alloc for empty mask rook sq %d\n", sq); return false;}
-        } else {
-            BISHOP_MAGICS[sq] = 0ULL;
-            BISHOP_ATTACKS_TABLE[sq] = (Bitboard*)calloc(1, sizeof(Bitboard));
-            if (BISHOP_ATTACKS_TABLE[sq]) BISHOP_ATTACKS_TABLE[sq][0] = generate_bishop_attacks_otf_user(sq, 0ULL);
-            else { printf("Error: Mem alloc for empty mask bishop sq %d\n", sq); return false;}
-        }
-        return true;
-    }
-    if (relevant_bits < 0 || relevant_bits > 15) { // Safety check for table sizes (max 2^15 entries for practical purposes)
-        printf("Error: Invalid relevant_bits %d for sq %d, is_rook %d\n", relevant_bits, sq, is_rook);
-        return false;
-    }
-
-
-    int num_occupancy_states = 1 << relevant_bits;
-
-    Bitboard* occupancies = (Bitboard*)malloc(num_occupancy_states * sizeof(Bitboard));
-    Bitboard* attacks = (Bitboard*)malloc(num_occupancy_states * sizeof(Bitboard));
-    Bitboard* current_attack_table_ptr; // Will point to the dynamically allocated attack table
-
-    size_t attack_table_size_bytes = num_occupancy_states * sizeof(Bitboard);
-    current_attack_table_ptr = (Bitboard*)malloc(attack_table_size_bytes);
-
-    if (is_rook) {
-        ROOK_ATTACKS_TABLE[sq] = current_attack_table_ptr;
-    } else {
-        BISHOP_ATTACKS_TABLE[sq] = current_attack_table_ptr;
-    }
-    
-    if (!occupancies || !attacks || !current_attack_table_ptr) {
-        printf("Error: Memory allocation failed for magic finding (main arrays) on square %d\n", sq);
-        if (occupancies) free(occupancies);
-        if (attacks) free(attacks);
-        if (current_attack_table_ptr) {
-            if (is_rook) ROOK_ATTACKS_TABLE[sq] = NULL; else BISHOP_ATTACKS_TABLE[sq] = NULL;
-            free(current_attack_table_ptr);
-        }
-        return false;
-    }
-
-    for (int i = 0; i < num_occupancy_states; i++) {
-        occupancies[i] = index_to_occupancy(i, relevant_bits, mask);
-        if (is_rook) {
-            attacks[i] = generate_rook_attacks_otf_user(sq, occupancies[i]);
-        } else {
-            attacks[i] = generate_bishop_attacks_otf_user(sq, occupancies[i]);
-        }
-    }
-
-    bool* index_is_used = (bool*)calloc(num_occupancy_states, sizeof(bool));
-     if (!index_is_used) {
-        printf("Error: Memory allocation failed for index_is_used on square %d\n", sq);
-        free(occupancies);
-        free(attacks);
-        if (is_rook && ROOK_ATTACKS_TABLE[sq]) { free(ROOK_ATTACKS_TABLE[sq]); ROOK_ATTACKS_TABLE[sq] = NULL; }
-        if (!is_rook && BISHOP_ATTACKS_TABLE[sq]) { free(BISHOP_ATTACKS_TABLE[sq]); BISHOP_ATTACKS_TABLE[sq] = NULL; }
-        // current_attack_table_ptr was assigned to ROOK/BISHOP_ATTACKS_TABLE[sq]
-        return false;
-    }
-
-    for (int attempt = 0; attempt < max_attempts; attempt++) {
-        Bitboard magic_candidate = random_u64_fewbits();
-        // The original condition from user's code:
-        // if (POPCOUNT((mask * magic_candidate) & 0xFF00000000000000ULL) < 6) continue; // Temporarily disabled
-
-
-        memset(index_is_used, 0, num_occupancy_states * sizeof(bool));
-        memset(current_attack_table_ptr, 0, attack_table_size_bytes); // Clear before trying to fill
-        bool possible_magic = true;
-
-        for (int i = 0; i < num_occupancy_states; i++) {
-            unsigned int magic_index = transform_magic(occupancies[i], magic_candidate, relevant_bits);
-            
-            if (magic_index >= (unsigned int)num_occupancy_states) { // Should not happen if relevant_bits is correct for transform
-                 possible_magic = false; break;
-            }
-
-            if (!index_is_used[magic_index]) {
-                current_attack_table_ptr[magic_index] = attacks[i];
-                index_is_used[magic_index] = true;
-            } else if (current_attack_table_ptr[magic_index] != attacks[i]) {
-                possible_magic = false;
-                break;
-            }
-        }
-
-        if (possible_magic) {
-            if (is_rook) {
-                ROOK_MAGICS[sq] = magic_candidate;
-            } else {
-                BISHOP_MAGICS[sq] = magic_candidate;
-            }
-            free(occupancies);
-            free(attacks);
-            free(index_is_used);
-            return true;
+// Fill SLIDER_ATTACKS from the fixed magics (or PEXT), enumerating every
+// subset of each mask with the carry-rippler trick
+static void init_slider_attacks(void) {
+#ifdef __BMI2__
+    // PEXT is microcoded and much slower than the multiply before Zen 3
+    __builtin_cpu_init();
+    use_pext = __builtin_cpu_supports("bmi2") &&
+               !__builtin_cpu_is("znver1") && !__builtin_cpu_is("znver2");
+#endif
+    Bitboard* next = SLIDER_ATTACKS;
+    for (int is_rook = 1; is_rook >= 0; is_rook--) {
+        for (Square sq = 0; sq < 64; sq++) {
+            SliderMagic* m = is_rook ? &ROOK_MAGIC[sq] : &BISHOP_MAGIC[sq];
+            m->mask = is_rook ? generate_rook_mask_user(sq) : generate_bishop_mask_user(sq);
+            m->magic = is_rook ? ROOK_MAGICS[sq] : BISHOP_MAGICS[sq];
+            m->shift = 64 - POPCOUNT(m->mask);
+            m->attacks = next;
+
+            Bitboard subset = 0;
+            do {
+                next[slider_index(m, subset)] = is_rook ? generate_rook_attacks_otf_user(sq, subset)
+                                                        : generate_bishop_attacks_otf_user(sq, subset);
+                subset = (subset - m->mask) & m->mask;
+            } while (subset);
+            next += 1ULL << POPCOUNT(m->mask);
         }
     }
-
-    free(occupancies);
-    free(attacks);
-    free(index_is_used);
-    // If magic not found, free the allocated attack table
-    if (is_rook && ROOK_ATTACKS_TABLE[sq]) { free(ROOK_ATTACKS_TABLE[sq]); ROOK_ATTACKS_TABLE[sq] = NULL; }
-    if (!is_rook && BISHOP_ATTACKS_TABLE[sq]) { free(BISHOP_ATTACKS_TABLE[sq]); BISHOP_ATTACKS_TABLE[sq] = NULL; }
-    return false;
+    printf("info string Slider attacks: %s\n", use_pext ? "pext" : "magic");
 }
 
-bool findAndInitMagicNumbers() {
-    srand((unsigned int)time(NULL)); // Seed rand()
-    printf("Attempting to find magic numbers (user logic, corrected random)... This may take a while.\n");
-    int magicAttemptsPerSquare = 10000000; // Kept high, but should succeed faster if logic is good.
-
-    for (Square sq = 0; sq < 64; sq++) {
-        ROOK_MAGICS[sq] = 0ULL; // Reset
-        BISHOP_MAGICS[sq] = 0ULL;
-        if(ROOK_ATTACKS_TABLE[sq]) { free(ROOK_ATTACKS_TABLE[sq]); ROOK_ATTACKS_TABLE[sq] = NULL; }
-        if(BISHOP_ATTACKS_TABLE[sq]) { free(BISHOP_ATTACKS_TABLE[sq]); BISHOP_ATTACKS_TABLE[sq] = NULL; }
-
-        // Rook
-        if (ROOK_RELEVANT_BITS[sq] > 0) { // Only find magic if mask is not empty
-            // printf("Finding Rook magic for sq %d (mask bits: %d)...\n\", sq, ROOK_RELEVANT_BITS[sq]);
-            if (!find_magic_for_square_user(sq, true, magicAttemptsPerSquare)) {
-                 // printf("Failed Rook magic for sq %d.\n\", sq);
-            }
-        } else { // Empty mask, still need to init attack table for 0 index
-            ROOK_ATTACKS_TABLE[sq] = (Bitboard*)calloc(1, sizeof(Bitboard));
-            if(ROOK_ATTACKS_TABLE[sq]) ROOK_ATTACKS_TABLE[sq][0] = generate_rook_attacks_otf_user(sq, 0ULL);
-        }
-
-
-        // Bishop
-        if (BISHOP_RELEVANT_BITS[sq] > 0) {
-            // printf("Finding Bishop magic for sq %d (mask bits: %d)...\n\", sq, BISHOP_RELEVANT_BITS[sq]);
-            if (!find_magic_for_square_user(sq, false, magicAttemptsPerSquare)) {
-                // printf("Failed Bishop magic for sq %d.\n\", sq);
+static void init_line_tables(void) {
+    for (Square a = 0; a < 64; a++) {
+        for (Square b = 0; b < 64; b++) {
+            Bitboard bbA = 1ULL << a;
+            Bitboard bbB = 1ULL << b;
+            BETWEEN_BB[a][b] = 0;
+            LINE_BB[a][b] = 0;
+            if (a == b) continue;
+            if (getRookAttacks(a, 0) & bbB) {
+                LINE_BB[a][b] = (getRookAttacks(a, 0) & getRookAttacks(b, 0)) | bbA | bbB;
+                BETWEEN_BB[a][b] = getRookAttacks(a, bbB) & getRookAttacks(b, bbA);
+            } else if (getBishopAttacks(a, 0) & bbB) {
+                LINE_BB[a][b] = (getBishopAttacks(a, 0) & getBishopAttacks(b, 0)) | bbA | bbB;
+                BETWEEN_BB[a][b] = getBishopAttacks(a, bbB) & getBishopAttacks(b, bbA);
             }
-        } else {
-            BISHOP_ATTACKS_TABLE[sq] = (Bitboard*)calloc(1, sizeof(Bitboard));
-            if(BISHOP_ATTACKS_TABLE[sq]) BISHOP_ATTACKS_TABLE[sq][0] = generate_bishop_attacks_otf_user(sq, 0ULL);
         }
     }
-
-    printf("Magic number search complete.\n");
-    int rooksFound = 0, bishopsFound = 0;
-    for(int i=0; i<64; ++i) {
-        if(ROOK_MAGICS[i] != 0ULL && ROOK_ATTACKS_TABLE[i] != NULL) rooksFound++;
-        else if (ROOK_RELEVANT_BITS[i] == 0 && ROOK_ATTACKS_TABLE[i] != NULL) rooksFound++; // Count empty mask cases as "found"
-        
-        if(BISHOP_MAGICS[i] != 0ULL && BISHOP_ATTACKS_TABLE[i] != NULL) bishopsFound++;
-        else if (BISHOP_RELEVANT_BITS[i] == 0 && BISHOP_ATTACKS_TABLE[i] != NULL) bishopsFound++;
-    }
-    printf("Found %d/64 Rook magics and %d/64 Bishop magics.\n", rooksFound, bishopsFound);
-    if (rooksFound < 64 || bishopsFound < 64) {
-        printf("Warning: Not all magic numbers were found. Sliding piece move generation might be slow or incorrect for some squares.\n");
-        printf("Consider using pre-calculated magics or increasing attempts (currently %d per square with non-zero mask).\n", magicAttemptsPerSquare);
-    }
-    return (rooksFound == 64 && bishopsFound == 64);
 }
 
 void initMoveGenerator() {
@@ -408,57 +308,38 @@ void initMoveGenerator() {
         }
     }
 
-    for (Square sq = 0; sq < 64; sq++) {
-        ROOK_MASKS[sq] = generate_rook_mask_user(sq);
-        ROOK_RELEVANT_BITS[sq] = POPCOUNT(ROOK_MASKS[sq]);
-
-        BISHOP_MASKS[sq] = generate_bishop_mask_user(sq);
-        BISHOP_RELEVANT_BITS[sq] = POPCOUNT(BISHOP_MASKS[sq]);
-        
-        ROOK_ATTACKS_TABLE[sq] = NULL; // Initialize pointers
-        BISHOP_ATTACKS_TABLE[sq] = NULL;
-    }
-
-    findAndInitMagicNumbers();
+    init_slider_attacks();
+    init_line_tables();
 }
 
 Bitboard getRookAttacks(Square square, Bitboard occupancy) {
-    if (ROOK_RELEVANT_BITS[square] == 0) { // Empty mask (e.g. corner for bishop mask, but rook masks are usually not empty)
-        return ROOK_ATTACKS_TABLE[square] ? ROOK_ATTACKS_TABLE[square][0] : generate_rook_attacks_otf_user(square, occupancy);
-    }
-    if (ROOK_MAGICS[square] == 0ULL || ROOK_ATTACKS_TABLE[square] == NULL) {
-        return generate_rook_attacks_otf_user(square, occupancy);
-    }
-    Bitboard relevant_occupancy = occupancy & ROOK_MASKS[square];
-    unsigned int index = transform_magic(relevant_occupancy, ROOK_MAGICS[square], ROOK_RELEVANT_BITS[square]);
-    if (index >= (1U << ROOK_RELEVANT_BITS[square])) { /* Should not happen */ return generate_rook_attacks_otf_user(square, occupancy); }
-    return ROOK_ATTACKS_TABLE[square][index];
+    const SliderMagic* m = &ROOK_MAGIC[square];
+    return m->attacks[slider_index(m, occupancy)];
 }
 
 Bitboard getBishopAttacks(Square square, Bitboard occupancy) {
-    if (BISHOP_RELEVANT_BITS[square] == 0) { // Empty mask (e.g. corner for bishop mask)
-         return BISHOP_ATTACKS_TABLE[square] ? BISHOP_ATTACKS_TABLE[square][0] : generate_bishop_attacks_otf_user(square, occupancy);
-    }
-    if (BISHOP_MAGICS[square] == 0ULL || BISHOP_ATTACKS_TABLE[square] == NULL) {
-        return generate_bishop_attacks_otf_user(square, occupancy);
-    }
-    Bitboard relevant_occupancy = occupancy & BISHOP_MASKS[square];
-    unsigned int index = transform_magic(relevant_occupancy, BISHOP_MAGICS[square], BISHOP_RELEVANT_BITS[square]);
-    if (index >= (1U << BISHOP_RELEVANT_BITS[square])) { /* Should not happen */ return generate_bishop_attacks_otf_user(square, occupancy); }
-    return BISHOP_ATTACKS_TABLE[square][index];
+    const SliderMagic* m = &BISHOP_MAGIC[square];
+    return m->attacks[slider_index(m, occupancy)];
 }
 
 Bitboard getQueenAttacks(Square square, Bitboard occupancy) {
     return getRookAttacks(square, occupancy) | getBishopAttacks(square, occupancy);
 }
 
-static Bitboard getOccupiedByColor(const Board* board, bool isWhite) {
+// Colour specialisation: the generators below take the side as a constant
+// parameter and are forced inline into one white and one black instance, so
+// every isWhite test - shift directions, start and promotion ranks, castling
+// squares, piece sets - folds at compile time. The public entry points
+// dispatch on the side to move once per call.
+#define COLOR_SPECIALIZED static inline __attribute__((always_inline))
+
+COLOR_SPECIALIZED Bitboard getOccupiedByColor(const Board* board, bool isWhite) {
     int c = isWhite ? WHITE : BLACK;
     return board->byTypeBB[c][PAWN] | board->byTypeBB[c][KNIGHT] | board->byTypeBB[c][BISHOP] | 
            board->byTypeBB[c][ROOK] | board->byTypeBB[c][QUEEN] | board->byTypeBB[c][KING];
 }
 
-static void generatePawnMoves(const Board* board, MoveList* list, bool isWhite) {
+COLOR_SPECIALIZED void generatePawnMoves(const Board* board, MoveList* list, bool isWhite) {
     Bitboard pawns = isWhite ? board->whitePawns : board->blackPawns;
     Bitboard friendlyPieces = getOccupiedByColor(board, isWhite);
     Bitboard enemyPieces = getOccupiedByColor(board, !isWhite);
@@ -520,7 +401,7 @@ static void generatePawnMoves(const Board* board, MoveList* list, bool isWhite)
     }
 }
 
-static void generatePieceMoves(const Board* board, MoveList* list, bool isWhite, Bitboard pieces, Bitboard attackTable[64]) {
+COLOR_SPECIALIZED void generatePieceMoves(const Board* board, MoveList* list, bool isWhite, Bitboard pieces, Bitboard attackTable[64]) {
     Bitboard friendlyPieces = getOccupiedByColor(board, isWhite);
     Bitboard enemyPieces = getOccupiedByColor(board, !isWhite);
     Bitboard currentPieces = pieces;
@@ -537,7 +418,7 @@ static void generatePieceMoves(const Board* board, MoveList* list, bool isWhite,
     }
 }
 
-static void generateSlidingPieceMoves(const Board* board, MoveList* list, bool isWhite, Bitboard pieces, PieceTypeToken pieceType) {
+COLOR_SPECIALIZED void generateSlidingPieceMoves(const Board* board, MoveList* list, bool isWhite, Bitboard pieces, PieceTypeToken pieceType) {
     Bitboard friendlyPieces = getOccupiedByColor(board, isWhite);
     Bitboard enemyPieces = getOccupiedByColor(board, !isWhite);
     Bitboard allPieces = friendlyPieces | enemyPieces;
@@ -562,7 +443,7 @@ static void generateSlidingPieceMoves(const Board* board, MoveList* list, bool i
 
 // Helper function to check if squares are attacked
 // Parameter 'byWhite' means "is the attacker white?"
-static bool isSquareAttacked(const Board* board, Square sq, bool byWhite) {
+COLOR_SPECIALIZED bool isSquareAttacked(const Board* board, Square sq, bool byWhite) {
     // Bitboard targetSqBit = 1ULL << sq; // Not needed for sliding optimization
 
     Bitboard occupiedWhite = getOccupiedByColor(board, true);
@@ -597,7 +478,7 @@ static bool isSquareAttacked(const Board* board, Square sq, bool byWhite) {
     return false; // Square is not attacked by the specified side
 }
 
-static void generateCastlingMoves(const Board* board, MoveList* list, bool isWhite) {
+COLOR_SPECIALIZED void generateCastlingMoves(const Board* board, MoveList* list, bool isWhite) {
     Bitboard occupied = board->whitePawns | board->whiteKnights | board->whiteBishops | board->whiteRooks | board->whiteQueens | board->whiteKings |
                          board->blackPawns | board->blackKnights | board->blackBishops | board->blackRooks | board->blackQueens | board->blackKings; // Ensure occupied is complete here too
 
@@ -645,13 +526,12 @@ bool isKingAttacked(const Board* board, bool kingColor) {
     if (kingSq == SQ_NONE) { 
         return false; 
     }
-    return isSquareAttacked(board, kingSq, !kingColor);
+    return kingColor ? isSquareAttacked(board, kingSq, false) : isSquareAttacked(board, kingSq, true);
 }
 
 // Generate only pseudo-legal CAPTURE moves for the current player
-void generateCaptureMoves(const Board* board, MoveList* list) {
+COLOR_SPECIALIZED void generateCaptureMovesFor(const Board* board, MoveList* list, const bool isWhite) {
     list->count = 0; // Initialize list
-    bool isWhite = board->whiteToMove;
 
     Bitboard friendlyPieces = getOccupiedByColor(board, isWhite);
     Bitboard enemyPieces = getOccupiedByColor(board, !isWhite);
@@ -746,10 +626,14 @@ void generateCaptureMoves(const Board* board, MoveList* list) {
     }
 }
 
+void generateCaptureMoves(const Board* board, MoveList* list) {
+    if (board->whiteToMove) generateCaptureMovesFor(board, list, true);
+    else generateCaptureMovesFor(board, list, false);
+}
+
 // Generate only pseudo-legal CAPTURE and PROMOTION moves for the current player
-void generateCaptureAndPromotionMoves(const Board* board, MoveList* list) {
+COLOR_SPECIALIZED void generateCaptureAndPromotionMovesFor(const Board* board, MoveList* list, const bool isWhite) {
     list->count = 0; // Initialize list
-    bool isWhite = board->whiteToMove;
 
     Bitboard friendlyPieces = getOccupiedByColor(board, isWhite);
     Bitboard enemyPieces = getOccupiedByColor(board, !isWhite);
@@ -862,12 +746,16 @@ void generateCaptureAndPromotionMoves(const Board* board, MoveList* list) {
     // That should be handled by the caller or a subsequent filtering step if needed.
 }
 
+void generateCaptureAndPromotionMoves(const Board* board, MoveList* list) {
+    if (board->whiteToMove) generateCaptureAndPromotionMovesFor(board, list, true);
+    else generateCaptureAndPromotionMovesFor(board, list, false);
+}
+
 
 // Generate all pseudo-legal moves (no legality check - king may be left in check)
 // Legality check is deferred to search/perft for better performance
-void generateMoves(const Board* board, MoveList* list) {
+COLOR_SPECIALIZED void generateMovesFor(const Board* board, MoveList* list, const bool isWhite) {
     list->count = 0;
-    bool isWhite = board->whiteToMove;
 
     // Generate all pseudo-legal moves directly into the output list
     generatePawnMoves(board, list, isWhite);
@@ -879,12 +767,16 @@ void generateMoves(const Board* board, MoveList* list) {
     generateCastlingMoves(board, list, isWhite);
 }
 
+void generateMoves(const Board* board, MoveList* list) {
+    if (board->whiteToMove) generateMovesFor(board, list, true);
+    else generateMovesFor(board, list, false);
+}
+
 // Generate only pseudo-legal QUIET moves (no captures, no promotions).
 // Together with generateCaptureAndPromotionMoves this covers exactly the
 // move set of generateMoves - the staged move picker relies on that.
-void generateQuietMoves(const Board* board, MoveList* list) {
+COLOR_SPECIALIZED void generateQuietMovesFor(const Board* board, MoveList* list, const bool isWhite) {
     list->count = 0;
-    bool isWhite = board->whiteToMove;
 
     Bitboard friendlyPieces = getOccupiedByColor(board, isWhite);
     Bitboard enemyPieces = getOccupiedByColor(board, !isWhite);
@@ -976,15 +868,19 @@ void generateQuietMoves(const Board* board, MoveList* list) {
     generateCastlingMoves(board, list, isWhite);
 }
 
+void generateQuietMoves(const Board* board, MoveList* list) {
+    if (board->whiteToMove) generateQuietMovesFor(board, list, true);
+    else generateQuietMovesFor(board, list, false);
+}
+
 // Check whether a move is pseudo-legal in the given position, i.e. whether
 // generateMoves would emit exactly this move. The staged move picker uses
 // this to validate TT moves before trying them without any generated list -
 // a corrupted or colliding TT entry must never reach applyMove.
-bool moveIsPseudoLegal(const Board* board, Move m) {
+COLOR_SPECIALIZED bool moveIsPseudoLegalFor(const Board* board, Move m, const bool isWhite) {
     if (m == 0) return false;
     int from = MOVE_FROM(m);
     int to = MOVE_TO(m);
-    bool isWhite = board->whiteToMove;
 
     uint8_t p = board->piece[from];
     if (p == NO_PIECE || PIECE_COLOR_OF(p) != (isWhite ? WHITE : BLACK)) return false;
@@ -1057,36 +953,289 @@ bool moveIsPseudoLegal(const Board* board, Move m) {
     return m == CREATE_MOVE(from, to, 0, GET_BIT(enemyPieces, to), 0, 0, 0);
 }
 
-// Generate all legal moves (filters out moves that leave king in check)
-// Use this when you need guaranteed legal moves (e.g., training data generation)
-void generateLegalMoves(Board* board, MoveList* list) {
-    MoveList pseudoLegalMoves;
-    pseudoLegalMoves.count = 0;
+bool moveIsPseudoLegal(const Board* board, Move m) {
+    return board->whiteToMove ? moveIsPseudoLegalFor(board, m, true)
+                              : moveIsPseudoLegalFor(board, m, false);
+}
+
+// =============================================================================
+// Legality without make/unmake
+//
+// The checkers and the pinned pieces are kept in the Board (updateCheckInfo,
+// once per applyMove); a pseudo-legal move is then legal unless it is
+// a king move to an attacked square, an en passant capture that exposes the
+// king, a pinned piece leaving its pin line, or a move that does not answer
+// a check.
+// =============================================================================
+
+// All pieces of color byColor attacking sq, sliders seen through occupancy occ
+static Bitboard attackersTo(const Board* board, Square sq, Bitboard occ, int byColor) {
+    const Bitboard* bb = board->byTypeBB[byColor];
+    return (PAWN_ATTACKS[byColor == WHITE ? 1 : 0][sq] & bb[PAWN]) |
+           (KNIGHT_ATTACKS[sq] & bb[KNIGHT]) |
+           (KING_ATTACKS[sq] & bb[KING]) |
+           (getBishopAttacks(sq, occ) & (bb[BISHOP] | bb[QUEEN])) |
+           (getRookAttacks(sq, occ) & (bb[ROOK] | bb[QUEEN]));
+}
+
+Bitboard attackersToSquare(const Board* board, Square sq, Bitboard occ) {
+    return attackersTo(board, sq, occ, WHITE) | attackersTo(board, sq, occ, BLACK);
+}
+
+// Pieces that alone block a slider of color byColor from square kingSq
+static Bitboard sliderBlockers(const Board* board, Square kingSq, int byColor, Bitboard occ, Bitboard* pinners) {
+    const Bitboard* enemy = board->byTypeBB[byColor];
+    Bitboard snipers = (getRookAttacks(kingSq, 0) & (enemy[ROOK] | enemy[QUEEN])) |
+                       (getBishopAttacks(kingSq, 0) & (enemy[BISHOP] | enemy[QUEEN]));
+    Bitboard own = getOccupiedByColor(board, byColor != WHITE);
+    Bitboard blockers = 0;
+    *pinners = 0;
+    while (snipers) {
+        Square s = BIT_SCAN_FORWARD(snipers);
+        CLEAR_BIT(snipers, s);
+        Bitboard between = BETWEEN_BB[kingSq][s] & occ;
+        if (between && !(between & (between - 1))) {
+            blockers |= between;
+            if (between & own) *pinners |= 1ULL << s;
+        }
+    }
+    return blockers;
+}
+
+void updateCheckInfo(Board* board) {
+    Bitboard occ = getOccupiedByColor(board, true) | getOccupiedByColor(board, false);
+    for (int c = WHITE; c <= BLACK; c++) {
+        Bitboard king = board->byTypeBB[c][KING];
+        board->blockersForKing[c] = 0;
+        board->pinners[c ^ 1] = 0;
+        if (king) {
+            board->blockersForKing[c] = sliderBlockers(board, BIT_SCAN_FORWARD(king), c ^ 1, occ,
+                                                       &board->pinners[c ^ 1]);
+        }
+    }
+    int us = board->whiteToMove ? WHITE : BLACK;
+    Bitboard king = board->byTypeBB[us][KING];
+    board->checkers = king ? attackersTo(board, BIT_SCAN_FORWARD(king), occ, us ^ 1) : 0;
+}
+
+bool moveIsLegal(const Board* board, Move m) {
+    int us = board->whiteToMove ? WHITE : BLACK;
+    int them = us ^ 1;
+    Bitboard king = board->byTypeBB[us][KING];
+    if (!king) return true;  // kingless test positions
+
+    Square k = BIT_SCAN_FORWARD(king);
+    Square from = MOVE_FROM(m);
+    Square to = MOVE_TO(m);
+    Bitboard occ = getOccupiedByColor(board, true) | getOccupiedByColor(board, false);
+
+    // The castling generator already requires the king's path to be safe
+    if (MOVE_IS_CASTLING(m)) return true;
+
+    if (from == k) {
+        return attackersTo(board, to, occ ^ (1ULL << from), them) == 0;
+    }
+
+    if (MOVE_IS_EN_PASSANT(m)) {
+        // Two pawns leave the king's rank/diagonals at once: test the sliders
+        // on the resulting occupancy; other checkers survive unless it is
+        // the captured pawn
+        Square capSq = to + (us == WHITE ? -8 : 8);
+        Bitboard after = (occ ^ (1ULL << from) ^ (1ULL << capSq)) | (1ULL << to);
+        const Bitboard* enemy = board->byTypeBB[them];
+        if (board->checkers & (enemy[PAWN] | enemy[KNIGHT]) & ~(1ULL << capSq)) return false;
+        return !(getRookAttacks(k, after) & (enemy[ROOK] | enemy[QUEEN])) &&
+               !(getBishopAttacks(k, after) & (enemy[BISHOP] | enemy[QUEEN]));
+    }
+
+    if (board->checkers) {
+        // Double check: only king moves; single check: capture or block
+        if (board->checkers & (board->checkers - 1)) return false;
+        Square c = BIT_SCAN_FORWARD(board->checkers);
+        if (!GET_BIT(BETWEEN_BB[k][c] | board->checkers, to)) return false;
+    }
+
+    return !GET_BIT(board->blockersForKing[us], from) || GET_BIT(LINE_BB[k][from], to);
+}
+
+bool givesCheck(const Board* board, Move m) {
+    int us = board->whiteToMove ? WHITE : BLACK;
+    int them = us ^ 1;
+    Bitboard enemyKing = board->byTypeBB[them][KING];
+    if (!enemyKing) return false;
+
+    Square k = BIT_SCAN_FORWARD(enemyKing);
+    Square from = MOVE_FROM(m);
+    Square to = MOVE_TO(m);
+    const Bitboard* own = board->byTypeBB[us];
+    Bitboard occ = getOccupiedByColor(board, true) | getOccupiedByColor(board, false);
+    Bitboard after = (occ ^ (1ULL << from)) | (1ULL << to);
+
+    int type = PIECE_TYPE_OF(board->piece[from]);
+    switch (MOVE_PROMOTION(m)) {
+        case PROMOTION_N: type = KNIGHT; break;
+        case PROMOTION_B: type = BISHOP; break;
+        case PROMOTION_R: type = ROOK; break;
+        case PROMOTION_Q: type = QUEEN; break;
+        default: break;
+    }
+
+    // Direct check by the moved (or promoted) piece
+    Bitboard checkSquares;
+    switch (type) {
+        case PAWN:   checkSquares = PAWN_ATTACKS[them][k]; break;
+        case KNIGHT: checkSquares = KNIGHT_ATTACKS[k]; break;
+        case BISHOP: checkSquares = getBishopAttacks(k, after); break;
+        case ROOK:   checkSquares = getRookAttacks(k, after); break;
+        case QUEEN:  checkSquares = getQueenAttacks(k, after); break;
+        default:     checkSquares = 0; break;
+    }
+    if (GET_BIT(checkSquares, to)) return true;
+
+    // Discovered check: the piece stepped off a line of one of our sliders
+    if (GET_BIT(board->blockersForKing[them], from) && !GET_BIT(LINE_BB[k][from], to)) return true;
+
+    if (MOVE_IS_EN_PASSANT(m)) {
+        // The captured pawn may have been the blocker
+        Square capSq = to + (us == WHITE ? -8 : 8);
+        after ^= 1ULL << capSq;
+        return (getRookAttacks(k, after) & (own[ROOK] | own[QUEEN])) ||
+               (getBishopAttacks(k, after) & (own[BISHOP] | own[QUEEN]));
+    }
+
+    if (MOVE_IS_CASTLING(m)) {
+        // Only the rook can give check, from its square next to the king
+        Square rookFrom = to > from ? to + 1 : to - 2;
+        Square rookTo = to > from ? to - 1 : to + 1;
+        Bitboard afterCastle = (occ ^ (1ULL << from) ^ (1ULL << rookFrom)) | (1ULL << to) | (1ULL << rookTo);
+        return GET_BIT(getRookAttacks(k, afterCastle), rookTo);
+    }
+    return false;
+}
+
+static void addPawnMove(MoveList* list, Square from, Square to, bool capture, bool promotion) {
+    if (promotion) {
+        addMove(list, CREATE_MOVE(from, to, PROMOTION_Q, capture, 0, 0, 0));
+        addMove(list, CREATE_MOVE(from, to, PROMOTION_R, capture, 0, 0, 0));
+        addMove(list, CREATE_MOVE(from, to, PROMOTION_B, capture, 0, 0, 0));
+        addMove(list, CREATE_MOVE(from, to, PROMOTION_N, capture, 0, 0, 0));
+    } else {
+        addMove(list, CREATE_MOVE(from, to, 0, capture, 0, 0, 0));
+    }
+}
+
+// Legal moves out of check: king steps to safe squares, and against a single
+// checker captures of it and interpositions by unpinned pieces
+COLOR_SPECIALIZED void generateEvasionsInCheckFor(const Board* board, MoveList* list, const bool isWhite) {
     list->count = 0;
+    int us = isWhite ? WHITE : BLACK;
+    int them = us ^ 1;
+    Square k = BIT_SCAN_FORWARD(board->byTypeBB[us][KING]);
+    Bitboard checkers = board->checkers;
+    Bitboard friendly = getOccupiedByColor(board, isWhite);
+    Bitboard enemy = getOccupiedByColor(board, !isWhite);
+    Bitboard occ = friendly | enemy;
+
+    Bitboard kingTargets = KING_ATTACKS[k] & ~friendly;
+    Bitboard occNoKing = occ ^ (1ULL << k);
+    while (kingTargets) {
+        Square to = BIT_SCAN_FORWARD(kingTargets);
+        CLEAR_BIT(kingTargets, to);
+        if (!attackersTo(board, to, occNoKing, them)) {
+            addMove(list, CREATE_MOVE(k, to, 0, GET_BIT(enemy, to), 0, 0, 0));
+        }
+    }
+    if (checkers & (checkers - 1)) return;  // double check
+
+    Square checkerSq = BIT_SCAN_FORWARD(checkers);
+    Bitboard target = BETWEEN_BB[k][checkerSq] | checkers;
+    // A pinned piece can never capture or block a checker on another line
+    Bitboard movable = friendly & ~board->blockersForKing[us];
+    const Bitboard* own = board->byTypeBB[us];
+
+    Bitboard pieces = own[KNIGHT] & movable;
+    while (pieces) {
+        Square from = BIT_SCAN_FORWARD(pieces);
+        CLEAR_BIT(pieces, from);
+        Bitboard t = KNIGHT_ATTACKS[from] & target;
+        while (t) {
+            Square to = BIT_SCAN_FORWARD(t);
+            CLEAR_BIT(t, to);
+            addMove(list, CREATE_MOVE(from, to, 0, GET_BIT(enemy, to), 0, 0, 0));
+        }
+    }
+
+    pieces = (own[BISHOP] | own[ROOK] | own[QUEEN]) & movable;
+    while (pieces) {
+        Square from = BIT_SCAN_FORWARD(pieces);
+        CLEAR_BIT(pieces, from);
+        Bitboard attacks = 0;
+        if (GET_BIT(own[BISHOP] | own[QUEEN], from)) attacks |= getBishopAttacks(from, occ);
+        if (GET_BIT(own[ROOK] | own[QUEEN], from)) attacks |= getRookAttacks(from, occ);
+        Bitboard t = attacks & target;
+        while (t) {
+            Square to = BIT_SCAN_FORWARD(t);
+            CLEAR_BIT(t, to);
+            addMove(list, CREATE_MOVE(from, to, 0, GET_BIT(enemy, to), 0, 0, 0));
+        }
+    }
+
+    int direction = isWhite ? 8 : -8;
+    int startRank = isWhite ? 1 : 6;
+    int promotionRank = isWhite ? 7 : 0;
+    pieces = own[PAWN] & movable;
+    while (pieces) {
+        Square from = BIT_SCAN_FORWARD(pieces);
+        CLEAR_BIT(pieces, from);
+        bool promotion = from / 8 + (isWhite ? 1 : -1) == promotionRank;
+
+        Square single = from + direction;
+        if (!GET_BIT(occ, single)) {
+            if (GET_BIT(target, single)) addPawnMove(list, from, single, false, promotion);
+            Square dbl = single + direction;
+            if (from / 8 == startRank && !GET_BIT(occ, dbl) && GET_BIT(target, dbl)) {
+                addMove(list, CREATE_MOVE(from, dbl, 0, 0, 1, 0, 0));
+            }
+        }
+
+        Bitboard pawnAttacks = PAWN_ATTACKS[us][from];
+        if (pawnAttacks & checkers) {
+            addPawnMove(list, from, checkerSq, true, promotion);
+        }
+        if (board->enPassantSquare != SQ_NONE && GET_BIT(pawnAttacks, board->enPassantSquare)) {
+            Move ep = CREATE_MOVE(from, board->enPassantSquare, 0, 1, 0, 1, 0);
+            if (moveIsLegal(board, ep)) addMove(list, ep);
+        }
+    }
+}
+
+static void generateEvasionsInCheck(const Board* board, MoveList* list) {
+    if (board->whiteToMove) generateEvasionsInCheckFor(board, list, true);
+    else generateEvasionsInCheckFor(board, list, false);
+}
 
-    bool isWhite = board->whiteToMove;
+void generateEvasions(const Board* board, MoveList* list) {
+    if (board->checkers == 0 || !board->byTypeBB[board->whiteToMove ? WHITE : BLACK][KING]) {
+        generateLegalMoves(board, list);
+        return;
+    }
+    generateEvasionsInCheck(board, list);
+}
 
-    // Generate all pseudo-legal moves
-    generatePawnMoves(board, &pseudoLegalMoves, isWhite);
-    generatePieceMoves(board, &pseudoLegalMoves, isWhite, isWhite ? board->whiteKnights : board->blackKnights, KNIGHT_ATTACKS);
-    generatePieceMoves(board, &pseudoLegalMoves, isWhite, isWhite ? board->whiteKings : board->blackKings, KING_ATTACKS);
-    generateSlidingPieceMoves(board, &pseudoLegalMoves, isWhite, isWhite ? board->whiteBishops : board->blackBishops, BISHOP_T);
-    generateSlidingPieceMoves(board, &pseudoLegalMoves, isWhite, isWhite ? board->whiteRooks : board->blackRooks, ROOK_T);
-    generateSlidingPieceMoves(board, &pseudoLegalMoves, isWhite, isWhite ? board->whiteQueens : board->blackQueens, QUEEN_T);
-    generateCastlingMoves(board, &pseudoLegalMoves, isWhite);
+// Generate all legal moves: evasions when in check, otherwise the
+// pseudo-legal moves that pass moveIsLegal
+void generateLegalMoves(const Board* board, MoveList* list) {
+    if (board->checkers && board->byTypeBB[board->whiteToMove ? WHITE : BLACK][KING]) {
+        generateEvasionsInCheck(board, list);
+        return;
+    }
 
-    // Filter for legality
+    MoveList pseudoLegalMoves;
+    generateMoves(board, &pseudoLegalMoves);
+    list->count = 0;
     for (int i = 0; i < pseudoLegalMoves.count; i++) {
-        Move currentMove = pseudoLegalMoves.moves[i];
-        
-        MoveUndoInfo undo_info;
-        applyMove(board, currentMove, &undo_info, NULL, NULL); 
-            
-        // Check if the king of the side that just moved is in check
-        if (!isKingAttacked(board, !board->whiteToMove)) { 
-            addMove(list, currentMove); 
+        if (moveIsLegal(board, pseudoLegalMoves.moves[i])) {
+            addMove(list, pseudoLegalMoves.moves[i]);
         }
-        
-        undoMove(board, currentMove, &undo_info, NULL, NULL);
     }
-}
\ No newline at end of file
+}
@@ -4,18 +4,30 @@
 #include "board.h"
 #include "move.h"
 
-// Initialize magic bitboards and other precomputed data
+// Initialize magic bitboards (fixed magics or PEXT) and other precomputed data
 void initMoveGenerator();
 
-// Called by initMoveGenerator to find magic numbers
-// Returns true on success, false on failure (e.g., too many attempts)
-bool findAndInitMagicNumbers();
-
 // Generate all pseudo-legal moves for the current player
 void generateMoves(const Board* board, MoveList* moveList);
 
-// Generate all legal moves for the current player (slower, but guaranteed legal)
-void generateLegalMoves(Board* board, MoveList* moveList);
+// Generate all legal moves for the current player
+void generateLegalMoves(const Board* board, MoveList* moveList);
+
+// Recompute board->checkers, blockersForKing and pinners from scratch
+// (applyMove and position setup call this)
+void updateCheckInfo(Board* board);
+
+// Whether a pseudo-legal move (generateMoves or moveIsPseudoLegal) is legal,
+// decided from the board's check info without making it
+bool moveIsLegal(const Board* board, Move move);
+
+// Whether a pseudo-legal move checks the opponent (direct, discovered,
+// en passant and castling checks), without making it
+bool givesCheck(const Board* board, Move move);
+
+// Generate the legal moves of a side in check (king steps, captures of the
+// checker, interpositions); falls back to generateLegalMoves if not in check
+void generateEvasions(const Board* board, MoveList* moveList);
 
 // Generate only pseudo-legal capture moves for the current player
 void generateCaptureMoves(const Board* board, MoveList* moveList);
@@ -37,6 +49,11 @@ Bitboard getRookAttacks(Square square, Bitboard occupancy);
 Bitboard getBishopAttacks(Square square, Bitboard occupancy);
 Bitboard getQueenAttacks(Square square, Bitboard occupancy); // Combines rook and bishop
 bool isKingAttacked(const Board* board, bool isWhite);
+// All pieces of both colors attacking a square, sliders seen through occupancy
+Bitboard attackersToSquare(const Board* board, Square square, Bitboard occupancy);
+// Squares strictly between two aligned squares (0 if they share no rank,
+// file or diagonal); filled by initMoveGenerator()
+extern Bitboard BETWEEN_BB[64][64];
 // static inline int pop_lsb(Bitboard *bb); // Removed static inline declaration from header
 // static inline int get_lsb_index(Bitboard bb); // Removed static inline declaration from header
 
@@ -1,18 +1,17 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
 #include "nnue.h"
 #include "bitboard_utils.h"
+#include "nnue_simd.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <errno.h>
-
-// SIMD support - compile-time detection (use -march=native)
-#if defined(__AVX512F__) && defined(__AVX512BW__)
-    #define NNUE_AVX512
-    #include <immintrin.h>
-#elif defined(__AVX2__)
-    #define NNUE_AVX2
-    #include <immintrin.h>
-#endif
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 // Input bucket map based on king position (32 elements for half-board with mirroring)
 // Index = rank * 8 + file (files 4-7 are mirrored from files 0-3)
@@ -85,6 +84,21 @@ static int get_feature_index(int perspective, int piece_type, int piece_color, i
     return king_bucket.index * BUCKET_STRIDE + mapped_color * COLOR_STRIDE + piece_type * PIECE_STRIDE + transformed_square;
 }
 
+// Feature transformer row for a feature index from get_feature_index()
+// (bucket * INPUT_SIZE + input, i.e. the row number in the weight matrix)
+static inline const int16_t* ft_row(const NNUENetwork* net, int feature) {
+    return net->ft_weights + (size_t)feature * net->hidden_size;
+}
+
+// Same for int8 nets; the row's int16 values are row8 * ft_row_scale()
+static inline const int8_t* ft_row8(const NNUENetwork* net, int feature) {
+    return net->ft_weights8 + (size_t)feature * net->hidden_size;
+}
+
+static inline int16_t ft_row_scale(const NNUENetwork* net, int feature) {
+    return net->ft_scales[feature / NNUE_INPUT_SIZE];
+}
+
 // Get output bucket based on piece count
 int nnue_get_output_bucket(const Board* board) {
     int piece_count = 0;
@@ -99,230 +113,555 @@ int nnue_get_output_bucket(const Board* board) {
     return bucket_index;
 }
 
-// Load NNUE weights from file into network
-bool nnue_load(const char* filename, NNUENetwork* net) {
-    if (!filename || !net) {
-        fprintf(stderr, "info string NNUE filename or network is NULL\n");
-        return false;
+// Bytes of ft weights in the file, int16 or int8 per weight
+static size_t nnue_ft_size(int hidden, bool ft_int8) {
+    return (size_t)NNUE_INPUT_BUCKETS * NNUE_INPUT_SIZE * hidden * (ft_int8 ? sizeof(int8_t) : sizeof(int16_t));
+}
+
+// Size of the weight data for a given hidden layer width (file layout order:
+// ft weights, ft biases, output weights, output biases, int8 ft scales)
+static size_t nnue_data_size(int hidden, bool ft_int8) {
+    return nnue_ft_size(hidden, ft_int8) +
+           (size_t)hidden * sizeof(int16_t) +
+           (size_t)NNUE_OUTPUT_BUCKETS * 2 * hidden * sizeof(int16_t) +
+           (size_t)NNUE_OUTPUT_BUCKETS * sizeof(int16_t) +
+           (ft_int8 ? (size_t)NNUE_FT_SCALE_SLOTS * sizeof(int16_t) : 0);
+}
+
+// The kernels step 32 lanes at a time and accumulators hold at most
+// NNUE_MAX_HIDDEN_SIZE values per perspective
+static bool nnue_hidden_supported(int hidden) {
+    return hidden > 0 && hidden <= NNUE_MAX_HIDDEN_SIZE && hidden % 32 == 0;
+}
+
+// FNV-1a over 64-bit little-endian words; size must be a multiple of 8
+// (every section is for the supported hidden sizes)
+static uint64_t nnue_hash_update(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, p + i, sizeof(word));
+        hash ^= word;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static uint64_t nnue_hash_net(const NNUENetwork* net) {
+    int hidden = net->hidden_size;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    if (net->ft_int8) {
+        hash = nnue_hash_update(hash, net->ft_weights8, nnue_ft_size(hidden, true));
+    } else {
+        hash = nnue_hash_update(hash, net->ft_weights, nnue_ft_size(hidden, false));
     }
-    
-    FILE* file = fopen(filename, "rb");
-    if (!file) {
-        fprintf(stderr, "info string Failed to open NNUE file: %s (errno: %d)\n", filename, errno);
-        char build_filename[256];
-        snprintf(build_filename, sizeof(build_filename), "build/%s", filename);
-        file = fopen(build_filename, "rb");
-        if (!file) {
-            fprintf(stderr, "info string Also tried: %s (not found)\n", build_filename);
+    hash = nnue_hash_update(hash, net->ft_biases, (size_t)hidden * sizeof(int16_t));
+    hash = nnue_hash_update(hash, net->output_weights,
+                            (size_t)NNUE_OUTPUT_BUCKETS * 2 * hidden * sizeof(int16_t));
+    hash = nnue_hash_update(hash, net->output_biases, (size_t)NNUE_OUTPUT_BUCKETS * sizeof(int16_t));
+    if (net->ft_int8) {
+        hash = nnue_hash_update(hash, net->ft_scales, (size_t)NNUE_FT_SCALE_SLOTS * sizeof(int16_t));
+    }
+    return hash;
+}
+
+#ifdef NNUE_EMBED
+// Default network linked into the binary (make EMBED=1). The weights are used
+// in place, so the blob is aligned like a mapped file.
+#if defined(__APPLE__)
+#define NNUE_EMBED_SYM(name) "_" #name
+#define NNUE_EMBED_SECTION ".const_data"
+#else
+#define NNUE_EMBED_SYM(name) #name
+#define NNUE_EMBED_SECTION ".section .rodata"
+#endif
+__asm__(NNUE_EMBED_SECTION "\n"
+        ".balign 64\n"
+        ".globl " NNUE_EMBED_SYM(nnue_embedded_data) "\n"
+        NNUE_EMBED_SYM(nnue_embedded_data) ":\n"
+        ".incbin \"" NNUE_EMBED_FILE "\"\n"
+        ".globl " NNUE_EMBED_SYM(nnue_embedded_end) "\n"
+        NNUE_EMBED_SYM(nnue_embedded_end) ":\n"
+        ".byte 0\n"
+        ".text\n");
+extern const unsigned char nnue_embedded_data[];
+extern const unsigned char nnue_embedded_end[];
+#endif
+
+// Bumped on every successful load so refresh caches notice a new net
+static uint64_t nnue_generation = 0;
+
+// Point the network at weights laid out as in the network file. Every section
+// starts on a 64 byte boundary relative to data (header_size is a multiple of
+// 64), so SIMD loads stay aligned as long as the image is (mmap and the
+// embedded blob are). The int8 scales after the output biases are only read
+// as scalars. Assumes a little-endian host, like the old fread loader.
+static void nnue_bind(NNUENetwork* net, const unsigned char* data, int hidden, bool ft_int8) {
+    size_t offset = 0;
+    net->hidden_size = hidden;
+    net->ft_int8 = ft_int8;
+    net->ft_weights = ft_int8 ? NULL : (const int16_t*)(data + offset);
+    net->ft_weights8 = ft_int8 ? (const int8_t*)(data + offset) : NULL;
+    offset += nnue_ft_size(hidden, ft_int8);
+    net->ft_biases = (const int16_t*)(data + offset);
+    offset += (size_t)hidden * sizeof(int16_t);
+    net->output_weights = (const int16_t*)(data + offset);
+    offset += (size_t)NNUE_OUTPUT_BUCKETS * 2 * hidden * sizeof(int16_t);
+    net->output_biases = (const int16_t*)(data + offset);
+    offset += (size_t)NNUE_OUTPUT_BUCKETS * sizeof(int16_t);
+    net->ft_scales = ft_int8 ? (const int16_t*)(data + offset) : NULL;
+}
+
+// Overflow bound for the SIMD output layer, which computes clamp(a)^2 * w as
+// (a * w) * a: a * w is an int16 product (mullo), madd adds two such terms
+// times a into int32 and the lanes are summed in int32. With 0 <= a <= QA
+// that is exact as long as
+//   max|w| * QA <= INT16_MAX                  (the mullo product)
+//   QA^2 * sum|w| over a bucket <= INT32_MAX  (any partial or total sum)
+// The second bound covers the madd pair as well (2 terms <= the bucket sum).
+// Nets that fail it (bigger QA or weights) use the exact int64 path.
+static bool nnue_output_bound_ok(const NNUENetwork* net) {
+    int64_t qa = net->qa;
+    for (int bucket = 0; bucket < NNUE_OUTPUT_BUCKETS; bucket++) {
+        const int16_t* w = net->output_weights + (size_t)bucket * 2 * net->hidden_size;
+        int64_t sum = 0;
+        for (int i = 0; i < 2 * net->hidden_size; i++) {
+            int64_t v = w[i] < 0 ? -(int64_t)w[i] : w[i];
+            if (v * qa > INT16_MAX) return false;
+            sum += v;
+        }
+        if (qa * qa * sum > INT32_MAX) return false;
+    }
+    return true;
+}
+
+// Validate a complete network image (header + weights, or a legacy headerless
+// bullet export) and bind the network to it
+static bool nnue_parse(const unsigned char* image, size_t size, NNUENetwork* net, const char* name) {
+    int hidden = 0;
+    bool ft_int8 = false;
+    const unsigned char* data = image;
+    NNUEFileHeader header;
+
+    if (size >= sizeof(header) && memcmp(image, NNUE_FILE_MAGIC, sizeof(header.magic)) == 0) {
+        memcpy(&header, image, sizeof(header));
+        if (header.version != NNUE_FILE_VERSION) {
+            fprintf(stderr, "info string %s: unsupported NNUE file version %u (expected %u)\n",
+                    name, header.version, NNUE_FILE_VERSION);
             return false;
         }
-        printf("info string Found NNUE file in build/ subdirectory\n");
+        if (header.input_size != NNUE_INPUT_SIZE || header.input_buckets != NNUE_INPUT_BUCKETS ||
+            header.output_buckets != NNUE_OUTPUT_BUCKETS) {
+            fprintf(stderr, "info string %s: NNUE architecture %ux%u buckets, %u output buckets "
+                    "does not match this build (%dx%d, %d)\n",
+                    name, header.input_size, header.input_buckets, header.output_buckets,
+                    NNUE_INPUT_SIZE, NNUE_INPUT_BUCKETS, NNUE_OUTPUT_BUCKETS);
+            return false;
+        }
+        if (!nnue_hidden_supported((int)header.hidden_size)) {
+            fprintf(stderr, "info string %s: NNUE hidden size %u not supported "
+                    "(multiple of 32, at most %d)\n", name, header.hidden_size, NNUE_MAX_HIDDEN_SIZE);
+            return false;
+        }
+        if (header.qa == 0 || header.qa > INT16_MAX || header.qb == 0 || header.scale == 0) {
+            fprintf(stderr, "info string %s: invalid NNUE quantisation QA=%u QB=%u scale=%u\n",
+                    name, header.qa, header.qb, header.scale);
+            return false;
+        }
+        if (header.flags & ~NNUE_FLAG_FT_INT8) {
+            fprintf(stderr, "info string %s: unsupported NNUE flags %08x\n", name, header.flags);
+            return false;
+        }
+        hidden = (int)header.hidden_size;
+        ft_int8 = (header.flags & NNUE_FLAG_FT_INT8) != 0;
+        if (header.header_size < sizeof(header) || header.header_size % 64 != 0 ||
+            header.data_size != nnue_data_size(hidden, ft_int8) ||
+            size < (size_t)header.header_size + header.data_size) {
+            fprintf(stderr, "info string %s: NNUE file truncated or inconsistent (%zu bytes)\n", name, size);
+            return false;
+        }
+        data = image + header.header_size;
+        net->qa = (int)header.qa;
+        net->qb = (int)header.qb;
+        net->scale = (int)header.scale;
     } else {
-        printf("info string Found NNUE file: %s\n", filename);
+        // Legacy raw export: the size (data padded to 64 bytes) gives the width
+        for (int h = 32; h <= NNUE_MAX_HIDDEN_SIZE; h += 32) {
+            if (((nnue_data_size(h, false) + 63) & ~(size_t)63) == size) {
+                hidden = h;
+                break;
+            }
+        }
+        if (hidden == 0) {
+            fprintf(stderr, "info string %s: NNUE file size %zu matches no supported network\n", name, size);
+            return false;
+        }
+        net->qa = NNUE_QA;
+        net->qb = NNUE_QB;
+        net->scale = NNUE_SCALE;
     }
-    
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    
-    long expected_data_size = 
-        (long)NNUE_INPUT_BUCKETS * NNUE_INPUT_SIZE * NNUE_HIDDEN_SIZE * sizeof(int16_t) +
-        (long)NNUE_HIDDEN_SIZE * sizeof(int16_t) +
-        (long)NNUE_OUTPUT_BUCKETS * 2 * NNUE_HIDDEN_SIZE * sizeof(int16_t) +
-        (long)NNUE_OUTPUT_BUCKETS * sizeof(int16_t);
-    long expected_size = expected_data_size + 48;
-    
-    printf("info string NNUE file size: %ld bytes, expected: %ld bytes\n", file_size, expected_size);
-    
-    if (file_size != expected_size) {
-        fprintf(stderr, "info string NNUE file size mismatch! Got %ld, expected %ld\n", file_size, expected_size);
-        fclose(file);
+
+    nnue_bind(net, data, hidden, ft_int8);
+    net->hash = nnue_hash_net(net);
+    if (data != image && net->hash != header.hash) {
+        fprintf(stderr, "info string %s: NNUE checksum mismatch (file %016llx, computed %016llx)\n",
+                name, (unsigned long long)header.hash, (unsigned long long)net->hash);
         return false;
     }
-    
-    // Read weights
-    for (int bucket = 0; bucket < NNUE_INPUT_BUCKETS; bucket++) {
-        for (int i = 0; i < NNUE_INPUT_SIZE; i++) {
-            if (fread(net->ft_weights[bucket][i], sizeof(int16_t), NNUE_HIDDEN_SIZE, file) != NNUE_HIDDEN_SIZE) {
-                fclose(file);
-                fprintf(stderr, "info string Failed to read NNUE feature transformer weights\n");
+    if (ft_int8) {
+        for (int b = 0; b < NNUE_INPUT_BUCKETS; b++) {
+            if (net->ft_scales[b] <= 0) {
+                fprintf(stderr, "info string %s: invalid int8 ft scale %d for bucket %d\n",
+                        name, net->ft_scales[b], b);
                 return false;
             }
         }
     }
-    
-    if (fread(net->ft_biases, sizeof(int16_t), NNUE_HIDDEN_SIZE, file) != NNUE_HIDDEN_SIZE) {
-        fclose(file);
-        fprintf(stderr, "info string Failed to read NNUE feature transformer biases\n");
-        return false;
+
+    net->output_fast = nnue_output_bound_ok(net);
+    if (!net->output_fast) {
+        printf("info string NNUE %s: output weights exceed the int16 kernel bound, using exact output layer\n",
+               name);
     }
-    
-    for (int bucket = 0; bucket < NNUE_OUTPUT_BUCKETS; bucket++) {
-        if (fread(net->output_weights[bucket], sizeof(int16_t), 2 * NNUE_HIDDEN_SIZE, file) != 2 * NNUE_HIDDEN_SIZE) {
-            fclose(file);
-            fprintf(stderr, "info string Failed to read NNUE output weights for bucket %d\n", bucket);
-            return false;
-        }
+
+    printf("info string NNUE %s: hidden %d, QA %d, QB %d, scale %d, hash %016llx%s%s\n",
+           name, net->hidden_size, net->qa, net->qb, net->scale, (unsigned long long)net->hash,
+           ft_int8 ? ", int8 ft weights" : "",
+           data == image ? " (legacy file without header)" : "");
+    net->generation = ++nnue_generation;
+    net->loaded = true;
+    return true;
+}
+
+// Map a network file read-only. Returns false if it can't be opened/mapped.
+static bool nnue_map_file(const char* filename, NNUENetwork* net) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
     }
-    
-    if (fread(net->output_biases, sizeof(int16_t), NNUE_OUTPUT_BUCKETS, file) != NNUE_OUTPUT_BUCKETS) {
-        fclose(file);
-        fprintf(stderr, "info string Failed to read NNUE output layer biases\n");
+
+    // MAP_SHARED + PROT_READ: all engine processes share the page cache copy
+    size_t size = (size_t)st.st_size;
+    void* data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "info string Failed to mmap NNUE file: %s (errno: %d)\n", filename, errno);
         return false;
     }
-    
-    fclose(file);
-    net->loaded = true;
-    printf("info string NNUE loaded successfully from %s\n", filename);
+
+    net->mapping = data;
+    net->mapping_size = size;
     return true;
 }
 
-// Save NNUE weights to file
-bool nnue_save(const char* filename, const NNUENetwork* net) {
-    if (!filename || !net) return false;
-    FILE* file = fopen(filename, "wb");
-    if (!file) return false;
-    
-    for (int bucket = 0; bucket < NNUE_INPUT_BUCKETS; bucket++) {
-        for (int i = 0; i < NNUE_INPUT_SIZE; i++) {
-            fwrite(net->ft_weights[bucket][i], sizeof(int16_t), NNUE_HIDDEN_SIZE, file);
+// Load NNUE weights from file into network
+bool nnue_load(const char* filename, NNUENetwork* net) {
+    if (!filename || !net) {
+        fprintf(stderr, "info string NNUE filename or network is NULL\n");
+        return false;
+    }
+
+    nnue_unload(net);
+
+    nnue_simd_init();
+    printf("info string NNUE kernels: %s\n", nnue_kernels.name);
+
+#ifdef NNUE_EMBED
+    if (strcmp(filename, NNUE_DEFAULT_NET) == 0) {
+        if (!nnue_parse(nnue_embedded_data, (size_t)(nnue_embedded_end - nnue_embedded_data),
+                        net, "embedded")) {
+            nnue_unload(net);
+            return false;
         }
+        printf("info string NNUE loaded from embedded network\n");
+        return true;
     }
-    fwrite(net->ft_biases, sizeof(int16_t), NNUE_HIDDEN_SIZE, file);
-    for (int bucket = 0; bucket < NNUE_OUTPUT_BUCKETS; bucket++) {
-        fwrite(net->output_weights[bucket], sizeof(int16_t), 2 * NNUE_HIDDEN_SIZE, file);
+#endif
+
+    if (!nnue_map_file(filename, net)) {
+        fprintf(stderr, "info string Failed to open NNUE file: %s (errno: %d)\n", filename, errno);
+        char build_filename[256];
+        snprintf(build_filename, sizeof(build_filename), "build/%s", filename);
+        if (!nnue_map_file(build_filename, net)) {
+            fprintf(stderr, "info string Also tried: %s (not found)\n", build_filename);
+            return false;
+        }
+        printf("info string Found NNUE file in build/ subdirectory\n");
+    } else {
+        printf("info string Found NNUE file: %s\n", filename);
     }
-    fwrite(net->output_biases, sizeof(int16_t), NNUE_OUTPUT_BUCKETS, file);
-    
-    fclose(file);
+
+    if (!nnue_parse((const unsigned char*)net->mapping, net->mapping_size, net, filename)) {
+        nnue_unload(net);
+        return false;
+    }
+
+    printf("info string NNUE loaded successfully from %s\n", filename);
     return true;
 }
 
-// SIMD vector operations - compile-time selected
-static inline void vec_add(int16_t* restrict dst, const int16_t* restrict src, int size) {
-#if defined(NNUE_AVX512)
-    for (int i = 0; i < size; i += 32) {
-        __m512i d = _mm512_load_si512((const __m512i*)(dst + i));
-        __m512i s = _mm512_loadu_si512((const __m512i*)(src + i));
-        _mm512_store_si512((__m512i*)(dst + i), _mm512_add_epi16(d, s));
+// Release the file mapping (if any) and mark the network as not loaded
+void nnue_unload(NNUENetwork* net) {
+    if (net == NULL) return;
+    if (net->mapping != NULL) {
+        munmap(net->mapping, net->mapping_size);
     }
-#elif defined(NNUE_AVX2)
-    for (int i = 0; i < size; i += 16) {
-        __m256i d = _mm256_load_si256((const __m256i*)(dst + i));
-        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
-        _mm256_store_si256((__m256i*)(dst + i), _mm256_add_epi16(d, s));
+    memset(net, 0, sizeof(*net));
+}
+
+// int16 value of ft weight i (flat index into [INPUT_BUCKETS][INPUT_SIZE][hidden])
+static int ft_weight(const NNUENetwork* net, size_t i) {
+    if (!net->ft_int8) return net->ft_weights[i];
+    return net->ft_weights8[i] * net->ft_scales[i / ((size_t)NNUE_INPUT_SIZE * net->hidden_size)];
+}
+
+// Quantise the ft weights of every bucket to int8 with the smallest scale
+// that keeps them in range, rounding to nearest, and report the error
+static void nnue_quantise_ft_int8(const NNUENetwork* net, int8_t* out, int16_t* scales) {
+    const size_t per_bucket = (size_t)NNUE_INPUT_SIZE * net->hidden_size;
+    int max_error = 0;
+    double total_error = 0.0;
+
+    printf("info string NNUE int8 ft scales:");
+    for (int b = 0; b < NNUE_INPUT_BUCKETS; b++) {
+        const size_t base = (size_t)b * per_bucket;
+        int max_abs = 0;
+        for (size_t i = 0; i < per_bucket; i++) {
+            int v = abs(ft_weight(net, base + i));
+            if (v > max_abs) max_abs = v;
+        }
+        int scale = max_abs > 127 ? (max_abs + 126) / 127 : 1;
+        scales[b] = (int16_t)scale;
+        printf(" %d", scale);
+
+        for (size_t i = 0; i < per_bucket; i++) {
+            int v = ft_weight(net, base + i);
+            int q = v >= 0 ? (v + scale / 2) / scale : -((-v + scale / 2) / scale);
+            if (q > 127) q = 127;
+            if (q < -127) q = -127;
+            out[base + i] = (int8_t)q;
+            int error = abs(q * scale - v);
+            if (error > max_error) max_error = error;
+            total_error += error;
+        }
     }
-#else
-    for (int i = 0; i < size; i++) {
-        dst[i] += src[i];
+    printf("\n");
+    printf("info string NNUE int8 rounding error: max %d, mean %.3f (int16 weight units)\n",
+           max_error, total_error / ((double)NNUE_INPUT_BUCKETS * per_bucket));
+}
+
+// Save NNUE weights to file (always in the current headered format). The
+// image is built in memory and bound like a loaded file, so the checksum is
+// computed over exactly what gets written.
+bool nnue_save(const char* filename, const NNUENetwork* net, bool ft_int8) {
+    if (!filename || !net || !net->loaded) return false;
+
+    int hidden = net->hidden_size;
+    size_t data_size = nnue_data_size(hidden, ft_int8);
+    unsigned char* data = NULL;
+    if (posix_memalign((void**)&data, 64, data_size) != 0) return false;
+    memset(data, 0, data_size);
+
+    NNUENetwork image;
+    memset(&image, 0, sizeof(image));
+    nnue_bind(&image, data, hidden, ft_int8);
+
+    const size_t ft_count = (size_t)NNUE_INPUT_BUCKETS * NNUE_INPUT_SIZE * hidden;
+    if (ft_int8 && net->ft_int8) {
+        memcpy((int8_t*)image.ft_weights8, net->ft_weights8, ft_count);
+        memcpy((int16_t*)image.ft_scales, net->ft_scales, (size_t)NNUE_FT_SCALE_SLOTS * sizeof(int16_t));
+    } else if (ft_int8) {
+        nnue_quantise_ft_int8(net, (int8_t*)image.ft_weights8, (int16_t*)image.ft_scales);
+    } else {
+        int16_t* ft = (int16_t*)image.ft_weights;
+        for (size_t i = 0; i < ft_count; i++) {
+            ft[i] = (int16_t)ft_weight(net, i);
+        }
     }
-#endif
+    memcpy((int16_t*)image.ft_biases, net->ft_biases, (size_t)hidden * sizeof(int16_t));
+    memcpy((int16_t*)image.output_weights, net->output_weights,
+           (size_t)NNUE_OUTPUT_BUCKETS * 2 * hidden * sizeof(int16_t));
+    memcpy((int16_t*)image.output_biases, net->output_biases, (size_t)NNUE_OUTPUT_BUCKETS * sizeof(int16_t));
+
+    NNUEFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, NNUE_FILE_MAGIC, sizeof(header.magic));
+    header.version = NNUE_FILE_VERSION;
+    header.header_size = sizeof(header);
+    header.input_size = NNUE_INPUT_SIZE;
+    header.input_buckets = NNUE_INPUT_BUCKETS;
+    header.output_buckets = NNUE_OUTPUT_BUCKETS;
+    header.hidden_size = (uint32_t)hidden;
+    header.qa = (uint32_t)net->qa;
+    header.qb = (uint32_t)net->qb;
+    header.scale = (uint32_t)net->scale;
+    header.flags = ft_int8 ? NNUE_FLAG_FT_INT8 : 0;
+    header.data_size = data_size;
+    header.hash = nnue_hash_net(&image);
+
+    FILE* file = fopen(filename, "wb");
+    bool ok = file != NULL;
+    ok = ok && fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && fwrite(data, 1, data_size, file) == data_size;
+    if (file != NULL && fclose(file) != 0) ok = false;
+    free(data);
+    return ok;
+}
+
+// SIMD vector operations - kernel variant selected at runtime (nnue_simd.c).
+// Feature rows go through ft_add/ft_sub/ft_update, which pick the int16 or
+// int8 kernels for the net's weight format.
+
+// SIMD memcpy for bias initialization
+static inline void vec_copy(int16_t* restrict dst, const int16_t* restrict src, int size) {
+    nnue_kernels.copy(dst, src, size);
 }
 
-static inline void vec_sub(int16_t* restrict dst, const int16_t* restrict src, int size) {
-#if defined(NNUE_AVX512)
-    for (int i = 0; i < size; i += 32) {
-        __m512i d = _mm512_load_si512((const __m512i*)(dst + i));
-        __m512i s = _mm512_loadu_si512((const __m512i*)(src + i));
-        _mm512_store_si512((__m512i*)(dst + i), _mm512_sub_epi16(d, s));
+static inline void ft_add(const NNUENetwork* net, int16_t* restrict dst, int feature) {
+    if (net->ft_int8) {
+        nnue_kernels.add_i8(dst, ft_row8(net, feature), ft_row_scale(net, feature), net->hidden_size);
+    } else {
+        nnue_kernels.add(dst, ft_row(net, feature), net->hidden_size);
     }
-#elif defined(NNUE_AVX2)
-    for (int i = 0; i < size; i += 16) {
-        __m256i d = _mm256_load_si256((const __m256i*)(dst + i));
-        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
-        _mm256_store_si256((__m256i*)(dst + i), _mm256_sub_epi16(d, s));
+}
+
+static inline void ft_sub(const NNUENetwork* net, int16_t* restrict dst, int feature) {
+    if (net->ft_int8) {
+        nnue_kernels.sub_i8(dst, ft_row8(net, feature), ft_row_scale(net, feature), net->hidden_size);
+    } else {
+        nnue_kernels.sub(dst, ft_row(net, feature), net->hidden_size);
     }
-#else
-    for (int i = 0; i < size; i++) {
-        dst[i] -= src[i];
+}
+
+// Fused child update: dst = src + add0 (+ add1) - sub0 (- sub1), single pass.
+// Arguments are feature indices of one king bucket, -1 for an unused row.
+static inline void ft_update(const NNUENetwork* net, int16_t* dst, const int16_t* src,
+                             int add0, int add1, int sub0, int sub1) {
+    if (net->ft_int8) {
+        nnue_kernels.update_i8(dst, src, ft_row8(net, add0), add1 >= 0 ? ft_row8(net, add1) : NULL,
+                               ft_row8(net, sub0), sub1 >= 0 ? ft_row8(net, sub1) : NULL,
+                               ft_row_scale(net, add0), net->hidden_size);
+    } else {
+        nnue_kernels.update(dst, src, ft_row(net, add0), add1 >= 0 ? ft_row(net, add1) : NULL,
+                            ft_row(net, sub0), sub1 >= 0 ? ft_row(net, sub1) : NULL, net->hidden_size);
     }
-#endif
 }
 
-// Add all pieces for accumulator computation
-static void add_piece_features(NNUEAccumulator* acc, const NNUENetwork* net,
-                                Bitboard pieces, int piece_type, int piece_color,
-                                KingBucket white_bucket, KingBucket black_bucket) {
-    while (pieces) {
-        int sq = get_lsb(pieces);
-        pieces &= pieces - 1;
+// Accumulator work of the calling thread, for the search statistics
+static _Thread_local uint64_t thread_refreshes = 0;
+static _Thread_local uint64_t thread_updates = 0;
 
-        int white_index = get_feature_index(0, piece_type, piece_color, sq, white_bucket);
-        int white_bucket_idx = white_index / NNUE_INPUT_SIZE;
-        int white_input_idx = white_index % NNUE_INPUT_SIZE;
-        vec_add(acc->white, net->ft_weights[white_bucket_idx][white_input_idx], NNUE_HIDDEN_SIZE);
+void nnue_thread_stats(uint64_t* refreshes, uint64_t* updates) {
+    *refreshes = thread_refreshes;
+    *updates = thread_updates;
+}
 
-        int black_index = get_feature_index(1, piece_type, piece_color, sq, black_bucket);
-        int black_bucket_idx = black_index / NNUE_INPUT_SIZE;
-        int black_input_idx = black_index % NNUE_INPUT_SIZE;
-        vec_add(acc->black, net->ft_weights[black_bucket_idx][black_input_idx], NNUE_HIDDEN_SIZE);
-    }
+void nnue_finny_clear(NNUEFinnyTable* table) {
+    if (table == NULL) return;
+    table->generation = 0;  // entries are rebuilt from the biases on next use
 }
 
-// SIMD memcpy for bias initialization
-static inline void vec_copy(int16_t* restrict dst, const int16_t* restrict src, int size) {
-#if defined(NNUE_AVX512)
-    for (int i = 0; i < size; i += 32) {
-        __m512i v = _mm512_loadu_si512((const __m512i*)(src + i));
-        _mm512_store_si512((__m512i*)(dst + i), v);
+// Bring the cache entry for this perspective's king bucket up to date with
+// the board (adding/removing only the pieces that changed since it was last
+// used) and copy it into the accumulator
+static void finny_refresh_perspective(const Board* board, int16_t* out, const NNUENetwork* net,
+                                      NNUEFinnyTable* table, int perspective, KingBucket bucket) {
+    if (table->generation != net->generation) {
+        for (int b = 0; b < NNUE_INPUT_BUCKETS; b++) {
+            for (int m = 0; m < 2; m++) {
+                for (int p = 0; p < 2; p++) {
+                    NNUEFinnyEntry* e = &table->entry[b][m][p];
+                    vec_copy(e->values, net->ft_biases, net->hidden_size);
+                    memset(e->pieces, 0, sizeof(e->pieces));
+                }
+            }
+        }
+        table->generation = net->generation;
+    }
+
+    NNUEFinnyEntry* e = &table->entry[bucket.index][bucket.mirrored][perspective];
+    for (int color = 0; color < 2; color++) {
+        for (int type = 0; type < 6; type++) {
+            Bitboard now = board->byTypeBB[color][type];
+            Bitboard removed = e->pieces[color][type] & ~now;
+            Bitboard added = now & ~e->pieces[color][type];
+
+            while (removed) {
+                int sq = get_lsb(removed);
+                removed &= removed - 1;
+                int idx = get_feature_index(perspective, type, color, sq, bucket);
+                ft_sub(net, e->values, idx);
+            }
+            while (added) {
+                int sq = get_lsb(added);
+                added &= added - 1;
+                int idx = get_feature_index(perspective, type, color, sq, bucket);
+                ft_add(net, e->values, idx);
+            }
+            e->pieces[color][type] = now;
+        }
     }
-#elif defined(NNUE_AVX2)
-    for (int i = 0; i < size; i += 16) {
-        __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
-        _mm256_store_si256((__m256i*)(dst + i), v);
+
+    vec_copy(out, e->values, net->hidden_size);
+}
+
+// Rebuild one perspective from the board (through the refresh cache if set)
+static void refresh_perspective(const Board* board, NNUEAccumulator* acc, const NNUENetwork* net,
+                                int perspective) {
+    int king_sq = get_lsb(perspective == 0 ? board->whiteKings : board->blackKings);
+    KingBucket bucket = get_king_bucket(king_sq, perspective);
+    int16_t* out = perspective == 0 ? acc->white : acc->black;
+    thread_refreshes++;
+
+    if (acc->cache != NULL) {
+        finny_refresh_perspective(board, out, net, acc->cache, perspective, bucket);
+    } else {
+        // Initialize with biases, then add every piece
+        vec_copy(out, net->ft_biases, net->hidden_size);
+        for (int color = 0; color < 2; color++) {
+            for (int type = 0; type < 6; type++) {
+                Bitboard pieces = board->byTypeBB[color][type];
+                while (pieces) {
+                    int sq = get_lsb(pieces);
+                    pieces &= pieces - 1;
+                    int idx = get_feature_index(perspective, type, color, sq, bucket);
+                    ft_add(net, out, idx);
+                }
+            }
+        }
     }
-#else
-    memcpy(dst, src, size * sizeof(int16_t));
-#endif
+
+    acc->dirty[perspective] = false;
+    acc->requires_refresh[perspective] = false;
 }
 
-// Compute full accumulator from scratch
+// Compute full accumulator from scratch (or from the refresh cache)
 void nnue_refresh_accumulator(const Board* board, NNUEAccumulator* acc, const NNUENetwork* net) {
-    if (acc == NULL || net == NULL || board == NULL) return;
-
-    int white_king_sq = get_lsb(board->whiteKings);
-    int black_king_sq = get_lsb(board->blackKings);
+    if (acc == NULL || net == NULL || !net->loaded || board == NULL) return;
 
-    if (white_king_sq < 0 || black_king_sq < 0) {
+    if (board->whiteKings == 0 || board->blackKings == 0) {
         memset(acc->white, 0, sizeof(acc->white));
         memset(acc->black, 0, sizeof(acc->black));
         acc->computed = false;
-        acc->dirty = false;
-        acc->requires_refresh = false;
+        acc->dirty[0] = acc->dirty[1] = false;
+        acc->requires_refresh[0] = acc->requires_refresh[1] = false;
         acc->previous = NULL;
         return;
     }
 
-    KingBucket white_bucket = get_king_bucket(white_king_sq, 0);
-    KingBucket black_bucket = get_king_bucket(black_king_sq, 1);
-
-    // Initialize with biases
-    vec_copy(acc->white, net->ft_biases, NNUE_HIDDEN_SIZE);
-    vec_copy(acc->black, net->ft_biases, NNUE_HIDDEN_SIZE);
-    
-    add_piece_features(acc, net, board->whitePawns, NNUE_PIECE_PAWN, 0, white_bucket, black_bucket);
-    add_piece_features(acc, net, board->whiteKnights, NNUE_PIECE_KNIGHT, 0, white_bucket, black_bucket);
-    add_piece_features(acc, net, board->whiteBishops, NNUE_PIECE_BISHOP, 0, white_bucket, black_bucket);
-    add_piece_features(acc, net, board->whiteRooks, NNUE_PIECE_ROOK, 0, white_bucket, black_bucket);
-    add_piece_features(acc, net, board->whiteQueens, NNUE_PIECE_QUEEN, 0, white_bucket, black_bucket);
-    add_piece_features(acc, net, board->whiteKings, NNUE_PIECE_KING, 0, white_bucket, black_bucket);
-    
-    add_piece_features(acc, net, board->blackPawns, NNUE_PIECE_PAWN, 1, white_bucket, black_bucket);
-    add_piece_features(acc, net, board->blackKnights, NNUE_PIECE_KNIGHT, 1, white_bucket, black_bucket);
-    add_piece_features(acc, net, board->blackBishops, NNUE_PIECE_BISHOP, 1, white_bucket, black_bucket);
-    add_piece_features(acc, net, board->blackRooks, NNUE_PIECE_ROOK, 1, white_bucket, black_bucket);
-    add_piece_features(acc, net, board->blackQueens, NNUE_PIECE_QUEEN, 1, white_bucket, black_bucket);
-    add_piece_features(acc, net, board->blackKings, NNUE_PIECE_KING, 1, white_bucket, black_bucket);
-    
+    refresh_perspective(board, acc, net, 0);
+    refresh_perspective(board, acc, net, 1);
     acc->computed = true;
-    acc->dirty = false;
-    acc->requires_refresh = false;
     acc->previous = NULL;
 }
 
 // Reset accumulator for new position using network
 void nnue_reset_accumulator(const Board* board, NNUEAccumulator* acc, const NNUENetwork* net) {
-    if (acc == NULL || net == NULL) return;
+    if (acc == NULL || net == NULL || !net->loaded) return;
     nnue_refresh_accumulator(board, acc, net);
 }
 
@@ -330,9 +669,10 @@ void nnue_prepare_child_accumulator(NNUEAccumulator* child, NNUEAccumulator* par
     if (child == NULL) return;
 
     child->computed = false;
-    child->dirty = true;
-    child->requires_refresh = false;
+    child->dirty[0] = child->dirty[1] = true;
+    child->requires_refresh[0] = child->requires_refresh[1] = false;
     child->previous = parent;
+    child->cache = parent ? parent->cache : NULL;
     child->from_sq = -1;
     child->to_sq = -1;
     child->piece_type = -1;
@@ -349,8 +689,13 @@ void nnue_mark_accumulator_dirty(NNUEAccumulator* acc, const Board* board, int f
     if (acc == NULL) return;
 
     acc->computed = false;
-    acc->dirty = true;
-    acc->requires_refresh = requires_refresh;
+    acc->dirty[0] = acc->dirty[1] = true;
+    acc->requires_refresh[0] = acc->requires_refresh[1] = requires_refresh;
+    // A king leaving its bucket only invalidates its own side's perspective;
+    // the other one still takes the incremental update
+    if (piece_type == NNUE_PIECE_KING && nnue_king_move_requires_refresh(from_sq, to_sq, is_white)) {
+        acc->requires_refresh[is_white ? 0 : 1] = true;
+    }
     acc->from_sq = from_sq;
     acc->to_sq = to_sq;
     acc->piece_type = piece_type;
@@ -365,64 +710,6 @@ void nnue_mark_accumulator_dirty(NNUEAccumulator* acc, const Board* board, int f
     }
 }
 
-// SCReLU² dot product using Leorik's trick:
-// Instead of (a * a) * w (overflow since 255²=65025 > int16_max)
-// Compute (a * w) * a, then use madd_epi16 for efficiency
-// This works when weights are in reasonable range (typically [-127..127] after quantization)
-static inline int32_t screlu_dot(const int16_t* acc, const int16_t* weights, int size) {
-#if defined(NNUE_AVX512)
-    const __m512i zero = _mm512_setzero_si512();
-    const __m512i qa = _mm512_set1_epi16(NNUE_QA);
-    __m512i sum = _mm512_setzero_si512();
-
-    for (int i = 0; i < size; i += 32) {
-        __m512i a = _mm512_load_si512((const __m512i*)(acc + i));
-        a = _mm512_max_epi16(a, zero);
-        a = _mm512_min_epi16(a, qa);
-
-        __m512i w = _mm512_loadu_si512((const __m512i*)(weights + i));
-
-        // (a * w) * a using madd - same trick as AVX2
-        __m512i aw = _mm512_mullo_epi16(a, w);
-        sum = _mm512_add_epi32(sum, _mm512_madd_epi16(aw, a));
-    }
-
-    return _mm512_reduce_add_epi32(sum);
-
-#elif defined(NNUE_AVX2)
-    const __m256i zero = _mm256_setzero_si256();
-    const __m256i qa = _mm256_set1_epi16(NNUE_QA);
-    __m256i sum = _mm256_setzero_si256();
-
-    for (int i = 0; i < size; i += 16) {
-        __m256i a = _mm256_load_si256((const __m256i*)(acc + i));
-        a = _mm256_max_epi16(a, zero);
-        a = _mm256_min_epi16(a, qa);
-
-        __m256i w = _mm256_loadu_si256((const __m256i*)(weights + i));
-
-        // (a * w) * a using madd
-        __m256i aw = _mm256_mullo_epi16(a, w);
-        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(aw, a));
-    }
-
-    // Horizontal sum
-    __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
-    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(1, 0, 3, 2)));
-    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(2, 3, 0, 1)));
-    return _mm_cvtsi128_si32(sum128);
-
-#else
-    int32_t output = 0;
-    for (int i = 0; i < size; i++) {
-        int32_t clamped = acc[i];
-        clamped = clamped < 0 ? 0 : (clamped > NNUE_QA ? NNUE_QA : clamped);
-        output += clamped * clamped * weights[i];
-    }
-    return output;
-#endif
-}
-
 // Evaluate position using NNUE
 int nnue_evaluate(const Board* board, NNUEAccumulator* acc, const NNUENetwork* net) {
     if (acc == NULL || net == NULL) return 0;
@@ -434,52 +721,29 @@ int nnue_evaluate(const Board* board, NNUEAccumulator* acc, const NNUENetwork* n
     int output_bucket = nnue_get_output_bucket(board);
     int16_t* us_acc = board->whiteToMove ? acc->white : acc->black;
     int16_t* them_acc = board->whiteToMove ? acc->black : acc->white;
-    const int16_t* us_weights = net->output_weights[output_bucket];
-    const int16_t* them_weights = net->output_weights[output_bucket] + NNUE_HIDDEN_SIZE;
+    const int16_t* us_weights = net->output_weights + (size_t)output_bucket * 2 * net->hidden_size;
+    const int16_t* them_weights = us_weights + net->hidden_size;
 
-    // SCReLU values are multiplied by QA * QA * QB, but output bias is only QA * QB
-    int32_t output = screlu_dot(us_acc, us_weights, NNUE_HIDDEN_SIZE)
-                   + screlu_dot(them_acc, them_weights, NNUE_HIDDEN_SIZE);
+    // SCReLU values are multiplied by QA * QA * QB, but output bias is only QA * QB.
+    // Both perspectives go through one kernel call; the scaling below is done
+    // in int64 since output * scale can exceed int32 for large nets.
+    int64_t output = net->output_fast
+        ? nnue_kernels.screlu_dual(us_acc, them_acc, us_weights, them_weights, net->hidden_size, (int16_t)net->qa)
+        : nnue_screlu_dual_exact(us_acc, them_acc, us_weights, them_weights, net->hidden_size, (int16_t)net->qa);
 
-    output /= NNUE_QA;
+    output /= net->qa;
     output += net->output_biases[output_bucket];
 
-    int eval = (output * NNUE_SCALE) / (NNUE_QA * NNUE_QB);
+    int eval = (int)((output * net->scale) / ((int64_t)net->qa * net->qb));
     return board->whiteToMove ? eval : -eval;
 }
 
-// Combined sub-add for move updates (dst = dst - src_sub + src_add)
-static inline void vec_sub_add(int16_t* restrict dst, const int16_t* restrict src_sub,
-                                const int16_t* restrict src_add, int size) {
-#if defined(NNUE_AVX512)
-    for (int i = 0; i < size; i += 32) {
-        __m512i d = _mm512_load_si512((const __m512i*)(dst + i));
-        __m512i sub = _mm512_loadu_si512((const __m512i*)(src_sub + i));
-        __m512i add = _mm512_loadu_si512((const __m512i*)(src_add + i));
-        d = _mm512_sub_epi16(d, sub);
-        d = _mm512_add_epi16(d, add);
-        _mm512_store_si512((__m512i*)(dst + i), d);
-    }
-#elif defined(NNUE_AVX2)
-    for (int i = 0; i < size; i += 16) {
-        __m256i d = _mm256_load_si256((const __m256i*)(dst + i));
-        __m256i sub = _mm256_loadu_si256((const __m256i*)(src_sub + i));
-        __m256i add = _mm256_loadu_si256((const __m256i*)(src_add + i));
-        d = _mm256_sub_epi16(d, sub);
-        d = _mm256_add_epi16(d, add);
-        _mm256_store_si256((__m256i*)(dst + i), d);
-    }
-#else
-    for (int i = 0; i < size; i++) {
-        dst[i] = dst[i] - src_sub[i] + src_add[i];
-    }
-#endif
-}
-
-// Helper: Update piece move for both perspectives
+// Helper: Update piece move (plus optional capture) for both perspectives in
+// one fused pass per perspective
 // WICHTIG: white_king_sq und black_king_sq müssen die Positionen VOR dem Zug sein!
 static void nnue_update_piece_move_with_kings(NNUEAccumulator* acc, const NNUENetwork* net,
                                               int from_sq, int to_sq, int piece_type, int piece_color,
+                                              int captured_piece_type, int capture_sq,
                                               int white_king_sq, int black_king_sq, bool apply) {
     if (acc == NULL || net == NULL) return;
 
@@ -487,115 +751,113 @@ static void nnue_update_piece_move_with_kings(NNUEAccumulator* acc, const NNUENe
         return;  // Invalid - caller should refresh
     }
 
-    KingBucket white_bucket = get_king_bucket(white_king_sq, 0);
-    KingBucket black_bucket = get_king_bucket(black_king_sq, 1);
-
-    int white_from_idx = get_feature_index(0, piece_type, piece_color, from_sq, white_bucket);
-    int white_to_idx = get_feature_index(0, piece_type, piece_color, to_sq, white_bucket);
-    int black_from_idx = get_feature_index(1, piece_type, piece_color, from_sq, black_bucket);
-    int black_to_idx = get_feature_index(1, piece_type, piece_color, to_sq, black_bucket);
-
-    // Extract bucket and input indices for all four feature updates
-    int white_from_bucket = white_from_idx / NNUE_INPUT_SIZE;
-    int white_from_input = white_from_idx % NNUE_INPUT_SIZE;
-    int white_to_bucket = white_to_idx / NNUE_INPUT_SIZE;
-    int white_to_input = white_to_idx % NNUE_INPUT_SIZE;
-
-    int black_from_bucket = black_from_idx / NNUE_INPUT_SIZE;
-    int black_from_input = black_from_idx % NNUE_INPUT_SIZE;
-    int black_to_bucket = black_to_idx / NNUE_INPUT_SIZE;
-    int black_to_input = black_to_idx % NNUE_INPUT_SIZE;
+    for (int perspective = 0; perspective < 2; perspective++) {
+        KingBucket bucket = get_king_bucket(perspective == 0 ? white_king_sq : black_king_sq, perspective);
+        int16_t* out = perspective == 0 ? acc->white : acc->black;
 
-    const int16_t* w_from = net->ft_weights[white_from_bucket][white_from_input];
-    const int16_t* w_to = net->ft_weights[white_to_bucket][white_to_input];
-    const int16_t* b_from = net->ft_weights[black_from_bucket][black_from_input];
-    const int16_t* b_to = net->ft_weights[black_to_bucket][black_to_input];
+        int from = get_feature_index(perspective, piece_type, piece_color, from_sq, bucket);
+        int to = get_feature_index(perspective, piece_type, piece_color, to_sq, bucket);
+        int captured = -1;
+        if (captured_piece_type >= 0) {
+            captured = get_feature_index(perspective, captured_piece_type, piece_color ^ 1, capture_sq, bucket);
+        }
 
-    if (apply) {
-        // apply: dst = dst - from + to
-        vec_sub_add(acc->white, w_from, w_to, NNUE_HIDDEN_SIZE);
-        vec_sub_add(acc->black, b_from, b_to, NNUE_HIDDEN_SIZE);
-    } else {
-        // undo: dst = dst + from - to (same as dst = dst - to + from)
-        vec_sub_add(acc->white, w_to, w_from, NNUE_HIDDEN_SIZE);
-        vec_sub_add(acc->black, b_to, b_from, NNUE_HIDDEN_SIZE);
+        if (apply) {
+            // apply: dst = dst - from + to - captured
+            ft_update(net, out, out, to, -1, from, captured);
+        } else {
+            // undo: dst = dst + from - to + captured
+            ft_update(net, out, out, from, captured, to, -1);
+        }
     }
+    thread_updates += 2;
 }
 
-static bool nnue_apply_lazy_delta(NNUEAccumulator* acc, const NNUENetwork* net) {
+// Compute one perspective of a lazy frame from its parent's values in a single
+// fused pass. King squares are the ones before the move.
+static bool nnue_apply_lazy_delta(NNUEAccumulator* acc, const int16_t* parent, const NNUENetwork* net,
+                                  int perspective) {
     if (acc == NULL || net == NULL) return false;
-    if (acc->requires_refresh || acc->piece_type < 0 ||
-        acc->white_king_sq < 0 || acc->black_king_sq < 0) {
+    int king_sq = perspective == 0 ? acc->white_king_sq : acc->black_king_sq;
+    if (acc->requires_refresh[perspective] || acc->piece_type < 0 || king_sq < 0) {
         return false;
     }
 
-    nnue_update_piece_move_with_kings(acc, net, acc->from_sq, acc->to_sq,
-                                      acc->piece_type, acc->moving_color,
-                                      acc->white_king_sq, acc->black_king_sq, true);
+    KingBucket bucket = get_king_bucket(king_sq, perspective);
+    int16_t* out = perspective == 0 ? acc->white : acc->black;
 
+    int from_idx = get_feature_index(perspective, acc->piece_type, acc->moving_color, acc->from_sq, bucket);
+    int to_idx = get_feature_index(perspective, acc->piece_type, acc->moving_color, acc->to_sq, bucket);
+    int cap_idx = -1;
     if (acc->captured_piece_type >= 0) {
-        KingBucket white_bucket = get_king_bucket(acc->white_king_sq, 0);
-        KingBucket black_bucket = get_king_bucket(acc->black_king_sq, 1);
-
         int captured_color = acc->moving_color ^ 1;
-        int white_cap_idx = get_feature_index(0, acc->captured_piece_type, captured_color,
-                                              acc->capture_sq, white_bucket);
-        int black_cap_idx = get_feature_index(1, acc->captured_piece_type, captured_color,
-                                              acc->capture_sq, black_bucket);
-
-        int white_bucket_idx = white_cap_idx / NNUE_INPUT_SIZE;
-        int white_cap_input = white_cap_idx % NNUE_INPUT_SIZE;
-        int black_bucket_idx = black_cap_idx / NNUE_INPUT_SIZE;
-        int black_cap_input = black_cap_idx % NNUE_INPUT_SIZE;
-
-        vec_sub(acc->white, net->ft_weights[white_bucket_idx][white_cap_input], NNUE_HIDDEN_SIZE);
-        vec_sub(acc->black, net->ft_weights[black_bucket_idx][black_cap_input], NNUE_HIDDEN_SIZE);
+        cap_idx = get_feature_index(perspective, acc->captured_piece_type, captured_color,
+                                    acc->capture_sq, bucket);
     }
 
+    ft_update(net, out, parent, to_idx, -1, from_idx, cap_idx);
+    thread_updates++;
+
+    acc->dirty[perspective] = false;
     return true;
 }
 
-void nnue_materialize_accumulator(const Board* board, NNUEAccumulator* acc, const NNUENetwork* net) {
-    if (acc == NULL || net == NULL) return;
-    if (acc->computed) return;
-
+// Bring one perspective of acc up to date: walk back to the nearest frame that
+// is clean for this perspective and replay the deltas, or refresh acc directly
+// if a frame on the way needs a refresh for it.
+static void materialize_perspective(const Board* board, NNUEAccumulator* acc, const NNUENetwork* net,
+                                    int perspective) {
     NNUEAccumulator* chain[256];
     int count = 0;
     NNUEAccumulator* cursor = acc;
 
-    while (cursor != NULL && !cursor->computed) {
-        if (cursor->requires_refresh || count >= (int)(sizeof(chain) / sizeof(chain[0]))) {
-            nnue_refresh_accumulator(board, acc, net);
+    while (cursor != NULL && cursor->dirty[perspective]) {
+        if (cursor->requires_refresh[perspective] || count >= (int)(sizeof(chain) / sizeof(chain[0]))) {
+            refresh_perspective(board, acc, net, perspective);
             return;
         }
         chain[count++] = cursor;
         cursor = cursor->previous;
     }
 
-    if (cursor == NULL || !cursor->computed) {
-        nnue_refresh_accumulator(board, acc, net);
+    if (cursor == NULL) {
+        refresh_perspective(board, acc, net, perspective);
         return;
     }
 
     for (int i = count - 1; i >= 0; i--) {
         NNUEAccumulator* frame = chain[i];
-        vec_copy(frame->white, cursor->white, NNUE_HIDDEN_SIZE);
-        vec_copy(frame->black, cursor->black, NNUE_HIDDEN_SIZE);
+        const int16_t* parent = perspective == 0 ? cursor->white : cursor->black;
 
-        if (!nnue_apply_lazy_delta(frame, net)) {
-            nnue_refresh_accumulator(board, acc, net);
+        if (!nnue_apply_lazy_delta(frame, parent, net, perspective)) {
+            refresh_perspective(board, acc, net, perspective);
             return;
         }
-
-        frame->computed = true;
-        frame->dirty = false;
         cursor = frame;
     }
 }
 
+void nnue_materialize_accumulator(const Board* board, NNUEAccumulator* acc, const NNUENetwork* net) {
+    if (acc == NULL || net == NULL || !net->loaded) return;
+    if (acc->computed) return;
+
+    if (board->whiteKings == 0 || board->blackKings == 0) {
+        nnue_refresh_accumulator(board, acc, net);
+        return;
+    }
+
+    for (int perspective = 0; perspective < 2; perspective++) {
+        if (acc->dirty[perspective]) {
+            materialize_perspective(board, acc, net, perspective);
+        }
+    }
+    acc->computed = true;
+}
+
 // Legacy wrapper that reads king positions from board
 static void nnue_update_piece_move(NNUEAccumulator* acc, const Board* board, const NNUENetwork* net,
-                                   int from_sq, int to_sq, int piece_type, int piece_color, bool apply) {
+                                   int from_sq, int to_sq, int piece_type, int piece_color,
+                                   int captured_piece_type, int capture_sq, bool apply) {
     if (acc == NULL || net == NULL) return;
     
     int white_king_sq = get_lsb(board->whiteKings);
@@ -607,7 +869,7 @@ static void nnue_update_piece_move(NNUEAccumulator* acc, const Board* board, con
     }
     
     nnue_update_piece_move_with_kings(acc, net, from_sq, to_sq, piece_type, piece_color,
-                                       white_king_sq, black_king_sq, apply);
+                                      captured_piece_type, capture_sq, white_king_sq, black_king_sq, apply);
 }
 
 // Apply move incrementally
@@ -615,40 +877,15 @@ static void nnue_update_piece_move(NNUEAccumulator* acc, const Board* board, con
 // captured_piece_type = -1 means no capture
 void nnue_apply_move(const Board* board, NNUEAccumulator* acc, const NNUENetwork* net, int from_sq, int to_sq, 
                      int piece_type, int captured_piece_type, bool is_white, bool is_en_passant) {
-    if (acc == NULL || net == NULL) return;
+    if (acc == NULL || net == NULL || !net->loaded) return;
     
     // WICHTIG: Nur inkrementell updaten wenn Accumulator bereits initialisiert!
     // Sonst würden wir Deltas auf Müllwerte anwenden.
     if (!acc->computed) return;
     
-    nnue_update_piece_move(acc, board, net, from_sq, to_sq, piece_type, is_white ? 0 : 1, true);
-    
-    if (captured_piece_type >= 0) {  // -1 means no capture
-        int capture_sq = to_sq;
-        if (is_en_passant) {
-            capture_sq = is_white ? (to_sq - 8) : (to_sq + 8);
-        }
-
-        int white_king_sq = get_lsb(board->whiteKings);
-        int black_king_sq = get_lsb(board->blackKings);
-
-        if (white_king_sq >= 0 && black_king_sq >= 0) {
-            KingBucket white_bucket = get_king_bucket(white_king_sq, 0);
-            KingBucket black_bucket = get_king_bucket(black_king_sq, 1);
-
-            int captured_color = is_white ? 1 : 0;
-            int white_cap_idx = get_feature_index(0, captured_piece_type, captured_color, capture_sq, white_bucket);
-            int black_cap_idx = get_feature_index(1, captured_piece_type, captured_color, capture_sq, black_bucket);
-
-            int white_bucket_idx = white_cap_idx / NNUE_INPUT_SIZE;
-            int white_cap_input = white_cap_idx % NNUE_INPUT_SIZE;
-            int black_bucket_idx = black_cap_idx / NNUE_INPUT_SIZE;
-            int black_cap_input = black_cap_idx % NNUE_INPUT_SIZE;
-
-            vec_sub(acc->white, net->ft_weights[white_bucket_idx][white_cap_input], NNUE_HIDDEN_SIZE);
-            vec_sub(acc->black, net->ft_weights[black_bucket_idx][black_cap_input], NNUE_HIDDEN_SIZE);
-        }
-    }
+    int capture_sq = is_en_passant ? (is_white ? (to_sq - 8) : (to_sq + 8)) : to_sq;
+    nnue_update_piece_move(acc, board, net, from_sq, to_sq, piece_type, is_white ? 0 : 1,
+                           captured_piece_type, capture_sq, true);
     // acc->computed bleibt true (war schon true, sonst hätten wir oben returned)
 }
 
@@ -657,38 +894,13 @@ void nnue_apply_move(const Board* board, NNUEAccumulator* acc, const NNUENetwork
 // captured_piece_type = -1 means no capture
 void nnue_undo_move(const Board* board, NNUEAccumulator* acc, const NNUENetwork* net, int from_sq, int to_sq,
                     int piece_type, int captured_piece_type, bool is_white, bool is_en_passant) {
-    if (acc == NULL || net == NULL) return;
+    if (acc == NULL || net == NULL || !net->loaded) return;
     
     // WICHTIG: Nur inkrementell updaten wenn Accumulator bereits initialisiert!
     if (!acc->computed) return;
     
-    nnue_update_piece_move(acc, board, net, from_sq, to_sq, piece_type, is_white ? 0 : 1, false);
-    
-    if (captured_piece_type >= 0) {  // -1 means no capture
-        int capture_sq = to_sq;
-        if (is_en_passant) {
-            capture_sq = is_white ? (to_sq - 8) : (to_sq + 8);
-        }
-
-        int white_king_sq = get_lsb(board->whiteKings);
-        int black_king_sq = get_lsb(board->blackKings);
-
-        if (white_king_sq >= 0 && black_king_sq >= 0) {
-            KingBucket white_bucket = get_king_bucket(white_king_sq, 0);
-            KingBucket black_bucket = get_king_bucket(black_king_sq, 1);
-
-            int captured_color = is_white ? 1 : 0;
-            int white_cap_idx = get_feature_index(0, captured_piece_type, captured_color, capture_sq, white_bucket);
-            int black_cap_idx = get_feature_index(1, captured_piece_type, captured_color, capture_sq, black_bucket);
-
-            int white_bucket_idx = white_cap_idx / NNUE_INPUT_SIZE;
-            int white_cap_input = white_cap_idx % NNUE_INPUT_SIZE;
-            int black_bucket_idx = black_cap_idx / NNUE_INPUT_SIZE;
-            int black_cap_input = black_cap_idx % NNUE_INPUT_SIZE;
-
-            vec_add(acc->white, net->ft_weights[white_bucket_idx][white_cap_input], NNUE_HIDDEN_SIZE);
-            vec_add(acc->black, net->ft_weights[black_bucket_idx][black_cap_input], NNUE_HIDDEN_SIZE);
-        }
-    }
+    int capture_sq = is_en_passant ? (is_white ? (to_sq - 8) : (to_sq + 8)) : to_sq;
+    nnue_update_piece_move(acc, board, net, from_sq, to_sq, piece_type, is_white ? 0 : 1,
+                           captured_piece_type, capture_sq, false);
     // acc->computed bleibt true (war schon true, sonst hätten wir oben returned)
 }
@@ -2,18 +2,24 @@
 #define NNUE_H
 
 #include "board.h"
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdalign.h>
 
 // NNUE Network Architecture
 #define NNUE_INPUT_SIZE      768   // 64 squares * 6 piece types * 2 colors
-#ifndef NNUE_HIDDEN_SIZE
-#define NNUE_HIDDEN_SIZE     256  // Hidden layer neurons per perspective
+// Hidden layer width is read from the net at load time; accumulators are
+// sized for the widest net this build accepts
+#ifndef NNUE_MAX_HIDDEN_SIZE
+#define NNUE_MAX_HIDDEN_SIZE 768  // Max hidden layer neurons per perspective
 #endif
 #define NNUE_INPUT_BUCKETS   10    // King position buckets
 #define NNUE_OUTPUT_BUCKETS  8     // Output buckets
 
+// Default network file; served from the binary itself when built with EMBED=1
+#define NNUE_DEFAULT_NET     "quantised.bin"
+
 // Feature indices
 #define NNUE_PIECE_PAWN      0
 #define NNUE_PIECE_KNIGHT    1
@@ -23,18 +29,37 @@
 #define NNUE_PIECE_KING      5
 
 // Quantization constants
+// Quantisation defaults for legacy nets without a header
 #define NNUE_QA              255   // Feature transformer weight quantization
 #define NNUE_QB              64    // Output layer weight quantization
 #define NNUE_SCALE           400   // Final output scale
 
+struct NNUENetwork;
+
+// Accumulator cache ("Finny table"): for every input bucket, mirror state and
+// perspective the accumulator last built there, together with the piece
+// bitboards it was built from. A refresh starts from the matching entry and
+// only adds/removes the pieces that differ, instead of rebuilding from the
+// biases. Entries stay exact for any position, so the cache never has to be
+// cleared except when the network changes.
+typedef struct {
+    alignas(64) int16_t values[NNUE_MAX_HIDDEN_SIZE];
+    Bitboard pieces[2][6];   // byTypeBB the values were built from
+} NNUEFinnyEntry;
+
+typedef struct NNUEFinnyTable {
+    NNUEFinnyEntry entry[NNUE_INPUT_BUCKETS][2][2]; // [bucket][mirrored][perspective]
+    uint64_t generation;                            // net load the entries belong to, 0 = empty
+} NNUEFinnyTable;
+
 // Accumulator for efficient incremental updates (activation values only)
 // Aligned to 64 bytes for AVX-512 optimal access
 typedef struct NNUEAccumulator {
-    alignas(64) int16_t white[NNUE_HIDDEN_SIZE];
-    alignas(64) int16_t black[NNUE_HIDDEN_SIZE];
-    bool computed;
-    bool dirty;
-    bool requires_refresh;
+    alignas(64) int16_t white[NNUE_MAX_HIDDEN_SIZE];
+    alignas(64) int16_t black[NNUE_MAX_HIDDEN_SIZE];
+    bool computed;              // both perspectives up to date
+    bool dirty[2];              // [perspective] lazy delta not applied yet
+    bool requires_refresh[2];   // [perspective] delta not incremental (bucket change, castling, promotion)
     struct NNUEAccumulator* previous;
     int from_sq;
     int to_sq;
@@ -44,21 +69,63 @@ typedef struct NNUEAccumulator {
     int capture_sq;
     int white_king_sq;
     int black_king_sq;
+    NNUEFinnyTable* cache;   // refresh cache, NULL = full refresh; inherited by children
 } NNUEAccumulator;
 
-// NNUE Network weights (separate from accumulator, can be loaded from file)
-// Aligned to 64 bytes for AVX-512 optimal access
-typedef struct {
-    // Feature transformer weights: [INPUT_BUCKETS][INPUT_SIZE][HIDDEN_SIZE]
-    alignas(64) int16_t ft_weights[NNUE_INPUT_BUCKETS][NNUE_INPUT_SIZE][NNUE_HIDDEN_SIZE];
-    // Feature transformer biases: [HIDDEN_SIZE]
-    alignas(64) int16_t ft_biases[NNUE_HIDDEN_SIZE];
+// On-disk network header (version 1). Weights follow at header_size in the
+// order ft weights [INPUT_BUCKETS][INPUT_SIZE][hidden], ft biases [hidden],
+// output weights [OUTPUT_BUCKETS][2 * hidden], output biases [OUTPUT_BUCKETS],
+// all little-endian int16. hash is FNV-1a over the weight data (64-bit words).
+//
+// With NNUE_FLAG_FT_INT8 the ft weights are int8, and the int16 weight of
+// bucket b is int8 * ft_scale[b]. The per-bucket scales follow the output
+// biases, as int16[NNUE_FT_SCALE_SLOTS] (unused slots 0); the weight
+// sections keep their 64 byte alignment.
+#define NNUE_FILE_MAGIC      "SMNNUE\0\0"
+#define NNUE_FILE_VERSION    1
+#define NNUE_FLAG_FT_INT8    1u
+#define NNUE_FT_SCALE_SLOTS  ((NNUE_INPUT_BUCKETS + 3) & ~3)  // padded to 8 bytes
 
-    // Output layer weights: [OUTPUT_BUCKETS][2 * HIDDEN_SIZE] (both perspectives concatenated)
-    alignas(64) int16_t output_weights[NNUE_OUTPUT_BUCKETS][2 * NNUE_HIDDEN_SIZE];
-    // Output layer biases: [OUTPUT_BUCKETS]
-    alignas(64) int16_t output_biases[NNUE_OUTPUT_BUCKETS];
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;      // multiple of 64 so the weights stay aligned
+    uint32_t input_size;
+    uint32_t input_buckets;
+    uint32_t output_buckets;
+    uint32_t hidden_size;
+    uint32_t qa;
+    uint32_t qb;
+    uint32_t scale;
+    uint32_t flags;            // NNUE_FLAG_*, 0 for plain int16 nets
+    uint64_t data_size;        // bytes of weight data after the header
+    uint64_t hash;
+} NNUEFileHeader;
+
+_Static_assert(sizeof(NNUEFileHeader) == 64, "NNUE file header must be 64 bytes");
 
+// NNUE Network weights (separate from accumulator, can be loaded from file)
+// Read-only view of the weights in a mmapped network file or the embedded
+// net; the layout is exactly the file layout, so nothing is copied.
+typedef struct NNUENetwork {
+    const int16_t* ft_weights;      // [INPUT_BUCKETS][INPUT_SIZE][hidden_size], NULL if ft_int8
+    const int8_t* ft_weights8;      // same layout as int8 (ft_int8 nets only)
+    const int16_t* ft_scales;       // [NNUE_FT_SCALE_SLOTS] int16 weight = int8 * scale (ft_int8 only)
+    bool ft_int8;                   // int8 ft weights, widened into the int16 accumulators
+    const int16_t* ft_biases;       // [hidden_size]
+    const int16_t* output_weights;  // [OUTPUT_BUCKETS][2 * hidden_size] (both perspectives concatenated)
+    const int16_t* output_biases;   // [OUTPUT_BUCKETS]
+
+    int hidden_size;         // from the file, multiple of 32, <= NNUE_MAX_HIDDEN_SIZE
+    int qa;
+    int qb;
+    int scale;
+    uint64_t hash;           // weight checksum (identifies the net)
+    uint64_t generation;     // unique per successful load
+    bool output_fast;        // output layer fits the int16/int32 SIMD kernel (see nnue_output_bound_ok)
+
+    void* mapping;           // mmapped file, NULL for the embedded net
+    size_t mapping_size;
     bool loaded;
 } NNUENetwork;
 
@@ -70,28 +137,39 @@ extern NNUENetwork nnue_net;
 // Initialize NNUE with random weights (for testing without a trained net)
 void nnue_init_random(void);
 
-// Load NNUE weights from file into network
+// Load NNUE weights from file into network (mmapped read-only, or the
+// embedded net for NNUE_DEFAULT_NET when built with EMBED=1)
 bool nnue_load(const char* filename, NNUENetwork* net);
 
-// Save NNUE weights to file
-bool nnue_save(const char* filename, const NNUENetwork* net);
+// Unmap a loaded network; safe to call on an unloaded one
+void nnue_unload(NNUENetwork* net);
 
-// Load NNUE weights from file into network
-bool nnue_load(const char* filename, NNUENetwork* net);
-
-// Save NNUE weights to file from network
-bool nnue_save(const char* filename, const NNUENetwork* net);
+// Save NNUE weights to file in the headered format, with int16 ft weights
+// (ft_int8 = false, expanding an int8 net) or int8 ft weights with per-bucket
+// scales chosen from the weights (ft_int8 = true, reports the scales and the
+// rounding error as info strings)
+bool nnue_save(const char* filename, const NNUENetwork* net, bool ft_int8);
 
 // Compute full accumulator from scratch - needs network for initial computation
 void nnue_reset_accumulator(const Board* board, NNUEAccumulator* acc, const NNUENetwork* net);
 
-// Refresh accumulator from current board state
+// Refresh accumulator from current board state (through acc->cache if set)
 void nnue_refresh_accumulator(const Board* board, NNUEAccumulator* acc, const NNUENetwork* net);
 
+// Accumulator perspectives the calling thread has rebuilt (from scratch or
+// the refresh cache) and updated incrementally so far; callers take
+// differences around the work they measure
+void nnue_thread_stats(uint64_t* refreshes, uint64_t* updates);
+
+// Invalidate all entries of an accumulator cache
+void nnue_finny_clear(NNUEFinnyTable* table);
+
 // Prepare/copy-make a child accumulator frame. The child is updated lazily on eval.
 void nnue_prepare_child_accumulator(NNUEAccumulator* child, NNUEAccumulator* parent);
 
 // Mark a prepared child accumulator as dirty for the move just made.
+// requires_refresh forces both perspectives to refresh; a king changing
+// buckets is detected here and only refreshes the mover's perspective.
 void nnue_mark_accumulator_dirty(NNUEAccumulator* acc, const Board* board, int from_sq, int to_sq,
                                  int piece_type, int captured_piece_type, bool is_white,
                                  bool is_en_passant, bool requires_refresh);
@@ -0,0 +1,588 @@
+#include "nnue_simd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define NNUE_SIMD_X86
+    #include <immintrin.h>
+    #define TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+    #define TARGET_AVX2   __attribute__((target("avx2")))
+    #define TARGET_SSE2   __attribute__((target("sse2")))
+#elif defined(__aarch64__)
+    #define NNUE_SIMD_NEON
+    #include <arm_neon.h>
+#endif
+
+// =============================================================================
+// Scalar fallback
+// =============================================================================
+
+static void add_scalar(int16_t* restrict dst, const int16_t* restrict src, int size) {
+    for (int i = 0; i < size; i++) {
+        dst[i] += src[i];
+    }
+}
+
+static void sub_scalar(int16_t* restrict dst, const int16_t* restrict src, int size) {
+    for (int i = 0; i < size; i++) {
+        dst[i] -= src[i];
+    }
+}
+
+static void sub_add_scalar(int16_t* restrict dst, const int16_t* restrict src_sub,
+                           const int16_t* restrict src_add, int size) {
+    for (int i = 0; i < size; i++) {
+        dst[i] = dst[i] - src_sub[i] + src_add[i];
+    }
+}
+
+static void copy_scalar(int16_t* restrict dst, const int16_t* restrict src, int size) {
+    memcpy(dst, src, size * sizeof(int16_t));
+}
+
+static void update_scalar(int16_t* dst, const int16_t* src, const int16_t* add0, const int16_t* add1,
+                          const int16_t* sub0, const int16_t* sub1, int size) {
+    for (int i = 0; i < size; i++) {
+        int16_t v = (int16_t)(src[i] + add0[i] - sub0[i]);
+        if (add1) v = (int16_t)(v + add1[i]);
+        if (sub1) v = (int16_t)(v - sub1[i]);
+        dst[i] = v;
+    }
+}
+
+static void add_i8_scalar(int16_t* restrict dst, const int8_t* restrict src, int16_t scale, int size) {
+    for (int i = 0; i < size; i++) {
+        dst[i] = (int16_t)(dst[i] + src[i] * scale);
+    }
+}
+
+static void sub_i8_scalar(int16_t* restrict dst, const int8_t* restrict src, int16_t scale, int size) {
+    for (int i = 0; i < size; i++) {
+        dst[i] = (int16_t)(dst[i] - src[i] * scale);
+    }
+}
+
+static void update_i8_scalar(int16_t* dst, const int16_t* src, const int8_t* add0, const int8_t* add1,
+                             const int8_t* sub0, const int8_t* sub1, int16_t scale, int size) {
+    for (int i = 0; i < size; i++) {
+        int d = add0[i] - sub0[i];
+        if (add1) d += add1[i];
+        if (sub1) d -= sub1[i];
+        dst[i] = (int16_t)(src[i] + d * scale);
+    }
+}
+
+int64_t nnue_screlu_dual_exact(const int16_t* us, const int16_t* them, const int16_t* w_us,
+                               const int16_t* w_them, int size, int16_t qa) {
+    int64_t output = 0;
+    for (int i = 0; i < size; i++) {
+        int64_t a = us[i] < 0 ? 0 : (us[i] > qa ? qa : us[i]);
+        int64_t b = them[i] < 0 ? 0 : (them[i] > qa ? qa : them[i]);
+        output += a * a * w_us[i] + b * b * w_them[i];
+    }
+    return output;
+}
+
+// Exact reference: int64 throughout, no assumption on QA or weight range
+static int32_t screlu_dual_scalar(const int16_t* us, const int16_t* them, const int16_t* w_us,
+                                  const int16_t* w_them, int size, int16_t qa) {
+    return (int32_t)nnue_screlu_dual_exact(us, them, w_us, w_them, size, qa);
+}
+
+// Fused update on tiles of 4 registers: every input row is streamed once and
+// the result stored once, instead of one load/store pass per feature. The
+// optional rows are tested per tile; the branch is loop invariant.
+#define DEFINE_UPDATE_KERNEL(NAME, ATTR, VEC, LANES, LOAD, LOADU, STORE, ADD, SUB)             \
+    ATTR static void NAME(int16_t* dst, const int16_t* src, const int16_t* add0,             \
+                          const int16_t* add1, const int16_t* sub0, const int16_t* sub1,     \
+                          int size) {                                                        \
+        int i = 0;                                                                           \
+        for (; i + 4 * (LANES) <= size; i += 4 * (LANES)) {                                  \
+            VEC r[4];                                                                        \
+            for (int k = 0; k < 4; k++) {                                                    \
+                int o = i + k * (LANES);                                                     \
+                r[k] = SUB(ADD(LOAD(src + o), LOADU(add0 + o)), LOADU(sub0 + o));            \
+            }                                                                                \
+            if (add1) {                                                                      \
+                for (int k = 0; k < 4; k++) r[k] = ADD(r[k], LOADU(add1 + i + k * (LANES))); \
+            }                                                                                \
+            if (sub1) {                                                                      \
+                for (int k = 0; k < 4; k++) r[k] = SUB(r[k], LOADU(sub1 + i + k * (LANES))); \
+            }                                                                                \
+            for (int k = 0; k < 4; k++) STORE(dst + i + k * (LANES), r[k]);                  \
+        }                                                                                    \
+        for (; i < size; i += (LANES)) {                                                     \
+            VEC r = SUB(ADD(LOAD(src + i), LOADU(add0 + i)), LOADU(sub0 + i));               \
+            if (add1) r = ADD(r, LOADU(add1 + i));                                           \
+            if (sub1) r = SUB(r, LOADU(sub1 + i));                                           \
+            STORE(dst + i, r);                                                               \
+        }                                                                                    \
+    }
+
+// The same kernels on int8 weight rows. WIDEN loads LANES int8 values as
+// int16; the row deltas are summed before the single multiply by the scale
+// (exact: every term fits int16 long before the product would wrap).
+#define DEFINE_I8_KERNELS(SUFFIX, ATTR, VEC, LANES, LOAD, STORE, ADD, SUB, MUL, SET1, WIDEN)    \
+    ATTR static void add_i8_##SUFFIX(int16_t* restrict dst, const int8_t* restrict src,        \
+                                     int16_t scale, int size) {                                \
+        const VEC s = SET1(scale);                                                             \
+        for (int i = 0; i < size; i += (LANES)) {                                              \
+            STORE(dst + i, ADD(LOAD(dst + i), MUL(WIDEN(src + i), s)));                        \
+        }                                                                                      \
+    }                                                                                          \
+    ATTR static void sub_i8_##SUFFIX(int16_t* restrict dst, const int8_t* restrict src,        \
+                                     int16_t scale, int size) {                                \
+        const VEC s = SET1(scale);                                                             \
+        for (int i = 0; i < size; i += (LANES)) {                                              \
+            STORE(dst + i, SUB(LOAD(dst + i), MUL(WIDEN(src + i), s)));                        \
+        }                                                                                      \
+    }                                                                                          \
+    ATTR static void update_i8_##SUFFIX(int16_t* dst, const int16_t* src, const int8_t* add0,  \
+                                        const int8_t* add1, const int8_t* sub0,                \
+                                        const int8_t* sub1, int16_t scale, int size) {         \
+        const VEC s = SET1(scale);                                                             \
+        int i = 0;                                                                             \
+        for (; i + 4 * (LANES) <= size; i += 4 * (LANES)) {                                    \
+            VEC r[4];                                                                          \
+            for (int k = 0; k < 4; k++) {                                                      \
+                int o = i + k * (LANES);                                                       \
+                r[k] = SUB(WIDEN(add0 + o), WIDEN(sub0 + o));                                  \
+            }                                                                                  \
+            if (add1) {                                                                        \
+                for (int k = 0; k < 4; k++) r[k] = ADD(r[k], WIDEN(add1 + i + k * (LANES)));   \
+            }                                                                                  \
+            if (sub1) {                                                                        \
+                for (int k = 0; k < 4; k++) r[k] = SUB(r[k], WIDEN(sub1 + i + k * (LANES)));   \
+            }                                                                                  \
+            for (int k = 0; k < 4; k++) {                                                      \
+                int o = i + k * (LANES);                                                       \
+                STORE(dst + o, ADD(LOAD(src + o), MUL(r[k], s)));                              \
+            }                                                                                  \
+        }                                                                                      \
+        for (; i < size; i += (LANES)) {                                                       \
+            VEC r = SUB(WIDEN(add0 + i), WIDEN(sub0 + i));                                     \
+            if (add1) r = ADD(r, WIDEN(add1 + i));                                             \
+            if (sub1) r = SUB(r, WIDEN(sub1 + i));                                             \
+            STORE(dst + i, ADD(LOAD(src + i), MUL(r, s)));                                     \
+        }                                                                                      \
+    }
+
+#ifdef NNUE_SIMD_X86
+
+// =============================================================================
+// AVX-512 (F + BW)
+// =============================================================================
+
+TARGET_AVX512
+static void add_avx512(int16_t* restrict dst, const int16_t* restrict src, int size) {
+    for (int i = 0; i < size; i += 32) {
+        __m512i d = _mm512_load_si512((const __m512i*)(dst + i));
+        __m512i s = _mm512_loadu_si512((const __m512i*)(src + i));
+        _mm512_store_si512((__m512i*)(dst + i), _mm512_add_epi16(d, s));
+    }
+}
+
+TARGET_AVX512
+static void sub_avx512(int16_t* restrict dst, const int16_t* restrict src, int size) {
+    for (int i = 0; i < size; i += 32) {
+        __m512i d = _mm512_load_si512((const __m512i*)(dst + i));
+        __m512i s = _mm512_loadu_si512((const __m512i*)(src + i));
+        _mm512_store_si512((__m512i*)(dst + i), _mm512_sub_epi16(d, s));
+    }
+}
+
+TARGET_AVX512
+static void sub_add_avx512(int16_t* restrict dst, const int16_t* restrict src_sub,
+                           const int16_t* restrict src_add, int size) {
+    for (int i = 0; i < size; i += 32) {
+        __m512i d = _mm512_load_si512((const __m512i*)(dst + i));
+        __m512i sub = _mm512_loadu_si512((const __m512i*)(src_sub + i));
+        __m512i add = _mm512_loadu_si512((const __m512i*)(src_add + i));
+        d = _mm512_sub_epi16(d, sub);
+        d = _mm512_add_epi16(d, add);
+        _mm512_store_si512((__m512i*)(dst + i), d);
+    }
+}
+
+TARGET_AVX512
+static void copy_avx512(int16_t* restrict dst, const int16_t* restrict src, int size) {
+    for (int i = 0; i < size; i += 32) {
+        __m512i v = _mm512_loadu_si512((const __m512i*)(src + i));
+        _mm512_store_si512((__m512i*)(dst + i), v);
+    }
+}
+
+#define LOAD512(p)     _mm512_load_si512((const void*)(p))
+#define LOADU512(p)    _mm512_loadu_si512((const void*)(p))
+#define STORE512(p, v) _mm512_store_si512((void*)(p), v)
+DEFINE_UPDATE_KERNEL(update_avx512, TARGET_AVX512, __m512i, 32, LOAD512, LOADU512, STORE512,
+                     _mm512_add_epi16, _mm512_sub_epi16)
+#define WIDEN512(p) _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(p)))
+DEFINE_I8_KERNELS(avx512, TARGET_AVX512, __m512i, 32, LOAD512, STORE512, _mm512_add_epi16,
+                  _mm512_sub_epi16, _mm512_mullo_epi16, _mm512_set1_epi16, WIDEN512)
+
+// SCReLU² dot product using Leorik's trick:
+// Instead of (a * a) * w (overflow since 255²=65025 > int16_max)
+// Compute (a * w) * a, then use madd_epi16 for efficiency
+// This works when weights are in reasonable range (typically [-127..127] after quantization)
+TARGET_AVX512
+static int32_t screlu_dual_avx512(const int16_t* us, const int16_t* them, const int16_t* w_us,
+                                  const int16_t* w_them, int size, int16_t qa_value) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i qa = _mm512_set1_epi16(qa_value);
+    __m512i sum_us = _mm512_setzero_si512();
+    __m512i sum_them = _mm512_setzero_si512();
+
+    for (int i = 0; i < size; i += 32) {
+        __m512i a = _mm512_min_epi16(_mm512_max_epi16(_mm512_load_si512((const void*)(us + i)), zero), qa);
+        __m512i b = _mm512_min_epi16(_mm512_max_epi16(_mm512_load_si512((const void*)(them + i)), zero), qa);
+        __m512i wa = _mm512_loadu_si512((const void*)(w_us + i));
+        __m512i wb = _mm512_loadu_si512((const void*)(w_them + i));
+
+        // (a * w) * a using madd - same trick as AVX2
+        sum_us = _mm512_add_epi32(sum_us, _mm512_madd_epi16(_mm512_mullo_epi16(a, wa), a));
+        sum_them = _mm512_add_epi32(sum_them, _mm512_madd_epi16(_mm512_mullo_epi16(b, wb), b));
+    }
+
+    return _mm512_reduce_add_epi32(_mm512_add_epi32(sum_us, sum_them));
+}
+
+// =============================================================================
+// AVX2
+// =============================================================================
+
+TARGET_AVX2
+static void add_avx2(int16_t* restrict dst, const int16_t* restrict src, int size) {
+    for (int i = 0; i < size; i += 16) {
+        __m256i d = _mm256_load_si256((const __m256i*)(dst + i));
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_store_si256((__m256i*)(dst + i), _mm256_add_epi16(d, s));
+    }
+}
+
+TARGET_AVX2
+static void sub_avx2(int16_t* restrict dst, const int16_t* restrict src, int size) {
+    for (int i = 0; i < size; i += 16) {
+        __m256i d = _mm256_load_si256((const __m256i*)(dst + i));
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_store_si256((__m256i*)(dst + i), _mm256_sub_epi16(d, s));
+    }
+}
+
+TARGET_AVX2
+static void sub_add_avx2(int16_t* restrict dst, const int16_t* restrict src_sub,
+                         const int16_t* restrict src_add, int size) {
+    for (int i = 0; i < size; i += 16) {
+        __m256i d = _mm256_load_si256((const __m256i*)(dst + i));
+        __m256i sub = _mm256_loadu_si256((const __m256i*)(src_sub + i));
+        __m256i add = _mm256_loadu_si256((const __m256i*)(src_add + i));
+        d = _mm256_sub_epi16(d, sub);
+        d = _mm256_add_epi16(d, add);
+        _mm256_store_si256((__m256i*)(dst + i), d);
+    }
+}
+
+TARGET_AVX2
+static void copy_avx2(int16_t* restrict dst, const int16_t* restrict src, int size) {
+    for (int i = 0; i < size; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_store_si256((__m256i*)(dst + i), v);
+    }
+}
+
+#define LOAD256(p)     _mm256_load_si256((const __m256i*)(p))
+#define LOADU256(p)    _mm256_loadu_si256((const __m256i*)(p))
+#define STORE256(p, v) _mm256_store_si256((__m256i*)(p), v)
+DEFINE_UPDATE_KERNEL(update_avx2, TARGET_AVX2, __m256i, 16, LOAD256, LOADU256, STORE256,
+                     _mm256_add_epi16, _mm256_sub_epi16)
+#define WIDEN256(p) _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(p)))
+DEFINE_I8_KERNELS(avx2, TARGET_AVX2, __m256i, 16, LOAD256, STORE256, _mm256_add_epi16,
+                  _mm256_sub_epi16, _mm256_mullo_epi16, _mm256_set1_epi16, WIDEN256)
+
+TARGET_AVX2
+static int32_t screlu_dual_avx2(const int16_t* us, const int16_t* them, const int16_t* w_us,
+                                const int16_t* w_them, int size, int16_t qa_value) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i qa = _mm256_set1_epi16(qa_value);
+    __m256i sum_us = _mm256_setzero_si256();
+    __m256i sum_them = _mm256_setzero_si256();
+
+    for (int i = 0; i < size; i += 16) {
+        __m256i a = _mm256_min_epi16(_mm256_max_epi16(_mm256_load_si256((const __m256i*)(us + i)), zero), qa);
+        __m256i b = _mm256_min_epi16(_mm256_max_epi16(_mm256_load_si256((const __m256i*)(them + i)), zero), qa);
+        __m256i wa = _mm256_loadu_si256((const __m256i*)(w_us + i));
+        __m256i wb = _mm256_loadu_si256((const __m256i*)(w_them + i));
+
+        // (a * w) * a using madd
+        sum_us = _mm256_add_epi32(sum_us, _mm256_madd_epi16(_mm256_mullo_epi16(a, wa), a));
+        sum_them = _mm256_add_epi32(sum_them, _mm256_madd_epi16(_mm256_mullo_epi16(b, wb), b));
+    }
+
+    // Single horizontal sum for both perspectives
+    __m256i sum = _mm256_add_epi32(sum_us, sum_them);
+    __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum128);
+}
+
+// =============================================================================
+// SSE2 (baseline on x86-64)
+// =============================================================================
+
+TARGET_SSE2
+static void add_sse2(int16_t* restrict dst, const int16_t* restrict src, int size) {
+    for (int i = 0; i < size; i += 8) {
+        __m128i d = _mm_load_si128((const __m128i*)(dst + i));
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_store_si128((__m128i*)(dst + i), _mm_add_epi16(d, s));
+    }
+}
+
+TARGET_SSE2
+static void sub_sse2(int16_t* restrict dst, const int16_t* restrict src, int size) {
+    for (int i = 0; i < size; i += 8) {
+        __m128i d = _mm_load_si128((const __m128i*)(dst + i));
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_store_si128((__m128i*)(dst + i), _mm_sub_epi16(d, s));
+    }
+}
+
+TARGET_SSE2
+static void sub_add_sse2(int16_t* restrict dst, const int16_t* restrict src_sub,
+                         const int16_t* restrict src_add, int size) {
+    for (int i = 0; i < size; i += 8) {
+        __m128i d = _mm_load_si128((const __m128i*)(dst + i));
+        __m128i sub = _mm_loadu_si128((const __m128i*)(src_sub + i));
+        __m128i add = _mm_loadu_si128((const __m128i*)(src_add + i));
+        d = _mm_sub_epi16(d, sub);
+        d = _mm_add_epi16(d, add);
+        _mm_store_si128((__m128i*)(dst + i), d);
+    }
+}
+
+TARGET_SSE2
+static void copy_sse2(int16_t* restrict dst, const int16_t* restrict src, int size) {
+    for (int i = 0; i < size; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_store_si128((__m128i*)(dst + i), v);
+    }
+}
+
+#define LOAD128(p)     _mm_load_si128((const __m128i*)(p))
+#define LOADU128(p)    _mm_loadu_si128((const __m128i*)(p))
+#define STORE128(p, v) _mm_store_si128((__m128i*)(p), v)
+DEFINE_UPDATE_KERNEL(update_sse2, TARGET_SSE2, __m128i, 8, LOAD128, LOADU128, STORE128,
+                     _mm_add_epi16, _mm_sub_epi16)
+
+// SSE2 has no sign extension (pmovsxbw is SSE4.1): put each byte in the high
+// half of a word and shift it back down arithmetically
+TARGET_SSE2
+static inline __m128i widen_i8_sse2(const int8_t* p) {
+    __m128i v = _mm_loadl_epi64((const __m128i*)p);
+    return _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+}
+DEFINE_I8_KERNELS(sse2, TARGET_SSE2, __m128i, 8, LOAD128, STORE128, _mm_add_epi16,
+                  _mm_sub_epi16, _mm_mullo_epi16, _mm_set1_epi16, widen_i8_sse2)
+
+TARGET_SSE2
+static int32_t screlu_dual_sse2(const int16_t* us, const int16_t* them, const int16_t* w_us,
+                                const int16_t* w_them, int size, int16_t qa_value) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i qa = _mm_set1_epi16(qa_value);
+    __m128i sum_us = _mm_setzero_si128();
+    __m128i sum_them = _mm_setzero_si128();
+
+    for (int i = 0; i < size; i += 8) {
+        __m128i a = _mm_min_epi16(_mm_max_epi16(_mm_load_si128((const __m128i*)(us + i)), zero), qa);
+        __m128i b = _mm_min_epi16(_mm_max_epi16(_mm_load_si128((const __m128i*)(them + i)), zero), qa);
+        __m128i wa = _mm_loadu_si128((const __m128i*)(w_us + i));
+        __m128i wb = _mm_loadu_si128((const __m128i*)(w_them + i));
+
+        sum_us = _mm_add_epi32(sum_us, _mm_madd_epi16(_mm_mullo_epi16(a, wa), a));
+        sum_them = _mm_add_epi32(sum_them, _mm_madd_epi16(_mm_mullo_epi16(b, wb), b));
+    }
+
+    __m128i sum = _mm_add_epi32(sum_us, sum_them);
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+
+#endif // NNUE_SIMD_X86
+
+#ifdef NNUE_SIMD_NEON
+
+// =============================================================================
+// NEON (aarch64)
+// =============================================================================
+
+static void add_neon(int16_t* restrict dst, const int16_t* restrict src, int size) {
+    for (int i = 0; i < size; i += 8) {
+        vst1q_s16(dst + i, vaddq_s16(vld1q_s16(dst + i), vld1q_s16(src + i)));
+    }
+}
+
+static void sub_neon(int16_t* restrict dst, const int16_t* restrict src, int size) {
+    for (int i = 0; i < size; i += 8) {
+        vst1q_s16(dst + i, vsubq_s16(vld1q_s16(dst + i), vld1q_s16(src + i)));
+    }
+}
+
+static void sub_add_neon(int16_t* restrict dst, const int16_t* restrict src_sub,
+                         const int16_t* restrict src_add, int size) {
+    for (int i = 0; i < size; i += 8) {
+        int16x8_t d = vsubq_s16(vld1q_s16(dst + i), vld1q_s16(src_sub + i));
+        vst1q_s16(dst + i, vaddq_s16(d, vld1q_s16(src_add + i)));
+    }
+}
+
+static void copy_neon(int16_t* restrict dst, const int16_t* restrict src, int size) {
+    for (int i = 0; i < size; i += 8) {
+        vst1q_s16(dst + i, vld1q_s16(src + i));
+    }
+}
+
+DEFINE_UPDATE_KERNEL(update_neon, , int16x8_t, 8, vld1q_s16, vld1q_s16, vst1q_s16,
+                     vaddq_s16, vsubq_s16)
+#define WIDEN_NEON(p) vmovl_s8(vld1_s8(p))
+DEFINE_I8_KERNELS(neon, , int16x8_t, 8, vld1q_s16, vst1q_s16, vaddq_s16, vsubq_s16,
+                  vmulq_s16, vdupq_n_s16, WIDEN_NEON)
+
+// Same (a * w) * a scheme as the x86 kernels: the wrapping int16 multiply
+// matches mullo_epi16, the widening multiply-accumulate matches madd_epi16
+static int32_t screlu_dual_neon(const int16_t* us, const int16_t* them, const int16_t* w_us,
+                                const int16_t* w_them, int size, int16_t qa_value) {
+    const int16x8_t zero = vdupq_n_s16(0);
+    const int16x8_t qa = vdupq_n_s16(qa_value);
+    int32x4_t sum_us = vdupq_n_s32(0);
+    int32x4_t sum_them = vdupq_n_s32(0);
+
+    for (int i = 0; i < size; i += 8) {
+        int16x8_t a = vminq_s16(vmaxq_s16(vld1q_s16(us + i), zero), qa);
+        int16x8_t b = vminq_s16(vmaxq_s16(vld1q_s16(them + i), zero), qa);
+        int16x8_t aw = vmulq_s16(a, vld1q_s16(w_us + i));
+        int16x8_t bw = vmulq_s16(b, vld1q_s16(w_them + i));
+        sum_us = vmlal_s16(sum_us, vget_low_s16(aw), vget_low_s16(a));
+        sum_us = vmlal_high_s16(sum_us, aw, a);
+        sum_them = vmlal_s16(sum_them, vget_low_s16(bw), vget_low_s16(b));
+        sum_them = vmlal_high_s16(sum_them, bw, b);
+    }
+
+    return vaddvq_s32(vaddq_s32(sum_us, sum_them));
+}
+
+#endif // NNUE_SIMD_NEON
+
+NNUEKernels nnue_kernels = {
+    "scalar", add_scalar, sub_scalar, sub_add_scalar, copy_scalar, update_scalar, screlu_dual_scalar,
+    add_i8_scalar, sub_i8_scalar, update_i8_scalar
+};
+
+void nnue_simd_init(void) {
+#if defined(NNUE_SIMD_X86)
+    static const NNUEKernels avx512 = {
+        "avx512", add_avx512, sub_avx512, sub_add_avx512, copy_avx512, update_avx512, screlu_dual_avx512,
+        add_i8_avx512, sub_i8_avx512, update_i8_avx512
+    };
+    static const NNUEKernels avx2 = {
+        "avx2", add_avx2, sub_avx2, sub_add_avx2, copy_avx2, update_avx2, screlu_dual_avx2,
+        add_i8_avx2, sub_i8_avx2, update_i8_avx2
+    };
+    static const NNUEKernels sse2 = {
+        "sse2", add_sse2, sub_sse2, sub_add_sse2, copy_sse2, update_sse2, screlu_dual_sse2,
+        add_i8_sse2, sub_i8_sse2, update_i8_sse2
+    };
+
+    // Checks CPUID and that the OS saves the wider registers (XGETBV)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        nnue_kernels = avx512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        nnue_kernels = avx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        nnue_kernels = sse2;
+    }
+#elif defined(NNUE_SIMD_NEON)
+    static const NNUEKernels neon = {
+        "neon", add_neon, sub_neon, sub_add_neon, copy_neon, update_neon, screlu_dual_neon,
+        add_i8_neon, sub_i8_neon, update_i8_neon
+    };
+    nnue_kernels = neon;
+#endif
+}
+
+void nnue_simd_bench(int hidden_size) {
+    enum { ROWS = 10 * 768, FRAMES = 64, UPDATES = 1 << 20 };
+    const size_t row_bytes = (size_t)hidden_size * sizeof(int16_t);
+
+    // Weight matrix of the real size, so row fetches miss like in search
+    int16_t* weights = aligned_alloc(64, ROWS * row_bytes);
+    int8_t* weights8 = aligned_alloc(64, (size_t)ROWS * hidden_size);
+    int16_t* frames = aligned_alloc(64, FRAMES * row_bytes);
+    int* rows = malloc(sizeof(int) * 3 * UPDATES);
+    if (weights == NULL || weights8 == NULL || frames == NULL || rows == NULL) {
+        free(weights);
+        free(weights8);
+        free(frames);
+        free(rows);
+        return;
+    }
+    for (size_t i = 0; i < (size_t)ROWS * hidden_size; i++) {
+        weights8[i] = (int8_t)((i * 7919) % 61 - 30);
+        weights[i] = weights8[i];
+    }
+    memset(frames, 0, FRAMES * row_bytes);
+
+    uint32_t seed = 12345;
+    for (int i = 0; i < 3 * UPDATES; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        rows[i] = (int)((seed >> 8) % ROWS);
+    }
+
+    // hot: rows drawn from a small set that stays in L1/L2 (kernel cost only);
+    // cold: rows spread over the whole matrix (includes the cache misses)
+    for (int hot = 1; hot >= 0; hot--) {
+    for (int capture = 0; capture <= 1; capture++) {
+        double ns[3];
+        const int row_mask = hot ? 15 : -1;
+        // 0 = separate passes, 1 = fused, 2 = fused on the int8 matrix
+        for (int fused = 0; fused <= 2; fused++) {
+            clock_t start = clock();
+            for (int n = 0; n < UPDATES; n++) {
+                // Parent -> child as in a search line (frames reused cyclically)
+                const int16_t* parent = frames + (size_t)(n % FRAMES) * hidden_size;
+                int16_t* child = frames + (size_t)((n + 1) % FRAMES) * hidden_size;
+                const int16_t* add0 = weights + (size_t)(rows[3 * n] & row_mask) * hidden_size;
+                const int16_t* sub0 = weights + (size_t)(rows[3 * n + 1] & row_mask) * hidden_size;
+                const int16_t* sub1 = capture ? weights + (size_t)(rows[3 * n + 2] & row_mask) * hidden_size
+                                              : NULL;
+                if (fused == 2) {
+                    const size_t a = (size_t)(add0 - weights), s0 = (size_t)(sub0 - weights);
+                    nnue_kernels.update_i8(child, parent, weights8 + a, NULL, weights8 + s0,
+                                           sub1 ? weights8 + (sub1 - weights) : NULL, 1, hidden_size);
+                } else if (fused) {
+                    nnue_kernels.update(child, parent, add0, NULL, sub0, sub1, hidden_size);
+                } else {
+                    nnue_kernels.copy(child, parent, hidden_size);
+                    nnue_kernels.sub_add(child, sub0, add0, hidden_size);
+                    if (sub1) nnue_kernels.sub(child, sub1, hidden_size);
+                }
+            }
+            ns[fused] = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / UPDATES;
+        }
+        printf("info string nnuebench %s hidden %d %s %s: separate %.1f ns, fused %.1f ns (%.2fx), "
+               "fused int8 %.1f ns\n",
+               nnue_kernels.name, hidden_size, hot ? "hot" : "cold", capture ? "capture" : "quiet",
+               ns[0], ns[1], ns[1] > 0 ? ns[0] / ns[1] : 0.0, ns[2]);
+    }
+    }
+    fflush(stdout);
+
+    free(rows);
+    free(weights);
+    free(weights8);
+    free(frames);
+}
@@ -0,0 +1,53 @@
+#ifndef NNUE_SIMD_H
+#define NNUE_SIMD_H
+
+#include <stdint.h>
+
+// NNUE vector kernels, one variant per instruction set built into the same
+// binary. nnue_simd_init() picks the best one the CPU supports at runtime
+// (CPUID on x86, NEON is always present on aarch64); until then the scalar
+// kernels are used.
+//
+// All sizes are multiples of 32. dst/acc pointers must be 64 byte aligned
+// (accumulators), weight rows only need natural int16 alignment.
+typedef struct {
+    const char* name;
+    void (*add)(int16_t* restrict dst, const int16_t* restrict src, int size);
+    void (*sub)(int16_t* restrict dst, const int16_t* restrict src, int size);
+    void (*sub_add)(int16_t* restrict dst, const int16_t* restrict src_sub,
+                    const int16_t* restrict src_add, int size);
+    void (*copy)(int16_t* restrict dst, const int16_t* restrict src, int size);
+    // Fused update: dst = src + add0 (+ add1) - sub0 (- sub1) in one pass.
+    // add1/sub1 may be NULL, dst may alias src.
+    void (*update)(int16_t* dst, const int16_t* src, const int16_t* add0, const int16_t* add1,
+                   const int16_t* sub0, const int16_t* sub1, int size);
+    // Output layer for both perspectives with a single reduction:
+    // sum clamp(us, 0, qa)^2 * w_us + clamp(them, 0, qa)^2 * w_them.
+    // Computed as (a * w) * a with madd: only valid for nets that pass
+    // NNUENetwork.output_fast (bound checked by nnue.c at load time).
+    int32_t (*screlu_dual)(const int16_t* us, const int16_t* them, const int16_t* w_us,
+                           const int16_t* w_them, int size, int16_t qa);
+    // add/sub/update for int8 weight rows (ft_int8 nets): every row value is
+    // widened to int16 and multiplied by scale, with the same int16 results
+    // as the matching int16 row
+    void (*add_i8)(int16_t* restrict dst, const int8_t* restrict src, int16_t scale, int size);
+    void (*sub_i8)(int16_t* restrict dst, const int8_t* restrict src, int16_t scale, int size);
+    void (*update_i8)(int16_t* dst, const int16_t* src, const int8_t* add0, const int8_t* add1,
+                      const int8_t* sub0, const int8_t* sub1, int16_t scale, int size);
+} NNUEKernels;
+
+extern NNUEKernels nnue_kernels;
+
+// Exact int64 output layer (reference and fallback for any QA/weight range)
+int64_t nnue_screlu_dual_exact(const int16_t* us, const int16_t* them, const int16_t* w_us,
+                               const int16_t* w_them, int size, int16_t qa);
+
+// Select the kernels for this CPU (idempotent)
+void nnue_simd_init(void);
+
+// Micro-benchmark: child accumulator updates (quiet move and capture) with
+// the fused kernel vs. separate copy/sub_add/sub passes, and the fused
+// kernel on int8 weight rows, at the given width
+void nnue_simd_bench(int hidden_size);
+
+#endif // NNUE_SIMD_H
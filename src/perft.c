@@ -0,0 +1,181 @@
+#include "perft.h"
+#include "board_modifiers.h"
+#include "move.h"
+#include "move_generator.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// =============================================================================
+// Perft hash
+//
+// Always-replace table shared by all perft threads without locks. Each entry
+// stores key ^ data next to data (data = nodes << 8 | depth), so a torn entry
+// written concurrently by two threads fails the key check instead of
+// returning a wrong count - the same trick the TT uses.
+// =============================================================================
+typedef struct {
+    uint64_t key;   // zobrist key ^ data
+    uint64_t data;  // nodes << 8 | depth
+} PerftEntry;
+
+typedef struct {
+    PerftEntry* entries;
+    uint64_t mask;  // entry count - 1 (power of two), unused when entries == NULL
+} PerftHash;
+
+static inline uint64_t perft_hash_index(const PerftHash* hash, uint64_t key, int depth) {
+    // Different depths of the same position go to different slots
+    return (key ^ ((uint64_t)depth * 0x9E3779B97F4A7C15ULL)) & hash->mask;
+}
+
+static bool perft_hash_probe(const PerftHash* hash, uint64_t key, int depth, uint64_t* nodes) {
+    const PerftEntry* e = &hash->entries[perft_hash_index(hash, key, depth)];
+    uint64_t k = __atomic_load_n(&e->key, __ATOMIC_RELAXED);
+    uint64_t d = __atomic_load_n(&e->data, __ATOMIC_RELAXED);
+    if ((k ^ d) != key || (int)(d & 0xFF) != depth) return false;
+    *nodes = d >> 8;
+    return true;
+}
+
+static void perft_hash_store(PerftHash* hash, uint64_t key, int depth, uint64_t nodes) {
+    PerftEntry* e = &hash->entries[perft_hash_index(hash, key, depth)];
+    uint64_t d = (nodes << 8) | (uint64_t)depth;
+    __atomic_store_n(&e->key, key ^ d, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->data, d, __ATOMIC_RELAXED);
+}
+
+static bool perft_hash_init(PerftHash* hash, size_t hash_mb) {
+    hash->entries = NULL;
+    hash->mask = 0;
+    if (hash_mb == 0) return true;
+
+    uint64_t count = 1;
+    while (count * 2 * sizeof(PerftEntry) <= (uint64_t)hash_mb * 1024 * 1024) count *= 2;
+    hash->entries = (PerftEntry*)calloc(count, sizeof(PerftEntry));
+    if (hash->entries == NULL) {
+        fprintf(stderr, "info string Failed to allocate %zu MB perft hash\n", hash_mb);
+        return false;
+    }
+    hash->mask = count - 1;
+    return true;
+}
+
+// =============================================================================
+// Recursive count
+// =============================================================================
+
+static uint64_t perft_hashed(Board* board, int depth, PerftHash* hash) {
+    // Bulk counting: the leaves themselves are never made
+    if (depth == 1) {
+        MoveList legal;
+        generateLegalMoves(board, &legal);
+        return (uint64_t)legal.count;
+    }
+
+    // Depth 2+ only: depth 1 is about as cheap as a probe
+    uint64_t nodes = 0;
+    if (hash->entries != NULL && perft_hash_probe(hash, board->zobristKey, depth, &nodes)) {
+        return nodes;
+    }
+
+    MoveList moves;
+    generateLegalMoves(board, &moves);
+    for (int i = 0; i < moves.count; ++i) {
+        Move m = moves.moves[i];
+        MoveUndoInfo undo_info;
+        applyMove(board, m, &undo_info, NULL, NULL);  // perft doesn't need NNUE
+        nodes += perft_hashed(board, depth - 1, hash);
+        undoMove(board, m, &undo_info, NULL, NULL);
+    }
+
+    if (hash->entries != NULL) perft_hash_store(hash, board->zobristKey, depth, nodes);
+    return nodes;
+}
+
+uint64_t perft(Board* board, int depth) {
+    if (depth <= 0) return 1;
+    PerftHash no_hash = {NULL, 0};
+    return perft_hashed(board, depth, &no_hash);
+}
+
+// =============================================================================
+// Parallel root split
+//
+// Threads take the next unclaimed root move from a shared counter, so a few
+// expensive subtrees do not leave the other threads idle.
+// =============================================================================
+typedef struct {
+    const Board* root;
+    const MoveList* root_moves;
+    uint64_t* counts;         // per root move
+    atomic_int next;          // next unclaimed root move
+    int depth;                // remaining depth below the root moves
+    PerftHash* hash;
+} PerftJob;
+
+static void* perft_worker(void* arg) {
+    PerftJob* job = (PerftJob*)arg;
+    Board board = *job->root;  // private copy; st still points at the shared (read-only) history
+    int i;
+    while ((i = atomic_fetch_add(&job->next, 1)) < job->root_moves->count) {
+        Move m = job->root_moves->moves[i];
+        MoveUndoInfo undo_info;
+        applyMove(&board, m, &undo_info, NULL, NULL);
+        job->counts[i] = job->depth == 0 ? 1 : perft_hashed(&board, job->depth, job->hash);
+        undoMove(&board, m, &undo_info, NULL, NULL);
+    }
+    return NULL;
+}
+
+uint64_t perft_run(const Board* board, int depth, int threads, size_t hash_mb, bool divide) {
+    if (depth <= 0) return 1;
+    if (threads < 1) threads = 1;
+
+    Board root = *board;
+    MoveList root_moves;
+    generateLegalMoves(&root, &root_moves);
+    if (threads > root_moves.count) threads = root_moves.count > 0 ? root_moves.count : 1;
+
+    PerftHash hash;
+    if (!perft_hash_init(&hash, hash_mb)) return 0;
+
+    uint64_t counts[MAX_MOVES] = {0};
+    PerftJob job = {
+        .root = &root,
+        .root_moves = &root_moves,
+        .counts = counts,
+        .depth = depth - 1,
+        .hash = &hash,
+    };
+    atomic_init(&job.next, 0);
+
+    // Thread 0 is the caller; extra threads that fail to start just leave
+    // their share to the others
+    pthread_t workers[threads > 1 ? threads - 1 : 1];
+    int started = 0;
+    for (int t = 1; t < threads; t++) {
+        if (pthread_create(&workers[started], NULL, perft_worker, &job) == 0) started++;
+    }
+    perft_worker(&job);
+    for (int t = 0; t < started; t++) {
+        pthread_join(workers[t], NULL);
+    }
+    free(hash.entries);
+
+    uint64_t total = 0;
+    for (int i = 0; i < root_moves.count; i++) {
+        if (divide) {
+            char move_str[6];
+            moveToString(root_moves.moves[i], move_str);
+            printf("%s: %llu\n", move_str, (unsigned long long)counts[i]);
+        }
+        total += counts[i];
+    }
+    if (divide) {
+        printf("Total: %llu\n", (unsigned long long)total);
+        fflush(stdout);
+    }
+    return total;
+}
@@ -0,0 +1,24 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include "board.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================================================================
+// Perft (move generator verification and throughput benchmark)
+//
+// Leaves are bulk counted: at depth 1 the number of legal moves is returned
+// without making them. perft_run() splits the root moves over threads and can
+// use a shared perft hash (zobrist key + depth -> node count).
+// =============================================================================
+
+// Single-threaded leaf count, no hash
+uint64_t perft(Board* board, int depth);
+
+// threads < 1 means 1, hash_mb 0 disables the hash. With divide the count of
+// every root move is printed ("e2e4: 1234") followed by "Total: n".
+uint64_t perft_run(const Board* board, int depth, int threads, size_t hash_mb, bool divide);
+
+#endif // PERFT_H
@@ -0,0 +1,356 @@
+// posix_memalign needs POSIX visibility under -std=c11
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include "rescore.h"
+#include "board_io.h"
+#include "bitboard_utils.h"
+#include "evaluation.h"
+#include "search.h"
+#include "tt.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RESCORE_BATCH    4096  // positions per batch
+#define RESCORE_LINE_MAX 256   // text lines are a FEN plus two short fields
+
+typedef struct {
+    union {
+        char line[RESCORE_LINE_MAX];  // TRAINING_FORMAT_TEXT, without the newline
+        BulletBoard packed;           // TRAINING_FORMAT_BULLET
+    };
+    int score;    // new score, side to move relative
+    bool valid;   // position could be set up; invalid entries are dropped
+} RescoreItem;
+
+typedef enum { BATCH_FREE, BATCH_FILLED, BATCH_DONE } BatchState;
+
+typedef struct {
+    RescoreItem items[RESCORE_BATCH];
+    int count;
+    BatchState state;
+} RescoreBatch;
+
+// Batches move through a ring: the calling thread reads batch read_seq into
+// its slot, workers claim them in order, and the calling thread writes batch
+// write_seq once it is done. A slot is only refilled after it was written,
+// so at most slot_count batches are in memory and the output keeps the
+// input order.
+typedef struct {
+    const RescoreConfig* config;
+    const NNUENetwork* net;
+    RescoreBatch* slots;
+    int slot_count;
+    uint64_t read_seq;    // batches read
+    uint64_t claim_seq;   // batches claimed by workers
+    bool finished;        // no more batches will be read
+    pthread_mutex_t mutex;
+    pthread_cond_t work_cond;  // a batch was read, or finished
+    pthread_cond_t done_cond;  // a batch was scored
+} Rescore;
+
+typedef struct {
+    SearchInfo search_info;  // search state, and the NNUE refresh cache for both modes
+    NNUEAccumulator acc;
+    int id;
+    Rescore* job;
+    pthread_t thread;
+} RescoreWorker;
+
+// =============================================================================
+// Scoring
+// =============================================================================
+
+// Text lines: the FEN is everything before the first '|'
+static bool setup_text_position(const char* line, Board* board) {
+    char fen[RESCORE_LINE_MAX];
+    size_t len = strcspn(line, "|");
+    while (len > 0 && (line[len - 1] == ' ' || line[len - 1] == '\t')) len--;
+    if (len == 0) return false;
+    memcpy(fen, line, len);
+    fen[len] = '\0';
+
+    *board = parseFEN(fen);
+    return POPCOUNT(board->byTypeBB[WHITE][KING]) == 1 && POPCOUNT(board->byTypeBB[BLACK][KING]) == 1;
+}
+
+static int static_score(RescoreWorker* w, const Board* board) {
+    // Through the refresh cache: consecutive positions of one game only
+    // add and remove the pieces that differ from the cached accumulator
+    nnue_refresh_accumulator(board, &w->acc, w->job->net);
+    int eval = evaluate(board, &w->acc, w->job->net);
+    return board->whiteToMove ? eval : -eval;
+}
+
+static int search_score(RescoreWorker* w, Board* board) {
+    const RescoreConfig* config = w->job->config;
+    SearchInfo* search = &w->search_info;
+
+    nnue_refresh_accumulator(board, &w->acc, w->job->net);
+
+    search_params_init(&search->params);
+    search_info_prepare(search, NULL);
+    search->depthLimit = config->nodes > 0 ? 0 : config->depth;
+    search->nodeLimit = config->nodes;
+    search->nnue_acc = &w->acc;
+    search->nnue_net = w->job->net;
+    clear_search_history(search);
+
+    iterative_deepening_search(board, search);
+    return search->bestScoreThisIteration;
+}
+
+static void score_batch(RescoreWorker* w, RescoreBatch* batch) {
+    const RescoreConfig* config = w->job->config;
+    for (int i = 0; i < batch->count; i++) {
+        RescoreItem* item = &batch->items[i];
+        Board board;
+        if (!item->valid) continue;  // rejected by the reader
+        item->valid = config->format == TRAINING_FORMAT_BULLET
+            ? training_unpack_bullet(&item->packed, &board)
+            : setup_text_position(item->line, &board);
+        if (!item->valid) continue;
+        item->score = config->static_eval ? static_score(w, &board) : search_score(w, &board);
+    }
+}
+
+static void* rescore_worker(void* arg) {
+    RescoreWorker* w = (RescoreWorker*)arg;
+    Rescore* job = w->job;
+    tt_use_slice(w->id, job->config->threads);
+
+    pthread_mutex_lock(&job->mutex);
+    for (;;) {
+        while (job->claim_seq == job->read_seq && !job->finished) {
+            pthread_cond_wait(&job->work_cond, &job->mutex);
+        }
+        if (job->claim_seq == job->read_seq) break;  // finished and drained
+        RescoreBatch* batch = &job->slots[job->claim_seq % (uint64_t)job->slot_count];
+        job->claim_seq++;
+        pthread_mutex_unlock(&job->mutex);
+
+        score_batch(w, batch);
+
+        pthread_mutex_lock(&job->mutex);
+        batch->state = BATCH_DONE;
+        pthread_cond_signal(&job->done_cond);
+    }
+    pthread_mutex_unlock(&job->mutex);
+    return NULL;
+}
+
+// =============================================================================
+// Reading and writing
+// =============================================================================
+
+// Fills the batch from the input; returns false at end of input
+static bool read_batch(FILE* in, TrainingFormat format, RescoreBatch* batch) {
+    batch->count = 0;
+    while (batch->count < RESCORE_BATCH) {
+        RescoreItem* item = &batch->items[batch->count];
+        if (format == TRAINING_FORMAT_BULLET) {
+            if (fread(&item->packed, sizeof(BulletBoard), 1, in) != 1) return false;
+            item->valid = true;
+        } else {
+            if (!fgets(item->line, sizeof(item->line), in)) return false;
+            size_t len = strlen(item->line);
+            bool complete = len > 0 && item->line[len - 1] == '\n';
+            if (!complete && !feof(in)) {
+                // Overlong line: skip the rest of it and drop the entry
+                int c;
+                while ((c = fgetc(in)) != EOF && c != '\n') {}
+                item->valid = false;
+            } else {
+                while (len > 0 && (item->line[len - 1] == '\n' || item->line[len - 1] == '\r')) {
+                    item->line[--len] = '\0';
+                }
+                item->valid = len > 0;
+            }
+        }
+        batch->count++;
+    }
+    return true;
+}
+
+// Returns the number of entries written, -1 on failure
+static int write_batch(const RescoreBatch* batch, TrainingFormat format, char* buffer) {
+    size_t length = 0;
+    int written = 0;
+    for (int i = 0; i < batch->count; i++) {
+        const RescoreItem* item = &batch->items[i];
+        if (!item->valid) continue;
+        written++;
+        if (format == TRAINING_FORMAT_BULLET) {
+            BulletBoard record = item->packed;
+            int score = item->score;
+            if (score > INT16_MAX) score = INT16_MAX;
+            if (score < -INT16_MAX) score = -INT16_MAX;
+            record.score = (int16_t)score;  // result stays as it was
+            memcpy(buffer + length, &record, sizeof(record));
+            length += sizeof(record);
+            continue;
+        }
+
+        // "fen | eval | wdl" with the eval replaced (white-relative like the
+        // generator writes it); lines without fields just get the eval
+        const char* line = item->line;
+        size_t fen_len = strcspn(line, "|");
+        size_t fen_end = fen_len;
+        while (fen_end > 0 && (line[fen_end - 1] == ' ' || line[fen_end - 1] == '\t')) fen_end--;
+        const char* wdl = NULL;
+        if (line[fen_len] == '|') {
+            wdl = strchr(line + fen_len + 1, '|');
+            if (wdl) {
+                wdl++;
+                while (*wdl == ' ' || *wdl == '\t') wdl++;
+            }
+        }
+        // The FEN's side to move decides the sign; setup_text_position
+        // accepted it, so the field exists
+        const char* stm = memchr(line, ' ', fen_end);
+        bool white = !(stm && stm[1] == 'b');
+        int eval = white ? item->score : -item->score;
+        length += (size_t)snprintf(buffer + length, RESCORE_LINE_MAX + 32, "%.*s | %d%s%s\n",
+                                   (int)fen_end, line, eval, wdl ? " | " : "", wdl ? wdl : "");
+    }
+    return training_output_write(buffer, length) ? written : -1;
+}
+
+// =============================================================================
+// Driver
+// =============================================================================
+
+bool rescore_run(const RescoreConfig* config, const NNUENetwork* net) {
+    bool use_stdin = strcmp(config->input, "-") == 0;
+    FILE* in = use_stdin ? stdin : fopen(config->input, config->format == TRAINING_FORMAT_BULLET ? "rb" : "r");
+    if (!in) {
+        fprintf(stderr, "Error: Cannot open input file %s\n", config->input);
+        return false;
+    }
+    if (!training_output_open(config->output, config->format, config->zstd_level)) {
+        fprintf(stderr, "Error: Cannot open output file %s\n", config->output);
+        if (!use_stdin) fclose(in);
+        return false;
+    }
+
+    int threads = config->threads < 1 ? 1 : config->threads;
+    Rescore job = {
+        .config = config,
+        .net = net,
+        .slot_count = 2 * threads + 2,  // a batch per worker, one being read, one being written
+    };
+    pthread_mutex_init(&job.mutex, NULL);
+    pthread_cond_init(&job.work_cond, NULL);
+    pthread_cond_init(&job.done_cond, NULL);
+    job.slots = (RescoreBatch*)calloc((size_t)job.slot_count, sizeof(RescoreBatch));
+    char* out_buffer = (char*)malloc((size_t)RESCORE_BATCH * (RESCORE_LINE_MAX + 32));
+
+    // Workers, 64-byte aligned for the NNUE accumulators
+    RescoreWorker* workers[threads];
+    int worker_count = 0;
+    for (int i = 0; job.slots && out_buffer && i < threads; i++) {
+        void* mem = NULL;
+        if (posix_memalign(&mem, 64, sizeof(RescoreWorker)) != 0) break;
+        memset(mem, 0, sizeof(RescoreWorker));
+        RescoreWorker* w = (RescoreWorker*)mem;
+        w->id = i;
+        w->job = &job;
+        w->acc.cache = &w->search_info.nnue_cache;
+        search_params_init(&w->search_info.params);  // builds the shared LMR table before any thread runs
+        workers[worker_count++] = w;
+    }
+
+    int started = 0;
+    if (worker_count == threads) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setstacksize(&attr, SEARCH_THREAD_STACK_SIZE);
+        for (int i = 0; i < worker_count; i++) {
+            if (pthread_create(&workers[i]->thread, &attr, rescore_worker, workers[i]) != 0) break;
+            started++;
+        }
+        pthread_attr_destroy(&attr);
+    }
+
+    bool ok = started == threads;
+    if (!ok) fprintf(stderr, "Error: Failed to set up %d rescoring threads\n", threads);
+
+    long start_ms = search_current_time_ms();
+    long last_report_ms = start_ms;
+    uint64_t positions = 0;
+    uint64_t write_seq = 0;
+    bool eof = !ok;
+
+    pthread_mutex_lock(&job.mutex);
+    for (;;) {
+        RescoreBatch* head = &job.slots[write_seq % (uint64_t)job.slot_count];
+        if (write_seq < job.read_seq && head->state == BATCH_DONE) {
+            pthread_mutex_unlock(&job.mutex);
+            int written = ok ? write_batch(head, config->format, out_buffer) : 0;
+            if (written < 0) {
+                fprintf(stderr, "Error: Failed to write %s\n", config->output);
+                ok = false;
+                eof = true;  // stop reading, drain what is in flight
+            } else {
+                positions += (uint64_t)written;
+            }
+            long now = search_current_time_ms();
+            if (config->verbose >= 1 && now - last_report_ms >= 5000) {
+                last_report_ms = now;
+                printf("[Rescored %llu positions, %.0f pos/sec]\n", (unsigned long long)positions,
+                       positions * 1000.0 / (double)(now - start_ms));
+                fflush(stdout);
+            }
+            pthread_mutex_lock(&job.mutex);
+            head->state = BATCH_FREE;
+            write_seq++;
+            continue;
+        }
+        if (!eof && job.read_seq - write_seq < (uint64_t)job.slot_count) {
+            RescoreBatch* tail = &job.slots[job.read_seq % (uint64_t)job.slot_count];
+            pthread_mutex_unlock(&job.mutex);
+            eof = !read_batch(in, config->format, tail);
+            pthread_mutex_lock(&job.mutex);
+            if (tail->count > 0) {
+                tail->state = BATCH_FILLED;
+                job.read_seq++;
+                pthread_cond_signal(&job.work_cond);
+            }
+            continue;
+        }
+        if (eof && write_seq == job.read_seq) break;
+        pthread_cond_wait(&job.done_cond, &job.mutex);
+    }
+    job.finished = true;
+    pthread_cond_broadcast(&job.work_cond);
+    pthread_mutex_unlock(&job.mutex);
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i]->thread, NULL);
+    }
+    for (int i = 0; i < worker_count; i++) {
+        free(workers[i]);
+    }
+    if (ok && ferror(in)) {
+        fprintf(stderr, "Error: Failed to read %s\n", config->input);
+        ok = false;
+    }
+
+    long elapsed_ms = search_current_time_ms() - start_ms;
+    if (config->verbose >= 1) {
+        printf("Rescored %llu positions in %.1f seconds (%.0f pos/sec)\n",
+               (unsigned long long)positions, elapsed_ms / 1000.0,
+               elapsed_ms > 0 ? positions * 1000.0 / (double)elapsed_ms : 0.0);
+    }
+
+    training_output_close();
+    if (!use_stdin) fclose(in);
+    free(out_buffer);
+    free(job.slots);
+    pthread_cond_destroy(&job.done_cond);
+    pthread_cond_destroy(&job.work_cond);
+    pthread_mutex_destroy(&job.mutex);
+    return ok;
+}
@@ -0,0 +1,34 @@
+#ifndef RESCORE_H
+#define RESCORE_H
+
+#include "nnue.h"
+#include "training_data.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// =============================================================================
+// Batch rescoring of existing training data
+//
+// Streams a position file (text "fen [| eval [| wdl]]" lines or bullet's
+// packed records) through worker threads. Each position gets a new score,
+// either the static NNUE eval or a fixed depth/node search. The output is in
+// the same format, in input order, with everything else kept. Memory stays
+// bounded: only a fixed ring of position batches is in flight.
+// =============================================================================
+
+typedef struct {
+    const char* input;        // "-" = stdin
+    const char* output;       // opened for appending
+    TrainingFormat format;    // of both files
+    int zstd_level;           // output compression, 0 = off
+    bool static_eval;         // static eval instead of a search
+    int depth;                // search depth (used when nodes == 0)
+    uint64_t nodes;           // search node limit, 0 = use depth
+    int threads;
+    int verbose;
+} RescoreConfig;
+
+// Runs the whole file; false on I/O errors
+bool rescore_run(const RescoreConfig* config, const NNUENetwork* net);
+
+#endif // RESCORE_H
@@ -0,0 +1,74 @@
+#include "san.h"
+#include <stdbool.h>
+#include <string.h>
+
+static const char piece_letters[] = "PNBRQK";
+
+static int piece_type_at(const Board* board, int sq) {
+    return PIECE_TYPE_OF(board->piece[sq]);
+}
+
+void move_to_san(const Board* board, const MoveList* legal, Move m, char* out) {
+    int from = MOVE_FROM(m);
+    int to = MOVE_TO(m);
+    int type = piece_type_at(board, from);
+    char* p = out;
+
+    if (MOVE_IS_CASTLING(m)) {
+        strcpy(out, (to & 7) == 6 ? "O-O" : "O-O-O");
+        return;
+    }
+    if (type == PAWN) {
+        if (MOVE_IS_CAPTURE(m)) {
+            *p++ = (char)('a' + (from & 7));
+            *p++ = 'x';
+        }
+    } else {
+        *p++ = piece_letters[type];
+        bool ambiguous = false, same_file = false, same_rank = false;
+        for (int i = 0; i < legal->count; i++) {
+            Move other = legal->moves[i];
+            int other_from = MOVE_FROM(other);
+            if (other == m || MOVE_TO(other) != to || other_from == from ||
+                piece_type_at(board, other_from) != type) continue;
+            ambiguous = true;
+            same_file |= (other_from & 7) == (from & 7);
+            same_rank |= (other_from >> 3) == (from >> 3);
+        }
+        if (ambiguous && (!same_file || same_rank)) *p++ = (char)('a' + (from & 7));
+        if (ambiguous && same_file) *p++ = (char)('1' + (from >> 3));
+        if (MOVE_IS_CAPTURE(m)) *p++ = 'x';
+    }
+    *p++ = (char)('a' + (to & 7));
+    *p++ = (char)('1' + (to >> 3));
+    if (MOVE_IS_PROMOTION(m)) {
+        *p++ = '=';
+        *p++ = piece_letters[MOVE_PROMOTION(m)];  // PROMOTION_N..Q are 1..4
+    }
+    *p = '\0';
+}
+
+// Drops what files disagree on: check and annotation marks, '=' before
+// a promotion piece, 'x', and zeros in castling
+static void normalize_san(const char* in, char* out, size_t size) {
+    size_t n = 0;
+    for (; *in && n + 1 < size; in++) {
+        if (strchr("+#!?=x", *in)) continue;
+        out[n++] = *in == '0' ? 'O' : *in;
+    }
+    out[n] = '\0';
+}
+
+Move parse_san_move(const Board* board, const MoveList* legal, const char* token) {
+    char want[SAN_MAX], have[SAN_MAX], san[SAN_MAX], uci[6];
+    normalize_san(token, want, sizeof(want));
+    for (int i = 0; i < legal->count; i++) {
+        Move m = legal->moves[i];
+        move_to_san(board, legal, m, san);
+        normalize_san(san, have, sizeof(have));
+        if (strcmp(want, have) == 0) return m;
+        moveToString(m, uci);
+        if (strcmp(token, uci) == 0) return m;
+    }
+    return 0;
+}
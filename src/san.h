@@ -0,0 +1,24 @@
+#ifndef SAN_H
+#define SAN_H
+
+#include "board.h"
+#include "move.h"
+
+// =============================================================================
+// Standard algebraic notation
+//
+// Shared by the EPD runner and the match runner's opening book / PGN output.
+// legal is always the list of all legal moves of board (for disambiguation).
+// =============================================================================
+
+#define SAN_MAX 16  // buffer size for one SAN move
+
+// SAN without check marks ("Nbd7", "exd6", "e8=Q", "O-O")
+void move_to_san(const Board* board, const MoveList* legal, Move m, char* out);
+
+// A move in SAN or UCI notation, tolerant of what files disagree on (check
+// and annotation marks, '=' before a promotion piece, 'x', "0-0"). 0 if it
+// is not one of the legal moves.
+Move parse_san_move(const Board* board, const MoveList* legal, const char* token);
+
+#endif // SAN_H
@@ -1,5 +1,5 @@
 #ifndef _POSIX_C_SOURCE
-#define _POSIX_C_SOURCE 199309L
+#define _POSIX_C_SOURCE 200112L
 #endif
 #include "search.h"
 #include "evaluation.h"
@@ -13,6 +13,11 @@
 #include "zobrist.h"
 #include "syzygy.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 // UCI cp value reported for a proven TB win/loss without a known mate distance.
 #define TB_DISPLAY_CP 20000
@@ -20,46 +25,60 @@
 // Define this to enable Zobrist hash verification after undo
 //#define DEBUG_ZOBRIST_VERIFY
 
-// Define this to enable search statistics (TT + pruning) output after each search
-// Can be enabled via: make STATS=1
-//#define SEARCH_STATS
-
+// Runtime search statistics (UCI option SearchStats). STATS=1 only switches
+// them on by default.
 #ifdef SEARCH_STATS
-static uint64_t tt_probes = 0;
-static uint64_t tt_hits = 0;
-static uint64_t tt_cutoffs = 0;
-static uint64_t beta_cutoffs = 0;
-static uint64_t beta_cutoffs_first = 0;
-
-static struct {
-    uint64_t null_move;
-    uint64_t reverse_futility;
-    uint64_t razoring;
-    uint64_t futility;
-    uint64_t lmp;
-    uint64_t lmr;
-    uint64_t delta;
-    uint64_t see_pruning;
-} pruning_stats;
-
-#define TT_STAT_INC(var) ((var)++)
-#define TT_STATS_RESET() do { tt_probes = 0; tt_hits = 0; tt_cutoffs = 0; \
-                              beta_cutoffs = 0; beta_cutoffs_first = 0; } while(0)
-#define PRUNING_STAT_INC(field) (pruning_stats.field++)
-#define PRUNING_STATS_RESET() memset(&pruning_stats, 0, sizeof(pruning_stats))
+static SearchStatsMode stats_mode = SEARCH_STATS_INFO;
 #else
-#define TT_STAT_INC(var) ((void)0)
-#define TT_STATS_RESET() ((void)0)
-#define PRUNING_STAT_INC(field) ((void)0)
-#define PRUNING_STATS_RESET() ((void)0)
+static SearchStatsMode stats_mode = SEARCH_STATS_OFF;
 #endif
 
+#define STAT_INC(info, field) \
+    do { if (stats_mode != SEARCH_STATS_OFF) (info)->stats.field++; } while (0)
+#define STAT_TT_PROBE(info, depth, hit) \
+    do { \
+        if (stats_mode != SEARCH_STATS_OFF) { \
+            int bucket_ = (depth) < 0 ? 0 : (depth) >= STATS_DEPTH_BUCKETS ? STATS_DEPTH_BUCKETS - 1 : (depth); \
+            (info)->stats.ttProbes[bucket_]++; \
+            if (hit) (info)->stats.ttHits[bucket_]++; \
+        } \
+    } while (0)
+
+// Sums over completed non-silent searches (bench), added by the main search
+// thread at the end of iterative_deepening_search()
+static SearchStats stats_totals;
+static uint64_t stats_total_nodes;
+static uint64_t stats_searches;
+
 #include <limits.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
 #include <math.h>
 
+void search_set_stats_mode(SearchStatsMode mode) {
+    stats_mode = mode;
+}
+
+SearchStatsMode search_get_stats_mode(void) {
+    return stats_mode;
+}
+
+// Start the statistics of a thread's search. The NNUE counters of nnue.c
+// run for the whole thread, so the search keeps their differences.
+static void stats_begin(SearchInfo* info) {
+    memset(&info->stats, 0, sizeof(info->stats));
+    nnue_thread_stats(&info->stats.nnueRefreshes, &info->stats.nnueUpdates);
+}
+
+static void stats_end(SearchInfo* info) {
+    uint64_t refreshes, updates;
+    nnue_thread_stats(&refreshes, &updates);
+    info->stats.nnueRefreshes = refreshes - info->stats.nnueRefreshes;
+    info->stats.nnueUpdates = updates - info->stats.nnueUpdates;
+}
+
 // =============================================================================
 // Silent Mode (for training - disables info/debug output)
 // =============================================================================
@@ -118,6 +137,9 @@ void search_params_init(SearchParams* params) {
     params->use_bad_capture_last = true; // SPRT-confirmed +11 Elo (losing captures ordered after quiets)
     params->use_lmp = true;
     params->use_mdp = true;             // Mate Distance Pruning
+    params->use_cuckoo = false;         // Upcoming repetition cut, off until SPRT-confirmed
+    params->use_capture_history = true; // Capture history replaces the LVA tiebreak
+    params->use_check_lmr = false;      // Less LMR for checking moves, off until SPRT-confirmed
 
     // Late Move Pruning: skip quiets after base + depth^2 searched moves
     params->lmp_base = 6;
@@ -168,6 +190,133 @@ void search_params_init(SearchParams* params) {
     params->lmr_stat_high2 = 14621;
 }
 
+// Soft and hard limit for one move from the remaining clock (go wtime/btime)
+void search_clock_limits(long time_left, long inc, int movestogo, long* soft, long* hard) {
+    // Berechne die erwartete Anzahl der verbleibenden Züge
+    int expected_moves = movestogo > 0 ? movestogo : 25;  // Annahme: 25 Züge bis Spielende (aggressiver)
+
+    // Basis-Zeit pro Zug, Inkrement voll hinzufügen
+    long base_time = time_left / expected_moves;
+
+    // Soft-Limit: Zeit, nach der keine neue Tiefe begonnen wird
+    long soft_limit = base_time + inc;
+
+    // Stelle sicher, dass wir nicht zu viel Zeit nutzen (max 25% der Gesamtzeit)
+    long max_time = time_left / 4;
+    if (soft_limit > max_time) {
+        soft_limit = max_time;
+    }
+
+    // Hard-Limit: Absolutes Maximum (2.5x Soft-Limit, aber max 40% der Zeit)
+    long hard_limit = (soft_limit * 5) / 2;
+    long absolute_max = (time_left * 40) / 100;
+    if (hard_limit > absolute_max) {
+        hard_limit = absolute_max;
+    }
+
+    // Mindestzeit garantieren
+    if (soft_limit < 50) soft_limit = 50;
+    if (hard_limit < 100) hard_limit = 100;
+
+    // Bei sehr wenig Zeit: aggressivere Einstellungen
+    if (time_left < 1000) {
+        soft_limit = time_left / 8;
+        hard_limit = time_left / 4;
+        if (soft_limit < 10) soft_limit = 10;
+        if (hard_limit < 20) hard_limit = 20;
+    }
+    *soft = soft_limit;
+    *hard = hard_limit;
+}
+
+// UCI option name -> SearchParams field, shared by setoption and the match runner
+typedef struct {
+    const char* name;
+    size_t offset;
+    bool is_bool;
+} SearchParamField;
+
+#define PARAM_BOOL(name, field) {name, offsetof(SearchParams, field), true}
+#define PARAM_INT(name, field)  {name, offsetof(SearchParams, field), false}
+
+static const SearchParamField param_fields[] = {
+    PARAM_BOOL("Use_LMR", use_lmr),
+    PARAM_BOOL("Use_NullMove", use_null_move),
+    PARAM_BOOL("Use_Futility", use_futility),
+    PARAM_BOOL("Use_RFP", use_rfp),
+    PARAM_BOOL("Use_DeltaPruning", use_delta_pruning),
+    PARAM_BOOL("Use_Aspiration", use_aspiration),
+    PARAM_BOOL("Use_Razoring", use_razoring),
+    PARAM_BOOL("Use_CheckExtension", use_check_extension),
+    PARAM_BOOL("Use_MDP", use_mdp),
+    PARAM_BOOL("Use_Cuckoo", use_cuckoo),
+    PARAM_BOOL("Use_QSSeePruning", use_qs_see_pruning),
+    PARAM_BOOL("Use_BadCaptureLast", use_bad_capture_last),
+    PARAM_BOOL("Use_LMP", use_lmp),
+    PARAM_BOOL("Use_CaptureHistory", use_capture_history),
+    PARAM_BOOL("Use_CheckLMR", use_check_lmr),
+    PARAM_INT("LMP_Base", lmp_base),
+    PARAM_INT("LMP_MaxDepth", lmp_max_depth),
+    PARAM_INT("LMR_FullDepthMoves", lmr_full_depth_moves),
+    PARAM_INT("LMR_ReductionLimit", lmr_reduction_limit),
+    PARAM_INT("NullMove_MinDepth", null_move_min_depth),
+    PARAM_INT("Futility_Margin", futility_margin),
+    PARAM_INT("Futility_MarginD2", futility_margin_d2),
+    PARAM_INT("Futility_MarginD3", futility_margin_d3),
+    PARAM_INT("RFP_Margin", rfp_margin),
+    PARAM_INT("RFP_MaxDepth", rfp_max_depth),
+    PARAM_INT("Delta_Margin", delta_margin),
+    PARAM_INT("Razor_Margin", razor_margin),
+    PARAM_INT("Aspiration_Window", aspiration_window),
+    PARAM_INT("Hist_BonusMult", hist_bonus_mult),
+    PARAM_INT("Hist_BonusSub", hist_bonus_sub),
+    PARAM_INT("Hist_BonusMax", hist_bonus_max),
+    PARAM_INT("Hist_MalusMult", hist_malus_mult),
+    PARAM_INT("Hist_MalusSub", hist_malus_sub),
+    PARAM_INT("Hist_MalusMax", hist_malus_max),
+    PARAM_INT("FMH_Weight", fmh_weight),
+    PARAM_INT("LMR_StatLow2", lmr_stat_low2),
+    PARAM_INT("LMR_StatLow1", lmr_stat_low1),
+    PARAM_INT("LMR_StatHigh1", lmr_stat_high1),
+    PARAM_INT("LMR_StatHigh2", lmr_stat_high2),
+};
+
+static const SearchParamField* find_param(const char* name) {
+    for (size_t i = 0; i < sizeof(param_fields) / sizeof(param_fields[0]); i++) {
+        if (strcmp(param_fields[i].name, name) == 0) return &param_fields[i];
+    }
+    return NULL;
+}
+
+bool search_params_set(SearchParams* params, const char* name, const char* value) {
+    const SearchParamField* f = find_param(name);
+    if (f == NULL) return false;
+    char* field = (char*)params + f->offset;
+    if (f->is_bool) {
+        *(bool*)field = strcmp(value, "true") == 0 || strcmp(value, "1") == 0;
+    } else {
+        *(int*)field = atoi(value);
+    }
+    return true;
+}
+
+const char* search_params_name(int index) {
+    int count = (int)(sizeof(param_fields) / sizeof(param_fields[0]));
+    return index >= 0 && index < count ? param_fields[index].name : NULL;
+}
+
+bool search_params_get(const SearchParams* params, const char* name, char* out, size_t size) {
+    const SearchParamField* f = find_param(name);
+    if (f == NULL) return false;
+    const char* field = (const char*)params + f->offset;
+    if (f->is_bool) {
+        snprintf(out, size, "%s", *(const bool*)field ? "true" : "false");
+    } else {
+        snprintf(out, size, "%d", *(const int*)field);
+    }
+    return true;
+}
+
 // =============================================================================
 // Piece values for move ordering
 // =============================================================================
@@ -210,179 +359,102 @@ static const int SEE_VALUES[7] = {
 extern Bitboard getRookAttacks(int square, Bitboard occupancy);
 extern Bitboard getBishopAttacks(int square, Bitboard occupancy);
 
-// Precomputed attack tables (declared in move_generator.c, we need access)
-// We'll compute attackers dynamically
+// Get all attackers to a square (both colors, move generator tables)
+static inline Bitboard get_all_attackers(const Board* board, int square, Bitboard occupied) {
+    return attackersToSquare(board, square, occupied);
+}
 
-// Get all attackers to a square
-static Bitboard get_all_attackers(const Board* board, int square, Bitboard occupied) {
-    Bitboard attackers = 0ULL;
-    
-    // Pawn attacks (reverse lookup - who can attack this square with a pawn?)
-    // White pawns attack diagonally upward, so square must be attacked from below
-    Bitboard white_pawn_attackers = 0ULL;
-    if (square >= 9 && (square % 8) > 0) white_pawn_attackers |= (1ULL << (square - 9));
-    if (square >= 7 && (square % 8) < 7) white_pawn_attackers |= (1ULL << (square - 7));
-    attackers |= white_pawn_attackers & board->byTypeBB[WHITE][PAWN];
-    
-    // Black pawns attack diagonally downward
-    Bitboard black_pawn_attackers = 0ULL;
-    if (square <= 54 && (square % 8) < 7) black_pawn_attackers |= (1ULL << (square + 9));
-    if (square <= 56 && (square % 8) > 0) black_pawn_attackers |= (1ULL << (square + 7));
-    attackers |= black_pawn_attackers & board->byTypeBB[BLACK][PAWN];
-    
-    // Knight attacks (symmetric)
-    static const int knight_offsets[8] = {-17, -15, -10, -6, 6, 10, 15, 17};
-    Bitboard knights = board->byTypeBB[WHITE][KNIGHT] | board->byTypeBB[BLACK][KNIGHT];
-    for (int i = 0; i < 8; i++) {
-        int from = square + knight_offsets[i];
-        if (from >= 0 && from < 64) {
-            int from_file = from % 8;
-            int to_file = square % 8;
-            if (abs(from_file - to_file) <= 2) {
-                attackers |= (1ULL << from) & knights;
-            }
-        }
-    }
-    
-    // King attacks (symmetric)
-    static const int king_offsets[8] = {-9, -8, -7, -1, 1, 7, 8, 9};
-    Bitboard kings = board->byTypeBB[WHITE][KING] | board->byTypeBB[BLACK][KING];
-    for (int i = 0; i < 8; i++) {
-        int from = square + king_offsets[i];
-        if (from >= 0 && from < 64) {
-            int from_file = from % 8;
-            int to_file = square % 8;
-            if (abs(from_file - to_file) <= 1) {
-                attackers |= (1ULL << from) & kings;
-            }
+// Least valuable piece of one side among the attackers: its type (PAWN..KING,
+// SEE_VALUES[type + 1]) and square, -1 if that side has none
+static inline int get_smallest_attacker(const Board* board, Bitboard attackers, bool white, int* piece_square) {
+    const Bitboard* pieces = board->byTypeBB[white ? WHITE : BLACK];
+    for (int type = PAWN; type <= KING; type++) {
+        Bitboard bb = attackers & pieces[type];
+        if (bb) {
+            *piece_square = BIT_SCAN_FORWARD(bb);
+            return type;
         }
     }
-    
-    // Sliding pieces - use indexed bitboards
-    Bitboard rooks_queens = board->byTypeBB[WHITE][ROOK] | board->byTypeBB[BLACK][ROOK] |
-                            board->byTypeBB[WHITE][QUEEN] | board->byTypeBB[BLACK][QUEEN];
-    Bitboard bishops_queens = board->byTypeBB[WHITE][BISHOP] | board->byTypeBB[BLACK][BISHOP] |
-                              board->byTypeBB[WHITE][QUEEN] | board->byTypeBB[BLACK][QUEEN];
-    
-    Bitboard rook_attacks = getRookAttacks(square, occupied);
-    attackers |= rook_attacks & rooks_queens;
-    
-    Bitboard bishop_attacks = getBishopAttacks(square, occupied);
-    attackers |= bishop_attacks & bishops_queens;
-    
-    return attackers;
+    return -1;
 }
 
-// Get the least valuable attacker from a set of attackers
-static int get_smallest_attacker(const Board* board, Bitboard attackers, bool white, int* piece_square) {
-    Bitboard our_pieces;
-    int c = white ? WHITE : BLACK;
-    
-    // Check in order: Pawns, Knights, Bishops, Rooks, Queens, King
-    our_pieces = attackers & board->byTypeBB[c][PAWN];
-    if (our_pieces) {
-        *piece_square = BIT_SCAN_FORWARD(our_pieces);
-        return SEE_VALUES[1]; // PAWN
-    }
-    
-    our_pieces = attackers & board->byTypeBB[c][KNIGHT];
-    if (our_pieces) {
-        *piece_square = BIT_SCAN_FORWARD(our_pieces);
-        return SEE_VALUES[2]; // KNIGHT
-    }
-    
-    our_pieces = attackers & board->byTypeBB[c][BISHOP];
-    if (our_pieces) {
-        *piece_square = BIT_SCAN_FORWARD(our_pieces);
-        return SEE_VALUES[3]; // BISHOP
-    }
-    
-    our_pieces = attackers & board->byTypeBB[c][ROOK];
-    if (our_pieces) {
-        *piece_square = BIT_SCAN_FORWARD(our_pieces);
-        return SEE_VALUES[4]; // ROOK
-    }
-    
-    our_pieces = attackers & board->byTypeBB[c][QUEEN];
-    if (our_pieces) {
-        *piece_square = BIT_SCAN_FORWARD(our_pieces);
-        return SEE_VALUES[5]; // QUEEN
+// Sliders behind a piece of `type` that just left the exchange on `square`.
+// Only the lines through that piece can open: diagonals behind pawns and
+// bishops, ranks and files behind rooks, both behind queens and kings.
+static inline Bitboard get_xray_attackers(const Board* board, int type, int square, Bitboard occupied) {
+    Bitboard xrays = 0;
+    if (type != KNIGHT && type != ROOK) {
+        xrays |= getBishopAttacks(square, occupied) &
+                 (board->whiteBishops | board->blackBishops | board->whiteQueens | board->blackQueens);
     }
-    
-    our_pieces = attackers & board->byTypeBB[c][KING];
-    if (our_pieces) {
-        *piece_square = BIT_SCAN_FORWARD(our_pieces);
-        return SEE_VALUES[6]; // KING
+    if (type == ROOK || type == QUEEN || type == KING) {
+        xrays |= getRookAttacks(square, occupied) &
+                 (board->whiteRooks | board->blackRooks | board->whiteQueens | board->blackQueens);
     }
-    
-    return 0; // No attacker
+    return xrays & occupied;
 }
 
-// Static Exchange Evaluation
-// Returns the expected material gain/loss from a capture sequence
-static int see(const Board* board, Move move) {
+// Value on the target square after the first capture, which the first
+// recapture wins, and the material the move itself gains. Returns false for
+// moves that capture nothing and do not promote (no exchange, SEE 0).
+static inline bool see_first_capture(const Board* board, Move move, int* piece_on_target_value, int* gain) {
     int from = MOVE_FROM(move);
     int to = MOVE_TO(move);
-    
-    // Get initial attacker value
+
     bool attacker_white = board->whiteToMove;
-    bool attacker_side = attacker_white;
     PieceTypeToken attacker_type = getPieceTypeAtSquare(board, from, &attacker_white);
-    int attacker_value = get_piece_value(attacker_type);
+    *piece_on_target_value = get_piece_value(attacker_type);
 
     // For promotions, the piece on the target square after the move is the
     // promoted piece, not the pawn - and the move itself already gains
     // (promo - pawn) in material, even with an empty target square
-    int piece_on_target_value = attacker_value;
     int promo_gain = 0;
     if (MOVE_IS_PROMOTION(move)) {
-        piece_on_target_value = get_promotion_value(MOVE_PROMOTION(move));
-        promo_gain = piece_on_target_value - SEE_VALUES[1];
+        *piece_on_target_value = get_promotion_value(MOVE_PROMOTION(move));
+        promo_gain = *piece_on_target_value - SEE_VALUES[1];
     }
-    
-    // Get victim value
+
     bool victim_white = !board->whiteToMove;
     PieceTypeToken victim_type = getPieceTypeAtSquare(board, to, &victim_white);
     int victim_value = get_piece_value(victim_type);
-    
-    // Handle en passant
     if (MOVE_IS_EN_PASSANT(move)) {
         victim_value = SEE_VALUES[1]; // Pawn
     }
-    
+
     // If capturing nothing (and not promoting), there is no exchange to evaluate
     if (victim_value == 0 && !MOVE_IS_EN_PASSANT(move) && !MOVE_IS_PROMOTION(move)) {
-        return 0;
+        return false;
     }
+    *gain = victim_value + promo_gain;
+    return true;
+}
+
+static inline Bitboard see_occupancy(const Board* board) {
+    return board->whitePawns | board->whiteKnights | board->whiteBishops |
+           board->whiteRooks | board->whiteQueens | board->whiteKings |
+           board->blackPawns | board->blackKnights | board->blackBishops |
+           board->blackRooks | board->blackQueens | board->blackKings;
+}
+
+// Static Exchange Evaluation
+// Returns the expected material gain/loss from a capture sequence
+static int see(const Board* board, Move move) {
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
 
-    // Gain array to track material balance at each step
+    int current_piece_value;  // the piece that just captured
     int gain[32];
     int depth = 0;
+    if (!see_first_capture(board, move, &current_piece_value, &gain[0])) {
+        return 0;
+    }
+
+    // Simulate the capture: remove the initial attacker from occupancy
+    Bitboard occupied = see_occupancy(board) & ~(1ULL << from);
+    Bitboard attackers = get_all_attackers(board, to, occupied) & ~(1ULL << from);
 
-    // Initial capture (plus material gained by promoting)
-    gain[depth] = victim_value + promo_gain;
-    
-    // Simulate the capture
-    Bitboard occupied = board->whitePawns | board->whiteKnights | board->whiteBishops |
-                        board->whiteRooks | board->whiteQueens | board->whiteKings |
-                        board->blackPawns | board->blackKnights | board->blackBishops |
-                        board->blackRooks | board->blackQueens | board->blackKings;
-    
-    // Remove the initial attacker from occupancy
-    occupied &= ~(1ULL << from);
-    
-    // Get all attackers to the target square
-    Bitboard attackers = get_all_attackers(board, to, occupied);
-    
-    // Remove the initial attacker
-    attackers &= ~(1ULL << from);
-    
-    // Current piece on the target square (the one that just captured)
-    // For promotions, the piece on the target is the promoted piece, not the pawn
-    int current_piece_value = piece_on_target_value;
-    
     // Alternate sides
-    bool side_to_move = !attacker_side;
+    bool side_to_move = !board->whiteToMove;
     
     while (attackers) {
         // Find smallest attacker for the side to move. If that side has no
@@ -390,8 +462,8 @@ static int see(const Board* board, Move move) {
         // set), the exchange is over. Must check BEFORE incrementing depth, else
         // gain[depth] is left uninitialised and the negamax below reads garbage.
         int piece_square;
-        int next_attacker_value = get_smallest_attacker(board, attackers, side_to_move, &piece_square);
-        if (next_attacker_value == 0) break;
+        int type = get_smallest_attacker(board, attackers, side_to_move, &piece_square);
+        if (type < 0) break;
 
         depth++;
         if (depth >= 32) break;
@@ -401,19 +473,15 @@ static int see(const Board* board, Move move) {
 
         // No early-exit pruning: a sound cutoff must not change the result. The
         // previous condition did (it stopped before a profitable recapture, e.g.
-        // Arasan SEE case "Bxc6" gave -130 instead of -230). Full swap instead.
+        // Arasan SEE case "Bxc6" gave -130 instead of -230). Full swap instead;
+        // see_ge() is the early-exit variant for callers that need no value.
 
-        // Update occupied (remove the attacker)
+        // Remove the attacker and add the sliders it uncovered
         occupied &= ~(1ULL << piece_square);
         attackers &= ~(1ULL << piece_square);
+        attackers |= get_xray_attackers(board, type, to, occupied);
         
-        // Update attackers (x-ray through the removed piece)
-        attackers |= get_all_attackers(board, to, occupied) & occupied;
-        
-        // Update current piece value
-        current_piece_value = next_attacker_value;
-        
-        // Switch sides
+        current_piece_value = SEE_VALUES[type + 1];
         side_to_move = !side_to_move;
     }
     
@@ -426,10 +494,50 @@ static int see(const Board* board, Move move) {
     return gain[0];
 }
 
-// Quick SEE check: is the capture likely good (>= threshold)?
-__attribute__((unused))
+// Threshold SEE: see(board, move) >= threshold, without the swap list. The
+// running balance is kept relative to the threshold, and the exchange stops
+// as soon as the side to move can no longer change the verdict: either it
+// stays ahead of the threshold even after losing the capturing piece, or it
+// is already behind after taking. Same values and x-rays as see(), so the two
+// always agree.
 static bool see_ge(const Board* board, Move move, int threshold) {
-    return see(board, move) >= threshold;
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+
+    int piece_on_target_value, gain;
+    if (!see_first_capture(board, move, &piece_on_target_value, &gain)) {
+        return 0 >= threshold;
+    }
+
+    // Below the threshold even if nobody recaptures
+    int swap = gain - threshold;
+    if (swap < 0) return false;
+    // Still at the threshold after losing the capturing piece
+    swap = piece_on_target_value - swap;
+    if (swap <= 0) return true;
+
+    Bitboard occupied = see_occupancy(board) & ~(1ULL << from);
+    Bitboard attackers = get_all_attackers(board, to, occupied) & ~(1ULL << from);
+    bool side_to_move = !board->whiteToMove;
+    bool result = true;  // verdict if the side to move stands pat
+
+    for (;;) {
+        int piece_square;
+        int type = get_smallest_attacker(board, attackers, side_to_move, &piece_square);
+        if (type < 0) break;
+
+        // Taking flips the verdict unless the piece it puts on the square
+        // can be won back with enough margin
+        result = !result;
+        swap = SEE_VALUES[type + 1] - swap;
+        if (swap < (int)result) break;
+
+        occupied &= ~(1ULL << piece_square);
+        attackers &= ~(1ULL << piece_square);
+        attackers |= get_xray_attackers(board, type, to, occupied);
+        side_to_move = !side_to_move;
+    }
+    return result;
 }
 
 // Debug wrapper to expose SEE for testing
@@ -440,13 +548,11 @@ int see_debug(const Board* board, Move move) {
 // =============================================================================
 // Continuation history (Stockfish-style, replaces killers + countermoves)
 // Indexed by [prev_piece][prev_to][piece][to]; piece index = board->piece - 1
-// (0-5 white, 6-11 black). File-scope static because the tables are too large
-// for the stack-allocated SearchInfo used in training. Cleared on new game,
-// persists (un-decayed) across searches within a game, like Stockfish.
+// (0-5 white, 6-11 black). The tables live in SearchInfo so every search
+// thread learns its own. Cleared on new game, persists (un-decayed) across
+// searches within a game, like Stockfish.
 // =============================================================================
 #define CMH_MAX 16384
-static int16_t cmh_table[12][64][12][64]; // 1 ply back (countermove history)
-static int16_t fmh_table[12][64][12][64]; // 2 plies back (follow-up history)
 
 // Piece index for continuation tables, -1 if square is empty
 static inline int cmh_piece_index(const Board* board, int sq) {
@@ -454,30 +560,22 @@ static inline int cmh_piece_index(const Board* board, int sq) {
     return p - 1; // NO_PIECE(0) -> -1
 }
 
-// Continuation history score for move m, `delta` plies back (0 if unavailable)
-static inline int cont_score(int16_t (*tbl)[64][12][64], const Board* board,
-                             SearchInfo* info, int ply, int delta, Move m) {
-    if (ply < delta) return 0;
-    Move prev = info->prev_moves[ply - delta];
-    if (prev == 0) return 0;
-    int pp = info->prev_pieces[ply - delta];
-    if (pp < 0) return 0;
-    int cp = cmh_piece_index(board, MOVE_FROM(m));
-    if (cp < 0) return 0;
-    return tbl[pp][MOVE_TO(prev)][cp][MOVE_TO(m)];
-}
-
-// Gravity update of a continuation history entry (bonus may be negative)
-static void update_cont(int16_t (*tbl)[64][12][64], const Board* board,
-                        SearchInfo* info, int ply, int delta, Move m, int bonus) {
-    if (ply < delta) return;
-    Move prev = info->prev_moves[ply - delta];
-    if (prev == 0) return;
-    int pp = info->prev_pieces[ply - delta];
-    if (pp < 0) return;
-    int cp = cmh_piece_index(board, MOVE_FROM(m));
-    if (cp < 0) return;
-    int16_t* e = &tbl[pp][MOVE_TO(prev)][cp][MOVE_TO(m)];
+// Continuation subtable `delta` plies back (NULL if unavailable)
+static inline PieceToHistory* cont_sub(PieceToHistory* const* subs, int ply, int delta) {
+    return ply >= delta ? subs[ply - delta] : NULL;
+}
+
+// Record the continuation subtables selected by move m, made at `ply`.
+// Called post-applyMove: the mover (or promoted piece) stands on `to`.
+static inline void set_cont_subs(SearchInfo* info, const Board* board, int ply, Move m) {
+    int to = MOVE_TO(m);
+    int pp = cmh_piece_index(board, to);
+    info->cmh_sub[ply] = &info->cmh_table[pp][to];
+    info->fmh_sub[ply] = &info->fmh_table[pp][to];
+}
+
+// Gravity update of a history entry (bonus may be negative)
+static inline void history_gravity(int16_t* e, int bonus) {
     int v = *e;
     *e = (int16_t)(v + bonus - v * abs(bonus) / CMH_MAX);
 }
@@ -485,21 +583,35 @@ static void update_cont(int16_t (*tbl)[64][12][64], const Board* board,
 // Apply bonus/malus to both continuation tables (fmh down-weighted like SF)
 static void update_cont_histories(const Board* board, SearchInfo* info, int ply,
                                   Move m, int bonus) {
-    update_cont(cmh_table, board, info, ply, 1, m, bonus);
-    update_cont(fmh_table, board, info, ply, 2, m, bonus * info->params.fmh_weight / 96);
+    int cp = cmh_piece_index(board, MOVE_FROM(m));
+    if (cp < 0) return;
+    int to = MOVE_TO(m);
+    PieceToHistory* cmh = cont_sub(info->cmh_sub, ply, 1);
+    PieceToHistory* fmh = cont_sub(info->fmh_sub, ply, 2);
+    if (cmh) history_gravity(&(*cmh)[cp][to], bonus);
+    if (fmh) history_gravity(&(*fmh)[cp][to], bonus * info->params.fmh_weight / 96);
+}
+
+// Capture history entry of capture m: [mover][to][captured type], the
+// captured type being a pawn for en passant
+static inline int16_t* capture_history_entry(SearchInfo* info, const Board* board, Move m) {
+    int to = MOVE_TO(m);
+    int victim = MOVE_IS_EN_PASSANT(m) ? PAWN : cmh_piece_index(board, to) % 6;
+    return &info->capture_history[cmh_piece_index(board, MOVE_FROM(m))][to][victim];
 }
 
 // =============================================================================
 // Staged move picker
 //
 // Yields moves lazily instead of scoring/sorting the full move list up front:
-//   1. TT move (validated pseudo-legal, no generation needed)
+//   1. TT move (validated legal, no generation needed)
 //   2. generate captures/promotions, yield the good ones (SEE >= 0, promos)
 //   3. generate quiet moves, yield by combined history score
 //   4. losing captures last (or before the quiets if use_bad_capture_last
 //      is disabled)
 // Qsearch skips the quiet stage; in-check qsearch uses a single evasion
-// stage over all moves.
+// stage over all moves. The root yields info->rootMoves from pvIdx on, in
+// the order the previous iteration left them.
 // =============================================================================
 
 typedef struct {
@@ -509,7 +621,7 @@ typedef struct {
 
 #define TT_MOVE_SCORE 10000000
 
-typedef enum { MP_NORMAL, MP_QSEARCH, MP_EVASION } MovePickerMode;
+typedef enum { MP_NORMAL, MP_QSEARCH, MP_EVASION, MP_ROOT } MovePickerMode;
 
 enum {
     MP_STAGE_TT,
@@ -520,6 +632,7 @@ enum {
     MP_STAGE_BAD_CAPTURES,
     MP_STAGE_GEN_EVASIONS,
     MP_STAGE_EVASIONS,
+    MP_STAGE_ROOT,
     MP_STAGE_DONE
 };
 
@@ -527,7 +640,7 @@ typedef struct {
     Board* board;
     SearchInfo* info;
     int ply;
-    Move tt_move;          // validated pseudo-legal TT move, 0 if none
+    Move tt_move;          // validated legal TT move, 0 if none
     MovePickerMode mode;
     int stage;
     // list layout: [0, good_count) good captures/promotions,
@@ -549,7 +662,12 @@ static void movepicker_init(MovePicker* mp, Board* board, SearchInfo* info,
     mp->stage = MP_STAGE_TT;
     mp->tt_move = 0;
     mp->idx = 0;
-    if (tt_move != 0 && moveIsPseudoLegal(board, tt_move)) {
+    if (mode == MP_ROOT) {
+        mp->stage = MP_STAGE_ROOT;
+        mp->idx = info->pvIdx;
+        return;
+    }
+    if (tt_move != 0 && moveIsPseudoLegal(board, tt_move) && moveIsLegal(board, tt_move)) {
         // Qsearch (not in check) only searches captures/promotions
         if (mode != MP_QSEARCH || MOVE_IS_CAPTURE(tt_move) || MOVE_IS_PROMOTION(tt_move)) {
             mp->tt_move = tt_move;
@@ -578,12 +696,17 @@ static int mp_capture_score(MovePicker* mp, Move m, bool* is_good) {
     if (MOVE_IS_CAPTURE(m)) {
         int see_value = see(board, m);
 
-        // MVV-LVA as tiebreaker
+        // MVV as tiebreaker, refined by capture history (or LVA without it)
         bool isWhite = board->whiteToMove;
         bool isBlack = !isWhite;
         PieceTypeToken victim = getPieceTypeAtSquare(board, MOVE_TO(m), &isBlack);
-        PieceTypeToken attacker = getPieceTypeAtSquare(board, MOVE_FROM(m), &isWhite);
-        int mvv_lva = get_piece_value(victim) * 10 - get_piece_value(attacker);
+        int mvv_lva = get_piece_value(victim) * 10;
+        if (mp->info->params.use_capture_history) {
+            mvv_lva += *capture_history_entry(mp->info, board, m) / 2;
+        } else {
+            PieceTypeToken attacker = getPieceTypeAtSquare(board, MOVE_FROM(m), &isWhite);
+            mvv_lva -= get_piece_value(attacker);
+        }
 
         *is_good = see_value >= 0;
         if (mp->mode == MP_NORMAL) {
@@ -612,7 +735,7 @@ static void mp_fill_captures(MovePicker* mp) {
     int good = 0;
     for (int i = 0; i < caps.count; i++) {
         Move m = caps.moves[i];
-        if (m == mp->tt_move) continue;
+        if (m == mp->tt_move || !moveIsLegal(mp->board, m)) continue;
         bool is_good;
         int score = mp_capture_score(mp, m, &is_good);
         mp->list[n].move = m;
@@ -637,16 +760,23 @@ static void mp_fill_quiets(MovePicker* mp) {
     Board* board = mp->board;
     SearchInfo* info = mp->info;
     int side = board->whiteToMove ? 0 : 1;
+    const int (*butterfly)[64] = info->history[side];
+    const PieceToHistory* cmh = cont_sub(info->cmh_sub, mp->ply, 1);
+    const PieceToHistory* fmh = cont_sub(info->fmh_sub, mp->ply, 2);
     int n = mp->cap_count;
     for (int i = 0; i < quiets.count && n < MAX_MOVES; i++) {
         Move m = quiets.moves[i];
-        if (m == mp->tt_move) continue;
+        if (m == mp->tt_move || !moveIsLegal(board, m)) continue;
         // Combined butterfly + continuation history (Stockfish-style:
         // continuation history subsumes killers and countermoves)
+        int from = MOVE_FROM(m);
+        int to = MOVE_TO(m);
+        int cp = cmh_piece_index(board, from);
+        int score = butterfly[from][to];
+        if (cmh) score += (*cmh)[cp][to];
+        if (fmh) score += (*fmh)[cp][to];
         mp->list[n].move = m;
-        mp->list[n].score = info->history[side][MOVE_FROM(m)][MOVE_TO(m)]
-                          + cont_score(cmh_table, board, info, mp->ply, 1, m)
-                          + cont_score(fmh_table, board, info, mp->ply, 2, m);
+        mp->list[n].score = score;
         n++;
     }
     mp->total_count = n;
@@ -654,7 +784,7 @@ static void mp_fill_quiets(MovePicker* mp) {
 
 static void mp_fill_evasions(MovePicker* mp) {
     MoveList all;
-    generateMoves(mp->board, &all);
+    generateEvasions(mp->board, &all);  // already legal
 
     int n = 0;
     for (int i = 0; i < all.count; i++) {
@@ -746,6 +876,20 @@ static Move movepicker_next(MovePicker* mp, int* score_out) {
             mp->stage = MP_STAGE_DONE;
             break;
 
+        case MP_STAGE_ROOT:
+            if (mp->idx < mp->info->rootMoveCount) {
+                Move m = mp->info->rootMoves[mp->idx++].move;
+                // LMR only looks at the score of quiets: their butterfly
+                // history (no continuation history exists at the root)
+                if (score_out) {
+                    *score_out = MOVE_IS_CAPTURE(m) || MOVE_IS_PROMOTION(m) ? 0
+                        : mp->info->history[mp->board->whiteToMove ? 0 : 1][MOVE_FROM(m)][MOVE_TO(m)];
+                }
+                return m;
+            }
+            mp->stage = MP_STAGE_DONE;
+            break;
+
         default:
             return 0;
         }
@@ -801,21 +945,52 @@ static void update_history_malus(SearchInfo* info, Board* board, Move m, int dep
     info->history[side][from][to] += -malus - (current * abs(malus) / max_history);
 }
 
+void search_info_prepare(SearchInfo* info, const SearchParams* params) {
+    if (params != NULL) info->params = *params;
+    info->startTimeMs = search_current_time_ms();
+    info->timeScaling = false;
+    info->timeBudgetStart = 0;
+    info->softTimeLimit = 0;
+    info->hardTimeLimit = 0;
+    info->depthLimit = 0;
+    info->nodeLimit = 0;
+    info->tbProbeLimit = 0;
+    info->tbHits = 0;
+    info->tbCacheHits = 0;
+    info->tbRootMoveCount = 0;
+    info->tbRootScore = 0;
+    info->tbRootMatePlies = -1;
+    info->tbRootPvLen = 0;
+    info->multiPV = 1;
+    info->searchMoveCount = 0;
+    info->onIteration = NULL;
+    info->onIterationCtx = NULL;
+    info->stopSearch = false;
+    info->lastIterationTime = 0;
+    info->nodesSearched = 0;
+    info->bestMoveThisIteration = 0;
+    info->bestScoreThisIteration = 0;
+    info->seldepth = 0;
+}
+
 // Clear all search heuristics (new game / startup)
 void clear_search_history(SearchInfo* info) {
     memset(info->history, 0, sizeof(info->history));
-    memset(info->prev_moves, 0, sizeof(info->prev_moves));
-    memset(info->prev_pieces, 0, sizeof(info->prev_pieces));
-    memset(cmh_table, 0, sizeof(cmh_table));
-    memset(fmh_table, 0, sizeof(fmh_table));
+    memset(info->cmh_sub, 0, sizeof(info->cmh_sub));
+    memset(info->fmh_sub, 0, sizeof(info->fmh_sub));
+    memset(info->cmh_table, 0, sizeof(info->cmh_table));
+    memset(info->fmh_table, 0, sizeof(info->fmh_table));
+    memset(info->capture_history, 0, sizeof(info->capture_history));
+    info->eval_cache.generation = 0;  // emptied on next use
 }
 
 // Clear only ply-indexed state before each search; histories persist
 // across moves within a game. Butterfly history is halved (aging) so stale
-// entries decay; continuation history is NOT decayed (entries are context-
-// specific, Stockfish keeps them un-decayed too).
+// entries decay; continuation and capture history are NOT decayed (entries
+// are context-specific, Stockfish keeps them un-decayed too).
 void clear_volatile_history(SearchInfo* info) {
-    memset(info->prev_moves, 0, sizeof(info->prev_moves));
+    memset(info->cmh_sub, 0, sizeof(info->cmh_sub));
+    memset(info->fmh_sub, 0, sizeof(info->fmh_sub));
     for (int s = 0; s < 2; s++)
         for (int f = 0; f < 64; f++)
             for (int t = 0; t < 64; t++)
@@ -825,6 +1000,35 @@ void clear_volatile_history(SearchInfo* info) {
 // Forward declaration
 int evaluate(const Board* board, NNUEAccumulator* nnue_acc, const NNUENetwork* nnue_net);
 
+// Static eval from the side to move's point of view, through the eval cache
+// when a net is loaded. A hit skips evaluate() and with it the
+// materialization of the lazy accumulator chain: a child then updates from
+// the nearest computed ancestor, or never if its eval is cached as well.
+static int static_evaluate(SearchInfo* info, const Board* board) {
+    const NNUENetwork* net = info->nnue_net;
+    int eval;
+    if (info->nnue_acc != NULL && net != NULL && net->loaded) {
+        EvalCache* cache = &info->eval_cache;
+        if (cache->generation != net->generation) {
+            memset(cache->entry, 0, sizeof(cache->entry));
+            cache->generation = net->generation;
+        }
+        uint64_t* e = &cache->entry[board->zobristKey & (EVAL_CACHE_SIZE - 1)];
+        uint64_t check = (board->zobristKey | (1ULL << 32)) & ~0xFFFFFFFFULL;
+        STAT_INC(info, evalCacheProbes);
+        if ((*e & ~0xFFFFFFFFULL) == check) {
+            STAT_INC(info, evalCacheHits);
+            eval = (int32_t)(uint32_t)*e;
+        } else {
+            eval = evaluate(board, info->nnue_acc, net);
+            *e = check | (uint32_t)eval;
+        }
+    } else {
+        eval = evaluate(board, info->nnue_acc, net);
+    }
+    return board->whiteToMove ? eval : -eval;
+}
+
 static NNUEAccumulator* search_prepare_nnue_child(SearchInfo* info, int ply) {
     if (info->nnue_acc == NULL || info->nnue_net == NULL || ply + 1 >= MAX_PLY + 2) {
         return info->nnue_acc;
@@ -835,9 +1039,59 @@ static NNUEAccumulator* search_prepare_nnue_child(SearchInfo* info, int ply) {
     return child;
 }
 
+// External stop request (UCI "stop"/"quit" from another thread). Only the
+// code starting a search clears it, so a request that arrives before the
+// search polls it for the first time is never lost.
+static atomic_bool stop_requested = false;
+
+// Raised by the main thread when its search ends; Lazy SMP helpers have no
+// limits of their own and stop on this signal.
+static atomic_bool helpers_stop = false;
+
+void search_request_stop(void) {
+    atomic_store(&stop_requested, true);
+}
+
+void search_clear_stop(void) {
+    atomic_store(&stop_requested, false);
+}
+
+bool search_stop_requested(void) {
+    return atomic_load(&stop_requested);
+}
+
+// "go ponder": while set, the search ignores its time limits. ponderhit
+// writes the real limits first and then clears the flag (release), so a
+// reader that sees it cleared (acquire) also sees the new limits.
+static atomic_bool pondering = false;
+
+void search_set_pondering(bool ponder) {
+    atomic_store(&pondering, ponder);
+}
+
+bool search_is_pondering(void) {
+    return atomic_load_explicit(&pondering, memory_order_acquire);
+}
+
+void search_ponderhit(SearchInfo* info, long soft_limit, long hard_limit) {
+    if (!search_is_pondering()) return;
+    // Limits count from now; startTimeMs stays put so elapsed times and
+    // iteration timings remain monotonic
+    long elapsed = search_current_time_ms() - info->startTimeMs;
+    info->softTimeLimit = soft_limit > 0 ? elapsed + soft_limit : 0;
+    info->hardTimeLimit = hard_limit > 0 ? elapsed + hard_limit : 0;
+    info->timeBudgetStart = elapsed;
+    atomic_store_explicit(&pondering, false, memory_order_release);
+}
+
 // Check time limit (hard limit - sofortiger Abbruch)
 static bool check_time(SearchInfo* info) {
-    if (info->hardTimeLimit > 0) {
+    if (atomic_load_explicit(&stop_requested, memory_order_relaxed) ||
+        atomic_load_explicit(&helpers_stop, memory_order_relaxed)) {
+        info->stopSearch = true;
+        return true;
+    }
+    if (!search_is_pondering() && info->hardTimeLimit > 0) {
         long elapsed = search_current_time_ms() - info->startTimeMs;
         if (elapsed >= info->hardTimeLimit) {
             info->stopSearch = true;
@@ -863,6 +1117,41 @@ static long get_elapsed_time(SearchInfo* info) {
     return search_current_time_ms() - info->startTimeMs;
 }
 
+// =============================================================================
+// Adaptive time management
+//
+// The soft limit from the go handler is the budget of an ordinary move. From
+// TM_MIN_DEPTH on it is rescaled after every completed iteration by
+//  - the share of the root nodes spent below the best move: a move that took
+//    nearly all of them is clear, alternatives that needed deep refutations
+//    are worth more time,
+//  - the number of iterations in a row the best move stayed the same,
+//  - how far the score dropped against the previous iteration.
+// The hard limit stays the absolute cap.
+// =============================================================================
+#define TM_MIN_DEPTH 5
+
+static long scaled_soft_limit(const SearchInfo* info, Move best_move, int stability, int score_drop) {
+    uint64_t total = 0, best = 0;
+    for (int i = 0; i < info->rootMoveCount; i++) {
+        total += info->rootMoves[i].nodes;
+        if (info->rootMoves[i].move == best_move) best = info->rootMoves[i].nodes;
+    }
+    double node_factor = total > 0 ? 1.6 - (double)best / (double)total : 1.0;   // 0.6 .. 1.6
+
+    if (stability > 10) stability = 10;
+    double stability_factor = 1.25 - 0.05 * stability;                           // 1.25 .. 0.75
+
+    if (score_drop < -20) score_drop = -20;
+    if (score_drop > 60) score_drop = 60;
+    double score_factor = 1.0 + score_drop / 100.0;                              // 0.8 .. 1.6
+
+    long budget = info->softTimeLimit - info->timeBudgetStart;
+    long soft = info->timeBudgetStart + (long)(budget * node_factor * stability_factor * score_factor);
+    if (info->hardTimeLimit > 0 && soft > info->hardTimeLimit) soft = info->hardTimeLimit;
+    return soft;
+}
+
 // Check if position is likely a draw
 static bool is_draw(Board* board, int ply) {
     // Draw by 50-move rule
@@ -870,22 +1159,61 @@ static bool is_draw(Board* board, int ply) {
         return true;
     }
     
-    // Draw by repetition
+    // Draw by repetition: only positions since the last capture, pawn move or
+    // null move can repeat, and only those with the same side to move, so
+    // walk the state chain back 2 plies at a time (same bound as
+    // upcoming_repetition)
     if (ply > 0) {
-        int rep_count = 0;
-        for (int i = 0; i < board->historyIndex; i++) {
-            if (board->history[i] == board->zobristKey) {
-                rep_count++;
-                if (rep_count >= 2) {
-                    return true;
-                }
+        const StateInfo* st = board->st;
+        int end = board->halfMoveClock < board->pliesFromNull ? board->halfMoveClock : board->pliesFromNull;
+        for (int i = 2; i <= end; i += 2) {
+            if (st == NULL || st->previous == NULL) break;
+            st = st->previous;  // st->oldZobristKey is the position i plies back
+            if (st->oldZobristKey == board->zobristKey) {
+                return true;
             }
+            st = st->previous;
         }
     }
     
     return false;
 }
 
+// Upcoming repetition (Stockfish's has_game_cycle): can the side to move
+// reach a position of this search again with one reversible move? The key
+// difference to each earlier position with the opponent to move is looked up
+// in the cuckoo table of reversible moves; a hit whose path is clear means
+// the repetition can be forced, so the node is worth at least a draw.
+// Positions at or before the root are skipped (ply > i) - those would need
+// an actual repetition to count, which is_draw handles.
+static bool upcoming_repetition(const Board* board, int ply) {
+    int end = board->halfMoveClock < board->pliesFromNull ? board->halfMoveClock : board->pliesFromNull;
+    if (end < 3) return false;
+
+    // pliesFromNull <= chain length, so the walk below stays on it
+    const StateInfo* st = board->st;  // st->oldZobristKey: position 1 ply back
+    uint64_t original = board->zobristKey;
+    uint64_t other = original ^ st->oldZobristKey ^ zobrist_side_to_move_key;
+    Bitboard occupied = board->whitePawns | board->whiteKnights | board->whiteBishops |
+                        board->whiteRooks | board->whiteQueens | board->whiteKings |
+                        board->blackPawns | board->blackKnights | board->blackBishops |
+                        board->blackRooks | board->blackQueens | board->blackKings;
+
+    for (int i = 3; i <= end; i += 2) {
+        st = st->previous;
+        other ^= st->oldZobristKey ^ st->previous->oldZobristKey ^ zobrist_side_to_move_key;
+        st = st->previous;  // st->oldZobristKey: position i plies back
+        if (other != 0) continue;
+
+        int s1, s2;
+        if (cuckoo_lookup(original ^ st->oldZobristKey, &s1, &s2) &&
+            !(BETWEEN_BB[s1][s2] & occupied) && ply > i) {
+            return true;
+        }
+    }
+    return false;
+}
+
 // Simple check if we can do null move (not in check, have pieces besides pawns)
 static bool can_do_null_move(Board* board) {
     if (board->whiteToMove) {
@@ -909,6 +1237,7 @@ static int quiescence(Board* board, int alpha, int beta, SearchInfo* info, int p
     // This node was already counted by the caller (the negamax leaf/razoring
     // node, or the parent quiescence before it recursed), so do NOT count it
     // again here - otherwise every qsearch-root node is counted twice.
+    STAT_INC(info, qsNodes);
 
     // Update selective depth
     if (ply > info->seldepth) {
@@ -923,8 +1252,7 @@ static int quiescence(Board* board, int alpha, int beta, SearchInfo* info, int p
     
     // Max ply check
     if (ply >= MAX_PLY) {
-        int eval = evaluate(board, info->nnue_acc, info->nnue_net);
-        return board->whiteToMove ? eval : -eval;
+        return static_evaluate(info, board);
     }
     
     int original_alpha = alpha;
@@ -934,11 +1262,10 @@ static int quiescence(Board* board, int alpha, int beta, SearchInfo* info, int p
     // TT Probe in Quiescence Search
     // ==========================================================================
     Move tt_move = 0;
-    TT_STAT_INC(tt_probes);
     TTData tte = tt_probe(board->zobristKey);
+    STAT_TT_PROBE(info, 0, tte.found);
     bool tt_pv = is_pv || (tte.found && tte.is_pv);
     if (tte.found) {
-        TT_STAT_INC(tt_hits);
         tt_move = tte.move;
 
         // Use TT cutoff if depth is sufficient (QS entries have depth 0)
@@ -954,22 +1281,22 @@ static int quiescence(Board* board, int alpha, int beta, SearchInfo* info, int p
             }
             
             if (tt_flag == TT_EXACT) {
-                TT_STAT_INC(tt_cutoffs);
+                STAT_INC(info, ttCutoffs);
                 return tt_score;
             }
             if (tt_flag == TT_LOWERBOUND && tt_score >= beta) {
-                TT_STAT_INC(tt_cutoffs);
+                STAT_INC(info, ttCutoffs);
                 return tt_score;
             }
             if (tt_flag == TT_UPPERBOUND && tt_score <= alpha) {
-                TT_STAT_INC(tt_cutoffs);
+                STAT_INC(info, ttCutoffs);
                 return tt_score;
             }
         }
     }
     
     // Check if we're in check
-    bool in_check = isKingAttacked(board, board->whiteToMove);
+    bool in_check = board->checkers != 0;
     
     // If in check, we must search all moves (not just captures)
     if (in_check) {
@@ -991,12 +1318,6 @@ static int quiescence(Board* board, int alpha, int beta, SearchInfo* info, int p
             NNUEAccumulator* child_acc = search_prepare_nnue_child(info, ply);
             MoveUndoInfo undo;
             applyMove(board, m, &undo, child_acc, info->nnue_net);
-            
-            // Skip illegal moves (king left in check) - move generator now returns pseudo-legal moves
-            if (isKingAttacked(board, !board->whiteToMove)) {
-                undoMove(board, m, &undo, child_acc, info->nnue_net);
-                continue;
-            }
             info->nnue_acc = child_acc;
             
             #ifdef DEBUG_NNUE_EVAL
@@ -1047,15 +1368,12 @@ static int quiescence(Board* board, int alpha, int beta, SearchInfo* info, int p
         return alpha;
     }
     
-    // Not in check: stand pat, reusing the TT static eval when available
+    // Not in check: stand pat, reusing the TT or cached static eval
     int stand_pat;
     if (tte.found && tte.eval != TT_EVAL_NONE) {
         stand_pat = tte.eval;
     } else {
-        stand_pat = evaluate(board, info->nnue_acc, info->nnue_net);
-        if (!board->whiteToMove) {
-            stand_pat = -stand_pat;
-        }
+        stand_pat = static_evaluate(info, board);
     }
     
     if (stand_pat >= beta) {
@@ -1067,7 +1385,7 @@ static int quiescence(Board* board, int alpha, int beta, SearchInfo* info, int p
     
     // Delta pruning: if we're so far behind that even capturing a queen won't help
     if (info->params.use_delta_pruning && stand_pat + 900 + info->params.delta_margin < alpha) {
-        PRUNING_STAT_INC(delta);
+        STAT_INC(info, deltaPrunes);
         return alpha;
     }
     
@@ -1093,7 +1411,7 @@ static int quiescence(Board* board, int alpha, int beta, SearchInfo* info, int p
             }
 
             if (stand_pat + gain + info->params.delta_margin < alpha) {
-                PRUNING_STAT_INC(delta);
+                STAT_INC(info, deltaPrunes);
                 continue;
             }
         }
@@ -1101,8 +1419,8 @@ static int quiescence(Board* board, int alpha, int beta, SearchInfo* info, int p
         // SEE pruning: skip captures that lose material (not in check here by branch).
         // Keep the TT move and promotions, which may be tactically necessary.
         if (info->params.use_qs_see_pruning && !MOVE_IS_PROMOTION(m) && m != tt_move) {
-            if (see(board, m) < 0) {
-                PRUNING_STAT_INC(see_pruning);
+            if (!see_ge(board, m, 0)) {
+                STAT_INC(info, qsSeePrunes);
                 continue;
             }
         }
@@ -1115,12 +1433,6 @@ static int quiescence(Board* board, int alpha, int beta, SearchInfo* info, int p
         NNUEAccumulator* child_acc = search_prepare_nnue_child(info, ply);
         MoveUndoInfo undo;
         applyMove(board, m, &undo, child_acc, info->nnue_net);
-
-        // Skip illegal moves (king left in check) - needed because generateCaptureAndPromotionMoves is pseudo-legal
-        if (isKingAttacked(board, !board->whiteToMove)) {
-            undoMove(board, m, &undo, child_acc, info->nnue_net);
-            continue;
-        }
         info->nnue_acc = child_acc;
         
         #ifdef DEBUG_NNUE_EVAL
@@ -1199,15 +1511,20 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
     if (ply > 0 && is_draw(board, ply)) {
         return 0;
     }
+
+    // A forcible repetition is worth at least a draw
+    if (ply > 0 && info->params.use_cuckoo && alpha < 0 && upcoming_repetition(board, ply)) {
+        alpha = 0;
+        if (alpha >= beta) return alpha;
+    }
     
     // Max ply check
     if (ply >= MAX_PLY) {
-        int eval = evaluate(board, info->nnue_acc, info->nnue_net);
-        return board->whiteToMove ? eval : -eval;  // Convert from White perspective to side-to-move
+        return static_evaluate(info, board);
     }
     
     // Check if in check (needed for various extensions/reductions)
-    bool in_check = isKingAttacked(board, board->whiteToMove);
+    bool in_check = board->checkers != 0;
     
     // Check extension
     if (in_check && info->params.use_check_extension) {
@@ -1216,11 +1533,10 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
     
     // TT Probe
     Move tt_move = 0;
-    TT_STAT_INC(tt_probes);
     TTData tte = tt_probe(board->zobristKey);
+    STAT_TT_PROBE(info, depth, tte.found);
     bool tt_pv = is_pv || (tte.found && tte.is_pv);
     if (tte.found) {
-        TT_STAT_INC(tt_hits);
         tt_move = tte.move;
 
         // Only use TT cutoff in non-PV nodes
@@ -1236,15 +1552,15 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
             }
             
             if (tt_flag == TT_EXACT) {
-                TT_STAT_INC(tt_cutoffs);
+                STAT_INC(info, ttCutoffs);
                 return tt_score;
             }
             if (tt_flag == TT_LOWERBOUND && tt_score >= beta) {
-                TT_STAT_INC(tt_cutoffs);
+                STAT_INC(info, ttCutoffs);
                 return tt_score;
             }
             if (tt_flag == TT_UPPERBOUND && tt_score <= alpha) {
-                TT_STAT_INC(tt_cutoffs);
+                STAT_INC(info, ttCutoffs);
                 return tt_score;
             }
         }
@@ -1268,9 +1584,11 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
             board->byTypeBB[WHITE][KING]   | board->byTypeBB[BLACK][KING];
         int tb_pieces = POPCOUNT(tb_occ);
         int wdl;
+        bool tb_cached;
         if (tb_pieces <= info->tbProbeLimit && syzygy_available(tb_pieces) &&
-            syzygy_probe_wdl(board, &wdl)) {
+            syzygy_probe_wdl(board, &wdl, &tb_cached)) {
             info->tbHits++;
+            if (tb_cached) info->tbCacheHits++;
             int tb_score = (wdl > 0) ?  (TB_WIN_SCORE - ply)
                          : (wdl < 0) ? -(TB_WIN_SCORE - ply)
                          :              0;
@@ -1300,17 +1618,14 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
         depth <= info->params.lmp_max_depth && abs(alpha) < TB_SCORE_MIN;
     int lmp_threshold = info->params.lmp_base + depth * depth;
 
-    // Static eval only where pruning needs it, reusing the TT copy when
-    // available; stays TT_EVAL_NONE otherwise (in check / PV nodes)
+    // Static eval only where pruning needs it, reusing the TT or cached copy
+    // when available; stays TT_EVAL_NONE otherwise (in check / PV nodes)
     int static_eval = TT_EVAL_NONE;
     if (can_null || can_rfp || can_razor || can_futility) {
         if (tte.found && tte.eval != TT_EVAL_NONE) {
             static_eval = tte.eval;
         } else {
-            static_eval = evaluate(board, info->nnue_acc, info->nnue_net);
-            if (!board->whiteToMove) {
-                static_eval = -static_eval;
-            }
+            static_eval = static_evaluate(info, board);
         }
     }
 
@@ -1322,19 +1637,16 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
     // ==========================================================================
     if (can_null && static_eval >= beta) {
 
+        STAT_INC(info, nullMoveTries);
+
         // Make null move - update zobrist key for consistent TT usage
-        board->whiteToMove = !board->whiteToMove;
-        board->zobristKey ^= zobrist_side_to_move_key;
-        
-        int old_ep = board->enPassantSquare;
-        if (old_ep != SQ_NONE) {
-            board->zobristKey ^= zobrist_enpassant_keys[old_ep];
-        }
-        board->enPassantSquare = SQ_NONE;
+        StateInfo null_state;
+        applyNullMove(board, &null_state);
 
         // No previous move after a null move - prevents stale counter-move
         // and continuation history lookups in the child node
-        info->prev_moves[ply] = 0;
+        info->cmh_sub[ply] = NULL;
+        info->fmh_sub[ply] = NULL;
 
         // Adaptive reduction: base 3, grows with depth and with the margin by
         // which the static eval exceeds beta (capped so shallow real search
@@ -1348,17 +1660,12 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
                                   info, ply + 1, false, true);
         
         // Unmake null move - restore zobrist key
-        board->enPassantSquare = old_ep;
-        if (old_ep != SQ_NONE) {
-            board->zobristKey ^= zobrist_enpassant_keys[old_ep];
-        }
-        board->whiteToMove = !board->whiteToMove;
-        board->zobristKey ^= zobrist_side_to_move_key;
+        undoNullMove(board, &null_state);
         
         if (info->stopSearch) return 0;
         
         if (null_score >= beta) {
-            PRUNING_STAT_INC(null_move);
+            STAT_INC(info, nullMoveCuts);
             // Never return unproven mate/TB scores from a null-window search
             return null_score >= TB_SCORE_MIN ? beta : null_score;
         }
@@ -1372,7 +1679,7 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
     if (can_rfp) {
         int rfp_margin = info->params.rfp_margin * depth;
         if (static_eval - rfp_margin >= beta) {
-            PRUNING_STAT_INC(reverse_futility);
+            STAT_INC(info, rfpCuts);
             return static_eval - rfp_margin;
         }
     }
@@ -1386,7 +1693,7 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
         if (static_eval + razor_margin < alpha) {
             int razor_score = quiescence(board, alpha - 1, alpha, info, ply);
             if (razor_score < alpha) {
-                PRUNING_STAT_INC(razoring);
+                STAT_INC(info, razorCuts);
                 return razor_score;
             }
         }
@@ -1410,44 +1717,40 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
         }
     }
     
-    // Staged move picker: TT move first (validated pseudo-legal, no move
-    // generation needed), then captures/promotions, then quiet moves.
-    // Legality is still checked after applyMove.
+    // Staged move picker: TT move first (validated, no move generation
+    // needed), then captures/promotions, then quiet moves. The picker only
+    // yields legal moves.
     MovePicker mp;
-    movepicker_init(&mp, board, info, ply, tt_move, MP_NORMAL);
+    movepicker_init(&mp, board, info, ply, tt_move, ply == 0 ? MP_ROOT : MP_NORMAL);
 
     Move best_move = 0;
     int moves_searched = 0;
 
-    // Quiet moves yielded so far (for the history malus on a beta cutoff)
+    // Quiet moves and captures yielded so far (for the history malus on a
+    // beta cutoff)
     Move quiets_tried[MAX_MOVES];
     int quiets_tried_count = 0;
+    Move captures_tried[MAX_MOVES];
+    int captures_tried_count = 0;
 
     Move m;
     int move_score;
     while ((m = movepicker_next(&mp, &move_score)) != 0) {
-        // Syzygy root-move restriction: at the root, only search TB-optimal moves.
-        if (ply == 0 && info->tbRootMoveCount > 0) {
-            bool tb_allowed = false;
-            for (int k = 0; k < info->tbRootMoveCount; k++) {
-                if (info->tbRootMoves[k] == m) { tb_allowed = true; break; }
-            }
-            if (!tb_allowed) continue;
-        }
-
         bool is_capture = MOVE_IS_CAPTURE(m);
         bool is_promotion = MOVE_IS_PROMOTION(m);
         bool is_tactical = is_capture || is_promotion;
 
         if (!is_tactical && quiets_tried_count < MAX_MOVES) {
             quiets_tried[quiets_tried_count++] = m;
+        } else if (is_capture && captures_tried_count < MAX_MOVES) {
+            captures_tried[captures_tried_count++] = m;
         }
 
         // =======================================================================
         // Futility Pruning: skip quiet moves that can't improve alpha
         // =======================================================================
         if (futility_pruning && moves_searched > 0 && !is_tactical) {
-            PRUNING_STAT_INC(futility);
+            STAT_INC(info, futilityPrunes);
             continue;
         }
 
@@ -1456,7 +1759,7 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
         // never raise alpha - skip them entirely (movecount-based pruning)
         // =======================================================================
         if (can_lmp && !is_tactical && moves_searched >= lmp_threshold) {
-            PRUNING_STAT_INC(lmp);
+            STAT_INC(info, lmpPrunes);
             continue;
         }
 
@@ -1476,16 +1779,15 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
         }
         #endif
         
+        // Decided before the move, from the board's check info (only the
+        // LMR rule below needs it)
+        bool gives_check = info->params.use_check_lmr && givesCheck(board, m);
+
+        uint64_t nodes_before = info->nodesSearched;
         NNUEAccumulator* parent_acc = info->nnue_acc;
         NNUEAccumulator* child_acc = search_prepare_nnue_child(info, ply);
         MoveUndoInfo undo;
         applyMove(board, m, &undo, child_acc, info->nnue_net);
-        
-        // Skip illegal moves (king left in check) - move generator now returns pseudo-legal moves
-        if (isKingAttacked(board, !board->whiteToMove)) {
-            undoMove(board, m, &undo, child_acc, info->nnue_net);
-            continue;
-        }
         info->nnue_acc = child_acc;
         
         // Track last move for debug
@@ -1496,10 +1798,8 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
         // Prefetch next position's TT entry
         tt_prefetch(board->zobristKey);
 
-        // Track this move for continuation history. Piece recorded
-        // post-applyMove: the mover (or promoted piece) on `to`.
-        info->prev_moves[ply] = m;
-        info->prev_pieces[ply] = cmh_piece_index(board, MOVE_TO(m));
+        // Track this move for continuation history
+        set_cont_subs(info, board, ply, m);
 
         int score;
 
@@ -1542,6 +1842,11 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
                     reduction--;
                 }
 
+                // Reduce checking moves less (Use_CheckLMR)
+                if (gives_check) {
+                    reduction--;
+                }
+
                 // Clamp reduction: at least 1, don't reduce below depth 1
                 if (reduction < 1) reduction = 1;
                 if (depth - 1 - reduction < 1) {
@@ -1552,13 +1857,14 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
             
             // Null window search with possible reduction
             if (reduction > 0) {
-                PRUNING_STAT_INC(lmr);
+                STAT_INC(info, lmrReductions);
             }
             score = -negamax(board, depth - 1 - reduction, -alpha - 1, -alpha, 
                             info, ply + 1, true, false);
             
             // Re-search if LMR failed high
             if (reduction > 0 && score > alpha) {
+                STAT_INC(info, lmrResearches);
                 score = -negamax(board, depth - 1, -alpha - 1, -alpha, info, ply + 1, true, false);
             }
             
@@ -1605,7 +1911,7 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
             bool mismatch = false;
             int first_mismatch_white = -1, first_mismatch_black = -1;
             int16_t diff_white = 0, diff_black = 0;
-            for (int i = 0; i < NNUE_HIDDEN_SIZE; i++) {
+            for (int i = 0; i < info->nnue_net->hidden_size; i++) {
                 if (info->nnue_acc->white[i] != saved_acc.white[i]) {
                     if (first_mismatch_white < 0) {
                         first_mismatch_white = i;
@@ -1642,6 +1948,21 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
         moves_searched++;
         
         if (info->stopSearch) return 0;
+
+        if (ply == 0) {
+            // The picker has just yielded rootMoves[mp.idx - 1]. Moves that
+            // failed low only have an upper bound and sort by effort instead.
+            RootMove* rm = &info->rootMoves[mp.idx - 1];
+            rm->nodes += info->nodesSearched - nodes_before;
+            if (moves_searched == 1 || score > alpha) {
+                rm->score = score;
+                rm->pv[0] = m;
+                memcpy(rm->pv + 1, info->pv_table[1], sizeof(Move) * (size_t)info->pv_length[1]);
+                rm->pvLength = info->pv_length[1] + 1;
+            } else {
+                rm->score = -INT_MAX;
+            }
+        }
         
         if (score > alpha) {
             alpha = score;
@@ -1654,17 +1975,15 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
             }
             info->pv_length[ply] = info->pv_length[ply + 1] + 1;
             
-            if (ply == 0) {
+            if (ply == 0 && info->pvIdx == 0) {
                 info->bestMoveThisIteration = m;
                 info->bestScoreThisIteration = score;  // Track score for training mode
             }
         }
         
         if (alpha >= beta) {
-#ifdef SEARCH_STATS
-            beta_cutoffs++;
-            if (moves_searched == 1) beta_cutoffs_first++;
-#endif
+            STAT_INC(info, betaCutoffs);
+            if (moves_searched == 1) STAT_INC(info, betaCutoffsFirst);
             // Beta cutoff - update histories for quiet moves
             if (!is_capture) {
                 update_history(info, board, m, depth);
@@ -1677,13 +1996,22 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
                     update_history_malus(info, board, prev, depth);
                     update_cont_histories(board, info, ply, prev, -history_malus(info, depth));
                 }
+            } else {
+                history_gravity(capture_history_entry(info, board, m), history_bonus(info, depth));
+            }
+
+            // Captures searched before the cutoff move failed to refute
+            for (int j = 0; j < captures_tried_count; j++) {
+                Move prev = captures_tried[j];
+                if (prev == m) continue;
+                history_gravity(capture_history_entry(info, board, prev), -history_malus(info, depth));
             }
             break;
         }
     }
     
     // No legal moves found: checkmate or stalemate
-    // (moves_searched == 0 means all pseudo-legal moves were illegal)
+    // (the picker only yields legal moves, so none existed)
     if (moves_searched == 0) {
         if (in_check) {
             return -MATE_SCORE + ply;
@@ -1691,8 +2019,10 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
         return 0;  // Stalemate
     }
     
-    // TT Store - skip for null move search positions (they can never be reached legally)
-    if (!info->stopSearch && !is_null_move_search) {
+    // TT Store - skip for null move search positions (they can never be
+    // reached legally) and for MultiPV lines after the first, whose root
+    // result excludes the better moves
+    if (!info->stopSearch && !is_null_move_search && !(ply == 0 && info->pvIdx > 0)) {
         uint8_t tt_flag;
         if (alpha <= original_alpha) {
             tt_flag = TT_UPPERBOUND;
@@ -1716,6 +2046,424 @@ static int negamax(Board* board, int depth, int alpha, int beta, SearchInfo* inf
     return alpha;
 }
 
+// =============================================================================
+// Root moves
+// =============================================================================
+
+static bool move_in_list(Move m, const Move* list, int count) {
+    for (int i = 0; i < count; i++) {
+        if (list[i] == m) return true;
+    }
+    return false;
+}
+
+// Legal root moves in move picker order (TT move, captures, quiets by
+// history), as the first iteration searched them before there was a root
+// list. Only tbRootMoves and searchMoves when set; if that leaves nothing
+// (searchmoves that are not legal or not TB-optimal), every legal move.
+static void root_moves_init(Board* board, SearchInfo* info) {
+    TTData tte = tt_probe(board->zobristKey);
+    MovePicker mp;
+    movepicker_init(&mp, board, info, 0, tte.found ? tte.move : 0, MP_NORMAL);
+
+    Move legal[MAX_MOVES];
+    int legal_count = 0;
+    Move m;
+    while ((m = movepicker_next(&mp, NULL)) != 0 && legal_count < MAX_MOVES) {
+        legal[legal_count++] = m;
+    }
+
+    for (int pass = 0; pass < 2 && info->rootMoveCount == 0; pass++) {
+        for (int i = 0; i < legal_count; i++) {
+            if (pass == 0 && info->tbRootMoveCount > 0 &&
+                !move_in_list(legal[i], info->tbRootMoves, info->tbRootMoveCount)) continue;
+            if (pass == 0 && info->searchMoveCount > 0 &&
+                !move_in_list(legal[i], info->searchMoves, info->searchMoveCount)) continue;
+            RootMove* rm = &info->rootMoves[info->rootMoveCount++];
+            rm->move = legal[i];
+            rm->score = -INT_MAX;
+            rm->prevScore = -INT_MAX;
+            rm->nodes = 0;
+            rm->pvLength = 0;
+        }
+    }
+}
+
+// Called before every iteration: the last scores become the aspiration
+// centres of the MultiPV lines
+static void root_moves_new_iteration(SearchInfo* info) {
+    for (int i = 0; i < info->rootMoveCount; i++) {
+        RootMove* rm = &info->rootMoves[i];
+        rm->prevScore = rm->score;
+        rm->score = -INT_MAX;
+        rm->nodes = 0;
+    }
+}
+
+// Stable sort: searched lines best first, then the moves that failed low by
+// the effort spent on them (a move that needed many nodes to refute is the
+// most likely to become best later)
+static void root_moves_sort(RootMove* moves, int count) {
+    for (int i = 1; i < count; i++) {
+        RootMove rm = moves[i];
+        int j = i - 1;
+        while (j >= 0 && (rm.score > moves[j].score ||
+                          (rm.score == moves[j].score && rm.nodes > moves[j].nodes))) {
+            moves[j + 1] = moves[j];
+            j--;
+        }
+        moves[j + 1] = rm;
+    }
+}
+
+// =============================================================================
+// Aspiration Windows
+// =============================================================================
+
+// Root search at `depth`: full window up to depth 4 (or with aspiration
+// disabled), then a window around prev_score that is widened to the full
+// range on the failing side until the score lands inside it.
+static int aspiration_search(Board* board, int depth, int prev_score, SearchInfo* info) {
+    int alpha = -INT_MAX + 1;
+    int beta = INT_MAX - 1;
+
+    if (info->params.use_aspiration && depth >= 5) {
+        alpha = prev_score - info->params.aspiration_window;
+        beta = prev_score + info->params.aspiration_window;
+
+        while (true) {
+            int score = negamax(board, depth, alpha, beta, info, 0, true, false);
+
+            if (info->stopSearch) return score;
+
+            // Failed low - widen alpha
+            if (score <= alpha) {
+                alpha = -INT_MAX + 1;
+            }
+            // Failed high - widen beta
+            else if (score >= beta) {
+                beta = INT_MAX - 1;
+            }
+            // Within window
+            else {
+                return score;
+            }
+        }
+    }
+
+    return negamax(board, depth, alpha, beta, info, 0, true, false);
+}
+
+// =============================================================================
+// Lazy SMP
+//
+// Helper threads run their own iterative deepening on a private copy of the
+// root position and share nothing but the transposition table (see tt.c for
+// its thread-safety policy). They diverge through odd/even start depths and
+// through their own, independently learned histories, and fill the TT with
+// results the main thread then picks up. Only the main thread manages time,
+// prints and chooses the best move; when it finishes it raises
+// helpers_stop and joins the helpers.
+// =============================================================================
+
+typedef struct {
+    SearchInfo info;   // persists across searches (histories accumulate)
+    Board board;       // private copy of the root position
+    pthread_t thread;
+    bool running;
+} SearchThread;
+
+static int search_threads = 1;
+static SearchThread* helpers[MAX_THREADS];  // [1, search_threads), 0 unused
+
+void search_set_threads(int threads) {
+    if (threads < 1) threads = 1;
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+
+    for (int i = threads; i < search_threads; i++) {
+        free(helpers[i]);
+        helpers[i] = NULL;
+    }
+    for (int i = search_threads; i < threads; i++) {
+        // 64-byte aligned for the NNUE accumulators in nnue_stack (SIMD
+        // loads); zeroed so a fresh helper starts with cleared histories
+        void* mem = NULL;
+        if (posix_memalign(&mem, 64, sizeof(SearchThread)) != 0) {
+            fprintf(stderr, "Failed to allocate search thread %d\n", i);
+            threads = i;
+            break;
+        }
+        memset(mem, 0, sizeof(SearchThread));
+        helpers[i] = (SearchThread*)mem;
+        helpers[i]->info.threadId = i;
+    }
+    search_threads = threads;
+}
+
+int search_get_threads(void) {
+    return search_threads;
+}
+
+void clear_helper_history(void) {
+    for (int i = 1; i < search_threads; i++) {
+        clear_search_history(&helpers[i]->info);
+    }
+}
+
+static void* helper_thread_main(void* arg) {
+    SearchThread* t = (SearchThread*)arg;
+    SearchInfo* info = &t->info;
+    int prev_score = 0;
+
+    stats_begin(info);
+    root_moves_init(&t->board, info);
+    for (int depth = 1 + (info->threadId & 1); depth <= MAX_PLY; depth++) {
+        info->seldepth = 0;
+        root_moves_new_iteration(info);
+        int score = aspiration_search(&t->board, depth, prev_score, info);
+        if (info->stopSearch) break;
+        root_moves_sort(info->rootMoves, info->rootMoveCount);
+        prev_score = score;
+    }
+    stats_end(info);
+    return NULL;
+}
+
+// Hand the root position and search setup of the main thread to every
+// helper and start them. Limits are left to the main thread.
+static void start_helper_threads(const Board* board, const SearchInfo* main_info) {
+    atomic_store(&helpers_stop, false);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, SEARCH_THREAD_STACK_SIZE);
+
+    for (int i = 1; i < search_threads; i++) {
+        SearchThread* t = helpers[i];
+        SearchInfo* h = &t->info;
+        t->board = *board;
+
+        h->startTimeMs = main_info->startTimeMs;
+        h->softTimeLimit = 0;
+        h->hardTimeLimit = 0;
+        h->depthLimit = 0;
+        h->nodeLimit = 0;
+        h->stopSearch = false;
+        h->nodesSearched = 0;
+        h->seldepth = 0;
+        h->tbHits = 0;
+        h->tbCacheHits = 0;
+        h->bestMoveThisIteration = 0;
+        h->bestScoreThisIteration = 0;
+        h->params = main_info->params;
+        h->tbProbeLimit = main_info->tbProbeLimit;
+        h->tbRootMoveCount = main_info->tbRootMoveCount;
+        memcpy(h->tbRootMoves, main_info->tbRootMoves,
+               sizeof(Move) * (size_t)main_info->tbRootMoveCount);
+        // Helpers search all allowed root moves as a single line
+        h->searchMoveCount = main_info->searchMoveCount;
+        memcpy(h->searchMoves, main_info->searchMoves,
+               sizeof(Move) * (size_t)main_info->searchMoveCount);
+        h->rootMoveCount = 0;
+        h->pvIdx = 0;
+        memset(h->pv_length, 0, sizeof(h->pv_length));
+        clear_volatile_history(h);
+
+        h->nnue_net = main_info->nnue_net;
+        h->nnue_acc = NULL;
+        if (main_info->nnue_acc != NULL && main_info->nnue_net != NULL) {
+            memcpy(&h->nnue_stack[0], main_info->nnue_acc, sizeof(NNUEAccumulator));
+            h->nnue_stack[0].previous = NULL;
+            h->nnue_stack[0].cache = &h->nnue_cache;
+            h->nnue_acc = &h->nnue_stack[0];
+        }
+
+        t->running = pthread_create(&t->thread, &attr, helper_thread_main, t) == 0;
+        if (!t->running) {
+            printf("info string Failed to start search thread %d\n", i);
+            fflush(stdout);
+        }
+    }
+    pthread_attr_destroy(&attr);
+}
+
+static void stop_helper_threads(void) {
+    atomic_store(&helpers_stop, true);
+    for (int i = 1; i < search_threads; i++) {
+        if (helpers[i]->running) {
+            pthread_join(helpers[i]->thread, NULL);
+            helpers[i]->running = false;
+        }
+    }
+    atomic_store(&helpers_stop, false);
+}
+
+// Node count over all threads. Helper counters are read while they run,
+// which is fine for reporting: a relaxed load of an aligned uint64 may be
+// slightly stale but is never torn.
+static uint64_t total_nodes(const SearchInfo* info) {
+    uint64_t nodes = info->nodesSearched;
+    if (info->threadId == 0) {
+        for (int i = 1; i < search_threads; i++) {
+            nodes += __atomic_load_n(&helpers[i]->info.nodesSearched, __ATOMIC_RELAXED);
+        }
+    }
+    return nodes;
+}
+
+static uint64_t total_tb_hits(const SearchInfo* info) {
+    uint64_t hits = info->tbHits;
+    if (info->threadId == 0) {
+        for (int i = 1; i < search_threads; i++) {
+            hits += __atomic_load_n(&helpers[i]->info.tbHits, __ATOMIC_RELAXED);
+        }
+    }
+    return hits;
+}
+
+static uint64_t total_tb_cache_hits(const SearchInfo* info) {
+    uint64_t hits = info->tbCacheHits;
+    if (info->threadId == 0) {
+        for (int i = 1; i < search_threads; i++) {
+            hits += __atomic_load_n(&helpers[i]->info.tbCacheHits, __ATOMIC_RELAXED);
+        }
+    }
+    return hits;
+}
+
+uint64_t search_total_nodes(const SearchInfo* info) {
+    return total_nodes(info);
+}
+
+// Adds the counters, the uint64_t words in front of depthsCompleted
+static void stats_add(SearchStats* dst, const SearchStats* src) {
+    uint64_t* d = (uint64_t*)dst;
+    const uint64_t* s = (const uint64_t*)src;
+    for (size_t i = 0; i < offsetof(SearchStats, depthsCompleted) / sizeof(uint64_t); i++) {
+        d[i] += s[i];
+    }
+}
+
+static double stats_pct(uint64_t part, uint64_t whole) {
+    return whole > 0 ? 100.0 * (double)part / (double)whole : 0.0;
+}
+
+#define ULL(x) ((unsigned long long)(x))
+
+static void stats_print_json(const SearchStats* st, uint64_t nodes, const char* label) {
+    printf("info string %s {\"nodes\":%llu,\"qsearch_nodes\":%llu,\"beta_cutoffs\":%llu,"
+           "\"first_move_cutoffs\":%llu,\"tt_cutoffs\":%llu",
+           label, ULL(nodes), ULL(st->qsNodes), ULL(st->betaCutoffs),
+           ULL(st->betaCutoffsFirst), ULL(st->ttCutoffs));
+    printf(",\"null_move_tries\":%llu,\"null_move_cuts\":%llu,\"rfp_cuts\":%llu,\"razor_cuts\":%llu"
+           ",\"futility_prunes\":%llu,\"lmp_prunes\":%llu,\"lmr_reductions\":%llu,\"lmr_researches\":%llu"
+           ",\"delta_prunes\":%llu,\"qsearch_see_prunes\":%llu",
+           ULL(st->nullMoveTries), ULL(st->nullMoveCuts), ULL(st->rfpCuts), ULL(st->razorCuts),
+           ULL(st->futilityPrunes), ULL(st->lmpPrunes), ULL(st->lmrReductions), ULL(st->lmrResearches),
+           ULL(st->deltaPrunes), ULL(st->qsSeePrunes));
+    printf(",\"nnue_refreshes\":%llu,\"nnue_updates\":%llu,\"eval_cache_probes\":%llu"
+           ",\"eval_cache_hits\":%llu",
+           ULL(st->nnueRefreshes), ULL(st->nnueUpdates), ULL(st->evalCacheProbes),
+           ULL(st->evalCacheHits));
+    printf(",\"tt_probes_by_depth\":[");
+    for (int d = 0; d < STATS_DEPTH_BUCKETS; d++) printf(d ? ",%llu" : "%llu", ULL(st->ttProbes[d]));
+    printf("],\"tt_hits_by_depth\":[");
+    for (int d = 0; d < STATS_DEPTH_BUCKETS; d++) printf(d ? ",%llu" : "%llu", ULL(st->ttHits[d]));
+    printf("],\"time_to_depth_ms\":[");
+    for (int d = 1; d <= st->depthsCompleted; d++) printf(d > 1 ? ",%ld" : "%ld", st->depthTimeMs[d]);
+    printf("]}\n");
+}
+
+static void stats_print_info(const SearchStats* st, uint64_t nodes, const char* label) {
+    uint64_t tt_probes = 0, tt_hits = 0;
+    for (int d = 0; d < STATS_DEPTH_BUCKETS; d++) {
+        tt_probes += st->ttProbes[d];
+        tt_hits += st->ttHits[d];
+    }
+    printf("info string %s: nodes %llu qsearch %.1f%% cutoffs %llu first-move %.2f%% "
+           "tt-hits %.1f%% tt-cutoffs %llu\n",
+           label, ULL(nodes), stats_pct(st->qsNodes, nodes), ULL(st->betaCutoffs),
+           stats_pct(st->betaCutoffsFirst, st->betaCutoffs), stats_pct(tt_hits, tt_probes),
+           ULL(st->ttCutoffs));
+    printf("info string %s: null %llu/%llu rfp %llu razor %llu futility %llu lmp %llu "
+           "lmr %llu (re-search %llu) delta %llu qs-see %llu\n",
+           label, ULL(st->nullMoveCuts), ULL(st->nullMoveTries), ULL(st->rfpCuts), ULL(st->razorCuts),
+           ULL(st->futilityPrunes), ULL(st->lmpPrunes), ULL(st->lmrReductions),
+           ULL(st->lmrResearches), ULL(st->deltaPrunes), ULL(st->qsSeePrunes));
+    printf("info string %s: nnue refreshes %llu incremental %llu (%.2f%% refreshes) "
+           "eval-cache hits %.1f%%\n",
+           label, ULL(st->nnueRefreshes), ULL(st->nnueUpdates),
+           stats_pct(st->nnueRefreshes, st->nnueRefreshes + st->nnueUpdates),
+           stats_pct(st->evalCacheHits, st->evalCacheProbes));
+    printf("info string %s: tt-hits by depth", label);
+    for (int d = 0; d < STATS_DEPTH_BUCKETS; d++) {
+        if (st->ttProbes[d] == 0) continue;
+        printf(" %d%s:%.1f%%", d, d == STATS_DEPTH_BUCKETS - 1 ? "+" : "",
+               stats_pct(st->ttHits[d], st->ttProbes[d]));
+    }
+    printf("\n");
+    if (st->depthsCompleted > 0) {
+        printf("info string %s: time to depth (ms)", label);
+        for (int d = 1; d <= st->depthsCompleted; d++) printf(" %d:%ld", d, st->depthTimeMs[d]);
+        printf("\n");
+    }
+}
+
+static void stats_print(const SearchStats* st, uint64_t nodes, const char* label) {
+    if (stats_mode == SEARCH_STATS_JSON) {
+        stats_print_json(st, nodes, label);
+    } else {
+        stats_print_info(st, nodes, label);
+    }
+    fflush(stdout);
+}
+
+void search_stats_reset_totals(void) {
+    memset(&stats_totals, 0, sizeof(stats_totals));
+    stats_total_nodes = 0;
+    stats_searches = 0;
+}
+
+void search_stats_print_totals(void) {
+    if (stats_mode == SEARCH_STATS_OFF || stats_searches == 0) return;
+    char label[48];
+    snprintf(label, sizeof(label), "Total stats (%llu searches)", ULL(stats_searches));
+    stats_print(&stats_totals, stats_total_nodes, stats_mode == SEARCH_STATS_JSON ? "stats_total" : label);
+}
+
+// Selective depth of the current iteration, the maximum over all threads
+static int max_seldepth(const SearchInfo* info) {
+    int seldepth = info->seldepth;
+    if (info->threadId == 0) {
+        for (int i = 1; i < search_threads; i++) {
+            int d = __atomic_load_n(&helpers[i]->info.seldepth, __ATOMIC_RELAXED);
+            if (d > seldepth) seldepth = d;
+        }
+    }
+    return seldepth;
+}
+
+// Format a search score for UCI (side-to-move perspective; the internal
+// negamax score already is). "mate N" is only reported for a known mate
+// distance. TB scores without a mate distance are shown as a fixed large cp
+// value so GUIs never see a false mate claim.
+static void format_uci_score(int score, char* out, size_t size) {
+    if (score > TB_WIN_SCORE) {
+        int plies = MATE_SCORE - score;
+        snprintf(out, size, "mate %d", (plies + 1) / 2);
+    } else if (score < -TB_WIN_SCORE) {
+        int plies = MATE_SCORE + score;
+        snprintf(out, size, "mate %d", -((plies + 1) / 2));
+    } else if (score >= TB_SCORE_MIN) {
+        // TB win propagated from the subtree: proven win, unknown distance.
+        snprintf(out, size, "cp %d", TB_DISPLAY_CP);
+    } else if (score <= -TB_SCORE_MIN) {
+        snprintf(out, size, "cp %d", -TB_DISPLAY_CP);
+    } else {
+        snprintf(out, size, "cp %d", score);
+    }
+}
+
 // =============================================================================
 // Iterative Deepening with Aspiration Windows
 // =============================================================================
@@ -1733,6 +2481,7 @@ Move iterative_deepening_search(Board* board, SearchInfo* info) {
     if (external_acc != NULL && info->nnue_net != NULL) {
         memcpy(&info->nnue_stack[0], external_acc, sizeof(NNUEAccumulator));
         info->nnue_stack[0].previous = NULL;
+        info->nnue_stack[0].cache = &info->nnue_cache;
         info->nnue_acc = &info->nnue_stack[0];
     }
     
@@ -1740,24 +2489,36 @@ Move iterative_deepening_search(Board* board, SearchInfo* info) {
     info->lastIterationTime = 0;
     info->seldepth = 0;
     info->tbHits = 0;
+    info->tbCacheHits = 0;
 
-    // Reset search statistics
-    TT_STATS_RESET();
-    PRUNING_STATS_RESET();
+    stats_begin(info);
     
     // Initialize TT for new search
     tt_new_search();
     
     // Track longest meaningful iteration time
     long max_meaningful_iteration_time = 0;
+
+    // Adaptive time management inputs (see scaled_soft_limit)
+    Move stable_move = 0;
+    int best_move_stability = 0;
+    int last_iteration_score = 0;
     
     for (int i = 0; i < MAX_PLY; i++) {
         info->pv_length[i] = 0;
     }
-    
-    // Aspiration window variables
-    int alpha = -INT_MAX + 1;
-    int beta = INT_MAX - 1;
+    info->bestPvLength = 0;
+    info->rootMoveCount = 0;
+    info->pvIdx = 0;
+    root_moves_init(board, info);
+    int lines = info->multiPV > 1 ? info->multiPV : 1;
+    if (lines > info->rootMoveCount) lines = info->rootMoveCount > 0 ? info->rootMoveCount : 1;
+
+    bool use_helpers = info->threadId == 0 && search_threads > 1;
+    if (use_helpers) {
+        start_helper_threads(board, info);
+    }
+
     int prev_score = 0;
     
     int max_depth = (info->depthLimit > 0) ? info->depthLimit : MAX_PLY;
@@ -1767,35 +2528,9 @@ Move iterative_deepening_search(Board* board, SearchInfo* info) {
         
         info->bestMoveThisIteration = 0;
         info->seldepth = 0;
+        root_moves_new_iteration(info);
         
-        int score;
-        
-        // Use aspiration windows after depth 4
-        if (info->params.use_aspiration && depth >= 5) {
-            alpha = prev_score - info->params.aspiration_window;
-            beta = prev_score + info->params.aspiration_window;
-            
-            while (true) {
-                score = negamax(board, depth, alpha, beta, info, 0, true, false);
-                
-                if (info->stopSearch) break;
-                
-                // Failed low - widen alpha
-                if (score <= alpha) {
-                    alpha = -INT_MAX + 1;
-                }
-                // Failed high - widen beta  
-                else if (score >= beta) {
-                    beta = INT_MAX - 1;
-                }
-                // Within window
-                else {
-                    break;
-                }
-            }
-        } else {
-            score = negamax(board, depth, alpha, beta, info, 0, true, false);
-        }
+        int score = aspiration_search(board, depth, prev_score, info);
         
         long iteration_end = get_elapsed_time(info);
         info->lastIterationTime = iteration_end - iteration_start;
@@ -1808,7 +2543,7 @@ Move iterative_deepening_search(Board* board, SearchInfo* info) {
         
         if (info->stopSearch) {
             if (!search_silent_mode) {
-                printf("info string Search stopped at depth %d (hard limit reached)\n", depth);
+                printf("info string Search stopped at depth %d (stop or hard limit)\n", depth);
                 fflush(stdout);
             }
             // DO NOT update best_move or best_score from incomplete iteration!
@@ -1825,18 +2560,53 @@ Move iterative_deepening_search(Board* board, SearchInfo* info) {
             best_move = info->bestMoveThisIteration;
             best_score = score;
             prev_score = score;
+            memcpy(info->bestPv, info->pv_table[0], sizeof(Move) * (size_t)info->pv_length[0]);
+            info->bestPvLength = info->pv_length[0];
+        }
+
+        // MultiPV: the other lines in the same iteration, each searching
+        // only the moves not taken by a line before it. They share the TT,
+        // the histories and the root ordering of the first line, which makes
+        // K lines far cheaper than K separate searches.
+        root_moves_sort(info->rootMoves, info->rootMoveCount);
+        int lines_done = 1;
+        for (info->pvIdx = 1; info->pvIdx < lines; info->pvIdx++) {
+            const RootMove* rm = &info->rootMoves[info->pvIdx];
+            aspiration_search(board, depth, rm->prevScore != -INT_MAX ? rm->prevScore : score, info);
+            if (info->stopSearch) break;
+            root_moves_sort(info->rootMoves + info->pvIdx, info->rootMoveCount - info->pvIdx);
+            // A later line can come out above an earlier one: keep the
+            // finished lines in score order
+            root_moves_sort(info->rootMoves, info->pvIdx + 1);
+            lines_done++;
+        }
+        info->pvIdx = 0;
+        if (lines_done > 1 && info->rootMoves[0].move != best_move) {
+            const RootMove* top = &info->rootMoves[0];
+            best_move = top->move;
+            score = top->score;
+            best_score = score;
+            prev_score = score;
+            info->bestScoreThisIteration = score;
+            memcpy(info->bestPv, top->pv, sizeof(Move) * (size_t)top->pvLength);
+            info->bestPvLength = top->pvLength;
+        }
+        if (info->onIteration != NULL && info->threadId == 0) {
+            info->onIteration(info, depth, best_move, score);
+        }
+        if (stats_mode != SEARCH_STATS_OFF) {
+            info->stats.depthTimeMs[depth] = get_elapsed_time(info);
+            info->stats.depthsCompleted = depth;
         }
         
         // UCI output
         long time_ms = get_elapsed_time(info);
-        uint64_t nps = time_ms > 0 ? (info->nodesSearched * 1000ULL / time_ms) : 0;
+        uint64_t nodes = total_nodes(info);
+        uint64_t nps = time_ms > 0 ? (nodes * 1000ULL / time_ms) : 0;
         int hashfull = tt_hashfull();
         
-        // Format the score for UCI (side-to-move perspective; the internal
-        // negamax score already is). "mate N" is only reported for a known
-        // mate distance: a real search mate, or a root TB hit whose PV was
-        // walked out to mate. TB scores without a mate distance are shown as
-        // a fixed large cp value so GUIs never see a false mate claim.
+        // A root TB hit reports the DTZ verdict instead of the search score
+        // for the best line (see format_uci_score for the rest)
         char score_str[32];
         if (info->tbRootMoveCount > 0) {
             // Root TB hit: report the DTZ-optimal verdict, not the search score.
@@ -1847,43 +2617,49 @@ Move iterative_deepening_search(Board* board, SearchInfo* info) {
             } else {
                 snprintf(score_str, sizeof(score_str), "cp %d", sign * TB_DISPLAY_CP);
             }
-        } else if (score > TB_WIN_SCORE) {
-            int plies = MATE_SCORE - score;
-            snprintf(score_str, sizeof(score_str), "mate %d", (plies + 1) / 2);
-        } else if (score < -TB_WIN_SCORE) {
-            int plies = MATE_SCORE + score;
-            snprintf(score_str, sizeof(score_str), "mate %d", -((plies + 1) / 2));
-        } else if (score >= TB_SCORE_MIN) {
-            // TB win propagated from the subtree: proven win, unknown distance.
-            snprintf(score_str, sizeof(score_str), "cp %d", TB_DISPLAY_CP);
-        } else if (score <= -TB_SCORE_MIN) {
-            snprintf(score_str, sizeof(score_str), "cp %d", -TB_DISPLAY_CP);
         } else {
-            snprintf(score_str, sizeof(score_str), "cp %d", score);
+            format_uci_score(score, score_str, sizeof(score_str));
         }
 
         if (!search_silent_mode) {
-            printf("info depth %d seldepth %d score %s nodes %llu nps %llu time %ld hashfull %d tbhits %llu pv",
-                   depth, info->seldepth, score_str, (unsigned long long)info->nodesSearched, (unsigned long long)nps, time_ms, hashfull, (unsigned long long)info->tbHits);
-            
-            if (info->tbRootMoveCount > 0 && info->tbRootPvLen > 0) {
-                // Tablebase root hit: report the DTZ-optimal line.
-                for (int i = 0; i < info->tbRootPvLen; i++) {
-                    char move_str[10];
-                    moveToString(info->tbRootPv[i], move_str);
-                    printf(" %s", move_str);
+            // One line per MultiPV line; "multipv" only when there are several
+            for (int line = 0; line < lines_done; line++) {
+                const Move* pv = info->bestPv;
+                int pv_length = info->bestPvLength;
+                char line_score[32];
+                if (line > 0) {
+                    const RootMove* rm = &info->rootMoves[line];
+                    format_uci_score(rm->score, line_score, sizeof(line_score));
+                    pv = rm->pv;
+                    pv_length = rm->pvLength;
+                } else {
+                    memcpy(line_score, score_str, sizeof(line_score));
+                    if (info->tbRootMoveCount > 0 && info->tbRootPvLen > 0) {
+                        // Tablebase root hit: report the DTZ-optimal line.
+                        pv = info->tbRootPv;
+                        pv_length = info->tbRootPvLen;
+                    }
                 }
-            } else {
-                for (int i = 0; i < info->pv_length[0]; i++) {
-                    if (info->pv_table[0][i] == 0) break;
+
+                printf("info depth %d seldepth %d", depth, max_seldepth(info));
+                if (lines > 1) printf(" multipv %d", line + 1);
+                printf(" score %s nodes %llu nps %llu time %ld hashfull %d tbhits %llu pv",
+                       line_score, (unsigned long long)nodes, (unsigned long long)nps, time_ms, hashfull,
+                       (unsigned long long)total_tb_hits(info));
+                for (int i = 0; i < pv_length; i++) {
+                    if (pv[i] == 0) break;
                     char move_str[10];
-                    moveToString(info->pv_table[0][i], move_str);
+                    moveToString(pv[i], move_str);
                     printf(" %s", move_str);
                 }
+                printf("\n");
             }
-            printf("\n");
             fflush(stdout);
         }
+
+        // A MultiPV line ran into the time limit: its iteration is reported
+        // up to the last finished line, nothing deeper can follow
+        if (info->stopSearch) break;
         
         // Stop if mate found. Strictly above TB_WIN_SCORE means a real mate
         // score; TB win scores (<= TB_WIN_SCORE) must NOT stop the search,
@@ -1898,31 +2674,43 @@ Move iterative_deepening_search(Board* board, SearchInfo* info) {
         }
         
         // Soft node limit - check between iterations (allows current iteration to complete)
-        if (info->nodeLimit > 0 && info->nodesSearched >= info->nodeLimit) {
+        if (info->nodeLimit > 0 && nodes >= info->nodeLimit) {
             if (!search_silent_mode) {
                 printf("info string Soft node limit reached after depth %d (%llu nodes)\n", 
-                       depth, (unsigned long long)info->nodesSearched);
+                       depth, (unsigned long long)nodes);
                 fflush(stdout);
             }
             break;
         }
         
-        // Time management
-        if (info->softTimeLimit > 0) {
-            long remaining = info->softTimeLimit - time_ms;
+        best_move_stability = (best_move == stable_move) ? best_move_stability + 1 : 0;
+        stable_move = best_move;
+        int score_drop = depth > 1 ? last_iteration_score - score : 0;
+        last_iteration_score = score;
+
+        // Time management (none while pondering - ponderhit sets the limits)
+        if (!search_is_pondering() && info->softTimeLimit > 0) {
+            long soft_limit = info->softTimeLimit;
+            if (info->timeScaling && depth >= TM_MIN_DEPTH) {
+                soft_limit = scaled_soft_limit(info, best_move, best_move_stability, score_drop);
+            }
+            long remaining = soft_limit - time_ms;
             
             long time_for_estimate = max_meaningful_iteration_time > 0 ? 
                                      max_meaningful_iteration_time : info->lastIterationTime;
             long estimated_next = time_for_estimate * 3;
             
-            if (time_ms >= info->softTimeLimit) {
-                printf("info string Soft time limit reached after depth %d\n", depth);
-                fflush(stdout);
+            if (time_ms >= soft_limit) {
+                if (!search_silent_mode) {
+                    printf("info string Soft time limit reached after depth %d (%ld of %ld ms)\n",
+                           depth, soft_limit, info->softTimeLimit);
+                    fflush(stdout);
+                }
                 break;
             }
             
             bool enough_time_for_next = (estimated_next <= remaining);
-            bool still_early = (time_ms < (info->softTimeLimit * 60) / 100);
+            bool still_early = (time_ms < (soft_limit * 60) / 100);
             
             if (!enough_time_for_next && !still_early) {
                 if (!search_silent_mode) {
@@ -1935,6 +2723,10 @@ Move iterative_deepening_search(Board* board, SearchInfo* info) {
         }
     }
     
+    if (use_helpers) {
+        stop_helper_threads();
+    }
+
     // Fallback: If we somehow have no best move (e.g., search stopped at depth 1 before finding anything),
     // use the bestMoveThisIteration if available, otherwise return 0 (shouldn't happen in legal position)
     if (best_move == 0 && info->bestMoveThisIteration != 0) {
@@ -1971,39 +2763,36 @@ Move iterative_deepening_search(Board* board, SearchInfo* info) {
     }
 #endif
     (void)best_score;
+    if (stats_mode != SEARCH_STATS_OFF) {
+        stats_end(info);
+        SearchStats total = info->stats;
+        if (use_helpers) {
+            for (int i = 1; i < search_threads; i++) stats_add(&total, &helpers[i]->info.stats);
+        }
+        if (!search_silent_mode) {
+            uint64_t nodes = total_nodes(info);
+            stats_print(&total, nodes, stats_mode == SEARCH_STATS_JSON ? "stats" : "Stats");
+            stats_add(&stats_totals, &total);
+            stats_total_nodes += nodes;
+            stats_searches++;
+        }
+    }
     if (!search_silent_mode) {
         printf("DEBUG: Best move: %u, Total time: %ld ms\n", best_move, get_elapsed_time(info));
-#ifdef SEARCH_STATS
-        // Print TT statistics
-        double hit_rate = tt_probes > 0 ? (100.0 * tt_hits / tt_probes) : 0;
-        double cutoff_rate = tt_hits > 0 ? (100.0 * tt_cutoffs / tt_hits) : 0;
-        printf("info string TT stats: probes=%llu hits=%llu (%.1f%%) cutoffs=%llu (%.1f%% of hits)\n",
-               (unsigned long long)tt_probes, (unsigned long long)tt_hits, hit_rate,
-               (unsigned long long)tt_cutoffs, cutoff_rate);
-        // Move ordering quality: how often the first searched move caused the beta cutoff
-        double fh_first = beta_cutoffs > 0 ? (100.0 * beta_cutoffs_first / beta_cutoffs) : 0;
-        printf("info string Ordering: beta_cutoffs=%llu first_move=%llu (%.2f%%)\n",
-               (unsigned long long)beta_cutoffs, (unsigned long long)beta_cutoffs_first, fh_first);
-        // Print pruning statistics
-        uint64_t total_prunings = pruning_stats.null_move + pruning_stats.reverse_futility +
-                                  pruning_stats.razoring + pruning_stats.futility +
-                                  pruning_stats.lmp + pruning_stats.lmr +
-                                  pruning_stats.delta + pruning_stats.see_pruning;
-        printf("info string Pruning stats (total=%llu):\n", (unsigned long long)total_prunings);
-        printf("info string   Null Move:    %llu\n", (unsigned long long)pruning_stats.null_move);
-        printf("info string   Rev Futility: %llu\n", (unsigned long long)pruning_stats.reverse_futility);
-        printf("info string   Razoring:     %llu\n", (unsigned long long)pruning_stats.razoring);
-        printf("info string   Futility:     %llu\n", (unsigned long long)pruning_stats.futility);
-        printf("info string   LMP:          %llu\n", (unsigned long long)pruning_stats.lmp);
-        printf("info string   LMR:          %llu\n", (unsigned long long)pruning_stats.lmr);
-        printf("info string   Delta:        %llu\n", (unsigned long long)pruning_stats.delta);
-        printf("info string   SEE Pruning:  %llu\n", (unsigned long long)pruning_stats.see_pruning);
-#endif
+        uint64_t tb_hits = total_tb_hits(info);
+        if (tb_hits > 0) {
+            uint64_t tb_cache_hits = total_tb_cache_hits(info);
+            printf("info string Syzygy: tbhits %llu, WDL cache hits %llu (%.1f%%)\n",
+                   (unsigned long long)tb_hits, (unsigned long long)tb_cache_hits,
+                   100.0 * tb_cache_hits / tb_hits);
+        }
         fflush(stdout);
     }
     if (external_acc != NULL && info->nnue_acc != NULL) {
+        NNUEFinnyTable* external_cache = external_acc->cache;
         memcpy(external_acc, &info->nnue_stack[0], sizeof(NNUEAccumulator));
         external_acc->previous = NULL;
+        external_acc->cache = external_cache;
         info->nnue_acc = external_acc;
     }
 
@@ -6,8 +6,10 @@
 #include "nnue.h"
 #include "syzygy.h"
 #include <stdbool.h>
+#include <stddef.h>
 
 #define MAX_PLY 64 // Maximum search depth
+#define MAX_THREADS 256 // Upper bound for the UCI "Threads" option
 
 // =============================================================================
 // Tunable Search Parameters (UCI Options)
@@ -26,6 +28,9 @@ typedef struct {
     bool use_bad_capture_last; // Order losing captures (SEE<0) below quiet moves (default: true, SPRT +11 Elo)
     bool use_lmp;              // Enable Late Move Pruning (default: true)
     bool use_mdp;              // Enable Mate Distance Pruning (default: true)
+    bool use_cuckoo;           // Cut to a draw on forcible upcoming repetitions (default: false)
+    bool use_capture_history;  // Order equal-SEE captures by capture history, not LVA (default: true)
+    bool use_check_lmr;        // Reduce checking moves one ply less in LMR (default: false)
 
     // Late Move Reduction parameters
     int lmr_full_depth_moves;  // Number of moves before LMR kicks in (default: 4)
@@ -77,16 +82,89 @@ typedef struct {
 
 // Initialize SearchParams with default values
 void search_params_init(SearchParams* params);
+// Set / format one parameter by its UCI option name ("Use_LMR", "LMP_Base",
+// ...): booleans take "true"/"1", the others an integer. False for an
+// unknown name.
+bool search_params_set(SearchParams* params, const char* name, const char* value);
+bool search_params_get(const SearchParams* params, const char* name, char* out, size_t size);
+const char* search_params_name(int index);  // NULL past the last parameter
 long search_current_time_ms(void);
+// Soft and hard limit (ms) for one move with time_left/inc on the clock and
+// movestogo moves to the next control (0 = sudden death)
+void search_clock_limits(long time_left, long inc, int movestogo, long* soft, long* hard);
 
 // Silent mode - disables info and debug output (for training)
 extern bool search_silent_mode;
 void set_search_silent(bool silent);
 
+// A legal root move and what the current iteration found for it. The list
+// is re-sorted after every iteration (and every MultiPV line), so the next
+// one starts with the best lines and then the moves that needed the most
+// effort, and it holds the score and PV of each MultiPV line.
 typedef struct {
+    Move move;
+    int score;               // -INT_MAX unless it was the first move or raised alpha
+    int prevScore;           // score of the previous iteration
+    uint64_t nodes;          // nodes spent below this move in the current iteration
+    int pvLength;
+    Move pv[MAX_PLY];
+} RootMove;
+
+// Runtime search statistics, counted per thread into SearchInfo.stats while
+// the mode is not SEARCH_STATS_OFF (one well-predicted branch per counter
+// otherwise). At the end of a search the main thread sums the helpers and
+// prints the result as info strings or as one JSON line.
+#define STATS_DEPTH_BUCKETS 16   // TT probes by draft: 0 = qsearch, last = 15 and up
+
+typedef enum { SEARCH_STATS_OFF, SEARCH_STATS_INFO, SEARCH_STATS_JSON } SearchStatsMode;
+
+typedef struct {
+    // Counters, summed over threads word by word (uint64_t only)
+    uint64_t qsNodes;                        // quiescence() calls
+    uint64_t ttProbes[STATS_DEPTH_BUCKETS];
+    uint64_t ttHits[STATS_DEPTH_BUCKETS];
+    uint64_t ttCutoffs;
+    uint64_t betaCutoffs;                    // fail-highs in the main search
+    uint64_t betaCutoffsFirst;               // ... on the first move searched
+    uint64_t nullMoveTries, nullMoveCuts;
+    uint64_t rfpCuts, razorCuts;
+    uint64_t futilityPrunes, lmpPrunes;
+    uint64_t lmrReductions, lmrResearches;   // reduced searches, ... that failed high
+    uint64_t deltaPrunes, qsSeePrunes;
+    uint64_t nnueRefreshes;                  // accumulator perspectives rebuilt
+    uint64_t nnueUpdates;                    // ... updated incrementally
+    uint64_t evalCacheProbes, evalCacheHits; // static evals not answered by the TT
+
+    // Main thread only: elapsed ms when each depth completed
+    int depthsCompleted;
+    long depthTimeMs[MAX_PLY + 1];
+} SearchStats;
+
+void search_set_stats_mode(SearchStatsMode mode);
+SearchStatsMode search_get_stats_mode(void);
+
+// Static eval cache: direct-mapped on zobristKey, per search thread. An
+// entry packs the key bits above the index (bit 32 forced so an empty entry
+// never matches) with the white-relative eval in the low 32 bits. Evals are
+// exact for a position and net, so entries only go stale when the net
+// changes, like the Finny table.
+#define EVAL_CACHE_BITS 14
+#define EVAL_CACHE_SIZE (1 << EVAL_CACHE_BITS)
+
+typedef struct {
+    uint64_t entry[EVAL_CACHE_SIZE];
+    uint64_t generation;     // net load the entries belong to, 0 = empty
+} EvalCache;
+
+// One [piece][to] slice of a continuation history table (piece index 0-11)
+typedef int16_t PieceToHistory[12][64];
+
+typedef struct SearchInfo {
     long startTimeMs;
     long softTimeLimit;  // Zeit, nach der keine neue Tiefe begonnen wird
     long hardTimeLimit;  // Absolutes Zeitlimit (Abbruch der Suche)
+    bool timeScaling;    // soft limit is a clock budget: rescaled after every iteration
+    long timeBudgetStart; // elapsed ms the limits count from (ponderhit), else 0
     bool stopSearch;
     uint64_t nodesSearched;
     Move bestMoveThisIteration;
@@ -95,21 +173,34 @@ typedef struct {
     // PV table
     Move pv_table[MAX_PLY][MAX_PLY]; // For storing the Principal Variation
     int pv_length[MAX_PLY];          // Length of PV at each ply
+    Move bestPv[MAX_PLY];            // PV of the last completed iteration
+    int bestPvLength;                // (pv_table[0] may hold a partial one)
     
     // History heuristic (indexed by [side][from][to])
     int history[2][64][64];
 
-    // Previous move at each ply (for continuation history)
-    Move prev_moves[MAX_PLY];
+    // Continuation history, indexed by [prev_piece][prev_to][piece][to].
+    // Per search thread (~2.4 MB together), so a SearchInfo must live on the
+    // heap or in static storage, never on the stack.
+    int16_t cmh_table[12][64][12][64]; // 1 ply back (countermove history)
+    int16_t fmh_table[12][64][12][64]; // 2 plies back (follow-up history)
 
-    // Piece index (0-11) that made prev_moves[ply], recorded at make time
-    // (the piece may be captured later, so a board lookup would be wrong)
-    int prev_pieces[MAX_PLY];
+    // [piece][to] subtables selected by the move made at each ply, set at
+    // make time from the mover and its target (the piece may be captured
+    // later, so a board lookup would be wrong). NULL after a null move.
+    // They point into this SearchInfo, which is therefore never copied.
+    PieceToHistory* cmh_sub[MAX_PLY];  // cmh_table[piece][to] of ply's move
+    PieceToHistory* fmh_sub[MAX_PLY];  // fmh_table[piece][to] of ply's move
+
+    // Capture history, indexed by [piece][to][captured piece type]
+    int16_t capture_history[12][64][6];
 
     // NNUE accumulator and network for incremental updates
     NNUEAccumulator* nnue_acc;
     const NNUENetwork* nnue_net;
     NNUEAccumulator nnue_stack[MAX_PLY + 2];
+    NNUEFinnyTable nnue_cache;  // refresh cache per king bucket (~40 KB), per thread
+    EvalCache eval_cache;       // static evals by position (128 KB), per thread
     
     long lastIterationTime;  // Zeit der letzten Iteration für Vorhersage
     int seldepth;            // Selective depth (max depth reached)
@@ -119,6 +210,7 @@ typedef struct {
     // Syzygy tablebase support
     int tbProbeLimit;        // Max piece count to probe WDL in search (0 = off)
     uint64_t tbHits;         // Number of successful TB probes this search
+    uint64_t tbCacheHits;    // ... of which answered by the WDL cache
     // Root move restriction from a DTZ probe (count 0 = inactive). When active,
     // the search at ply 0 only considers these moves.
     Move tbRootMoves[MAX_MOVES];
@@ -129,8 +221,26 @@ typedef struct {
     Move tbRootPv[SYZYGY_MAX_PV]; // DTZ-optimal principal variation
     int tbRootPvLen;           // length of tbRootPv
 
+    // Root moves, built at the start of every search from the legal moves,
+    // restricted to tbRootMoves and searchMoves when those are set
+    RootMove rootMoves[MAX_MOVES];
+    int rootMoveCount;
+    int pvIdx;               // MultiPV line being searched; the root skips rootMoves[0, pvIdx)
+    int multiPV;             // lines to search and report (0 or 1 = best line only)
+    Move searchMoves[MAX_MOVES]; // "go searchmoves" (count 0 = all moves)
+    int searchMoveCount;
+
     // Tunable search parameters
     SearchParams params;
+
+    int threadId;            // 0 = main thread (reports and decides), >0 = helper
+
+    SearchStats stats;       // counted while the statistics mode is on
+
+    // Optional hook called by the main thread after every completed
+    // iteration with its best move (test-suite runners time the solution)
+    void (*onIteration)(const struct SearchInfo* info, int depth, Move best, int score);
+    void* onIterationCtx;
 } SearchInfo;
 
 // TB win/loss score base. Below real mate scores (so a found mate is always
@@ -148,6 +258,45 @@ int alpha_beta_search(Board* board, int depth, int alpha, int beta, bool maximiz
 int quiescence_search(Board* board, int alpha, int beta, bool maximizingPlayer, SearchInfo* info, int ply);
 void clear_search_history(SearchInfo* info);
 void clear_volatile_history(SearchInfo* info);
+
+// Reset the per-search state of info for a new search: start time now, no
+// time/depth/node limit, no tablebase probing or root restriction, single
+// PV, all moves, no iteration callback, results cleared. params (if not
+// NULL) is copied in. The caller then sets its limits, nnue_acc/nnue_net
+// and whatever else it needs; histories are left alone.
+void search_info_prepare(SearchInfo* info, const SearchParams* params);
+
+// Lazy SMP: number of search threads used by iterative_deepening_search()
+// (1 = single-threaded, the default). Helper threads keep their own
+// SearchInfo across searches and share only the transposition table.
+void search_set_threads(int threads);
+int search_get_threads(void);
+void clear_helper_history(void);  // clear_search_history() for every helper
+// Nodes of the last search summed over all threads
+uint64_t search_total_nodes(const SearchInfo* info);
+
+// Totals of the search statistics over several searches (bench); no-ops
+// while the statistics mode is off
+void search_stats_reset_totals(void);
+void search_stats_print_totals(void);
+
+// Search threads need deep recursion (negamax + qsearch frames); do not rely
+// on the platform default stack, which is as small as 128 KB on some libcs.
+#define SEARCH_THREAD_STACK_SIZE (8 * 1024 * 1024)
+
+// Asynchronous stop: search_request_stop() may be called from any thread and
+// makes a running search return at its next time check. The flag stays set
+// until search_clear_stop(), which the caller issues before each new search.
+void search_request_stop(void);
+void search_clear_stop(void);
+bool search_stop_requested(void);
+
+// Pondering: a search started with search_set_pondering(true) runs without
+// time limits until search_ponderhit() installs soft/hard limits counted
+// from that moment (or it is stopped). Called from the UCI thread.
+void search_set_pondering(bool ponder);
+bool search_is_pondering(void);
+void search_ponderhit(SearchInfo* info, long soft_limit, long hard_limit);
 int see_debug(const Board* board, Move move); // Debug: expose SEE
 
 #define MATE_SCORE 1000000 // Arbitrary large score for checkmate
@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 200112L
 #include "syzygy.h"
 #include "tbprobe.h"
 #include "move_generator.h"
@@ -5,12 +6,81 @@
 #include "bitboard_utils.h"
 
 #include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 // Tablebases are loaded iff this is true (and TB_LARGEST > 0).
 static bool tb_loaded = false;
 
+// -----------------------------------------------------------------------------
+// WDL result cache
+//
+// In-search probes require rule50 == 0 and no castling rights, so the zobrist
+// key alone determines the result. A slot is one 64-bit word: the key with its
+// low two bits replaced by wdl + 2 (1..3; 0 = empty). Slots are read and
+// written with single relaxed atomic accesses, so search threads never see a
+// torn entry and a lost update just costs one more probe.
+// -----------------------------------------------------------------------------
+#define WDL_CACHE_BITS 18   // 256K slots = 2 MB
+
+static uint64_t* wdl_cache = NULL;
+
+static uint64_t* wdl_cache_slot(uint64_t key) {
+    return &wdl_cache[key >> (64 - WDL_CACHE_BITS)];
+}
+
+// -----------------------------------------------------------------------------
+// Background warm-up of the tablebase files
+// -----------------------------------------------------------------------------
+static bool warmup_enabled = false;
+static bool warmup_running = false;   // thread started and not yet joined
+static atomic_bool warmup_stop;
+static pthread_t warmup_thread;
+
+static bool warmup_should_stop(void) {
+    return atomic_load_explicit(&warmup_stop, memory_order_relaxed);
+}
+
+static long warmup_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+static void* warmup_main(void* arg) {
+    (void)arg;
+    long start = warmup_now_ms();
+    unsigned files = 0;
+    uint64_t bytes = tb_warmup(TB_LARGEST, warmup_should_stop, &files);
+    if (!warmup_should_stop()) {
+        printf("info string Syzygy: warm-up read %u files (%llu MB) in %ld ms\n",
+               files, (unsigned long long)(bytes >> 20), warmup_now_ms() - start);
+        fflush(stdout);
+    }
+    return NULL;
+}
+
+static void warmup_start(void) {
+    if (warmup_running) return;
+    atomic_store(&warmup_stop, false);
+    if (pthread_create(&warmup_thread, NULL, warmup_main, NULL) != 0) {
+        fprintf(stderr, "Error: Could not start the Syzygy warm-up thread\n");
+        return;
+    }
+    warmup_running = true;
+}
+
+static void warmup_join(void) {
+    if (!warmup_running) return;
+    atomic_store(&warmup_stop, true);
+    pthread_join(warmup_thread, NULL);
+    warmup_running = false;
+}
+
 // -----------------------------------------------------------------------------
 // Board -> Fathom bitboard conversion
 //
@@ -65,8 +135,13 @@ void syzygy_init(const char* path) {
     tb_loaded = ok && TB_LARGEST > 0;
 
     if (tb_loaded) {
+        wdl_cache = calloc((size_t)1 << WDL_CACHE_BITS, sizeof(uint64_t));
+        if (wdl_cache == NULL) {
+            fprintf(stderr, "Error: Could not allocate the Syzygy WDL cache\n");
+        }
         printf("info string Syzygy: loaded, max %u pieces from %s\n",
                TB_LARGEST, path);
+        if (warmup_enabled) warmup_start();
     } else {
         printf("info string Syzygy: no tablebases found at %s\n", path);
     }
@@ -74,10 +149,19 @@ void syzygy_init(const char* path) {
 }
 
 void syzygy_free(void) {
+    warmup_join();
     if (tb_loaded) {
         tb_free();
         tb_loaded = false;
     }
+    free(wdl_cache);
+    wdl_cache = NULL;
+}
+
+void syzygy_set_warmup(bool enabled) {
+    warmup_enabled = enabled;
+    warmup_join();
+    if (enabled && tb_loaded) warmup_start();
 }
 
 int syzygy_max_pieces(void) {
@@ -88,9 +172,20 @@ bool syzygy_available(int piece_count) {
     return tb_loaded && piece_count >= 0 && piece_count <= (int)TB_LARGEST;
 }
 
-bool syzygy_probe_wdl(const Board* board, int* wdl) {
+bool syzygy_probe_wdl(const Board* board, int* wdl, bool* cached) {
     if (!tb_loaded) return false;
 
+    uint64_t tag = board->zobristKey & ~3ULL;
+    if (wdl_cache != NULL) {
+        uint64_t slot = __atomic_load_n(wdl_cache_slot(board->zobristKey), __ATOMIC_RELAXED);
+        if ((slot & 3) != 0 && (slot & ~3ULL) == tag) {
+            *wdl = (int)(slot & 3) - 2;
+            if (cached) *cached = true;
+            return true;
+        }
+    }
+    if (cached) *cached = false;
+
     uint64_t white, black, kings, queens, rooks, bishops, knights, pawns;
     unsigned castling, ep;
     board_to_fathom(board, &white, &black, &kings, &queens, &rooks,
@@ -111,6 +206,10 @@ bool syzygy_probe_wdl(const Board* board, int* wdl) {
         case TB_LOSS: *wdl = -1; break;
         default:      *wdl =  0; break; // draw / cursed win / blessed loss
     }
+    if (wdl_cache != NULL) {
+        __atomic_store_n(wdl_cache_slot(board->zobristKey),
+                         tag | (uint64_t)(*wdl + 2), __ATOMIC_RELAXED);
+    }
     return true;
 }
 
@@ -158,6 +257,7 @@ int syzygy_probe_play(const Board* b, Move* move, int* wdl, int* dtz) {
 // of the board; NNUE is not needed, so applyMove is called with NULL networks.
 static void syzygy_walk_pv(const Board* root, SyzygyRootResult* out) {
     Board b = *root;
+    StateInfo states[SYZYGY_MAX_PV];  // chain of the walked line, outlives each step
     out->pvLen = 0;
     out->matePlies = -1;
 
@@ -173,8 +273,7 @@ static void syzygy_walk_pv(const Board* root, SyzygyRootResult* out) {
 
         out->pv[out->pvLen++] = mv;
 
-        MoveUndoInfo undo;
-        applyMove(&b, mv, &undo, NULL, NULL);
+        applyMove(&b, mv, &states[ply], NULL, NULL);
 
         if (wdl == 0) return;         // drawn line: stop, no forced mate
     }
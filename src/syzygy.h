@@ -19,6 +19,13 @@ void syzygy_init(const char* path);
 // Release tablebase resources. Safe to call when nothing is loaded.
 void syzygy_free(void);
 
+// Background warm-up: when enabled, every successful syzygy_init() starts a
+// thread that reads the WDL files once (smallest first) so the first searches
+// do not stall on page faults from slow TB storage. Enabling it while
+// tablebases are loaded (re)starts it right away; disabling it or
+// syzygy_free() stops it.
+void syzygy_set_warmup(bool enabled);
+
 // Largest number of pieces for which tablebases are loaded (0 = disabled).
 int syzygy_max_pieces(void);
 
@@ -29,7 +36,9 @@ bool syzygy_available(int piece_count);
 // On success returns true and sets *wdl, from the side-to-move's perspective:
 //   -1 = loss, 0 = draw (incl. cursed win / blessed loss), +1 = win.
 // Returns false if the probe failed (e.g. file missing, rule50 != 0).
-bool syzygy_probe_wdl(const Board* board, int* wdl);
+// Results are kept in a small lock-free cache keyed on the zobrist key; if
+// `cached` is non-NULL it is set to whether the result came from that cache.
+bool syzygy_probe_wdl(const Board* board, int* wdl, bool* cached);
 
 #define SYZYGY_MAX_PV 256
 
@@ -473,6 +473,7 @@ struct BaseEntry {
     uint8_t pawns[2];
   };
   bool dtmLossOnly;
+  char name[TB_PIECES + 2]; // e.g. "KRPvKR", for files opened outside a probe
 };
 
 struct PieceEntry {
@@ -780,6 +781,8 @@ static void init_tb(char *str)
   be->num = 0;
   for (int i = 0; i < 16; i++)
     be->num += pcs[i];
+  strncpy(be->name, str, sizeof(be->name) - 1);
+  be->name[sizeof(be->name) - 1] = '\0';
 
   numWdl++;
   numDtm += be->hasDtm = test_tb(str, tbSuffix[DTM]);
@@ -1057,6 +1060,57 @@ void tb_free(void)
   pawnEntry = NULL;
 }
 
+#ifndef _WIN32
+#define WARMUP_CHUNK (1 << 20)
+
+static uint64_t warm_file(const char *name, const char *suffix, char *buf,
+                          bool (*should_stop)(void))
+{
+  FD fd = open_tb(name, suffix);
+  if (fd == FD_ERR)
+    return 0;
+#ifdef POSIX_FADV_WILLNEED
+  posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+  uint64_t total = 0;
+  ssize_t n;
+  while (!should_stop() && (n = read(fd, buf, WARMUP_CHUNK)) > 0)
+    total += (uint64_t)n;
+  close_tb(fd);
+  return total;
+}
+#endif
+
+uint64_t tb_warmup(unsigned max_pieces, bool (*should_stop)(void),
+                   unsigned *files)
+{
+  *files = 0;
+#ifndef _WIN32
+  char *buf = (char*)malloc(WARMUP_CHUNK);
+  if (!buf)
+    return 0;
+  uint64_t total = 0;
+  for (unsigned num = 3; num <= max_pieces && !should_stop(); num++) {
+    for (int i = 0; i < tbNumPiece && !should_stop(); i++)
+      if (pieceEntry[i].be.num == num) {
+        total += warm_file(pieceEntry[i].be.name, tbSuffix[WDL], buf, should_stop);
+        (*files)++;
+      }
+    for (int i = 0; i < tbNumPawn && !should_stop(); i++)
+      if (pawnEntry[i].be.num == num) {
+        total += warm_file(pawnEntry[i].be.name, tbSuffix[WDL], buf, should_stop);
+        (*files)++;
+      }
+  }
+  free(buf);
+  return total;
+#else
+  (void)max_pieces;
+  (void)should_stop;
+  return 0;
+#endif
+}
+
 static const int8_t OffDiag[] = {
   0,-1,-1,-1,-1,-1,-1,-1,
   1, 0,-1,-1,-1,-1,-1,-1,
@@ -180,6 +180,20 @@ bool tb_init(const char *_path);
  */
 void tb_free(void);
 
+/*
+ * Read the WDL files of all tables with at most `max_pieces' pieces once,
+ * smallest tables first, so that later probes find them in the page cache
+ * instead of faulting on slow (e.g. network) storage. The tables themselves
+ * are still mapped lazily by the first probe. Stops as soon as should_stop()
+ * returns true. Must not run concurrently with tb_init()/tb_free().
+ *
+ * RETURN:
+ * - the number of bytes read; *files is set to the number of files visited.
+ *   Not implemented on Windows (returns 0).
+ */
+uint64_t tb_warmup(unsigned max_pieces, bool (*should_stop)(void),
+                   unsigned *files);
+
 /*
  * Probe the Win-Draw-Loss (WDL) table.
  *
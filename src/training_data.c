@@ -1,93 +1,217 @@
 #include "training_data.h"
 #include "board_io.h"
+#include "bitboard_utils.h"
+#include "move_generator.h"  // updateCheckInfo
+#include "zobrist.h"
 #include <string.h>
 #include <stdlib.h>
-#include <sys/types.h>  // For pid_t
-#include <unistd.h>     // For getpid()
-
-// Global variables
-TrainingEntry training_data[MAX_TRAINING_ENTRIES];
-int training_data_count = 0;
-FILE* training_file = NULL;
-char training_data_path[256] = "";
-bool training_enabled = false;
-
-void init_training_data() {
-    training_data_count = 0;
-    if (training_file) {
-        fclose(training_file);
-        training_file = NULL;
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+static FILE* training_file = NULL;
+static TrainingFormat output_format = TRAINING_FORMAT_TEXT;
+
+#ifdef USE_ZSTD
+static ZSTD_CCtx* zstd_ctx = NULL;   // NULL = uncompressed
+static void* zstd_buffer = NULL;
+static size_t zstd_buffer_size = 0;
+#endif
+
+// Straight from the bitboards: squares are visited in ascending order of the
+// side to move's (possibly flipped) board, as bullet expects
+static void pack_bullet_board(const Board* board, int eval, BulletBoard* out) {
+    int us = board->whiteToMove ? WHITE : BLACK;
+    int flip = us == WHITE ? 0 : 56;
+    // Occupancy from byTypeBB: byColorBB is not maintained incrementally
+    Bitboard occ = 0;
+    for (int type = PAWN; type <= KING; type++) {
+        occ |= board->byTypeBB[WHITE][type] | board->byTypeBB[BLACK][type];
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->occ = us == WHITE ? occ : __builtin_bswap64(occ);
+
+    int idx = 0;
+    for (Bitboard bb = out->occ; bb; bb &= bb - 1) {
+        int piece = board->piece[__builtin_ctzll(bb) ^ flip];
+        int colour = PIECE_COLOR_OF(piece) != us;
+        out->pcs[idx / 2] |= (uint8_t)(((colour << 3) | PIECE_TYPE_OF(piece)) << (4 * (idx & 1)));
+        idx++;
+    }
+
+    if (eval > INT16_MAX) eval = INT16_MAX;
+    if (eval < -INT16_MAX) eval = -INT16_MAX;
+    out->score = (int16_t)eval;  // already side-to-move relative
+    out->ksq = (uint8_t)(__builtin_ctzll(board->byTypeBB[us][KING]) ^ flip);
+    out->opp_ksq = (uint8_t)(__builtin_ctzll(board->byTypeBB[!us][KING]) ^ flip ^ 56);
+}
+
+bool training_unpack_bullet(const BulletBoard* packed, Board* board) {
+    memset(board, 0, sizeof(*board));
+    clear_piece_array(board);
+    int idx = 0;
+    for (Bitboard bb = packed->occ; bb; bb &= bb - 1) {
+        if (idx == 32) return false;
+        int nibble = (packed->pcs[idx / 2] >> (4 * (idx & 1))) & 0xF;
+        idx++;
+        int type = nibble & 7;
+        if (type > KING) return false;
+        put_piece(board, (uint8_t)MAKE_PIECE_NEW(type, nibble >> 3), __builtin_ctzll(bb));
+    }
+    if (POPCOUNT(board->byTypeBB[WHITE][KING]) != 1 || POPCOUNT(board->byTypeBB[BLACK][KING]) != 1) {
+        return false;
     }
-    training_enabled = false;
-    strcpy(training_data_path, "");
+    sync_color_bitboards(board);
+
+    board->whiteToMove = true;
+    board->castlingRights = 0;
+    board->enPassantSquare = SQ_NONE;
+    board->halfMoveClock = 0;
+    board->fullMoveNumber = 1;
+    board->st = NULL;
+    board->zobristKey = calculate_zobrist_key(board);
+    updateCheckInfo(board);
+    return true;
 }
 
-void add_training_entry(const Board* board, int eval, int ply) {
-    if (!training_enabled || training_data_count >= MAX_TRAINING_ENTRIES) return;
-    const char* fen = outputFEN(board);
-    strncpy(training_data[training_data_count].fen, fen, sizeof(training_data[training_data_count].fen) - 1);
-    training_data[training_data_count].eval = eval;
-    training_data[training_data_count].ply = ply;
-    training_data[training_data_count].white_to_move = board->whiteToMove;
-    training_data_count++;
+void training_game_add(TrainingGame* game, const Board* board, int eval, int ply) {
+    if (game->count >= MAX_TRAINING_ENTRIES) return;
+    TrainingEntry* entry = &game->entries[game->count];
+    if (output_format == TRAINING_FORMAT_BULLET) {
+        pack_bullet_board(board, eval, &entry->packed);
+    } else {
+        const char* fen = outputFEN(board);
+        strncpy(entry->fen, fen, sizeof(entry->fen) - 1);
+        entry->fen[sizeof(entry->fen) - 1] = '\0';
+    }
+    entry->eval = eval;
+    entry->ply = ply;
+    entry->white_to_move = board->whiteToMove;
+    game->count++;
 }
 
-void write_training_data(int result) {  // 1 = win for white, 0 = draw, -1 = loss for white
-    if (!training_enabled || !training_data_path[0]) return;
-    if (!training_file) {
-        training_file = fopen(training_data_path, "a");
-        if (!training_file) return;
+static char* encode_bullet(const TrainingGame* game, int result, size_t* length) {
+    BulletBoard* records = (BulletBoard*)malloc((size_t)game->count * sizeof(BulletBoard) + 1);
+    if (!records) return NULL;
+    for (int i = 0; i < game->count; i++) {
+        records[i] = game->entries[i].packed;
+        int stm_result = game->entries[i].white_to_move ? result : -result;
+        records[i].result = (uint8_t)(stm_result + 1);
     }
-    for (int i = 0; i < training_data_count; i++) {
+    *length = (size_t)game->count * sizeof(BulletBoard);
+    return (char*)records;
+}
+
+static char* encode_text(const TrainingGame* game, int result, size_t* length) {
+    // WDL is white-relative: 1.0 = white wins, 0.5 = draw, 0.0 = white loses
+    const char* wdl;
+    if (result == 1) wdl = "1.0";       // White won
+    else if (result == -1) wdl = "0.0"; // White lost
+    else wdl = "0.5";                   // Draw
+
+    // FEN + " | " + eval + " | " + wdl + "\n" stays well below this
+    const size_t max_line = sizeof(game->entries[0].fen) + 32;
+    char* text = (char*)malloc((size_t)game->count * max_line + 1);
+    if (!text) return NULL;
+
+    size_t len = 0;
+    for (int i = 0; i < game->count; i++) {
         // Score is white-relative: positive = good for white
         // The stored eval is STM-relative, so flip if black to move
-        int white_relative_eval = training_data[i].white_to_move 
-            ? training_data[i].eval 
-            : -training_data[i].eval;
-        
-        // WDL is white-relative: 1.0 = white wins, 0.5 = draw, 0.0 = white loses
-        const char* wdl;
-        if (result == 1) wdl = "1.0";       // White won
-        else if (result == -1) wdl = "0.0"; // White lost
-        else wdl = "0.5";                   // Draw
-        fprintf(training_file, "%s | %d | %s\n", training_data[i].fen, white_relative_eval, wdl);
+        int white_relative_eval = game->entries[i].white_to_move
+            ? game->entries[i].eval
+            : -game->entries[i].eval;
+        len += (size_t)snprintf(text + len, max_line, "%s | %d | %s\n",
+                                game->entries[i].fen, white_relative_eval, wdl);
     }
-    // Flush after each game to ensure data is written to disk
-    // This prevents data loss if the process is terminated
-    fflush(training_file);
-    training_data_count = 0;  // Reset
+    *length = len;
+    return text;
 }
 
-void flush_training_data() {
-    if (training_file) {
-        fflush(training_file);
-    }
+char* training_game_encode(const TrainingGame* game, int result, size_t* length) {
+    return output_format == TRAINING_FORMAT_BULLET
+        ? encode_bullet(game, result, length)
+        : encode_text(game, result, length);
 }
 
-void set_training_data_path(const char* path) {
-    if (path && strlen(path) > 0) {
-        // Append PID to filename for unique files in parallel runs
-        pid_t pid = getpid();
-        snprintf(training_data_path, sizeof(training_data_path), "%s.%lld", path, (long long)pid);
-        training_enabled = true;
-        if (training_file) {
-            fclose(training_file);
-        }
-        training_file = fopen(training_data_path, "a");
-        if (training_file) {
-            // Use larger buffer for better I/O performance
-            setvbuf(training_file, NULL, _IOFBF, 65536);  // 64KB buffer
-        }
-    } else {
-        training_enabled = false;
-        if (training_file) {
-            fclose(training_file);
-            training_file = NULL;
+bool training_output_open(const char* path, TrainingFormat format, int zstd_level) {
+    training_output_close();
+    if (!path || !path[0]) return false;
+    output_format = format;
+
+#ifdef USE_ZSTD
+    if (zstd_level > 0) {
+        zstd_ctx = ZSTD_createCCtx();
+        zstd_buffer_size = ZSTD_CStreamOutSize();
+        zstd_buffer = malloc(zstd_buffer_size);
+        if (!zstd_ctx || !zstd_buffer ||
+            ZSTD_isError(ZSTD_CCtx_setParameter(zstd_ctx, ZSTD_c_compressionLevel, zstd_level))) {
+            fprintf(stderr, "Error: Failed to set up zstd compression\n");
+            training_output_close();
+            return false;
         }
-        strcpy(training_data_path, "");
     }
+#else
+    if (zstd_level > 0) {
+        fprintf(stderr, "Error: zstd output needs a build with ZSTD=1\n");
+        return false;
+    }
+#endif
+
+    training_file = fopen(path, format == TRAINING_FORMAT_TEXT ? "a" : "ab");
+    if (!training_file) {
+        training_output_close();
+        return false;
+    }
+    // Use larger buffer for better I/O performance
+    setvbuf(training_file, NULL, _IOFBF, 65536);  // 64KB buffer
+    return true;
+}
+
+#ifdef USE_ZSTD
+// Feed data through the compressor; ZSTD_e_flush ends the current block,
+// ZSTD_e_end the frame
+static bool zstd_write(const char* data, size_t length, ZSTD_EndDirective mode) {
+    ZSTD_inBuffer in = {data, length, 0};
+    size_t remaining;
+    do {
+        ZSTD_outBuffer out = {zstd_buffer, zstd_buffer_size, 0};
+        remaining = ZSTD_compressStream2(zstd_ctx, &out, &in, mode);
+        if (ZSTD_isError(remaining)) return false;
+        if (fwrite(zstd_buffer, 1, out.pos, training_file) != out.pos) return false;
+    } while (remaining != 0 || in.pos < in.size);
+    return true;
 }
+#endif
 
-void enable_training(bool enable) {
-    training_enabled = enable;
-}
\ No newline at end of file
+bool training_output_write(const char* data, size_t length) {
+    if (!training_file) return false;
+    bool ok;
+#ifdef USE_ZSTD
+    if (zstd_ctx) {
+        ok = zstd_write(data, length, ZSTD_e_flush);
+        return fflush(training_file) == 0 && ok;
+    }
+#endif
+    ok = fwrite(data, 1, length, training_file) == length;
+    // Flush after each game to ensure data is written to disk
+    // This prevents data loss if the process is terminated
+    return fflush(training_file) == 0 && ok;
+}
+
+void training_output_close(void) {
+#ifdef USE_ZSTD
+    if (zstd_ctx && training_file) {
+        zstd_write(NULL, 0, ZSTD_e_end);
+    }
+    ZSTD_freeCCtx(zstd_ctx);  // accepts NULL
+    zstd_ctx = NULL;
+    free(zstd_buffer);
+    zstd_buffer = NULL;
+#endif
+    if (training_file) {
+        fclose(training_file);
+        training_file = NULL;
+    }
+}
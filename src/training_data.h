@@ -4,29 +4,68 @@
 #include "board.h"
 #include <stdio.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Output formats
+typedef enum {
+    TRAINING_FORMAT_TEXT,    // "fen | eval | wdl" lines, white-relative (bullet-utils "text")
+    TRAINING_FORMAT_BULLET   // bullet's packed 32-byte ChessBoard records (.data)
+} TrainingFormat;
+
+// bullet's ChessBoard record (bulletformat crate), written as is on a
+// little-endian host. Everything is seen from the side to move: for black
+// the board is flipped vertically and colours are swapped.
+typedef struct {
+    uint64_t occ;        // occupied squares
+    uint8_t  pcs[16];    // one nibble per occupied square, ascending: colour << 3 | piece (0 = side to move)
+    int16_t  score;      // eval in cp
+    uint8_t  result;     // 0 = loss, 1 = draw, 2 = win
+    uint8_t  ksq;        // king square
+    uint8_t  opp_ksq;    // opponent's king square, mirrored again (^ 56)
+    uint8_t  extra[3];
+} BulletBoard;
+
+_Static_assert(sizeof(BulletBoard) == 32, "BulletBoard must be 32 bytes");
 
 // Training data collection
 #define MAX_TRAINING_ENTRIES 10000
 typedef struct {
-    char fen[100];
+    union {
+        char fen[100];        // TRAINING_FORMAT_TEXT
+        BulletBoard packed;   // TRAINING_FORMAT_BULLET, result set when the game ends
+    };
     int eval;
     int ply;
     bool white_to_move;
 } TrainingEntry;
 
-// Global variables (declared in training_data.c)
-extern TrainingEntry training_data[MAX_TRAINING_ENTRIES];
-extern int training_data_count;
-extern FILE* training_file;
-extern char training_data_path[256];
-extern bool training_enabled;
-
-// Functions
-void init_training_data();
-void add_training_entry(const Board* board, int eval, int ply);
-void write_training_data(int result);
-void flush_training_data();
-void set_training_data_path(const char* path);
-void enable_training(bool enable);
-
-#endif // TRAINING_DATA_H
\ No newline at end of file
+// Positions of one game, collected by a self-play worker until the result
+// is known (~1 MB, so it lives in the worker, not on the stack)
+typedef struct {
+    TrainingEntry entries[MAX_TRAINING_ENTRIES];
+    int count;
+} TrainingGame;
+
+// Records the position in the format passed to training_output_open()
+void training_game_add(TrainingGame* game, const Board* board, int eval, int ply);
+// The game's entries in the output format (result: 1 = win for white,
+// 0 = draw, -1 = loss for white). Returns a malloc'd buffer of *length
+// bytes (not NUL terminated), NULL on failure.
+char* training_game_encode(const TrainingGame* game, int result, size_t* length);
+
+// Inverse of the packing: the record's board with the side to move as white
+// (castling rights, en passant square and move counters are not stored).
+// False if the record does not hold exactly one king per side.
+bool training_unpack_bullet(const BulletBoard* packed, Board* board);
+
+// Output file, opened for appending (the self-play generator passes
+// "<path>.<pid>" so several processes can share one prefix). zstd_level > 0
+// compresses the stream (needs a ZSTD=1 build); every write ends a zstd
+// block, so a killed run still decompresses up to its last game. Not
+// thread-safe, the training program writes from a single writer thread.
+bool training_output_open(const char* path, TrainingFormat format, int zstd_level);
+bool training_output_write(const char* data, size_t length);  // flushes
+void training_output_close(void);
+
+#endif // TRAINING_DATA_H
@@ -1,11 +1,17 @@
+// posix_memalign and nanosleep need POSIX visibility under -std=c11
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 #include <getopt.h>
 #include <signal.h>
 #include <unistd.h>
+#include <pthread.h>
 
 #include "board.h"
 #include "board_io.h"
@@ -20,6 +26,8 @@
 #include "zobrist.h"
 #include "tt.h"
 #include "syzygy.h"
+#include "rescore.h"
+#include "game.h"
 
 // =============================================================================
 // Configuration
@@ -27,6 +35,8 @@
 
 typedef struct {
     char output_file[256];
+    TrainingFormat format;      // text lines or bullet's packed records
+    int zstd_level;             // zstd compression level, 0 = uncompressed
     int random_moves;           // Number of random moves at start of game
     int random_probability;     // Probability (0-100) for each random move
     int draw_threshold;         // Moves without progress before draw
@@ -41,10 +51,15 @@ typedef struct {
     bool filter_tactics;        // Filter out tactical positions (checks, captures)
     char syzygy_path[1024];     // Syzygy tablebase path (empty = disabled)
     int syzygy_probe_limit;     // Max piece count for TB adjudication
+    int threads;                // Self-play worker threads
+    char rescore_input[1024];   // Rescore this file instead of playing games (empty = self-play)
+    bool rescore_static;        // Rescore with the static eval instead of a search
 } TrainingConfig;
 
 static TrainingConfig config = {
     .output_file = "training_data.txt",
+    .format = TRAINING_FORMAT_TEXT,
+    .zstd_level = 0,
     .random_moves = 12,
     .random_probability = 100,  // 100% random for first N moves
     .draw_threshold = 100,      // 50-move rule
@@ -58,17 +73,23 @@ static TrainingConfig config = {
     .adjudicate_threshold = 10, // Default: adjudicate at +/-1000cp
     .filter_tactics = true,     // Default: filter tactical positions
     .syzygy_path = "",          // Default: tablebases disabled
-    .syzygy_probe_limit = 7     // Max pieces for TB adjudication (when loaded)
+    .syzygy_probe_limit = 7,    // Max pieces for TB adjudication (when loaded)
+    .threads = 1,
+    .rescore_input = "",
+    .rescore_static = false
 };
 
-// Global flag for graceful shutdown
-static volatile sig_atomic_t should_stop = 0;
-static int games_completed = 0;
+#define MAX_TRAINING_THREADS 256
 
-// Statistics tracking
-static int total_positions = 0;
-static int filtered_positions = 0;
-static int games_discarded = 0;
+// Global flag for graceful shutdown (lock-free, so the signal handler may
+// set it while the workers poll it)
+static atomic_bool should_stop = false;
+static atomic_int games_completed = 0;
+
+// Statistics tracking (updated by all workers)
+static atomic_int total_positions = 0;
+static atomic_int filtered_positions = 0;
+static atomic_int games_discarded = 0;
 static time_t start_time = 0;
 static time_t last_status_time = 0;
 
@@ -76,9 +97,11 @@ static void print_status(void) {
     time_t now = time(NULL);
     double elapsed = difftime(now, start_time);
     if (elapsed > 0) {
-        double pos_per_sec = total_positions / elapsed;
+        int positions = atomic_load(&total_positions);
+        double pos_per_sec = positions / elapsed;
         printf("[Status: %d games, %d discarded, %d positions (%d filtered), %.1f pos/sec, %.0fs elapsed]\n", 
-               games_completed, games_discarded, total_positions, filtered_positions, pos_per_sec, elapsed);
+               atomic_load(&games_completed), atomic_load(&games_discarded), positions,
+               atomic_load(&filtered_positions), pos_per_sec, elapsed);
         fflush(stdout);
     }
 }
@@ -100,120 +123,98 @@ static void check_status_output(void) {
 // Message and data flush happen in the main loop when the flag is seen.
 void signal_handler(int sig) {
     (void)sig;
-    should_stop = 1;
+    atomic_store(&should_stop, true);
 }
 
 // =============================================================================
-// Game Result Detection
+// Self-Play Workers
+//
+// Each worker thread plays whole games with private state: its own
+// SearchInfo, slice of the transposition table, RNG and position buffers.
+// The NNUE network is shared read-only. Finished games are formatted by the
+// worker and handed to the single writer thread, which owns the output file.
 // =============================================================================
 
-typedef enum {
-    GAME_ONGOING,
-    GAME_WHITE_WINS,
-    GAME_BLACK_WINS,
-    GAME_DRAW
-} GameResult;
-
-// Check for insufficient material
-static bool is_insufficient_material(const Board* board) {
-    // Count pieces
-    int white_pawns = __builtin_popcountll(board->whitePawns);
-    int black_pawns = __builtin_popcountll(board->blackPawns);
-    int white_rooks = __builtin_popcountll(board->whiteRooks);
-    int black_rooks = __builtin_popcountll(board->blackRooks);
-    int white_queens = __builtin_popcountll(board->whiteQueens);
-    int black_queens = __builtin_popcountll(board->blackQueens);
-    int white_knights = __builtin_popcountll(board->whiteKnights);
-    int black_knights = __builtin_popcountll(board->blackKnights);
-    int white_bishops = __builtin_popcountll(board->whiteBishops);
-    int black_bishops = __builtin_popcountll(board->blackBishops);
-    
-    // If there are pawns, rooks, or queens, sufficient material
-    if (white_pawns || black_pawns || white_rooks || black_rooks || 
-        white_queens || black_queens) {
-        return false;
-    }
-    
-    int white_minor = white_knights + white_bishops;
-    int black_minor = black_knights + black_bishops;
-    
-    // King vs King
-    if (white_minor == 0 && black_minor == 0) return true;
-    
-    // King + minor vs King
-    if ((white_minor == 1 && black_minor == 0) ||
-        (white_minor == 0 && black_minor == 1)) return true;
-    
-    // King + Bishop vs King + Bishop (same color bishops)
-    if (white_knights == 0 && black_knights == 0 &&
-        white_bishops == 1 && black_bishops == 1) {
-        // Check if bishops are on same color
-        int white_bishop_sq = __builtin_ctzll(board->whiteBishops);
-        int black_bishop_sq = __builtin_ctzll(board->blackBishops);
-        int white_color = (white_bishop_sq / 8 + white_bishop_sq % 8) % 2;
-        int black_color = (black_bishop_sq / 8 + black_bishop_sq % 8) % 2;
-        if (white_color == black_color) return true;
-    }
-    
-    return false;
-}
-
-// Check for threefold repetition (simplified - just check last few positions)
-static uint64_t position_history[1024];
-static int position_count = 0;
-
-static void reset_position_history(void) {
-    position_count = 0;
+typedef struct {
+    // Fully reset before every search; only the NNUE refresh cache is kept
+    // across moves and games. Too large for a thread stack, like the rest.
+    SearchInfo search_info;
+    StateInfo game_states[MAX_GAME_STATES];  // game history for the search's repetition check (board.st chain)
+    PositionHistory history;
+    TrainingGame data;
+    uint64_t rng;       // xorshift64* state (rand() is shared by all threads)
+    int id;
+    const NNUENetwork* nnue_network;  // shared by all workers
+    pthread_t thread;
+} Worker;
+
+static uint32_t worker_rand(Worker* w) {
+    w->rng ^= w->rng >> 12;
+    w->rng ^= w->rng << 25;
+    w->rng ^= w->rng >> 27;
+    return (uint32_t)((w->rng * 0x2545F4914F6CDD1DULL) >> 32);
 }
 
-static void record_position(uint64_t hash) {
-    if (position_count < 1024) {
-        position_history[position_count++] = hash;
+// Finished games on their way to the writer thread
+typedef struct FinishedGame {
+    struct FinishedGame* next;
+    char* text;
+    size_t length;
+} FinishedGame;
+
+static pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+static FinishedGame* queue_head = NULL;
+static FinishedGame* queue_tail = NULL;
+static bool queue_closed = false;  // no more games will be queued
+
+static void queue_game(char* text, size_t length) {
+    FinishedGame* game = (FinishedGame*)malloc(sizeof(FinishedGame));
+    if (!game) {
+        free(text);
+        return;
     }
+    game->next = NULL;
+    game->text = text;
+    game->length = length;
+
+    pthread_mutex_lock(&queue_mutex);
+    if (queue_tail) queue_tail->next = game;
+    else queue_head = game;
+    queue_tail = game;
+    pthread_cond_signal(&queue_cond);
+    pthread_mutex_unlock(&queue_mutex);
 }
 
-static int count_position_repetitions(uint64_t hash) {
-    int count = 0;
-    for (int i = 0; i < position_count; i++) {
-        if (position_history[i] == hash) count++;
-    }
-    return count;
+static void close_queue(void) {
+    pthread_mutex_lock(&queue_mutex);
+    queue_closed = true;
+    pthread_cond_signal(&queue_cond);
+    pthread_mutex_unlock(&queue_mutex);
 }
 
-static GameResult check_game_result(Board* board, int half_move_clock, MoveList* moves) {
-    generateLegalMoves(board, moves);
-    
-    // Check for checkmate or stalemate
-    if (moves->count == 0) {
-        if (isKingAttacked(board, board->whiteToMove)) {
-            // Checkmate
-            return board->whiteToMove ? GAME_BLACK_WINS : GAME_WHITE_WINS;
-        } else {
-            // Stalemate
-            return GAME_DRAW;
+static void* writer_main(void* arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&queue_mutex);
+        while (!queue_head && !queue_closed) {
+            pthread_cond_wait(&queue_cond, &queue_mutex);
         }
+        FinishedGame* game = queue_head;
+        if (game) {
+            queue_head = game->next;
+            if (!queue_head) queue_tail = NULL;
+        }
+        pthread_mutex_unlock(&queue_mutex);
+        if (!game) break;  // closed and drained
+
+        if (!training_output_write(game->text, game->length)) {
+            fprintf(stderr, "Error: Failed to write training data\n");
+        }
+        free(game->text);
+        free(game);
     }
-    
-    // 50-move rule
-    if (half_move_clock >= config.draw_threshold * 2) {
-        return GAME_DRAW;
-    }
-    
-    // Insufficient material
-    if (is_insufficient_material(board)) {
-        return GAME_DRAW;
-    }
-    
-    // Threefold repetition. The position just reached is recorded at the top
-    // of the NEXT game-loop iteration, so it is not in position_history yet
-    // and counts as one occurrence itself. Without the +1 this adjudicated
-    // only on the 4th occurrence - one full repetition cycle too late (a
-    // hung search on the 3rd occurrence is what stalled instances for hours).
-    if (count_position_repetitions(board->zobristKey) + 1 >= 3) {
-        return GAME_DRAW;
-    }
-    
-    return GAME_ONGOING;
+    return NULL;
 }
 
 // =============================================================================
@@ -221,13 +222,16 @@ static GameResult check_game_result(Board* board, int half_move_clock, MoveList*
 // =============================================================================
 
 // Returns true if game was valid, false if discarded (eval threshold exceeded)
-static bool play_game(int game_num, NNUENetwork* nnue_network) {
+static bool play_game(Worker* w, int game_num) {
     Board board = parseFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    SearchInfo* search = &w->search_info;
+    const NNUENetwork* nnue_network = w->nnue_network;
+
     NNUEAccumulator nnue_accumulator = {0};
+    nnue_accumulator.cache = &search->nnue_cache;
     nnue_reset_accumulator(&board, &nnue_accumulator, nnue_network);
     
     MoveList moves;
-    MoveUndoInfo undo_info;
     
     int ply = 0;
     int half_move_clock = 0;
@@ -236,18 +240,17 @@ static bool play_game(int game_num, NNUENetwork* nnue_network) {
     bool tb_adjudicated = false;     // Game ended by an exact tablebase result
     
     // Reset position history and training data for this game
-    reset_position_history();
-    clear_tt();
-    training_data_count = 0;  // Just reset count, keep path from set_training_data_path
-    enable_training(true);    // Make sure training is enabled
+    reset_position_history(&w->history);
+    clear_tt();  // this worker's slice
+    w->data.count = 0;
     
     if (config.verbose >= 1) {
         printf("Game %d/%d starting...\n", game_num, config.num_games);
     }
     
-    while (result == GAME_ONGOING && ply < config.max_game_moves && !should_stop) {
+    while (result == GAME_ONGOING && ply < config.max_game_moves && !atomic_load(&should_stop)) {
         // Record position for repetition detection
-        record_position(board.zobristKey);
+        record_position(&w->history, board.zobristKey);
         
         // Generate legal moves
         generateLegalMoves(&board, &moves);
@@ -259,9 +262,9 @@ static bool play_game(int game_num, NNUENetwork* nnue_network) {
         
         // Random opening moves
         if (ply < config.random_moves) {
-            int roll = rand() % 100;
+            int roll = (int)(worker_rand(w) % 100);
             if (roll < config.random_probability) {
-                int idx = rand() % moves.count;
+                int idx = (int)(worker_rand(w) % (uint32_t)moves.count);
                 best_move = moves.moves[idx];
                 is_random_move = true;
                 
@@ -279,75 +282,37 @@ static bool play_game(int game_num, NNUENetwork* nnue_network) {
             // Once the position is within the tablebases the exact outcome is
             // known: end the game immediately and use the TB WDL as the game
             // result. The TB position itself is NOT recorded as training data.
-            Move tb_move = 0;
             int tb_wdl = 0, tb_dtz = 0;
-            if (syzygy_max_pieces() > 0 && board.castlingRights == NO_CASTLING &&
-                !isKingAttacked(&board, !board.whiteToMove)) {
-                Bitboard tb_occ =
-                    board.byTypeBB[WHITE][PAWN]   | board.byTypeBB[BLACK][PAWN]   |
-                    board.byTypeBB[WHITE][KNIGHT] | board.byTypeBB[BLACK][KNIGHT] |
-                    board.byTypeBB[WHITE][BISHOP] | board.byTypeBB[BLACK][BISHOP] |
-                    board.byTypeBB[WHITE][ROOK]   | board.byTypeBB[BLACK][ROOK]   |
-                    board.byTypeBB[WHITE][QUEEN]  | board.byTypeBB[BLACK][QUEEN]  |
-                    board.byTypeBB[WHITE][KING]   | board.byTypeBB[BLACK][KING];
-                int tb_pieces = POPCOUNT(tb_occ);
-                if (tb_pieces <= config.syzygy_probe_limit &&
-                    syzygy_available(tb_pieces) &&
-                    syzygy_probe_play(&board, &tb_move, &tb_wdl, &tb_dtz) == 1) {
-                    int white_wdl = board.whiteToMove ? tb_wdl : -tb_wdl;
-                    result = white_wdl > 0 ? GAME_WHITE_WINS
-                           : white_wdl < 0 ? GAME_BLACK_WINS : GAME_DRAW;
-                    tb_adjudicated = true;
-                    if (config.verbose >= 2) {
-                        printf("  Ply %d: TB adjudication (wdl %d, dtz %d)\n",
-                               ply, tb_wdl, tb_dtz);
-                    }
-                    break;
+            if (game_tb_adjudicate(&board, config.syzygy_probe_limit, &result, &tb_wdl, &tb_dtz)) {
+                tb_adjudicated = true;
+                if (config.verbose >= 2) {
+                    printf("  Ply %d: TB adjudication (wdl %d, dtz %d)\n",
+                           ply, tb_wdl, tb_dtz);
                 }
+                break;
             }
 
-            SearchInfo search_info;
-            search_info.startTimeMs = search_current_time_ms();
-            search_params_init(&search_info.params);  // Initialize search parameters
+            search_params_init(&search->params);  // Initialize search parameters
             // Tablebases are not probed inside the search during training
             // data generation (adjudication above handles TB positions).
-            search_info.tbProbeLimit = 0;
-            search_info.tbHits = 0;
-            search_info.tbRootMoveCount = 0;
-            search_info.tbRootScore = 0;
-            search_info.tbRootMatePlies = -1;
-            search_info.tbRootPvLen = 0;
+            search_info_prepare(search, NULL);
             
             if (config.search_nodes > 0) {
                 // Node-based search: no time or depth limit
-                search_info.softTimeLimit = 0;
-                search_info.hardTimeLimit = 0;
-                search_info.depthLimit = 0;
-                search_info.nodeLimit = config.search_nodes;
+                search->nodeLimit = config.search_nodes;
             } else if (config.search_time_ms > 0) {
-                search_info.softTimeLimit = config.search_time_ms;
-                search_info.hardTimeLimit = config.search_time_ms;
-                search_info.depthLimit = 0;
-                search_info.nodeLimit = 0;
+                search->softTimeLimit = config.search_time_ms;
+                search->hardTimeLimit = config.search_time_ms;
             } else {
-                search_info.softTimeLimit = 0;
-                search_info.hardTimeLimit = 0;
-                search_info.depthLimit = config.search_depth;
-                search_info.nodeLimit = 0;
+                search->depthLimit = config.search_depth;
             }
             
-            search_info.stopSearch = false;
-            search_info.lastIterationTime = 0;
-            search_info.nnue_acc = &nnue_accumulator;
-            search_info.nnue_net = nnue_network;
-            search_info.nodesSearched = 0;
-            search_info.bestMoveThisIteration = 0;
-            search_info.bestScoreThisIteration = 0;
-            search_info.seldepth = 0;
-            clear_search_history(&search_info);
+            search->nnue_acc = &nnue_accumulator;
+            search->nnue_net = nnue_network;
+            clear_search_history(search);
             
-            best_move = iterative_deepening_search(&board, &search_info);
-            best_score = search_info.bestScoreThisIteration;
+            best_move = iterative_deepening_search(&board, search);
+            best_score = search->bestScoreThisIteration;
             
             if (config.verbose >= 2) {
                 char move_str[6];
@@ -393,13 +358,13 @@ static bool play_game(int game_num, NNUENetwork* nnue_network) {
             bool should_record = (ply >= config.random_moves);
             if (should_record && config.filter_tactics) {
                 // Check if side to move is in check
-                bool in_check = isKingAttacked(&board, board.whiteToMove);
+                bool in_check = board.checkers != 0;
                 // Check if best move is a capture
                 bool is_capture_move = MOVE_IS_CAPTURE(best_move);
                 
                 if (in_check || is_capture_move) {
                     should_record = false;
-                    filtered_positions++;
+                    atomic_fetch_add(&filtered_positions, 1);
                     if (config.verbose >= 2) {
                         printf("  Ply %d: filtered (%s)\n", ply, 
                                in_check ? "in check" : "capture move");
@@ -409,7 +374,7 @@ static bool play_game(int game_num, NNUENetwork* nnue_network) {
             
             // Record training data (only for non-random, non-tactical moves)
             if (should_record) {
-                add_training_entry(&board, best_score, ply);
+                training_game_add(&w->data, &board, best_score, ply);
             }
         }
         
@@ -430,7 +395,7 @@ static bool play_game(int game_num, NNUENetwork* nnue_network) {
         }
         
         // Apply the move
-        applyMove(&board, best_move, &undo_info, &nnue_accumulator, nnue_network);
+        applyMove(&board, best_move, &w->game_states[ply % MAX_GAME_STATES], &nnue_accumulator, nnue_network);
         ply++;
         
         // Update half-move clock
@@ -441,7 +406,7 @@ static bool play_game(int game_num, NNUENetwork* nnue_network) {
         }
         
         // Check for game end
-        result = check_game_result(&board, half_move_clock, &moves);
+        result = check_game_result(&board, half_move_clock, config.draw_threshold, &moves, &w->history);
     }
     
     // Determine final result
@@ -465,20 +430,48 @@ static bool play_game(int game_num, NNUENetwork* nnue_network) {
                    : result_value < 0 ? "black wins (TB)" : "draw (TB)";
     }
 
-    // Write training data
-    int entries_written = training_data_count;
-    total_positions += entries_written;
-    write_training_data(result_value);
+    // Hand the game to the writer thread
+    int entries_written = w->data.count;
+    if (entries_written > 0) {
+        size_t length = 0;
+        char* text = training_game_encode(&w->data, result_value, &length);
+        if (text) {
+            queue_game(text, length);
+        } else {
+            fprintf(stderr, "Error: Out of memory encoding game %d\n", game_num);
+            entries_written = 0;
+        }
+    }
+    atomic_fetch_add(&total_positions, entries_written);
     
     if (config.verbose >= 1) {
         printf("Game %d finished: %s after %d plies (%d training entries)\n", 
                game_num, result_str, ply, entries_written);
     }
     
-    games_completed++;
+    atomic_fetch_add(&games_completed, 1);
     return true;  // Game was valid
 }
 
+static atomic_int next_game = 1;       // next game number to hand out
+static atomic_int workers_running = 0;
+
+static void* worker_main(void* arg) {
+    Worker* w = (Worker*)arg;
+    tt_use_slice(w->id, config.threads);
+
+    while (!atomic_load(&should_stop)) {
+        int game = atomic_fetch_add(&next_game, 1);
+        if (game > config.num_games) break;
+        // A discarded game is replayed under the same number
+        while (!play_game(w, game) && !atomic_load(&should_stop)) {
+            atomic_fetch_add(&games_discarded, 1);
+        }
+    }
+    atomic_fetch_sub(&workers_running, 1);
+    return NULL;
+}
+
 // =============================================================================
 // Usage and Argument Parsing
 // =============================================================================
@@ -487,6 +480,8 @@ static void print_usage(const char* program_name) {
     printf("Usage: %s [options]\n", program_name);
     printf("\nOptions:\n");
     printf("  -o, --output FILE       Output file for training data (default: training_data.txt)\n");
+    printf("  -F, --format FMT        text (fen | eval | wdl lines) or bullet (packed .data records) (default: text)\n");
+    printf("  -z, --zstd LEVEL        zstd-compress the output at LEVEL (needs a ZSTD=1 build, default: 0=off)\n");
     printf("  -n, --num-games N       Number of games to play (default: 100)\n");
     printf("  -r, --random-moves N    Number of random moves at start (default: 12)\n");
     printf("  -p, --random-prob N     Probability (0-100) for random moves (default: 100)\n");
@@ -501,15 +496,22 @@ static void print_usage(const char* program_name) {
     printf("  -v, --verbose LEVEL     Verbosity level 0-2 (default: 1)\n");
     printf("  -S, --syzygy-path PATH  Syzygy tablebase path for exact endgame adjudication (default: off)\n");
     printf("  -L, --syzygy-probe-limit N  Max piece count for TB adjudication (default: 7)\n");
+    printf("  -T, --threads N         Self-play worker threads, one game each (default: 1)\n");
     printf("  -h, --help              Show this help message\n");
+    printf("\nRescoring (replaces the eval of existing data, -o is written as is):\n");
+    printf("  -R, --rescore FILE      Rescore FILE (- = stdin) in the -F format with a -d/-N search on -T threads\n");
+    printf("  --static                Rescore with the static NNUE eval instead of a search\n");
     printf("\nExample:\n");
     printf("  %s -o data.txt -n 1000 -r 8 -d 6 -e 4 -a 10 -f 1\n", program_name);
     printf("  %s -o data.txt -n 1000 -r 8 -N 10000 -e 4 -a 10 -f 1  # Node-based search\n", program_name);
+    printf("  %s -R old.data -F bullet -o new.data -N 5000 -T 8  # Relabel with a new net\n", program_name);
 }
 
 static void parse_arguments(int argc, char* argv[]) {
     static struct option long_options[] = {
         {"output",         required_argument, 0, 'o'},
+        {"format",         required_argument, 0, 'F'},
+        {"zstd",           required_argument, 0, 'z'},
         {"num-games",      required_argument, 0, 'n'},
         {"random-moves",   required_argument, 0, 'r'},
         {"random-prob",    required_argument, 0, 'p'},
@@ -524,16 +526,33 @@ static void parse_arguments(int argc, char* argv[]) {
         {"verbose",        required_argument, 0, 'v'},
         {"syzygy-path",        required_argument, 0, 'S'},
         {"syzygy-probe-limit", required_argument, 0, 'L'},
+        {"threads",        required_argument, 0, 'T'},
+        {"rescore",        required_argument, 0, 'R'},
+        {"static",         no_argument,       0, 's'},
         {"help",           no_argument,       0, 'h'},
         {0, 0, 0, 0}
     };
 
     int c;
-    while ((c = getopt_long(argc, argv, "o:n:r:p:d:t:N:e:a:f:v:S:L:h", long_options, NULL)) != -1) {
+    while ((c = getopt_long(argc, argv, "o:F:z:n:r:p:d:t:N:e:a:f:v:S:L:T:R:h", long_options, NULL)) != -1) {
         switch (c) {
             case 'o':
                 strncpy(config.output_file, optarg, sizeof(config.output_file) - 1);
                 break;
+            case 'F':
+                if (strcmp(optarg, "text") == 0) {
+                    config.format = TRAINING_FORMAT_TEXT;
+                } else if (strcmp(optarg, "bullet") == 0) {
+                    config.format = TRAINING_FORMAT_BULLET;
+                } else {
+                    fprintf(stderr, "Unknown output format: %s\n", optarg);
+                    print_usage(argv[0]);
+                    exit(1);
+                }
+                break;
+            case 'z':
+                config.zstd_level = atoi(optarg);
+                break;
             case 'n':
                 config.num_games = atoi(optarg);
                 break;
@@ -579,6 +598,18 @@ static void parse_arguments(int argc, char* argv[]) {
             case 'L':
                 config.syzygy_probe_limit = atoi(optarg);
                 break;
+            case 'T':
+                config.threads = atoi(optarg);
+                if (config.threads < 1) config.threads = 1;
+                if (config.threads > MAX_TRAINING_THREADS) config.threads = MAX_TRAINING_THREADS;
+                break;
+            case 'R':
+                strncpy(config.rescore_input, optarg, sizeof(config.rescore_input) - 1);
+                config.rescore_input[sizeof(config.rescore_input) - 1] = '\0';
+                break;
+            case 's':
+                config.rescore_static = true;
+                break;
             case 'h':
                 print_usage(argv[0]);
                 exit(0);
@@ -603,12 +634,12 @@ int main(int argc, char* argv[]) {
     
     // Initialize engine components
     init_zobrist_keys();
-    init_tt(256);  // 256 MB transposition table
+    init_tt(256);  // 256 MB transposition table, one slice per worker
     initMoveGenerator();
     
-    // Initialize random seed AFTER initMoveGenerator (which also calls srand)
+    // Random seed for the workers' RNGs
     // Using multiplication ensures different PIDs give very different seeds
-    srand((unsigned int)(time(NULL) * getpid()));
+    uint64_t seed = (uint64_t)time(NULL) * (uint64_t)getpid();
     
     // Disable search output for training (no "info depth" and "DEBUG" spam)
     set_search_silent(true);
@@ -619,22 +650,53 @@ int main(int argc, char* argv[]) {
         fprintf(stderr, "Error: Failed to allocate memory for NNUE network\n");
         return 1;
     }
-    eval_init("quantised.bin", nnue_network);
+    eval_init(NNUE_DEFAULT_NET, nnue_network);
     
     if (!nnue_network->loaded) {
         printf("Warning: NNUE network not loaded, using classical evaluation\n");
     }
     
+    if (config.rescore_input[0]) {
+        if (strcmp(config.rescore_input, config.output_file) == 0) {
+            fprintf(stderr, "Error: Rescoring needs an output file other than the input\n");
+            return 1;
+        }
+        RescoreConfig rescore = {
+            .input = config.rescore_input,
+            .output = config.output_file,
+            .format = config.format,
+            .zstd_level = config.zstd_level,
+            .static_eval = config.rescore_static,
+            .depth = config.search_depth,
+            .nodes = config.search_nodes,
+            .threads = config.threads,
+            .verbose = config.verbose,
+        };
+        bool ok = rescore_run(&rescore, nnue_network);
+        nnue_unload(nnue_network);
+        free(nnue_network);
+        return ok ? 0 : 1;
+    }
+
     // Initialize Syzygy tablebases (no-op if path is empty)
     syzygy_init(config.syzygy_path);
 
     // Set up training data output
-    set_training_data_path(config.output_file);
+    // Append PID to filename for unique files in parallel runs
+    char output_path[512];
+    snprintf(output_path, sizeof(output_path), "%s.%lld", config.output_file, (long long)getpid());
+    if (!training_output_open(output_path, config.format, config.zstd_level)) {
+        fprintf(stderr, "Error: Cannot open output file %s\n", output_path);
+        return 1;
+    }
     
     // Print configuration
     printf("=== Training Data Generator ===\n");
     printf("Output file:       %s\n", config.output_file);
+    printf("Output format:     %s%s\n", config.format == TRAINING_FORMAT_BULLET ? "bullet" : "text",
+           config.zstd_level > 0 ? " (zstd)" : "");
     printf("Number of games:   %d\n", config.num_games);
+    printf("Threads:           %d\n", config.threads);
     printf("Random moves:      %d\n", config.random_moves);
     printf("Random probability: %d%%\n", config.random_probability);
     if (config.search_nodes > 0) {
@@ -669,21 +731,64 @@ int main(int argc, char* argv[]) {
     start_time = time(NULL);
     last_status_time = start_time;
     
-    // Play games
-    int game = 1;
-    while (game <= config.num_games && !should_stop) {
-        bool valid = play_game(game, nnue_network);
-        if (valid) {
-            game++;  // Only advance to next game if this one was valid
-        } else {
-            games_discarded++;
+    // Workers, 64-byte aligned for the NNUE accumulators in SearchInfo
+    Worker* workers[MAX_TRAINING_THREADS];
+    int worker_count = 0;
+    for (int i = 0; i < config.threads; i++) {
+        void* mem = NULL;
+        if (posix_memalign(&mem, 64, sizeof(Worker)) != 0) {
+            fprintf(stderr, "Failed to allocate worker %d\n", i);
+            break;
+        }
+        memset(mem, 0, sizeof(Worker));
+        Worker* w = (Worker*)mem;
+        w->id = i;
+        w->nnue_network = nnue_network;
+        w->rng = (seed ^ ((uint64_t)(i + 1) * 0x9E3779B97F4A7C15ULL)) | 1;  // never 0
+        search_params_init(&w->search_info.params);  // builds the shared LMR table before any thread runs
+        workers[worker_count++] = w;
+    }
+    if (worker_count == 0) return 1;
+    config.threads = worker_count;  // slice count
+
+    pthread_t writer;
+    if (pthread_create(&writer, NULL, writer_main, NULL) != 0) {
+        fprintf(stderr, "Error: Failed to start writer thread\n");
+        return 1;
+    }
+
+    // Worker threads search, so they get the search thread stack size
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, SEARCH_THREAD_STACK_SIZE);
+    // Counted before each start (a worker may finish before pthread_create
+    // returns), taken back if the thread doesn't start
+    int started = 0;
+    for (int i = 0; i < worker_count; i++) {
+        atomic_fetch_add(&workers_running, 1);
+        if (pthread_create(&workers[i]->thread, &attr, worker_main, workers[i]) != 0) {
+            atomic_fetch_sub(&workers_running, 1);
+            fprintf(stderr, "Failed to start worker %d\n", i);
+            break;
         }
+        started++;
+    }
+    pthread_attr_destroy(&attr);
+
+    // Play games (the workers do; this thread only reports)
+    while (atomic_load(&workers_running) > 0) {
+        struct timespec pause = {0, 100000000}; // 100 ms
+        nanosleep(&pause, NULL);
         check_status_output();
     }
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i]->thread, NULL);
+    }
+    close_queue();
+    pthread_join(writer, NULL);
 
-    if (should_stop) {
+    if (atomic_load(&should_stop)) {
         printf("\nReceived signal, shut down after finishing current game.\n");
-        flush_training_data();
     }
 
     // Final statistics
@@ -692,19 +797,23 @@ int main(int argc, char* argv[]) {
     
     // Summary
     printf("\n=== Summary ===\n");
-    printf("Games completed: %d/%d\n", games_completed, config.num_games);
-    printf("Games discarded: %d\n", games_discarded);
-    printf("Total positions: %d\n", total_positions);
-    printf("Filtered (tactics): %d\n", filtered_positions);
+    printf("Games completed: %d/%d\n", atomic_load(&games_completed), config.num_games);
+    printf("Games discarded: %d\n", atomic_load(&games_discarded));
+    printf("Total positions: %d\n", atomic_load(&total_positions));
+    printf("Filtered (tactics): %d\n", atomic_load(&filtered_positions));
     if (total_elapsed > 0) {
         printf("Total time:      %.1f seconds\n", total_elapsed);
-        printf("Avg pos/sec:     %.1f\n", total_positions / total_elapsed);
+        printf("Avg pos/sec:     %.1f\n", atomic_load(&total_positions) / total_elapsed);
     }
     printf("Training data written to: %s.*\n", config.output_file);
     
     // Cleanup
-    init_training_data();  // Closes training file properly
+    for (int i = 0; i < worker_count; i++) {
+        free(workers[i]);
+    }
+    training_output_close();
     syzygy_free();
+    nnue_unload(nnue_network);
     free(nnue_network);
 
     return 0;
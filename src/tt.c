@@ -1,10 +1,21 @@
-// posix_memalign needs POSIX visibility under glibc's strict -std=c11 mode
-#define _POSIX_C_SOURCE 200112L
+// posix_memalign, mmap flags (MAP_HUGETLB, MADV_HUGEPAGE) and CPU affinity
+// need GNU visibility under glibc's strict -std=c11 mode
+#define _GNU_SOURCE
 
 #include "tt.h"
 #include <stdlib.h>
 #include <string.h> // For memset
 #include <stdio.h>  // For info string output
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
 
 // =============================================================================
 // Bucketed transposition table with generation-based aging
@@ -15,6 +26,19 @@
 // entries from the current search survive while stale ones get recycled.
 // Indexing uses the high 64 bits of key * cluster_count, which allows
 // arbitrary (non power-of-two) table sizes; the low 16 key bits verify hits.
+//
+// Thread safety: all Lazy SMP search threads - and, with a shared segment
+// (tt_set_shared), other engine processes - share the table without locks.
+// Entries are read and written field by field, so a probe racing a store can
+// see a torn entry. To keep that from producing a false hit, the stored key16
+// is XORed with the other fields (entry_check); a torn entry fails the key
+// comparison unless its fields happen to cancel, which is as likely as the
+// 16-bit key collisions we already accept. Those remain harmless: the move is
+// only played after moveIsPseudoLegal() validated it, and a wrong score or
+// bound costs search quality in one node, never correctness. init_tt(),
+// clear_tt() and tt_new_search() must only be called while no search of this
+// process is running - except by a thread working in a slice of its own
+// (tt_use_slice), for which they only touch that slice.
 // =============================================================================
 
 // Depth is stored in a uint8 with an offset so that qsearch depths (<= 0)
@@ -47,81 +71,582 @@ typedef struct {
 _Static_assert(sizeof(TTEntry) == 12, "TTEntry must be 12 bytes");
 _Static_assert(sizeof(TTCluster) == 64, "TTCluster must be 64 bytes");
 
-static TTCluster* table = NULL;
-static uint64_t cluster_count = 0;
-static uint8_t generation8 = 0;  // current generation, pre-shifted by TT_GENERATION_BITS
+// A range of clusters with its own generation. `whole` is the entire table;
+// a thread that called tt_use_slice() probes and stores in its private part
+// of it instead (self-play workers playing independent games).
+typedef struct {
+    TTCluster* clusters;
+    uint64_t count;
+    uint8_t  generation8;  // current generation, pre-shifted by TT_GENERATION_BITS
+} TTView;
+
+static TTView whole = {NULL, 0, 0};
+static _Thread_local TTView own_slice;
+static _Thread_local TTView* view = &whole;  // what this thread's probes/stores use
+static _Thread_local uint8_t* slice_generation_home = NULL;  // tt_switch_slice() keeps own_slice's generation here
+static _Thread_local int slice_index = 0, slice_count = 1;     // last tt_use_slice() layout of this thread
+
+static size_t table_mem_size = 0;     // bytes actually reserved (rounded up to huge pages)
+static bool table_mmapped = false;    // free with munmap instead of free
+static const char* table_pages = "";  // what backs the table, for the info string
+static size_t table_megabytes = 0;    // size requested by the last init_tt()
 
 // Age of an entry relative to the current search, in multiples of
 // TT_GENERATION_DELTA. The cycle constant keeps the subtraction correct
 // across uint8 wraparound.
 static inline int relative_age(uint8_t gen_bound) {
-    return (TT_GENERATION_CYCLE + generation8 - gen_bound) & TT_GENERATION_MASK;
+    return (TT_GENERATION_CYCLE + view->generation8 - gen_bound) & TT_GENERATION_MASK;
 }
 
 static inline TTCluster* cluster_for(uint64_t key) {
-    return &table[(uint64_t)(((unsigned __int128)key * cluster_count) >> 64)];
+    return &view->clusters[(uint64_t)(((unsigned __int128)key * view->count) >> 64)];
 }
 
 static inline Move entry_move(const TTEntry* e) {
     return ((Move)e->move_hi << 16) | e->move_lo;
 }
 
+// XOR of the data fields folded into key16. The generation bits are left out
+// because probes refresh them in place.
+static inline uint16_t entry_check(const TTEntry* e) {
+    return (uint16_t)(e->move_lo ^ e->move_hi ^ (uint16_t)e->score16 ^ (uint16_t)e->eval16 ^
+                      (e->depth8 | (uint16_t)(e->genBound8 & (TT_GENERATION_DELTA - 1)) << 8));
+}
+
+static inline uint16_t entry_key(const TTEntry* e) {
+    return e->key16 ^ entry_check(e);
+}
+
+// =============================================================================
+// Allocation: huge pages and NUMA placement
+//
+// With multi-GB tables nearly every probe is a TLB miss on 4 KB pages, so the
+// table is backed by huge pages where possible: explicit hugetlbfs pages
+// (MAP_HUGETLB, only if the admin reserved them via vm.nr_hugepages), else a
+// 2 MB aligned anonymous mapping with madvise(MADV_HUGEPAGE) for transparent
+// huge pages, else plain posix_memalign (non-Linux).
+//
+// Physical pages are placed on the NUMA node of the thread that first touches
+// them. clear_tt() therefore runs one thread per online CPU, pins thread i to
+// node i % nodes and hands out 2 MB stripes round-robin, so the first clear
+// after init_tt() interleaves the table across all nodes instead of putting
+// it on the node of the UCI thread. Later clears just run in parallel.
+// =============================================================================
+
+#define TT_HUGE_PAGE_SIZE       ((size_t)2 * 1024 * 1024)
+#define TT_CLEAR_STRIPE         TT_HUGE_PAGE_SIZE
+#define TT_MAX_CLEAR_THREADS    64
+#define TT_MAX_NUMA_NODES       16
+
+#ifdef __linux__
+static int numa_node_count = -1;  // -1 = not probed yet
+static cpu_set_t numa_node_cpus[TT_MAX_NUMA_NODES];
+
+// CPU lists of the online NUMA nodes from sysfs ("0-15,32-47" style)
+static int numa_nodes(void) {
+    if (numa_node_count >= 0) return numa_node_count;
+    numa_node_count = 0;
+    for (int node = 0; node < TT_MAX_NUMA_NODES; node++) {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        FILE* file = fopen(path, "r");
+        if (file == NULL) continue;
+
+        cpu_set_t* set = &numa_node_cpus[numa_node_count];
+        CPU_ZERO(set);
+        int first, last;
+        char sep;
+        while (fscanf(file, "%d", &first) == 1) {
+            last = first;
+            if (fscanf(file, "%c", &sep) == 1 && sep == '-') {
+                if (fscanf(file, "%d", &last) != 1) break;
+                if (fscanf(file, "%c", &sep) != 1) sep = '\n';
+            }
+            for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) CPU_SET(cpu, set);
+            if (sep != ',') break;
+        }
+        fclose(file);
+        if (CPU_COUNT(set) > 0) numa_node_count++;
+    }
+    return numa_node_count;
+}
+
+// AnonHugePages of the mapping starting at addr (transparent huge pages
+// actually obtained), from /proc/self/smaps
+static size_t thp_kb(const void* addr) {
+    FILE* file = fopen("/proc/self/smaps", "r");
+    if (file == NULL) return 0;
+    char line[256];
+    bool in_mapping = false;
+    size_t kb = 0;
+    while (fgets(line, sizeof(line), file)) {
+        unsigned long start, end;
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+            if (in_mapping) break;
+            in_mapping = start == (unsigned long)(uintptr_t)addr;
+        } else if (in_mapping && strncmp(line, "AnonHugePages:", 14) == 0) {
+            kb = strtoul(line + 14, NULL, 10);
+        }
+    }
+    fclose(file);
+    return kb;
+}
+#endif
+
+// Give back a private table block from tt_alloc()
+static void tt_release(void* mem, size_t mem_size, bool mmapped) {
+    if (mmapped) {
+        munmap(mem, mem_size);
+    } else {
+        free(mem);
+    }
+}
+
+static void* tt_alloc(size_t size) {
+    table_mmapped = false;
+    table_mem_size = size;
+#ifdef __linux__
+    size_t huge_size = (size + TT_HUGE_PAGE_SIZE - 1) & ~(TT_HUGE_PAGE_SIZE - 1);
+    void* mem;
+#ifdef MAP_HUGETLB
+    if (size >= TT_HUGE_PAGE_SIZE) {
+        mem = mmap(NULL, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (mem != MAP_FAILED) {
+            table_mmapped = true;
+            table_mem_size = huge_size;
+            table_pages = "explicit 2 MB huge pages";
+            return mem;
+        }
+    }
+#endif
+    // Over-map by one huge page and trim so the table starts 2 MB aligned,
+    // otherwise the kernel can't back the first and last part with THP
+    size_t map_size = huge_size + TT_HUGE_PAGE_SIZE;
+    mem = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem != MAP_FAILED) {
+        uintptr_t raw = (uintptr_t)mem;
+        uintptr_t aligned = (raw + TT_HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(TT_HUGE_PAGE_SIZE - 1);
+        size_t head = aligned - raw;
+        size_t tail = map_size - head - huge_size;
+        if (head) munmap(mem, head);
+        if (tail) munmap((void*)(aligned + huge_size), tail);
+#ifdef MADV_HUGEPAGE
+        madvise((void*)aligned, huge_size, MADV_HUGEPAGE);
+#endif
+        table_mmapped = true;
+        table_mem_size = huge_size;
+        table_pages = "transparent huge pages";
+        return (void*)aligned;
+    }
+#endif
+    void* mem_aligned = NULL;
+    if (posix_memalign(&mem_aligned, 64, size) != 0) return NULL;
+    table_pages = "regular pages";
+    return mem_aligned;
+}
+
+typedef struct {
+    int index;        // thread number, clears stripes index, index + count, ...
+    int count;
+    int node;         // NUMA node to run on, -1 = don't pin
+    size_t bytes;
+} TTClearJob;
+
+static void* tt_clear_worker(void* arg) {
+    const TTClearJob* job = (const TTClearJob*)arg;
+#ifdef __linux__
+    if (job->node >= 0) {
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &numa_node_cpus[job->node]);
+    }
+#endif
+    unsigned char* base = (unsigned char*)whole.clusters;
+    for (size_t offset = (size_t)job->index * TT_CLEAR_STRIPE; offset < job->bytes;
+         offset += (size_t)job->count * TT_CLEAR_STRIPE) {
+        size_t len = job->bytes - offset < TT_CLEAR_STRIPE ? job->bytes - offset : TT_CLEAR_STRIPE;
+        memset(base + offset, 0, len);
+    }
+    return NULL;
+}
+
+// Zero the table with one thread per CPU (capped, and no more than stripes).
+// Returns the number of threads used.
+static int tt_clear_parallel(size_t bytes) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t stripes = (bytes + TT_CLEAR_STRIPE - 1) / TT_CLEAR_STRIPE;
+    int count = cpus > 0 ? (int)cpus : 1;
+    if (count > TT_MAX_CLEAR_THREADS) count = TT_MAX_CLEAR_THREADS;
+    if ((size_t)count > stripes) count = (int)stripes;
+    if (count < 1) count = 1;
+
+    int nodes = 0;
+#ifdef __linux__
+    nodes = numa_nodes();
+#endif
+    TTClearJob jobs[TT_MAX_CLEAR_THREADS];
+    pthread_t threads[TT_MAX_CLEAR_THREADS];
+    bool started[TT_MAX_CLEAR_THREADS] = {false};
+    for (int i = 0; i < count; i++) {
+        jobs[i] = (TTClearJob){ i, count, nodes > 1 ? i % nodes : -1, bytes };
+    }
+    // Thread 0's share runs here; fall back to doing a share inline if a
+    // thread can't be started
+    for (int i = 1; i < count; i++) {
+        started[i] = pthread_create(&threads[i], NULL, tt_clear_worker, &jobs[i]) == 0;
+        if (!started[i]) tt_clear_worker(&jobs[i]);
+    }
+    if (nodes > 1) {
+        // Don't leave the UCI thread pinned: clear its share from a thread too
+        started[0] = pthread_create(&threads[0], NULL, tt_clear_worker, &jobs[0]) == 0;
+        if (!started[0]) {
+            jobs[0].node = -1;
+            tt_clear_worker(&jobs[0]);
+        }
+    } else {
+        tt_clear_worker(&jobs[0]);
+    }
+    for (int i = 0; i < count; i++) {
+        if (started[i]) pthread_join(threads[i], NULL);
+    }
+    return count;
+}
+
+// =============================================================================
+// Shared table: a named POSIX shared memory segment (shm_open + mmap) that
+// cooperating engine processes attach to, so workers analysing the same
+// positions reuse each other's entries. The segment starts with a 64 byte
+// header; the clusters follow. The first process creates and sizes it, later
+// ones adopt its size. The generation lives in the header so all processes
+// age entries on one timeline. clear_tt() leaves a shared table alone (other
+// processes are using it) and the segment outlives the processes; remove it
+// with rm /dev/shm/<name> on Linux.
+// =============================================================================
+
+#define TT_SHM_MAGIC 0x4853544D4D53ULL  // "SMMTSH"
+
+typedef struct {
+    uint64_t magic;          // written last by the creator
+    uint64_t cluster_count;
+    uint64_t zobrist_check;  // zobrist_side_to_move_key, processes must agree
+    uint32_t cluster_size;
+    uint8_t  generation8;    // shared generation, bumped atomically
+    uint8_t  reserved[35];
+} TTSharedHeader;
+
+_Static_assert(sizeof(TTSharedHeader) == 64, "TTSharedHeader must be 64 bytes");
+
+static char shared_name[256] = "";        // empty = private table
+static TTSharedHeader* shared_header = NULL;
+
+static bool tt_attach_shared(size_t table_size_mb) {
+    uint64_t clusters = (table_size_mb * 1024 * 1024) / sizeof(TTCluster);
+    if (clusters == 0) clusters = 1;
+
+    bool created = true;
+    int fd = shm_open(shared_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        created = false;
+        fd = shm_open(shared_name, O_RDWR, 0600);
+    }
+    if (fd < 0) {
+        fprintf(stderr, "info string Cannot open shared TT %s: %s\n", shared_name, strerror(errno));
+        return false;
+    }
+
+    size_t size = sizeof(TTSharedHeader) + clusters * sizeof(TTCluster);
+    if (created) {
+        if (ftruncate(fd, (off_t)size) != 0) {
+            fprintf(stderr, "info string Cannot size shared TT %s: %s\n", shared_name, strerror(errno));
+            close(fd);
+            shm_unlink(shared_name);
+            return false;
+        }
+    } else {
+        // Wait briefly for a concurrent creator to size it
+        struct stat st;
+        for (int tries = 0; tries < 100 && fstat(fd, &st) == 0 && st.st_size == 0; tries++) usleep(10000);
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size <= sizeof(TTSharedHeader)) {
+            fprintf(stderr, "info string Shared TT %s is not initialised\n", shared_name);
+            close(fd);
+            return false;
+        }
+        size = (size_t)st.st_size;
+    }
+
+    void* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        fprintf(stderr, "info string Cannot map shared TT %s: %s\n", shared_name, strerror(errno));
+        if (created) shm_unlink(shared_name);
+        return false;
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(mem, size, MADV_HUGEPAGE);  // only effective with shmem_enabled=advise
+#endif
+
+    TTSharedHeader* header = (TTSharedHeader*)mem;
+    if (created) {
+        header->cluster_count = clusters;
+        header->zobrist_check = zobrist_side_to_move_key;
+        header->cluster_size = sizeof(TTCluster);
+        __atomic_store_n(&header->magic, TT_SHM_MAGIC, __ATOMIC_RELEASE);
+    } else {
+        for (int tries = 0; tries < 100 && __atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != TT_SHM_MAGIC;
+             tries++) {
+            usleep(10000);
+        }
+        if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != TT_SHM_MAGIC ||
+            header->cluster_size != sizeof(TTCluster) ||
+            header->zobrist_check != zobrist_side_to_move_key ||
+            sizeof(TTSharedHeader) + header->cluster_count * sizeof(TTCluster) > size) {
+            fprintf(stderr, "info string Shared TT %s belongs to a different engine version\n", shared_name);
+            munmap(mem, size);
+            return false;
+        }
+    }
+
+    shared_header = header;
+    whole.clusters = (TTCluster*)(header + 1);
+    whole.count = header->cluster_count;
+    table_mem_size = size;
+    table_mmapped = true;
+    whole.generation8 = __atomic_load_n(&header->generation8, __ATOMIC_RELAXED);
+    printf("info string TT %s shared segment %s with %llu entries (%.2f MB)\n",
+           created ? "created" : "attached to", shared_name,
+           (unsigned long long)(whole.count * TT_CLUSTER_SIZE),
+           (double)(whole.count * sizeof(TTCluster)) / (1024 * 1024));
+    return true;
+}
+
+void tt_set_shared(const char* name) {
+    if (name == NULL || name[0] == '\0' || strcmp(name, "<empty>") == 0) {
+        shared_name[0] = '\0';
+    } else {
+        // POSIX wants a single leading slash
+        snprintf(shared_name, sizeof(shared_name), "%s%s", name[0] == '/' ? "" : "/", name);
+    }
+    init_tt(table_megabytes);
+}
+
+size_t tt_size_mb(void) {
+    return table_megabytes;
+}
+
 void init_tt(size_t table_size_mb) {
-    if (table != NULL) {
+    if (whole.clusters != NULL) {
         free_tt();
     }
+    table_megabytes = table_size_mb;
     if (table_size_mb == 0) {
         printf("info string TT disabled (0 MB)\n");
         return;
     }
-    cluster_count = (table_size_mb * 1024 * 1024) / sizeof(TTCluster);
-    if (cluster_count == 0) {
-        cluster_count = 1;
+    if (shared_name[0] != '\0') {
+        if (tt_attach_shared(table_size_mb)) return;
+        printf("info string Falling back to a private TT\n");
+    }
+    whole.count = (table_size_mb * 1024 * 1024) / sizeof(TTCluster);
+    if (whole.count == 0) {
+        whole.count = 1;
     }
-    void* mem = NULL;
-    if (posix_memalign(&mem, 64, cluster_count * sizeof(TTCluster)) != 0) {
+    void* mem = tt_alloc(whole.count * sizeof(TTCluster));
+    if (mem == NULL) {
         fprintf(stderr, "Failed to allocate transposition table!\n");
-        cluster_count = 0;
+        whole.count = 0;
         return;
     }
-    table = (TTCluster*)mem;
-    clear_tt();
+    whole.clusters = (TTCluster*)mem;
+    int threads = tt_clear_parallel(whole.count * sizeof(TTCluster));  // first touch places the pages
+    whole.generation8 = 0;
     printf("info string TT initialized with %llu entries (%.2f MB)\n",
-           (unsigned long long)(cluster_count * TT_CLUSTER_SIZE),
-           (double)(cluster_count * sizeof(TTCluster)) / (1024 * 1024));
+           (unsigned long long)(whole.count * TT_CLUSTER_SIZE),
+           (double)(whole.count * sizeof(TTCluster)) / (1024 * 1024));
+
+    char pages[96];
+    snprintf(pages, sizeof(pages), "%s", table_pages);
+    int nodes = 1;
+#ifdef __linux__
+    if (strcmp(table_pages, "transparent huge pages") == 0) {
+        snprintf(pages, sizeof(pages), "transparent huge pages (%zu of %zu MB obtained)",
+                 thp_kb(whole.clusters) / 1024, table_mem_size / (1024 * 1024));
+    }
+    if (numa_nodes() > 1) nodes = numa_nodes();
+#endif
+    if (nodes > 1) {
+        printf("info string TT memory: %s, cleared by %d thread%s, interleaved across %d NUMA nodes\n",
+               pages, threads, threads == 1 ? "" : "s", nodes);
+    } else {
+        printf("info string TT memory: %s, cleared by %d thread%s\n", pages, threads, threads == 1 ? "" : "s");
+    }
 }
 
 void clear_tt() {
-    if (table != NULL && cluster_count > 0) {
-        memset(table, 0, cluster_count * sizeof(TTCluster));
+    if (view != &whole) {
+        // Only this thread's slice; the other workers keep searching
+        memset(view->clusters, 0, view->count * sizeof(TTCluster));
+        view->generation8 = 0;
+        return;
     }
-    generation8 = 0;
+    if (shared_header != NULL) return;  // other processes rely on the contents
+    if (whole.clusters != NULL && whole.count > 0) {
+        tt_clear_parallel(whole.count * sizeof(TTCluster));
+    }
+    whole.generation8 = 0;
+}
+
+// =============================================================================
+// Hash file: the raw cluster array behind a 64 byte header, so a long analysis
+// can continue after a restart. The header records everything cluster_for()
+// and relative_age() depend on (cluster count, generation) plus the zobrist
+// side key, since a table written with different keys would be garbage.
+// =============================================================================
+
+#define TT_FILE_MAGIC   "SMTTHASH"
+#define TT_FILE_VERSION 1
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t cluster_size;   // sizeof(TTCluster)
+    uint64_t cluster_count;
+    uint64_t zobrist_check;  // zobrist_side_to_move_key of the writer
+    uint8_t  generation8;
+    uint8_t  reserved[31];
+} TTFileHeader;
+
+_Static_assert(sizeof(TTFileHeader) == 64, "TTFileHeader must be 64 bytes");
+
+bool tt_save(const char* filename) {
+    if (whole.clusters == NULL || whole.count == 0) {
+        fprintf(stderr, "info string No transposition table to save\n");
+        return false;
+    }
+    FILE* file = fopen(filename, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "info string Cannot open hash file %s for writing\n", filename);
+        return false;
+    }
+    TTFileHeader header = {0};
+    memcpy(header.magic, TT_FILE_MAGIC, sizeof(header.magic));
+    header.version = TT_FILE_VERSION;
+    header.cluster_size = sizeof(TTCluster);
+    header.cluster_count = whole.count;
+    header.zobrist_check = zobrist_side_to_move_key;
+    header.generation8 = whole.generation8;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(whole.clusters, sizeof(TTCluster), whole.count, file) == whole.count;
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) fprintf(stderr, "info string Failed to write hash file %s\n", filename);
+    return ok;
+}
+
+// The clusters are read into a table allocated like init_tt() does (huge
+// pages, first touch spread over the NUMA nodes) rather than mmapping the
+// file as the table, which would give up both. The table takes the size
+// recorded in the file.
+bool tt_load(const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "info string Cannot open hash file %s\n", filename);
+        return false;
+    }
+    TTFileHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, TT_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != TT_FILE_VERSION || header.cluster_size != sizeof(TTCluster) ||
+        header.cluster_count == 0) {
+        fprintf(stderr, "info string %s is not a hash file of this engine version\n", filename);
+        fclose(file);
+        return false;
+    }
+    if (header.zobrist_check != zobrist_side_to_move_key) {
+        fprintf(stderr, "info string %s was written with different zobrist keys\n", filename);
+        fclose(file);
+        return false;
+    }
+
+    if (header.cluster_count != whole.count && shared_header != NULL) {
+        fprintf(stderr, "info string %s doesn't match the size of the shared TT\n", filename);
+        fclose(file);
+        return false;
+    }
+    if (header.cluster_count != whole.count) {
+        // Allocate the new table before dropping the old one, so a failed
+        // allocation leaves the current TT in place
+        TTCluster* old_clusters = whole.clusters;
+        size_t old_mem_size = table_mem_size;
+        bool old_mmapped = table_mmapped;
+        const char* old_pages = table_pages;
+        void* mem = tt_alloc(header.cluster_count * sizeof(TTCluster));
+        if (mem == NULL) {
+            table_mem_size = old_mem_size;
+            table_mmapped = old_mmapped;
+            table_pages = old_pages;
+            fprintf(stderr, "Failed to allocate transposition table!\n");
+            fclose(file);
+            return false;
+        }
+        if (old_clusters != NULL) tt_release(old_clusters, old_mem_size, old_mmapped);
+        whole.clusters = (TTCluster*)mem;
+        whole.count = header.cluster_count;
+        // Hash follows the loaded table (rounded up, so init_tt() from it
+        // gets at least as many clusters)
+        table_megabytes = (size_t)((whole.count * sizeof(TTCluster) + 1024 * 1024 - 1) / (1024 * 1024));
+        tt_clear_parallel(whole.count * sizeof(TTCluster));
+        if (view == &own_slice) {
+            uint8_t generation = own_slice.generation8;
+            uint8_t* home = slice_generation_home;
+            tt_use_slice(slice_index, slice_count);
+            if (view == &own_slice) own_slice.generation8 = generation;
+            slice_generation_home = home;
+        }
+    }
+
+    bool ok = fread(whole.clusters, sizeof(TTCluster), whole.count, file) == whole.count;
+    fclose(file);
+    if (!ok) {
+        // Don't keep a half-read table around
+        fprintf(stderr, "info string Hash file %s is truncated, table cleared\n", filename);
+        tt_clear_parallel(whole.count * sizeof(TTCluster));
+        return false;
+    }
+    whole.generation8 = header.generation8;
+    if (shared_header != NULL) __atomic_store_n(&shared_header->generation8, whole.generation8, __ATOMIC_RELAXED);
+    printf("info string TT loaded from %s: %llu entries (%.2f MB), hashfull %d\n", filename,
+           (unsigned long long)(whole.count * TT_CLUSTER_SIZE),
+           (double)(whole.count * sizeof(TTCluster)) / (1024 * 1024), tt_hashfull());
+    return true;
 }
 
 void tt_new_search() {
-    generation8 += TT_GENERATION_DELTA;  // uint8 wraps around by itself
+    if (shared_header != NULL && view == &whole) {
+        view->generation8 = __atomic_add_fetch(&shared_header->generation8, TT_GENERATION_DELTA, __ATOMIC_RELAXED);
+        return;
+    }
+    view->generation8 += TT_GENERATION_DELTA;  // uint8 wraps around by itself
 }
 
 TTData tt_probe(uint64_t key) {
     TTData data = {0};
-    if (table == NULL) return data;
+    if (view->clusters == NULL) return data;
 
     TTCluster* cluster = cluster_for(key);
     uint16_t key16 = (uint16_t)key;
 
     for (int i = 0; i < TT_CLUSTER_SIZE; i++) {
-        TTEntry* e = &cluster->entry[i];
-        if (e->key16 == key16 && e->depth8) {
+        // Verify and decode one snapshot, the shared entry may change under us
+        TTEntry e = cluster->entry[i];
+        if (entry_key(&e) == key16 && e.depth8) {
             // Refresh generation so entries that keep getting hit survive
-            e->genBound8 = (uint8_t)(generation8 | (e->genBound8 & (TT_GENERATION_DELTA - 1)));
+            cluster->entry[i].genBound8 = (uint8_t)(view->generation8 | (e.genBound8 & (TT_GENERATION_DELTA - 1)));
 
             data.found = true;
-            data.is_pv = (e->genBound8 >> 2) & 1;
-            data.bound = e->genBound8 & 0x3;
-            data.depth = (int)e->depth8 - TT_DEPTH_OFFSET;
-            data.score = e->score16;
-            data.eval  = e->eval16;
-            data.move  = entry_move(e);
+            data.is_pv = (e.genBound8 >> 2) & 1;
+            data.bound = e.genBound8 & 0x3;
+            data.depth = (int)e.depth8 - TT_DEPTH_OFFSET;
+            data.score = e.score16;
+            data.eval  = e.eval16;
+            data.move  = entry_move(&e);
             return data;
         }
     }
@@ -129,7 +654,7 @@ TTData tt_probe(uint64_t key) {
 }
 
 void tt_store(uint64_t key, int depth, int score, uint8_t bound, Move best_move, bool is_pv, int eval) {
-    if (table == NULL) return;
+    if (view->clusters == NULL) return;
 
     TTCluster* cluster = cluster_for(key);
     uint16_t key16 = (uint16_t)key;
@@ -138,7 +663,7 @@ void tt_store(uint64_t key, int depth, int score, uint8_t bound, Move best_move,
     TTEntry* replace = NULL;
     for (int i = 0; i < TT_CLUSTER_SIZE; i++) {
         TTEntry* e = &cluster->entry[i];
-        if (e->key16 == key16 || !e->depth8) {
+        if (entry_key(e) == key16 || !e->depth8) {
             replace = e;
             break;
         }
@@ -155,10 +680,15 @@ void tt_store(uint64_t key, int depth, int score, uint8_t bound, Move best_move,
         }
     }
 
+    // Build the new entry from a snapshot and write it back once, with the
+    // check folded into key16
+    TTEntry e = *replace;
+    uint16_t old_key16 = entry_key(&e);
+
     // Keep the old move if the new search produced none for the same position
-    if (best_move != 0 || key16 != replace->key16) {
-        replace->move_lo = (uint16_t)best_move;
-        replace->move_hi = (uint16_t)(best_move >> 16);
+    if (best_move != 0 || key16 != old_key16) {
+        e.move_lo = (uint16_t)best_move;
+        e.move_hi = (uint16_t)(best_move >> 16);
     }
 
     int depth8 = depth + TT_DEPTH_OFFSET;
@@ -167,41 +697,75 @@ void tt_store(uint64_t key, int depth, int score, uint8_t bound, Move best_move,
 
     // Overwrite less valuable entries: exact bounds and new positions always
     // win, otherwise require comparable depth or a stale generation
-    if (bound == TT_EXACT || key16 != replace->key16 ||
-        depth8 + 2 * is_pv > replace->depth8 - 4 ||
-        relative_age(replace->genBound8)) {
-        replace->key16 = key16;
-        replace->score16 = (int16_t)score;
-        replace->eval16 = (int16_t)eval;
-        replace->depth8 = (uint8_t)depth8;
-        replace->genBound8 = (uint8_t)(generation8 | ((uint8_t)is_pv << 2) | bound);
+    if (bound == TT_EXACT || key16 != old_key16 ||
+        depth8 + 2 * is_pv > e.depth8 - 4 ||
+        relative_age(e.genBound8)) {
+        e.score16 = (int16_t)score;
+        e.eval16 = (int16_t)eval;
+        e.depth8 = (uint8_t)depth8;
+        e.genBound8 = (uint8_t)(view->generation8 | ((uint8_t)is_pv << 2) | bound);
     }
+    // Either overwritten or the same position (key16 == old_key16)
+    e.key16 = key16 ^ entry_check(&e);
+    *replace = e;
 }
 
 void tt_prefetch(uint64_t key) {
-    if (table == NULL) return;
+    if (view->clusters == NULL) return;
     __builtin_prefetch(cluster_for(key), 0, 1);
 }
 
 int tt_hashfull() {
-    if (table == NULL || cluster_count == 0) return 0;
+    if (view->clusters == NULL || view->count == 0) return 0;
 
     // Sample the first 1000 clusters, counting entries of the current generation
     int cnt = 0;
-    uint64_t samples = cluster_count < 1000 ? cluster_count : 1000;
+    uint64_t samples = view->count < 1000 ? view->count : 1000;
     for (uint64_t i = 0; i < samples; i++) {
         for (int j = 0; j < TT_CLUSTER_SIZE; j++) {
-            const TTEntry* e = &table[i].entry[j];
-            cnt += e->depth8 && (e->genBound8 & TT_GENERATION_MASK) == generation8;
+            const TTEntry* e = &view->clusters[i].entry[j];
+            cnt += e->depth8 && (e->genBound8 & TT_GENERATION_MASK) == view->generation8;
         }
     }
     return (int)(cnt * 1000 / (samples * TT_CLUSTER_SIZE));
 }
 
+void tt_use_slice(int index, int count) {
+    slice_generation_home = NULL;
+    slice_index = index;
+    slice_count = count;
+    if (count <= 1 || whole.count < (uint64_t)count) {
+        view = &whole;
+        return;
+    }
+    uint64_t begin = whole.count * (uint64_t)index / (uint64_t)count;
+    uint64_t end = whole.count * (uint64_t)(index + 1) / (uint64_t)count;
+    own_slice.clusters = whole.clusters + begin;
+    own_slice.count = end - begin;
+    own_slice.generation8 = 0;
+    view = &own_slice;
+}
+
+void tt_switch_slice(int index, int count, uint8_t* generation) {
+    if (slice_generation_home != NULL && view == &own_slice) {
+        *slice_generation_home = own_slice.generation8;
+    }
+    tt_use_slice(index, count);
+    if (view == &own_slice) {
+        own_slice.generation8 = *generation;
+        slice_generation_home = generation;
+    }
+}
+
 void free_tt() {
-    if (table != NULL) {
-        free(table);
-        table = NULL;
-        cluster_count = 0;
+    if (whole.clusters != NULL) {
+        if (shared_header != NULL) {
+            munmap(shared_header, table_mem_size);  // segment stays for the other processes
+            shared_header = NULL;
+        } else {
+            tt_release(whole.clusters, table_mem_size, table_mmapped);
+        }
+        whole.clusters = NULL;
+        whole.count = 0;
     }
 }
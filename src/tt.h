@@ -29,14 +29,39 @@ typedef struct {
     Move    move;
 } TTData;
 
+// Size at startup and limit of the Hash option
+#define TT_DEFAULT_MB 256
+#define TT_MAX_MB     (1 << 20)
+
 void init_zobrist_keys();
 void init_tt(size_t table_size_mb);
+size_t tt_size_mb(void);  // size requested by the last init_tt()
+// Back the TT with the named shared memory segment (empty name = private
+// table) and re-initialise it with the current size. Cooperating processes
+// using the same name share one table.
+void tt_set_shared(const char* name);
+// Confine the calling thread to slice `index` of `count` equal parts of the
+// table, with a generation of its own: its probes, stores, clear_tt(),
+// tt_new_search() and tt_hashfull() then only see that slice. count <= 1
+// returns the thread to the whole table. Slices are invalidated by init_tt().
+void tt_use_slice(int index, int count);
+// Like tt_use_slice(), but the slice's generation lives in *generation (0
+// for a fresh slice) and is written back on the next switch, so a thread can
+// alternate between slices (one per side in a match) without losing their aging.
+void tt_switch_slice(int index, int count, uint8_t* generation);
 void clear_tt();
 void tt_new_search();  // Call at start of each search to bump the generation
+// tt_probe/tt_store/tt_prefetch may be called concurrently from multiple
+// search threads (lockless, racy by design - see tt.c).
 void tt_store(uint64_t key, int depth, int score, uint8_t bound, Move best_move, bool is_pv, int eval);
 TTData tt_probe(uint64_t key);
 void tt_prefetch(uint64_t key);  // Prefetch TT cluster for better cache performance
 void free_tt();
+// Write the table to / read it back from a hash file (raw clusters plus
+// header). Loading resizes the table to the saved size. Only call while no
+// search is running.
+bool tt_save(const char* filename);
+bool tt_load(const char* filename);
 int tt_hashfull();  // Returns permille of TT usage
 
 #endif // TT_H
@@ -13,14 +13,19 @@
 #include "search.h" // Will be created later
 #include "bitboard_utils.h" // ADDED
 #include "nnue.h" // For NNUE accumulator management
+#include "nnue_simd.h" // For the nnuebench kernel benchmark
+#include "tt.h" // For clear_tt on ucinewgame
 #include "evaluation.h" // For eval_init
 #include "syzygy.h" // Syzygy tablebase adapter
+#include "perft.h"
+#include "epd.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <time.h> // For time management
 #include <stdint.h>
 #include <string.h>
+#include <pthread.h>
 
 
 #define ENGINE_NAME "SleepMind UCI"
@@ -32,7 +37,116 @@ static int current_ply = 0;
 
 // Syzygy tablebase settings (configured via UCI options)
 static char syzygy_path[1024] = {0};
+static char eval_file[1024] = NNUE_DEFAULT_NET;
+static char hash_file[1024] = "hash.bin";  // savehash / loadhash target
 static int syzygy_probe_limit = 7; // max piece count probed during search
+static int multi_pv = 1;           // lines reported per iteration (MultiPV option)
+
+// Values of the SearchStats option, indexed by SearchStatsMode
+static const char* const stats_mode_names[] = { "off", "info", "json" };
+
+// =============================================================================
+// Asynchronous search
+//
+// "go" runs the search on its own thread so the UCI thread keeps reading
+// stdin: "stop", "ponderhit", "isready" and "quit" are handled at once,
+// every other command first waits for the running search to finish. The
+// search thread prints the bestmove itself.
+// =============================================================================
+typedef struct {
+    Board board;         // private copy, the UCI thread keeps current_board
+    SearchInfo* info;
+    bool infinite;       // "go infinite": hold bestmove back until "stop"
+} SearchJob;
+
+static SearchJob search_job;
+static pthread_t search_thread;
+static bool search_running = false;
+
+static void* search_thread_main(void* arg) {
+    SearchJob* job = (SearchJob*)arg;
+    SearchInfo* info = job->info;
+
+    Move best_move = iterative_deepening_search(&job->board, info);
+    // On a tablebase root hit, play the DTZ-optimal move so that the
+    // played move, the reported score and the displayed PV all agree.
+    if (info->tbRootMoveCount > 0 && info->tbRootPvLen > 0) {
+        best_move = info->tbRootPv[0];
+    }
+    printf("info string DEBUG: UCI: iterative_deepening_search returned. Best move: %u\n", best_move);
+    printf("Best score: %d\n", info->bestScoreThisIteration);
+    fflush(stdout);
+
+    // UCI: in infinite and ponder mode bestmove may only be sent after
+    // "stop" (or "ponderhit"), even if the search finished on its own
+    // (mate found, MAX_PLY reached)
+    while ((job->infinite || search_is_pondering()) && !search_stop_requested()) {
+        struct timespec pause = {0, 1000000}; // 1 ms
+        nanosleep(&pause, NULL);
+    }
+
+    // A stop right after "go" can end the search before any root move was
+    // completed - still answer with a legal move
+    if (best_move == 0) {
+        MoveList legal;
+        generateLegalMoves(&job->board, &legal);
+        if (legal.count > 0) best_move = legal.moves[0];
+    }
+
+    // Expected reply for "bestmove ... ponder": second move of the last
+    // completed PV, as long as that PV starts with the move we play
+    Move ponder_move = 0;
+    if (info->tbRootMoveCount > 0 && info->tbRootPvLen > 0) {
+        if (info->tbRootPvLen >= 2) ponder_move = info->tbRootPv[1];
+    } else if (info->bestPvLength >= 2 && info->bestPv[0] == best_move) {
+        ponder_move = info->bestPv[1];
+    }
+
+    if (best_move != 0) {
+        char move_str[6];
+        moveToString(best_move, move_str);
+        if (ponder_move != 0) {
+            char ponder_str[6];
+            moveToString(ponder_move, ponder_str);
+            printf("bestmove %s ponder %s\n", move_str, ponder_str);
+        } else {
+            printf("bestmove %s\n", move_str);
+        }
+    } else {
+        printf("bestmove 0000\n"); // Should not happen in a legal position
+    }
+    fflush(stdout);
+    return NULL;
+}
+
+static void start_search(const Board* board, SearchInfo* info, bool infinite) {
+    search_job.board = *board;
+    search_job.info = info;
+    search_job.infinite = infinite;
+    search_clear_stop();
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, SEARCH_THREAD_STACK_SIZE);
+    if (pthread_create(&search_thread, &attr, search_thread_main, &search_job) == 0) {
+        search_running = true;
+    } else {
+        // No thread available: search synchronously instead
+        printf("info string Failed to start search thread, searching synchronously\n");
+        fflush(stdout);
+        search_job.infinite = false;
+        search_thread_main(&search_job);
+    }
+    pthread_attr_destroy(&attr);
+}
+
+// Block until the running search (if any) has printed its bestmove
+static void wait_for_search(void) {
+    if (search_running) {
+        pthread_join(search_thread, NULL);
+        search_running = false;
+    }
+}
 
 // Function to parse moves in UCI format (e.g., "e2e4", "e7e8q")
 
@@ -122,82 +236,142 @@ Move parse_uci_move(Board* board, const char* move_str) {
     return 0; // Move not found or invalid
 }
 
-// Perft: count leaf nodes to given depth. Uses global move_list and existing apply/undo.
-// Now checks legality after applying each move (pseudo-legal move generation)
-static unsigned long long perft(Board* board, int depth) {
-    if (depth == 0) return 1ULL;
-
-    MoveList local_moves;
-    local_moves.count = 0;
-    generateMoves(board, &local_moves);
-
-    unsigned long long nodes = 0ULL;
-    for (int i = 0; i < local_moves.count; ++i) {
-        Move m = local_moves.moves[i];
-        MoveUndoInfo undo_info;
-        applyMove(board, m, &undo_info, NULL, NULL);  // perft doesn't need NNUE
-        
-        // Skip illegal moves (king left in check) - move generator now returns pseudo-legal moves
-        if (isKingAttacked(board, !board->whiteToMove)) {
-            undoMove(board, m, &undo_info, NULL, NULL);
-            continue;
-        }
-        
-        if (depth == 1) {
-            nodes++;
-        } else {
-            nodes += perft(board, depth - 1);
-        }
-        undoMove(board, m, &undo_info, NULL, NULL);  // perft doesn't need NNUE
-    }
-    return nodes;
-}
+// =============================================================================
+// Bench
+//
+// "bench [depth] [hash] [threads]" searches a fixed suite of positions to the
+// same depth, each from a clean TT and cleared histories, and prints the
+// total node count and NPS. With one thread the node count is deterministic
+// for a given build: a changed count means the search changed, an unchanged
+// count with different NPS is a pure speed change.
+// =============================================================================
+#define BENCH_DEFAULT_DEPTH 13
+#define BENCH_DEFAULT_HASH 16
 
-// Perft divide: print per-move counts and return total
-// Now checks legality after applying each move (pseudo-legal move generation)
-static unsigned long long perft_divide(Board* board, int depth) {
-    MoveList local_moves;
-    local_moves.count = 0;
-    generateMoves(board, &local_moves);
-    unsigned long long total = 0ULL;
-
-    for (int i = 0; i < local_moves.count; ++i) {
-        Move m = local_moves.moves[i];
-        MoveUndoInfo undo_info;
-        applyMove(board, m, &undo_info, NULL, NULL);  // perft doesn't need NNUE
-        
-        // Skip illegal moves (king left in check) - move generator now returns pseudo-legal moves
-        if (isKingAttacked(board, !board->whiteToMove)) {
-            undoMove(board, m, &undo_info, NULL, NULL);
-            continue;
-        }
-        
-        unsigned long long cnt;
-        if (depth == 1) {
-            cnt = 1;
-        } else {
-            cnt = perft(board, depth - 1);
-        }
-        undoMove(board, m, &undo_info, NULL, NULL);  // perft doesn't need NNUE
+static const char* bench_fens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+    "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+    "rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+    "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+    "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+    "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+    "r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+    "4r1k1/r1q2ppp/ppp2n2/4P3/5Rb1/1N1BQ3/PPP3PP/R5K1 w - - 1 17",
+    "2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11",
+    "r1bq1r1k/b1p1npp1/p2p3p/1p6/3PP3/1B2NN2/PP3PPP/R2Q1RK1 w - - 1 16",
+    "3r1rk1/p5pp/bpp1pp2/8/q1PP1P2/b3P3/P2NQRPP/1R2B1K1 b - - 6 22",
+    "r1q2rk1/2p1bppp/2Pp4/p6b/Q1PNp3/4B3/PP1R1PPP/2K4R w - - 2 18",
+    "4k2r/1pb2ppp/1p2p3/1R1p4/3P4/2r1PN2/P4PPP/1R4K1 b - - 3 22",
+    "3q2k1/pb3p1p/4pbp1/2r5/PpN2N2/1P2P2P/5PP1/Q2R2K1 b - - 4 26",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "rnbqkbnr/pppp1ppp/8/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R b KQkq - 1 2",
+    "r3k2r/3nnpbp/q2pp1p1/p7/Pp1PPPP1/4BNN1/1P5P/R2Q1RK1 w kq - 0 16",
+    "3Qb1k1/1r2ppb1/pN1n2q1/Pp1Pp1Pr/4P2p/4BP2/4B1R1/1R5K b - - 11 40",
+    "4k3/3q1r2/1N2r1b1/3ppN2/2nPP3/1B1R2n1/2R1Q3/3K4 w - - 5 1",
+    "5rk1/q6p/2p3bR/1pPp1rP1/1P1Pp3/P3B1Q1/1K3P2/R7 w - - 93 90",
+    "4rrk1/1p1nq3/p7/2p1P1pp/3P2bp/3Q1Bn1/PPPB4/1K2R1NR w - - 40 21",
+    "6k1/3b3r/1p1p4/p1n2p2/1PPNpP1q/P3Q1p1/1R1RB1P1/5K2 b - - 0 1",
+    "r2r1n2/pp2bk2/2p1p2p/3q4/3PN1QP/2P3R1/P4PP1/5RK1 w - - 0 1",
+    "1r3k2/4q3/2Pp3b/3Bp3/2Q2p2/1p1P2P1/1P2KP2/3N4 w - - 0 1",
+    "6k1/4pp1p/3p2p1/P1pPb3/R7/1r2P1PP/3B1P2/6K1 w - - 0 1",
+    "6k1/6p1/P6p/r1N5/5p2/7P/1b3PP1/4R1K1 w - - 0 1",
+    "8/pp2r1k1/2p1p3/3pP2p/1P1P1P1P/P5KR/8/8 w - - 0 1",
+    "8/3p4/p1bk3p/Pp6/1Kp1PpPp/2P2P1P/2P5/5B2 b - - 0 1",
+    "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/3N4 b - - 0 1",
+    "3b4/5kp1/1p1p1p1p/pP1PpP1P/P1P1P3/3KN3/8/8 w - - 0 1",
+    "8/6pk/1p6/8/PP3p1p/5P2/4KP1q/3Q4 w - - 0 1",
+    "7k/3p2pp/4q3/8/4Q3/5Kp1/P6b/8 w - - 0 1",
+    "8/3p3B/5p2/5P2/p7/PP5b/k7/6K1 w - - 0 1",
+    "2K5/p7/7P/5pR1/8/5k2/r7/8 w - - 0 1",
+    "8/2p5/8/2kPKp1p/2p4P/2P5/3P4/8 w - - 0 1",
+    "8/1p3pp1/7p/5P1P/2k3P1/8/2K2P2/8 w - - 0 1",
+    "5k2/7R/4P2p/5K2/p1r2P1p/8/8/8 b - - 0 1",
+    "8/R7/2q5/8/6k1/8/1P5p/K6R w - - 0 124",
+    "8/8/1P6/5pr1/8/4R3/7k/2K5 w - - 0 1",
+    "8/2p4P/8/kr6/6R1/8/8/1K6 w - - 0 1",
+    "8/8/3P3k/8/1p6/8/1P6/1K3n2 b - - 0 1",
+    "8/5k2/8/3K4/8/8/2P5/8 w - - 0 1",
+    "8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 1",
+    "8/8/8/5N2/8/p7/8/2NK3k w - - 0 1",
+    "8/3k4/8/8/8/4B3/4KB2/2B5 w - - 0 1",
+    "7k/7P/6K1/8/3B4/8/8/8 b - - 0 1",
+};
+#define BENCH_POSITIONS ((int)(sizeof(bench_fens) / sizeof(bench_fens[0])))
 
-        char move_str[6];
-        moveToString(m, move_str);
-        printf("%s: %llu\n", move_str, cnt);
+// Leaves the engine as after ucinewgame: startpos, cleared TT and histories,
+// previous hash size and thread count
+static void bench(int depth, int hash_mb, int threads, SearchInfo* info,
+                  NNUEAccumulator* acc, NNUENetwork* net, const SearchParams* params) {
+    size_t old_hash_mb = tt_size_mb();
+    int old_threads = search_get_threads();
+    if ((size_t)hash_mb != old_hash_mb) init_tt((size_t)hash_mb);
+    search_set_threads(threads);
+    search_stats_reset_totals();
+
+    uint64_t total = 0;
+    long start = search_current_time_ms();
+    for (int i = 0; i < BENCH_POSITIONS; i++) {
+        printf("info string Bench position %d/%d: %s\n", i + 1, BENCH_POSITIONS, bench_fens[i]);
         fflush(stdout);
-        total += cnt;
+
+        current_board = parseFEN(bench_fens[i]);
+        nnue_reset_accumulator(&current_board, acc, net);
+        clear_tt();
+        clear_search_history(info);
+        clear_helper_history();
+
+        // No tablebases: they would make the count depend on the installed files
+        search_info_prepare(info, params);
+        search_set_pondering(false);
+        info->nnue_acc = acc;
+        info->nnue_net = net;
+        info->depthLimit = depth;
+
+        start_search(&current_board, info, false);
+        wait_for_search();
+        total += search_total_nodes(info);
     }
+    long elapsed = search_current_time_ms() - start;
+    if (elapsed < 1) elapsed = 1;
 
-    printf("Total: %llu\n", total);
+    search_stats_print_totals();
+    printf("info string Bench: %d positions, depth %d, hash %d MB, threads %d\n",
+           BENCH_POSITIONS, depth, hash_mb, threads);
+    printf("Total time (ms) : %ld\n", elapsed);
+    printf("Nodes searched  : %llu\n", (unsigned long long)total);
+    printf("Nodes/second    : %llu\n", (unsigned long long)(total * 1000 / (uint64_t)elapsed));
     fflush(stdout);
-    return total;
+
+    search_set_threads(old_threads);
+    if (tt_size_mb() != old_hash_mb) init_tt(old_hash_mb);
+    clear_tt();
+    clear_search_history(info);
+    clear_helper_history();
+    current_ply = 0;
+    current_board = parseFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    nnue_reset_accumulator(&current_board, acc, net);
 }
 
+// "epd" defaults: the node budget per position when no limit is given, the
+// eval difference symmetry_test.sh tolerates for NNUE rounding, and the one
+// "epd compare" tolerates between a converted net and its original
+#define EPD_DEFAULT_NODES 1000000
+#define EPD_SYMMETRY_TOLERANCE 10
+#define EPD_COMPARE_TOLERANCE 10
 
-void uci_loop() {
+// command: run this single command instead of reading stdin (command line
+// use, e.g. "sleepmind bench"), NULL for the normal UCI loop
+void uci_loop(const char* command) {
     char line[4096];
-    MoveUndoInfo undo_info;
+    // Game history of the "position ... moves" line; current_board.st points
+    // into it, so it must outlive every search started from current_board
+    static StateInfo game_states[MAX_GAME_STATES];
     
-    // NNUE network is ~7.5 MB - must be on heap, not stack (stack is only ~1MB on Windows)
+    // NNUE network: a small view onto the mmapped (or embedded) weights
     NNUENetwork* nnue_network = (NNUENetwork*)calloc(1, sizeof(NNUENetwork));
     if (!nnue_network) {
         fprintf(stderr, "Error: Failed to allocate memory for NNUE network\n");
@@ -213,13 +387,18 @@ void uci_loop() {
     // accumulate over the whole game; fully cleared on ucinewgame
     static SearchInfo search_info;
     clear_search_history(&search_info);
+    nnue_accumulator.cache = &search_info.nnue_cache;  // position resets go through the refresh cache
+
+    // Time limits of the last "go", applied on ponderhit
+    long ponder_soft_limit = 0;
+    long ponder_hard_limit = 0;
 
     printf("DEBUG: Starting uci_loop initialization\n"); fflush(stdout);
     
     initMoveGenerator(); // Initialize move generator data
     printf("DEBUG: Move generator initialized\n"); fflush(stdout);
     
-    eval_init("quantised.bin", nnue_network);  // Load NNUE network
+    eval_init(eval_file, nnue_network);  // Load NNUE network
     printf("DEBUG: NNUE initialized, loaded=%d\n", nnue_network->loaded); fflush(stdout);
 
     // Default to standard start position so commands like "perft" work
@@ -232,12 +411,26 @@ void uci_loop() {
     printf("%s by %s\n", ENGINE_NAME, ENGINE_AUTHOR);
     printf("DEBUG: Starting main loop\n"); fflush(stdout);
 
-    while (fgets(line, sizeof(line), stdin)) {
+    if (command) snprintf(line, sizeof(line), "%s", command);
+    for (bool first = true; command ? first : fgets(line, sizeof(line), stdin) != NULL; first = false) {
         line[strcspn(line, "\n")] = 0; // Remove newline
 
+        // Only these commands may run alongside a search; everything else
+        // reads or changes state the search thread is using
+        if (strcmp(line, "isready") != 0 && strcmp(line, "stop") != 0 &&
+            strcmp(line, "ponderhit") != 0 && strcmp(line, "quit") != 0) {
+            wait_for_search();
+        }
+
         if (strcmp(line, "uci") == 0) {
             printf("id name %s\n", ENGINE_NAME);
             printf("id author %s\n", ENGINE_AUTHOR);
+            printf("option name Hash type spin default %d min 1 max %d\n", TT_DEFAULT_MB, TT_MAX_MB);
+            printf("option name Threads type spin default 1 min 1 max %d\n", MAX_THREADS);
+            printf("option name Ponder type check default false\n");
+            printf("option name MultiPV type spin default 1 min 1 max %d\n", MAX_MOVES);
+            printf("option name SearchStats type combo default %s var off var info var json\n",
+                   stats_mode_names[search_get_stats_mode()]);
             // Feature enable/disable options
             printf("option name Use_LMR type check default true\n");
             printf("option name Use_NullMove type check default true\n");
@@ -250,7 +443,10 @@ void uci_loop() {
             printf("option name Use_QSSeePruning type check default true\n");
             printf("option name Use_BadCaptureLast type check default true\n");
             printf("option name Use_LMP type check default true\n");
+            printf("option name Use_CaptureHistory type check default true\n");
+            printf("option name Use_CheckLMR type check default false\n");
             printf("option name Use_MDP type check default true\n");
+            printf("option name Use_Cuckoo type check default false\n");
             // Search parameter options
             printf("option name LMR_FullDepthMoves type spin default 3 min 1 max 10\n");
             printf("option name LMP_Base type spin default 6 min 1 max 20\n");
@@ -276,8 +472,12 @@ void uci_loop() {
             printf("option name LMR_StatLow1 type spin default -2893 min -49000 max 0\n");
             printf("option name LMR_StatHigh1 type spin default 23973 min 0 max 49000\n");
             printf("option name LMR_StatHigh2 type spin default 14621 min 0 max 49000\n");
+            printf("option name EvalFile type string default %s\n", NNUE_DEFAULT_NET);
+            printf("option name HashFile type string default hash.bin\n");
+            printf("option name SharedHash type string default <empty>\n");
             printf("option name SyzygyPath type string default <empty>\n");
             printf("option name SyzygyProbeLimit type spin default 7 min 0 max 7\n");
+            printf("option name SyzygyWarmup type check default false\n");
             printf("uciok\n");
             fflush(stdout);
         } else if (strcmp(line, "isready") == 0) {
@@ -317,116 +517,69 @@ void uci_loop() {
                 bool bool_value = (strcmp(value_start, "true") == 0 || strcmp(value_start, "1") == 0);
                 
                 // Match option names and set values in search_params
-                // Feature enable/disable flags
-                if (strcmp(option_name, "Use_LMR") == 0) {
-                    search_params.use_lmr = bool_value;
-                    printf("info string Set Use_LMR to %s\n", bool_value ? "true" : "false");
-                } else if (strcmp(option_name, "Use_NullMove") == 0) {
-                    search_params.use_null_move = bool_value;
-                    printf("info string Set Use_NullMove to %s\n", bool_value ? "true" : "false");
-                } else if (strcmp(option_name, "Use_Futility") == 0) {
-                    search_params.use_futility = bool_value;
-                    printf("info string Set Use_Futility to %s\n", bool_value ? "true" : "false");
-                } else if (strcmp(option_name, "Use_RFP") == 0) {
-                    search_params.use_rfp = bool_value;
-                    printf("info string Set Use_RFP to %s\n", bool_value ? "true" : "false");
-                } else if (strcmp(option_name, "Use_DeltaPruning") == 0) {
-                    search_params.use_delta_pruning = bool_value;
-                    printf("info string Set Use_DeltaPruning to %s\n", bool_value ? "true" : "false");
-                } else if (strcmp(option_name, "Use_Aspiration") == 0) {
-                    search_params.use_aspiration = bool_value;
-                    printf("info string Set Use_Aspiration to %s\n", bool_value ? "true" : "false");
-                } else if (strcmp(option_name, "Use_Razoring") == 0) {
-                    search_params.use_razoring = bool_value;
-                    printf("info string Set Use_Razoring to %s\n", bool_value ? "true" : "false");
-                } else if (strcmp(option_name, "Use_CheckExtension") == 0) {
-                    search_params.use_check_extension = bool_value;
-                    printf("info string Set Use_CheckExtension to %s\n", bool_value ? "true" : "false");
-                } else if (strcmp(option_name, "Use_MDP") == 0) {
-                    search_params.use_mdp = bool_value;
-                    printf("info string Set Use_MDP to %s\n", bool_value ? "true" : "false");
-                } else if (strcmp(option_name, "Use_QSSeePruning") == 0) {
-                    search_params.use_qs_see_pruning = bool_value;
-                    printf("info string Set Use_QSSeePruning to %s\n", bool_value ? "true" : "false");
-                } else if (strcmp(option_name, "Use_BadCaptureLast") == 0) {
-                    search_params.use_bad_capture_last = bool_value;
-                    printf("info string Set Use_BadCaptureLast to %s\n", bool_value ? "true" : "false");
-                } else if (strcmp(option_name, "Use_LMP") == 0) {
-                    search_params.use_lmp = bool_value;
-                    printf("info string Set Use_LMP to %s\n", bool_value ? "true" : "false");
-                // Numeric parameters
-                } else if (strcmp(option_name, "LMP_Base") == 0) {
-                    search_params.lmp_base = value;
-                    printf("info string Set LMP_Base to %d\n", value);
-                } else if (strcmp(option_name, "LMP_MaxDepth") == 0) {
-                    search_params.lmp_max_depth = value;
-                    printf("info string Set LMP_MaxDepth to %d\n", value);
-                } else if (strcmp(option_name, "LMR_FullDepthMoves") == 0) {
-                    search_params.lmr_full_depth_moves = value;
-                    printf("info string Set LMR_FullDepthMoves to %d\n", value);
-                } else if (strcmp(option_name, "LMR_ReductionLimit") == 0) {
-                    search_params.lmr_reduction_limit = value;
-                    printf("info string Set LMR_ReductionLimit to %d\n", value);
-                } else if (strcmp(option_name, "NullMove_MinDepth") == 0) {
-                    search_params.null_move_min_depth = value;
-                    printf("info string Set NullMove_MinDepth to %d\n", value);
-                } else if (strcmp(option_name, "Futility_Margin") == 0) {
-                    search_params.futility_margin = value;
-                    printf("info string Set Futility_Margin to %d\n", value);
-                } else if (strcmp(option_name, "Futility_MarginD2") == 0) {
-                    search_params.futility_margin_d2 = value;
-                    printf("info string Set Futility_MarginD2 to %d\n", value);
-                } else if (strcmp(option_name, "Futility_MarginD3") == 0) {
-                    search_params.futility_margin_d3 = value;
-                    printf("info string Set Futility_MarginD3 to %d\n", value);
-                } else if (strcmp(option_name, "RFP_Margin") == 0) {
-                    search_params.rfp_margin = value;
-                    printf("info string Set RFP_Margin to %d\n", value);
-                } else if (strcmp(option_name, "RFP_MaxDepth") == 0) {
-                    search_params.rfp_max_depth = value;
-                    printf("info string Set RFP_MaxDepth to %d\n", value);
-                } else if (strcmp(option_name, "Delta_Margin") == 0) {
-                    search_params.delta_margin = value;
-                    printf("info string Set Delta_Margin to %d\n", value);
-                } else if (strcmp(option_name, "Razor_Margin") == 0) {
-                    search_params.razor_margin = value;
-                    printf("info string Set Razor_Margin to %d\n", value);
-                } else if (strcmp(option_name, "Aspiration_Window") == 0) {
-                    search_params.aspiration_window = value;
-                    printf("info string Set Aspiration_Window to %d\n", value);
-                } else if (strcmp(option_name, "Hist_BonusMult") == 0) {
-                    search_params.hist_bonus_mult = value;
-                    printf("info string Set Hist_BonusMult to %d\n", value);
-                } else if (strcmp(option_name, "Hist_BonusSub") == 0) {
-                    search_params.hist_bonus_sub = value;
-                    printf("info string Set Hist_BonusSub to %d\n", value);
-                } else if (strcmp(option_name, "Hist_BonusMax") == 0) {
-                    search_params.hist_bonus_max = value;
-                    printf("info string Set Hist_BonusMax to %d\n", value);
-                } else if (strcmp(option_name, "Hist_MalusMult") == 0) {
-                    search_params.hist_malus_mult = value;
-                    printf("info string Set Hist_MalusMult to %d\n", value);
-                } else if (strcmp(option_name, "Hist_MalusSub") == 0) {
-                    search_params.hist_malus_sub = value;
-                    printf("info string Set Hist_MalusSub to %d\n", value);
-                } else if (strcmp(option_name, "Hist_MalusMax") == 0) {
-                    search_params.hist_malus_max = value;
-                    printf("info string Set Hist_MalusMax to %d\n", value);
-                } else if (strcmp(option_name, "FMH_Weight") == 0) {
-                    search_params.fmh_weight = value;
-                    printf("info string Set FMH_Weight to %d\n", value);
-                } else if (strcmp(option_name, "LMR_StatLow2") == 0) {
-                    search_params.lmr_stat_low2 = value;
-                    printf("info string Set LMR_StatLow2 to %d\n", value);
-                } else if (strcmp(option_name, "LMR_StatLow1") == 0) {
-                    search_params.lmr_stat_low1 = value;
-                    printf("info string Set LMR_StatLow1 to %d\n", value);
-                } else if (strcmp(option_name, "LMR_StatHigh1") == 0) {
-                    search_params.lmr_stat_high1 = value;
-                    printf("info string Set LMR_StatHigh1 to %d\n", value);
-                } else if (strcmp(option_name, "LMR_StatHigh2") == 0) {
-                    search_params.lmr_stat_high2 = value;
-                    printf("info string Set LMR_StatHigh2 to %d\n", value);
+                if (strcmp(option_name, "Hash") == 0) {
+                    init_tt((size_t)(value < 1 ? 1 : value > TT_MAX_MB ? TT_MAX_MB : value));
+                    printf("info string Set Hash to %zu MB\n", tt_size_mb());
+                } else if (strcmp(option_name, "Threads") == 0) {
+                    search_set_threads(value);
+                    printf("info string Set Threads to %d\n", search_get_threads());
+                } else if (strcmp(option_name, "MultiPV") == 0) {
+                    multi_pv = value < 1 ? 1 : value > MAX_MOVES ? MAX_MOVES : value;
+                    printf("info string Set MultiPV to %d\n", multi_pv);
+                } else if (strcmp(option_name, "SearchStats") == 0) {
+                    for (int m = SEARCH_STATS_OFF; m <= SEARCH_STATS_JSON; m++) {
+                        if (strcmp(value_start, stats_mode_names[m]) == 0) {
+                            search_set_stats_mode((SearchStatsMode)m);
+                        }
+                    }
+                    printf("info string Set SearchStats to %s\n", stats_mode_names[search_get_stats_mode()]);
+                } else if (strcmp(option_name, "Ponder") == 0) {
+                    // Only tells us the GUI may send "go ponder"; nothing to configure
+                    printf("info string Set Ponder to %s\n", bool_value ? "true" : "false");
+                } else if (search_params_set(&search_params, option_name, value_start)) {
+                    // Use_* flags and numeric search parameters
+                    char shown[16];
+                    search_params_get(&search_params, option_name, shown, sizeof(shown));
+                    printf("info string Set %s to %s\n", option_name, shown);
+                } else if (strcmp(option_name, "EvalFile") == 0) {
+                    strncpy(eval_file, value_start, sizeof(eval_file) - 1);
+                    eval_file[sizeof(eval_file) - 1] = '\0';
+                    size_t elen = strlen(eval_file);
+                    while (elen > 0 && (eval_file[elen - 1] == '\r' || eval_file[elen - 1] == ' ')) {
+                        eval_file[--elen] = '\0';
+                    }
+                    // Any width up to NNUE_MAX_HIDDEN_SIZE; refresh caches see
+                    // the new load generation and rebuild themselves
+                    bool had_net = nnue_network->loaded;
+                    uint64_t old_hash = nnue_network->hash;
+                    eval_init(eval_file, nnue_network);
+                    nnue_reset_accumulator(&current_board, &nnue_accumulator, nnue_network);
+                    if (nnue_network->loaded != had_net || nnue_network->hash != old_hash) {
+                        // TT evals and histories belong to the old eval: start
+                        // over as on ucinewgame
+                        clear_search_history(&search_info);
+                        clear_helper_history();
+                        clear_tt();
+                    }
+                } else if (strcmp(option_name, "HashFile") == 0) {
+                    strncpy(hash_file, value_start, sizeof(hash_file) - 1);
+                    hash_file[sizeof(hash_file) - 1] = '\0';
+                    size_t hlen = strlen(hash_file);
+                    while (hlen > 0 && (hash_file[hlen - 1] == '\r' || hash_file[hlen - 1] == ' ')) {
+                        hash_file[--hlen] = '\0';
+                    }
+                    printf("info string Set HashFile to %s\n", hash_file);
+                } else if (strcmp(option_name, "SharedHash") == 0) {
+                    // Name of a shared memory segment other engine processes
+                    // attach to as well; <empty> switches back to a private TT
+                    char shm_name[256];
+                    strncpy(shm_name, value_start, sizeof(shm_name) - 1);
+                    shm_name[sizeof(shm_name) - 1] = '\0';
+                    size_t slen = strlen(shm_name);
+                    while (slen > 0 && (shm_name[slen - 1] == '\r' || shm_name[slen - 1] == ' ')) {
+                        shm_name[--slen] = '\0';
+                    }
+                    tt_set_shared(shm_name);
                 } else if (strcmp(option_name, "SyzygyPath") == 0) {
                     // value_start holds the raw path; strip trailing whitespace.
                     strncpy(syzygy_path, value_start, sizeof(syzygy_path) - 1);
@@ -441,6 +594,9 @@ void uci_loop() {
                 } else if (strcmp(option_name, "SyzygyProbeLimit") == 0) {
                     syzygy_probe_limit = value;
                     printf("info string Set SyzygyProbeLimit to %d\n", value);
+                } else if (strcmp(option_name, "SyzygyWarmup") == 0) {
+                    syzygy_set_warmup(bool_value);
+                    printf("info string Set SyzygyWarmup to %s\n", bool_value ? "true" : "false");
                 } else {
                     printf("info string Unknown option: %s\n", option_name);
                 }
@@ -452,6 +608,8 @@ void uci_loop() {
             current_board = parseFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
             nnue_reset_accumulator(&current_board, &nnue_accumulator, nnue_network);
             clear_search_history(&search_info);
+            clear_helper_history();
+            clear_tt();
         } else if (strncmp(line, "position", 8) == 0) {
             char* token;
             char* rest = line + 9; // Skip "position "
@@ -499,7 +657,8 @@ void uci_loop() {
                 while ((current_move_token = strtok_r(NULL, " ", &rest)) != NULL) {
                     Move move = parse_uci_move(&current_board, current_move_token);
                     if (move != 0) {
-                        applyMove(&current_board, move, &undo_info, &nnue_accumulator, nnue_network);  // Update NNUE
+                        applyMove(&current_board, move, &game_states[current_ply % MAX_GAME_STATES],
+                                  &nnue_accumulator, nnue_network);  // Update NNUE
                         current_ply++;
                         // Log after applying, to see the state if needed, or confirm application
                         printf("info string DEBUG: UCI: Move '%s' (parsed as %u) successfully applied.\n", current_move_token, move); fflush(stdout);
@@ -533,39 +692,42 @@ void uci_loop() {
                 printf("info string DEBUG: UCI: Exited moves parsing loop. Processed %d moves.\n", move_idx); fflush(stdout);
             }
         } else if (strncmp(line, "perft", 5) == 0) {
+            // perft [divide] <depth> [threads <n>] [hash <MB>]
+            // threads defaults to the Threads option, the perft hash is off
+            // unless a size is given
             char* token;
-            char* rest = line + 6; // skip "perft "
+            char* rest = line + 5;
             int divide = 0;
-            token = strtok_r(rest, " ", &rest);
-            if (token && strcmp(token, "divide") == 0) {
-                divide = 1;
-                token = strtok_r(NULL, " ", &rest);
-            }
             int depth = 0;
-            if (token) depth = atoi(token);
-            if (depth <= 0) {
-                printf("info string Error: perft requires positive depth\n");
+            int threads = search_get_threads();
+            int hash_mb = 0;
+            while ((token = strtok_r(rest, " ", &rest))) {
+                if (strcmp(token, "divide") == 0) divide = 1;
+                else if (strcmp(token, "threads") == 0 && (token = strtok_r(NULL, " ", &rest))) threads = atoi(token);
+                else if (strcmp(token, "hash") == 0 && (token = strtok_r(NULL, " ", &rest))) hash_mb = atoi(token);
+                else depth = atoi(token);
+            }
+            if (threads < 1) threads = 1;
+            if (hash_mb < 0) hash_mb = 0;
+            if (depth <= 0 || depth > 63) {
+                printf("info string Error: perft requires a depth between 1 and 63\n");
                 fflush(stdout);
             } else {
-                printf("info string DEBUG: UCI: Running perft depth %d (divide=%s)\n", depth, divide ? "true" : "false"); fflush(stdout);
+                printf("info string DEBUG: UCI: Running perft depth %d (divide=%s, threads=%d, hash=%d MB)\n",
+                       depth, divide ? "true" : "false", threads, hash_mb); fflush(stdout);
                 struct timespec t_start, t_end;
                 clock_gettime(CLOCK_MONOTONIC, &t_start);
+                unsigned long long nodes = perft_run(&current_board, depth, threads, (size_t)hash_mb, divide);
+                clock_gettime(CLOCK_MONOTONIC, &t_end);
+                double elapsed_ms = (t_end.tv_sec - t_start.tv_sec) * 1000.0 + (t_end.tv_nsec - t_start.tv_nsec) / 1e6;
+                double nps = elapsed_ms > 0.0 ? (nodes / (elapsed_ms / 1000.0)) : 0.0;
                 if (divide) {
-                    unsigned long long total = perft_divide(&current_board, depth);
-                    clock_gettime(CLOCK_MONOTONIC, &t_end);
-                    double elapsed_ms = (t_end.tv_sec - t_start.tv_sec) * 1000.0 + (t_end.tv_nsec - t_start.tv_nsec) / 1e6;
-                    double nps = elapsed_ms > 0.0 ? (total / (elapsed_ms / 1000.0)) : 0.0;
-                    printf("info string perft depth %d completed: %llu nodes in %.3f ms (nps: %.0f)\n", depth, total, elapsed_ms, nps);
-                    fflush(stdout);
+                    printf("info string perft depth %d completed: %llu nodes in %.3f ms (nps: %.0f)\n", depth, nodes, elapsed_ms, nps);
                 } else {
-                    unsigned long long nodes = perft(&current_board, depth);
-                    clock_gettime(CLOCK_MONOTONIC, &t_end);
-                    double elapsed_ms = (t_end.tv_sec - t_start.tv_sec) * 1000.0 + (t_end.tv_nsec - t_start.tv_nsec) / 1e6;
-                    double nps = elapsed_ms > 0.0 ? (nodes / (elapsed_ms / 1000.0)) : 0.0;
                     printf("perft %d: %llu\n", depth, nodes);
                     printf("info string perft time: %.3f ms, nps: %.0f\n", elapsed_ms, nps);
-                    fflush(stdout);
                 }
+                fflush(stdout);
             }
         } else if (strncmp(line, "go", 2) == 0) {
             printf("info string DEBUG: UCI: Received \'go\' command: %s\n", line);
@@ -578,6 +740,10 @@ void uci_loop() {
             uint64_t node_limit = 0;  // Knotenlimit (go nodes X)
             long movetime = 0;  // Feste Zeit pro Zug (go movetime X)
             bool infinite = false;
+            bool ponder = false;  // Auf Zeit des Gegners rechnen (go ponder)
+            bool searchmoves = false;  // Nur diese Wurzelzüge durchsuchen (go searchmoves m1 m2 ...)
+            // Fresh per-search state; searchmoves and the limits are filled in below
+            search_info_prepare(&search_info, &search_params);
 
             char* token;
             char* rest = line + 3;
@@ -591,12 +757,19 @@ void uci_loop() {
                 else if(strcmp(token, "nodes") == 0 && (token = strtok_r(NULL, " ", &rest))) node_limit = strtoull(token, NULL, 10);
                 else if(strcmp(token, "movetime") == 0 && (token = strtok_r(NULL, " ", &rest))) movetime = atol(token);
                 else if(strcmp(token, "infinite") == 0) infinite = true;
+                else if(strcmp(token, "ponder") == 0) ponder = true;
+                else if(strcmp(token, "searchmoves") == 0) searchmoves = true;
+                else if(searchmoves && search_info.searchMoveCount < MAX_MOVES) {
+                    Move m = parse_uci_move(&current_board, token);
+                    if (m != 0) search_info.searchMoves[search_info.searchMoveCount++] = m;
+                }
             }
 
             long current_player_time = current_board.whiteToMove ? wtime : btime;
             long current_player_inc = current_board.whiteToMove ? winc : binc;
 
             long soft_limit, hard_limit;
+            bool time_scaling = false;  // nur bei normaler Zeitkontrolle
 
             if (infinite || depth_limit > 0 || node_limit > 0) {
                 // Unendliche Suche, Tiefenbegrenzung oder Knotenbegrenzung
@@ -607,43 +780,10 @@ void uci_loop() {
                 soft_limit = movetime;
                 hard_limit = movetime;
             } else if (current_player_time > 0) {
-                // Normale Zeitkontrolle
-                // Berechne die erwartete Anzahl der verbleibenden Züge
-                int expected_moves = movestogo > 0 ? movestogo : 25;  // Annahme: 25 Züge bis Spielende (aggressiver)
-                
-                // Basis-Zeit pro Zug
-                long base_time = current_player_time / expected_moves;
-                
-                // Inkrement voll hinzufügen
-                long inc_bonus = current_player_inc;
-                
-                // Soft-Limit: Zeit, nach der keine neue Tiefe begonnen wird
-                soft_limit = base_time + inc_bonus;
-                
-                // Stelle sicher, dass wir nicht zu viel Zeit nutzen (max 25% der Gesamtzeit)
-                long max_time = current_player_time / 4;
-                if (soft_limit > max_time) {
-                    soft_limit = max_time;
-                }
-                
-                // Hard-Limit: Absolutes Maximum (2.5x Soft-Limit, aber max 40% der Zeit)
-                hard_limit = (soft_limit * 5) / 2;
-                long absolute_max = (current_player_time * 40) / 100;
-                if (hard_limit > absolute_max) {
-                    hard_limit = absolute_max;
-                }
-                
-                // Mindestzeit garantieren
-                if (soft_limit < 50) soft_limit = 50;
-                if (hard_limit < 100) hard_limit = 100;
-                
-                // Bei sehr wenig Zeit: aggressivere Einstellungen
-                if (current_player_time < 1000) {
-                    soft_limit = current_player_time / 8;
-                    hard_limit = current_player_time / 4;
-                    if (soft_limit < 10) soft_limit = 10;
-                    if (hard_limit < 20) hard_limit = 20;
-                }
+                // Normale Zeitkontrolle, das Soft-Limit passt die Suche pro Iteration an
+                time_scaling = true;
+                search_clock_limits(current_player_time, current_player_inc, movestogo,
+                                    &soft_limit, &hard_limit);
             } else {
                 // Keine Zeitkontrolle angegeben - Standard
                 soft_limit = 2000;
@@ -659,18 +799,22 @@ void uci_loop() {
             search_info.startTimeMs = search_current_time_ms();
             search_info.softTimeLimit = soft_limit;
             search_info.hardTimeLimit = hard_limit;
-            search_info.stopSearch = false;
-            search_info.lastIterationTime = 0;
+            search_info.timeScaling = time_scaling;
+            // Pondering: search without limits, ponderhit applies the limits
+            // computed above counted from that moment
+            ponder_soft_limit = soft_limit;
+            ponder_hard_limit = hard_limit;
+            if (ponder) {
+                search_info.softTimeLimit = 0;
+                search_info.hardTimeLimit = 0;
+            }
+            search_set_pondering(ponder);
             search_info.nnue_acc = &nnue_accumulator;  // Use the local NNUE accumulator
             search_info.nnue_net = nnue_network;       // Use the heap-allocated NNUE network
-            search_info.nodesSearched = 0;
-            search_info.bestMoveThisIteration = 0;
-            search_info.bestScoreThisIteration = 0;
-            search_info.seldepth = 0;
             search_info.depthLimit = depth_limit;  // Set depth limit from UCI
             search_info.nodeLimit = node_limit;     // Set node limit from UCI
-            search_info.params = search_params;    // Copy search parameters
-            clear_volatile_history(&search_info);  // Killers/prev_moves only; history persists
+            search_info.multiPV = multi_pv;
+            clear_volatile_history(&search_info);  // Ply-indexed state only; history persists
 
             // =================================================================
             // Syzygy tablebases: configure in-search WDL probing and probe the
@@ -686,10 +830,6 @@ void uci_loop() {
                 (tb_max > 0 && syzygy_probe_limit > 0 && root_legal)
                     ? (syzygy_probe_limit < tb_max ? syzygy_probe_limit : tb_max)
                     : 0;
-            search_info.tbRootMoveCount = 0;
-            search_info.tbRootScore = 0;
-            search_info.tbRootMatePlies = -1;
-            search_info.tbRootPvLen = 0;
             if (search_info.tbProbeLimit > 0 &&
                 current_board.castlingRights == NO_CASTLING) {
                 Bitboard tb_occ =
@@ -742,52 +882,147 @@ void uci_loop() {
                     }
                 }
             }
+            // searchmoves: only the TB-optimal moves among them stay. If the
+            // DTZ line starts with another move, its mate distance and PV say
+            // nothing about ours.
+            if (search_info.searchMoveCount > 0 && search_info.tbRootMoveCount > 0) {
+                int kept = 0;
+                for (int i = 0; i < search_info.tbRootMoveCount; i++) {
+                    for (int j = 0; j < search_info.searchMoveCount; j++) {
+                        if (search_info.tbRootMoves[i] == search_info.searchMoves[j]) {
+                            search_info.tbRootMoves[kept++] = search_info.tbRootMoves[i];
+                            break;
+                        }
+                    }
+                }
+                search_info.tbRootMoveCount = kept;
+                bool pv_kept = false;
+                for (int i = 0; i < kept; i++) {
+                    if (search_info.tbRootPvLen > 0 && search_info.tbRootMoves[i] == search_info.tbRootPv[0]) pv_kept = true;
+                }
+                if (!pv_kept) {
+                    search_info.tbRootPvLen = 0;
+                    search_info.tbRootMatePlies = -1;
+                    if (search_info.tbRootScore > TB_WIN_SCORE) search_info.tbRootScore = TB_WIN_SCORE;
+                    if (search_info.tbRootScore < -TB_WIN_SCORE) search_info.tbRootScore = -TB_WIN_SCORE;
+                }
+            }
 
-
-            // This is where the search will be called.
-            // For now, let's just pick the first legal move.
-            // Later, this will be replaced by iterative deepening alpha-beta search.
-            // Move best_move = find_best_move(&current_board, &search_info);
             generateMoves(&current_board, &move_list);
             printf("info string DEBUG: UCI: Generated %d moves before calling search.\n", move_list.count);
             fflush(stdout); // CHANGED from stderr
-            Move best_move = 0;
-            
+
             if (move_list.count > 0) {
-                // Normal search
+                // Search on the search thread; it prints the bestmove
                 printf("info string DEBUG: UCI: Calling iterative_deepening_search...\n");
                 const char* fen_before_search = outputFEN(&current_board);
                 printf("info string FEN: %s\n", fen_before_search);
                 fflush(stdout);
-                best_move = iterative_deepening_search(&current_board, &search_info);
-                // On a tablebase root hit, play the DTZ-optimal move so that the
-                // played move, the reported score and the displayed PV all agree.
-                if (search_info.tbRootMoveCount > 0 && search_info.tbRootPvLen > 0) {
-                    best_move = search_info.tbRootPv[0];
-                }
-                printf("info string DEBUG: UCI: iterative_deepening_search returned. Best move: %u\n", best_move);
-                fflush(stdout);
-                printf("Best score: %d\n", search_info.bestScoreThisIteration);
+                start_search(&current_board, &search_info, infinite);
             } else {
                 printf("info string DEBUG: UCI: No moves generated, not calling search.\n");
+                printf("bestmove 0000\n"); // Should not happen in a legal position
                 fflush(stdout);
             }
 
-
-            if (best_move != 0) {
-                char move_str[6];
-                moveToString(best_move, move_str);
-                printf("bestmove %s\n", move_str);
+        } else if (strcmp(line, "bench") == 0 || strncmp(line, "bench ", 6) == 0) {
+            // bench [depth] [hash MB] [threads]
+            int depth = BENCH_DEFAULT_DEPTH, hash_mb = BENCH_DEFAULT_HASH, threads = 1;
+            sscanf(line + 5, "%d %d %d", &depth, &hash_mb, &threads);
+            if (depth < 1) depth = 1;
+            if (depth >= MAX_PLY) depth = MAX_PLY - 1;
+            if (hash_mb < 1) hash_mb = 1;
+            if (threads < 1) threads = 1;
+            if (threads > MAX_THREADS) threads = MAX_THREADS;
+            bench(depth, hash_mb, threads, &search_info, &nnue_accumulator, nnue_network, &search_params);
+        } else if (strncmp(line, "epd ", 4) == 0) {
+            // epd <file> [nodes <n>] [movetime <ms>] [depth <d>] [threads <n>] [shared]
+            // epd symmetry <file> [tolerance <cp>]
+            // epd compare <file> net <reference> [tolerance <cp>]
+            // threads defaults to the Threads option, the limit to 1M nodes
+            char* token;
+            char* rest = line + 4;
+            EpdConfig epd = {.threads = search_get_threads()};
+            bool symmetry = false;
+            bool compare = false;
+            const char* reference_path = NULL;
+            int tolerance = -1;
+            while ((token = strtok_r(rest, " ", &rest))) {
+                if (strcmp(token, "symmetry") == 0) symmetry = true;
+                else if (strcmp(token, "compare") == 0) compare = true;
+                else if (strcmp(token, "net") == 0 && (token = strtok_r(NULL, " ", &rest))) reference_path = token;
+                else if (strcmp(token, "shared") == 0) epd.shared_tt = true;
+                else if (strcmp(token, "nodes") == 0 && (token = strtok_r(NULL, " ", &rest))) epd.nodes = strtoull(token, NULL, 10);
+                else if (strcmp(token, "movetime") == 0 && (token = strtok_r(NULL, " ", &rest))) epd.movetime_ms = atol(token);
+                else if (strcmp(token, "depth") == 0 && (token = strtok_r(NULL, " ", &rest))) epd.depth = atoi(token);
+                else if (strcmp(token, "threads") == 0 && (token = strtok_r(NULL, " ", &rest))) epd.threads = atoi(token);
+                else if (strcmp(token, "tolerance") == 0 && (token = strtok_r(NULL, " ", &rest))) tolerance = atoi(token);
+                else epd.path = token;
+            }
+            if (epd.threads < 1) epd.threads = 1;
+            if (epd.threads > MAX_THREADS) epd.threads = MAX_THREADS;
+            if (epd.depth < 0 || epd.depth >= MAX_PLY) epd.depth = 0;
+            if (epd.nodes == 0 && epd.movetime_ms <= 0 && epd.depth == 0) epd.nodes = EPD_DEFAULT_NODES;
+            if (tolerance < 0) tolerance = compare ? EPD_COMPARE_TOLERANCE : EPD_SYMMETRY_TOLERANCE;
+            if (epd.path == NULL) {
+                printf("info string Error: epd requires a file\n");
+                fflush(stdout);
+            } else if (compare) {
+                // The reference is loaded next to the active net only for the run
+                NNUENetwork reference;
+                memset(&reference, 0, sizeof(reference));
+                if (reference_path == NULL) {
+                    printf("info string Error: epd compare requires net <reference>\n");
+                } else if (!nnue_network || !nnue_network->loaded) {
+                    printf("info string Error: epd compare requires a loaded NNUE net\n");
+                } else if (nnue_load(reference_path, &reference)) {
+                    epd_compare(epd.path, tolerance, nnue_network, &reference);
+                }
+                nnue_unload(&reference);
+                fflush(stdout);
+            } else if (symmetry) {
+                epd_symmetry(epd.path, tolerance, nnue_network);
             } else {
-                printf("bestmove 0000\n"); // Should not happen in a legal position
+                epd_solve(&epd, nnue_network);
             }
-
         } else if (strcmp(line, "eval") == 0) {
             // Evaluate current position using current evaluation (NNUE or HCE)
             int score = evaluate(&current_board, &nnue_accumulator, nnue_network);
             printf("info string Evaluation: %d cp (from %s perspective)\n", 
                    score, current_board.whiteToMove ? "white" : "black");
             fflush(stdout);
+        } else if (strcmp(line, "nnuebench") == 0) {
+            // Accumulator update kernels at the common net widths
+            nnue_simd_init();
+            nnue_simd_bench(256);
+            nnue_simd_bench(768);
+        } else if (strncmp(line, "savenet ", 8) == 0) {
+            // savenet <path> [int8]: write the loaded net in the current
+            // headered format (converts legacy headerless bullet exports, and
+            // with int8 quantises the ft weights to int8 with per-bucket scales)
+            char* path = line + 8;
+            bool ft_int8 = false;
+            char* last = strrchr(path, ' ');
+            if (last != NULL && strcmp(last + 1, "int8") == 0) {
+                *last = '\0';
+                ft_int8 = true;
+            }
+            if (nnue_save(path, nnue_network, ft_int8)) {
+                printf("info string NNUE net saved to %s\n", path);
+            } else {
+                printf("info string Failed to save NNUE net to %s\n", path);
+            }
+            fflush(stdout);
+        } else if (strcmp(line, "savehash") == 0) {
+            // Persist the TT to HashFile, e.g. before stopping a long analysis
+            if (tt_save(hash_file)) {
+                printf("info string TT saved to %s\n", hash_file);
+            }
+            fflush(stdout);
+        } else if (strcmp(line, "loadhash") == 0) {
+            // Replace the TT with the contents of HashFile (takes its size)
+            tt_load(hash_file);
+            fflush(stdout);
         } else if (strcmp(line, "flip") == 0 || strcmp(line, "mirror") == 0) {
             // Mirror the current position (swap colors and flip board)
             mirrorBoard(&current_board);
@@ -796,18 +1031,29 @@ void uci_loop() {
             const char* mirrored_fen = outputFEN(&current_board);
             printf("info string FEN: %s\n", mirrored_fen);
             fflush(stdout);
+        } else if (strcmp(line, "ponderhit") == 0) {
+            // The opponent played the expected move: continue as a normal search
+            search_ponderhit(&search_info, ponder_soft_limit, ponder_hard_limit);
         } else if (strcmp(line, "stop") == 0) {
-            // stop_search(); // This function will set a flag for the search to stop
-            // For now, this doesn't do much until search is implemented
-             printf("info string stop command received (no active search to stop yet)\n");
+            // Returns once the search thread has printed its bestmove
+            search_request_stop();
+            wait_for_search();
         } else if (strcmp(line, "quit") == 0) {
+            search_request_stop();
+            wait_for_search();
             break;
         }
         fflush(stdout);
         // fflush(stderr); // Consider adding here as well for other commands if needed
     }
     
-    // Release tablebases and heap-allocated NNUE network
+    // stdin closed mid-search: stop it before tearing anything down
+    search_request_stop();
+    wait_for_search();
+
+    // Release tablebases, helper threads and heap-allocated NNUE network
     syzygy_free();
+    search_set_threads(1);
+    nnue_unload(nnue_network);
     free(nnue_network);
 }
@@ -1,6 +1,8 @@
 #ifndef UCI_H
 #define UCI_H
 
-void uci_loop();
+// Runs the UCI loop on stdin; a non-NULL command is executed instead and
+// the loop returns afterwards
+void uci_loop(const char* command);
 
 #endif // UCI_H
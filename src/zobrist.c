@@ -38,6 +38,87 @@ void init_zobrist_keys() {
         zobrist_enpassant_keys[i] = random_uint64();
     }
     zobrist_side_to_move_key = random_uint64();
+
+    init_cuckoo();
+}
+
+// =============================================================================
+// Cuckoo table of reversible moves (upcoming repetition detection)
+//
+// For every non-pawn piece and every pair of squares s1 < s2 it can move
+// between on an empty board, the key difference of that move
+// (piece on s1 ^ piece on s2 ^ side to move) is stored with (s1, s2). Any
+// position reachable by one reversible move differs from the current key by
+// exactly one of these values. Two hash functions with displacement (cuckoo
+// hashing) keep every one of the 3668 entries in one of two slots.
+// =============================================================================
+
+uint64_t cuckoo_keys[CUCKOO_SIZE];
+uint16_t cuckoo_moves[CUCKOO_SIZE];  // s1 | s2 << 8, 0 = empty (a1-a1 is no move)
+
+static inline int cuckoo_h1(uint64_t key) { return (int)(key & (CUCKOO_SIZE - 1)); }
+static inline int cuckoo_h2(uint64_t key) { return (int)((key >> 16) & (CUCKOO_SIZE - 1)); }
+
+// Empty-board reach along rays (sliders) or single steps (knight, king)
+static bool piece_reaches(int pt, int s1, int s2) {
+    static const int KNIGHT_STEPS[8][2] = {{1,2},{2,1},{2,-1},{1,-2},{-1,-2},{-2,-1},{-2,1},{-1,2}};
+    int dr = s2 / 8 - s1 / 8, df = s2 % 8 - s1 % 8;
+    int adr = dr < 0 ? -dr : dr, adf = df < 0 ? -df : df;
+    switch (pt) {
+    case KNIGHT_T:
+        for (int i = 0; i < 8; i++) {
+            if (KNIGHT_STEPS[i][0] == dr && KNIGHT_STEPS[i][1] == df) return true;
+        }
+        return false;
+    case BISHOP_T: return adr == adf && adr != 0;
+    case ROOK_T:   return (adr == 0) != (adf == 0);
+    case QUEEN_T:  return (adr == adf && adr != 0) || ((adr == 0) != (adf == 0));
+    case KING_T:   return adr <= 1 && adf <= 1 && (adr | adf) != 0;
+    default:       return false;
+    }
+}
+
+void init_cuckoo(void) {
+    for (int i = 0; i < CUCKOO_SIZE; i++) {
+        cuckoo_keys[i] = 0;
+        cuckoo_moves[i] = 0;
+    }
+    for (int pt = KNIGHT_T; pt <= KING_T; pt++) {
+        for (int color = 0; color < 2; color++) {
+            for (int s1 = 0; s1 < 64; s1++) {
+                for (int s2 = s1 + 1; s2 < 64; s2++) {
+                    if (!piece_reaches(pt, s1, s2)) continue;
+
+                    uint64_t key = ZOBRIST_PIECE_KEY(pt, color, s1) ^ ZOBRIST_PIECE_KEY(pt, color, s2) ^
+                                   zobrist_side_to_move_key;
+                    uint16_t move = (uint16_t)(s1 | (s2 << 8));
+                    // Insert, kicking the occupant to its other slot until one is free
+                    int slot = cuckoo_h1(key);
+                    for (;;) {
+                        uint64_t kicked_key = cuckoo_keys[slot];
+                        uint16_t kicked_move = cuckoo_moves[slot];
+                        cuckoo_keys[slot] = key;
+                        cuckoo_moves[slot] = move;
+                        if (kicked_move == 0) break;
+                        key = kicked_key;
+                        move = kicked_move;
+                        slot = (slot == cuckoo_h1(key)) ? cuckoo_h2(key) : cuckoo_h1(key);
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool cuckoo_lookup(uint64_t move_key, int* s1, int* s2) {
+    int slot = cuckoo_h1(move_key);
+    if (cuckoo_keys[slot] != move_key) {
+        slot = cuckoo_h2(move_key);
+        if (cuckoo_keys[slot] != move_key) return false;
+    }
+    *s1 = cuckoo_moves[slot] & 0xFF;
+    *s2 = cuckoo_moves[slot] >> 8;
+    return true;
 }
 
 uint64_t calculate_zobrist_key(const Board* board) {
@@ -22,6 +22,17 @@ extern uint64_t zobrist_side_to_move_key;
     zobrist_piece_keys_flat[ZOBRIST_PIECE_INDEX(pieceType, colorIdx, square)]
 
 uint64_t calculate_zobrist_key(const Board* board);
+void init_zobrist_keys();
+
+// --- Cuckoo table of reversible move keys (filled by init_zobrist_keys) ---
+#define CUCKOO_SIZE 8192
+extern uint64_t cuckoo_keys[CUCKOO_SIZE];
+extern uint16_t cuckoo_moves[CUCKOO_SIZE];
+
+void init_cuckoo(void);
+// Is move_key the key difference of a reversible (non-pawn, non-capture)
+// move? If so returns its two squares (s1 < s2, either may be the origin).
+bool cuckoo_lookup(uint64_t move_key, int* s1, int* s2);
 
 
 #endif
\ No newline at end of file
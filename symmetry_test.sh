@@ -3,6 +3,8 @@
 # Symmetry Test Suite for sleepmind
 # Tests evaluation and search for color bias (white vs black)
 # Uses mirrored positions to check if eval/search treats both colors equally
+# The eval check alone runs natively over whole EPD files:
+#   ./build/sleepmind epd symmetry <file.epd> [tolerance <cp>]
 
 ENGINE="./build/sleepmind"
 
@@ -28,6 +28,7 @@ fn main() {
     let mut net_id = "sleepmind".to_string();
     let mut threads: usize = 2;
     let mut save_rate: usize = 10;
+    let mut ft_int8_scale: Option<f32> = None;
     
     // Parse arguments
     let mut i = 1;
@@ -75,6 +76,12 @@ fn main() {
                     save_rate = args[i].parse().unwrap_or(10);
                 }
             }
+            "--ft-int8-scale" => {
+                i += 1;
+                if i < args.len() {
+                    ft_int8_scale = args[i].parse().ok().filter(|s: &f32| *s >= 1.0);
+                }
+            }
             "--help" | "-h" => {
                 println!("SleepMind NNUE Trainer");
                 println!();
@@ -88,6 +95,7 @@ fn main() {
                 println!("  -n, --name <NAME>        Network ID for output (default: sleepmind)");
                 println!("  -t, --threads <N>        Number of threads (default: 2)");
                 println!("      --save-rate <N>      Save checkpoint every N superbatches (default: 10)");
+                println!("      --ft-int8-scale <S>  Clip the input layer so it converts to int8 with scale <= S");
                 println!("  -h, --help               Show this help");
                 println!();
                 println!("Examples:");
@@ -111,6 +119,9 @@ fn main() {
     if let Some(ref path) = load_weights {
         println!("Loading weights: {}", path);
     }
+    if let Some(scale) = ft_int8_scale {
+        println!("FT int8 scale: {} (convert with \"savenet <out> int8\" in the engine)", scale);
+    }
     println!();
 
     // hyperparams
@@ -177,8 +188,11 @@ fn main() {
         trainer.optimiser.load_weights_from_file(path).expect("Failed to load weights");
     }
 
-    // need to account for factoriser weight magnitudes
-    let stricter_clipping = AdamWParams { max_weight: 0.99, min_weight: -0.99, ..Default::default() };
+    // need to account for factoriser weight magnitudes. The merged weight is
+    // l0w + l0f quantised by 255; for int8 ft weights with scale S it has to
+    // stay within 127 * S, so each part gets half of 127 * S / 255.
+    let l0_clip = ft_int8_scale.map_or(0.99, |scale| (127.0 * scale / 255.0 / 2.0).min(0.99));
+    let stricter_clipping = AdamWParams { max_weight: l0_clip, min_weight: -l0_clip, ..Default::default() };
     trainer.optimiser.set_params_for_weight("l0w", stricter_clipping);
     trainer.optimiser.set_params_for_weight("l0f", stricter_clipping);
 